@@ -1,8 +1,35 @@
+/*
+ * File: main.c
+ * Project: STM32 PlatformIO Playground - LED Blink Example
+ * Description:
+ * Toggles the onboard LED (PA5) every 5 seconds. The blink is a periodic
+ * task of the shared tickless scheduler (lib/task): TIM6 is programmed
+ * for the next toggle and the core sleeps in WFI until then, instead of
+ * spinning in HAL_Delay() with a SysTick interrupt every millisecond.
+ */
+
 #include "stm32f0xx_hal.h"
+#include "task.h"
+#include "hwio.h"
+#include "clk.h"
+#include "board.h"
+
+#define BLINK_PERIOD_MS 5000U
+
+// Clock profile from lib/clk: 48 MHz, from the HSI48 where the board has one
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
+
+// Onboard LED; a BSRR store unless built with -DHW_BACKEND=HW_BACKEND_HAL
+static const hw_pin_t led = HW_PIN(BOARD_LED_PORT, BOARD_LED_PIN_NUM);
 
 // Function prototypes
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void blinkTask(void *ctx);
+
+static task_t blink;
 
 int main(void) {
     // Initialize the HAL Library
@@ -14,51 +41,42 @@ int main(void) {
     // Initialize GPIO for the onboard LED
     MX_GPIO_Init();
 
-    // Main loop
-    while (1) {
-        // Toggle the onboard LED
-        HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
+    // Scheduler on TIM6; nothing uses HAL_Delay(), so the 1 ms tick can stop
+    task_init();
+    HAL_SuspendTick();
+    task_every(&blink, BLINK_PERIOD_MS, blinkTask, NULL);
 
-        // Delay for 5 seconds
-        HAL_Delay(5000); 
+    // Main loop: run due tasks, sleep until the next one
+    while (1) {
+        task_run();
     }
 }
-// SysTick interrupt handler (required for HAL_Delay)
+
+// Toggle the onboard LED
+static void blinkTask(void *ctx) {
+    (void)ctx;
+    hw_pin_toggle(led);
+}
+
+// Scheduler timer: next deadline reached
+void TIM6_IRQHandler(void) {
+    task_timer_irq();
+}
+
+// SysTick interrupt handler (HAL timebase, suspended once the scheduler runs)
 void SysTick_Handler(void)
 {
     HAL_IncTick();
 }
-void SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    // Initialize the CPU, AHB, and APB clocks
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-    RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
-    RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL6;
-    RCC_OscInitStruct.PLL.PREDIV = RCC_PREDIV_DIV1;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
 
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_1);
+// System clock configuration: APP_CLK_PROFILE
+void SystemClock_Config(void) {
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
 }
 
+// Onboard LED (PA5 on every board of the matrix), off
 static void MX_GPIO_Init(void) {
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-
-    // Enable GPIOA clock
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    // Configure GPIO pin: PA5 (onboard LED)
-    GPIO_InitStruct.Pin = GPIO_PIN_5;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    board_led_init();
 }
\ No newline at end of file
@@ -1,53 +1,134 @@
+/*
+ * File: main.c
+ * Project: STM32 PlatformIO Playground - Push Button Example
+ * Description:
+ * Interrupt-driven buttons with the shared lib/button: the user button
+ * (PC13) and two optional external buttons (PB4, PB5) raise EXTI4_15 on
+ * both edges, a 5 ms TIM16 scan debounces them only while one is moving,
+ * and the debounced press, release, long-press and double-click events
+ * are queued for the main loop. Between events the core sleeps in WFI
+ * with SysTick stopped, so an untouched board takes no interrupts at all.
+ *
+ * The LED toggles on every press of the user button and turns off on a
+ * long press; every event is logged on USART1 with its latency from the
+ * first edge.
+ *
+ * Hardware Setup:
+ * - PA5: onboard LED (output).
+ * - PC13: user button B1 (active low, external pull-up on the Nucleo).
+ * - PB4, PB5: optional buttons to ground (internal pull-ups).
+ * - USART1 on PA9 (TX) / PA10 (RX), 115200 8N1.
+ */
+
 #include "stm32f0xx_hal.h"
+#include "button.h"
+#include "clk.h"
+#include "board.h"
+#include <stdio.h>
+#include <string.h>
+
+// Clock profile from lib/clk: 48 MHz, from the HSI48 where the board has one
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
 
 // Pin Definitions
-#define LED_PIN           GPIO_PIN_5
-#define LED_GPIO_PORT     GPIOA
-#define BUTTON_PIN        GPIO_PIN_13
-#define BUTTON_GPIO_PORT  GPIOC
+#define LED_PIN           BOARD_LED_PIN
+#define LED_GPIO_PORT     BOARD_LED_PORT
+
+// Buttons, index = event.button; each pin number is its own EXTI line
+static const button_config_t buttons[] = {
+    { BOARD_BUTTON_PORT, BOARD_BUTTON_PIN, BOARD_BUTTON_ACTIVE_LOW },   // B1 (user button)
+    { GPIOB, GPIO_PIN_4,  true },   // External button to ground
+    { GPIOB, GPIO_PIN_5,  true },   // External button to ground
+};
+#define BUTTON_COUNT (sizeof(buttons) / sizeof(buttons[0]))
+
+static const char *const buttonNames[BUTTON_COUNT] = { "B1", "PB4", "PB5" };
+static const char *const eventNames[] = { "press", "release", "long", "double" };
+
+UART_HandleTypeDef huart1;
 
 // Function Prototypes
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_USART1_UART_Init(void);
+static void logEvent(const button_event_t *ev);
 
 int main(void) {
     HAL_Init();
     SystemClock_Config();
     MX_GPIO_Init();
+    MX_USART1_UART_Init();
+
+    if (button_init(buttons, BUTTON_COUNT) != HAL_OK) {
+        while (1); // Error handling
+    }
+
+    const char *banner = "pushbutton: press, release, long, double\r\n";
+    HAL_UART_Transmit(&huart1, (uint8_t *)banner, strlen(banner), HAL_MAX_DELAY);
+
+    // Nothing uses HAL_Delay(): stop the 1 ms tick, only the buttons wake the CPU
+    HAL_SuspendTick();
 
     while (1) {
-        // Check if the button is pressed
-        if (HAL_GPIO_ReadPin(BUTTON_GPIO_PORT, BUTTON_PIN) == GPIO_PIN_RESET) {
-            HAL_GPIO_TogglePin(LED_GPIO_PORT, LED_PIN); // Toggle LED
-            HAL_Delay(300);  // Debounce delay
+        button_event_t ev;
+
+        while (button_get(&ev)) {
+            if (ev.button == 0U && ev.type == BUTTON_PRESS) {
+                HAL_GPIO_TogglePin(LED_GPIO_PORT, LED_PIN);
+            } else if (ev.button == 0U && ev.type == BUTTON_LONG) {
+                HAL_GPIO_WritePin(LED_GPIO_PORT, LED_PIN, GPIO_PIN_RESET);
+            }
+            logEvent(&ev);
         }
+        __WFI();
     }
 }
 
-// SysTick interrupt handler (required for HAL_Delay)
+// One line per event: latency from the first edge (long: how long it was held)
+static void logEvent(const button_event_t *ev) {
+    char line[96];
+    int n = snprintf(line, sizeof(line), "%-3s %-7s %6lu us", buttonNames[ev->button],
+                     eventNames[ev->type], (unsigned long)ev->latency);
+
+    if (ev->type == BUTTON_RELEASE) {
+        button_stats_t st;
+        button_stats(&st);
+        n += snprintf(&line[n], sizeof(line) - (size_t)n, "  (wakeups %lu, scans %lu)",
+                      (unsigned long)st.wakeups, (unsigned long)st.ticks);
+    }
+    n += snprintf(&line[n], sizeof(line) - (size_t)n, "\r\n");
+    HAL_UART_Transmit(&huart1, (uint8_t *)line, (uint16_t)n, HAL_MAX_DELAY);
+}
+
+// EXTI lines 4..15: PB4, PB5 and PC13
+void EXTI4_15_IRQHandler(void) {
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_4);
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_5);
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_13);
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    button_exti(GPIO_Pin);
+}
+
+// Button scan timer (BUTTON_TIM)
+void TIM16_IRQHandler(void) {
+    button_timer_irq();
+}
+
+// SysTick interrupt handler (HAL timebase, suspended once the buttons run)
 void SysTick_Handler(void)
 {
     HAL_IncTick();
 }
+
+// System clock configuration: APP_CLK_PROFILE
 void SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    // Initialize the CPU, AHB, and APB clocks
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-    RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
-    RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL6;
-    RCC_OscInitStruct.PLL.PREDIV = RCC_PREDIV_DIV1;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
-
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_1);
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
 }
 
 static void MX_GPIO_Init(void) {
@@ -55,7 +136,9 @@ static void MX_GPIO_Init(void) {
 
     // Enable GPIO Clocks
     __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_SYSCFG_CLK_ENABLE();  // EXTI line -> port mapping
 
     // Configure LED Pin
     GPIO_InitStruct.Pin = LED_PIN;
@@ -64,9 +147,33 @@ static void MX_GPIO_Init(void) {
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(LED_GPIO_PORT, &GPIO_InitStruct);
 
-    // Configure Button Pin
-    GPIO_InitStruct.Pin = BUTTON_PIN;
-    GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+    // Configure the button pins: EXTI on both edges
+    GPIO_InitStruct.Pin = BOARD_BUTTON_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
     GPIO_InitStruct.Pull = GPIO_PULLUP;
-    HAL_GPIO_Init(BUTTON_GPIO_PORT, &GPIO_InitStruct);
-}
\ No newline at end of file
+    HAL_GPIO_Init(BOARD_BUTTON_PORT, &GPIO_InitStruct);
+
+    GPIO_InitStruct.Pin = GPIO_PIN_4 | GPIO_PIN_5;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    // Same priority as the scan timer: the two never preempt each other
+    HAL_NVIC_SetPriority(EXTI4_15_IRQn, BUTTON_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(EXTI4_15_IRQn);
+}
+
+// USART1 on PA9 (TX) / PA10 (RX) at 115200 baud: event log
+static void MX_USART1_UART_Init(void) {
+    board_uart_pins_init(USART1);
+
+    huart1.Instance = USART1;
+    huart1.Init.BaudRate = 115200;
+    huart1.Init.WordLength = UART_WORDLENGTH_8B;
+    huart1.Init.StopBits = UART_STOPBITS_1;
+    huart1.Init.Parity = UART_PARITY_NONE;
+    huart1.Init.Mode = UART_MODE_TX_RX;
+    huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+    if (HAL_UART_Init(&huart1) != HAL_OK) {
+        while (1); // Error handling
+    }
+}
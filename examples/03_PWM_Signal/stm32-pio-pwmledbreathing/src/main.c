@@ -4,7 +4,10 @@
  * Project: STM32 PlatformIO Playground - Breathing LED Example
  * Description:
  * This code creates a smooth "breathing" LED effect on the onboard LED (PA5).
- * The PWM duty cycle varies sinusoidally to simulate the breathing effect.
+ * The PWM duty cycle follows a waveform table (lib/wave), played by DMA:
+ * every Timer 3 update copies the next duty sample into CCR1 (lib/pwm_player)
+ * and the CPU sleeps in WFI between the half-buffer refills. Build with
+ * -DBREATH_SINF=1 for the original sinf() curve, computed once into a RAM table.
  *
  * Hardware Setup:
  * - Configure PA5 (onboard LED) in analog mode (high impedance).
@@ -13,14 +16,59 @@
  */
 
 #include "stm32f0xx_hal.h"
+#include "prof.h"
+#include "pwm.h"
+#include "pwm_player.h"
+#include "clk.h"
+#include "board.h"
+
+// Clock profile from lib/clk: SYSCLK, AHB /1, APB /1 (-DAPP_CLK_PROFILE=CLK_LP for 8 MHz);
+// 48 MHz by default, from the HSI48 where the board has one
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
+#define SYSCLK_HZ     CLK_HZ(APP_CLK_PROFILE)
+#define TIM_CLOCK_HZ  PWM_TIMER_CLOCK(SYSCLK_HZ, 1U, 1U)
+
+// TIM3 PWM: 1 kHz with at least 1000 duty steps, checked at compile time.
+// The player scales samples to the timer's ARR + 1, so full scale is 100 %.
+#define PWM_FREQ_HZ   1000U
+#define PWM_STEPS     1000U
+PWM_PLAN_ASSERT(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);
+
+// 1 = original float curve (pulls in sinf() and the soft-float library)
+#ifndef BREATH_SINF
+#define BREATH_SINF 0
+#endif
+
+// One breath in ms: 126 updates of 10 ms in the former HAL_Delay() loop
+#ifndef BREATH_MS
+#define BREATH_MS 1260U
+#endif
+
+#if BREATH_SINF
 #include <math.h> // For sine wave calculation
+#define BREATH_TABLE sinfTable
+static uint16_t sinfTable[WAVE_TABLE_LEN];
+#else
+// wave_sine, wave_sine_gamma, wave_triangle or wave_breath
+#ifndef BREATH_TABLE
+#define BREATH_TABLE wave_sine
+#endif
+#endif
+
+// Profiled region (build with -DPROF_ENABLE=1, stats in prof.c): one half-buffer refill
+enum { PROF_REFILL };
 
 // Function prototypes
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_TIM3_Init(void);
 
 TIM_HandleTypeDef htim3;
+DMA_HandleTypeDef hdma_tim3_up;
+pwm_player_t player;  // Global: the DMA reads its buffer
 
 int main(void) {
     // Initialize the HAL Library
@@ -29,57 +77,57 @@ int main(void) {
     // Configure the system clock
     SystemClock_Config();
 
-    // Initialize GPIO and Timer
+    // Initialize GPIO, DMA and Timer
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_TIM3_Init();
 
-    // Start PWM on Timer 3, Channel 1
-    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_1);
+    PROF_INIT();
 
-    uint32_t dutyCycle;
-    float phase = 0.0f; // Phase for sine wave
+#if BREATH_SINF
+    // One sine cycle as Q15 samples: (sinf(phase) + 1) / 2
+    for (uint32_t i = 0; i < WAVE_TABLE_LEN; i++) {
+        float phase = 2.0f * (float)M_PI * (float)i / (float)WAVE_TABLE_LEN;
+        sinfTable[i] = (uint16_t)((sinf(phase) + 1.0f) * (WAVE_Q15_MAX / 2.0f) + 0.5f);
+    }
+#endif
 
-    // Main loop
-    while (1) {
-        // Calculate duty cycle as a sine wave
-        dutyCycle = (uint32_t)((sinf(phase) + 1) * 500); // Scale sine value to 0-1000
+    // Endless breath: one cycle per BREATH_MS PWM periods of 1 ms
+    static const pwm_player_wave_t breath = {
+        BREATH_TABLE, WAVE_STEP(BREATH_MS * PWM_FREQ_HZ / 1000U), 0
+    };
 
-        // Update PWM duty cycle
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, dutyCycle);
+    // Starts TIM3 CH1 and its update DMA
+    if (pwm_player_start(&player, &htim3, TIM_CHANNEL_1, &hdma_tim3_up, &breath) != HAL_OK) {
+        while (1); // Error handling
+    }
 
-        // Increment phase and wrap around
-        phase += 0.05f; // Controls breathing speed
-        if (phase >= 2 * M_PI) {
-            phase -= 2 * M_PI; // Keep phase within 0 to 2*PI
-        }
+    // Nothing uses HAL_Delay(): stop the 1 ms tick so only the DMA wakes the CPU
+    HAL_SuspendTick();
 
-        HAL_Delay(10); // Smooth transition
+    // Main loop: the DMA interrupt does the work
+    while (1) {
+        __WFI();
     }
 }
 
-// SysTick interrupt handler (required for HAL_Delay)
+// DMA interrupt handler: half/full buffer played, refill it
+void DMA1_Channel2_3_IRQHandler(void) {
+    PROF_BEGIN(PROF_REFILL);
+    HAL_DMA_IRQHandler(&hdma_tim3_up);
+    PROF_END(PROF_REFILL);
+}
+
+// SysTick interrupt handler (HAL timebase, suspended once the player runs)
 void SysTick_Handler(void) {
     HAL_IncTick();
 }
 
-// System clock configuration
+// System clock configuration: APP_CLK_PROFILE (SYSCLK_HZ)
 void SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_ON;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-    RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
-    RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL6;
-    RCC_OscInitStruct.PLL.PREDIV = RCC_PREDIV_DIV1;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
-
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_1);
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
 }
 
 // GPIO initialization
@@ -104,6 +152,26 @@ static void MX_GPIO_Init(void) {
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 }
 
+// DMA initialization: TIM3_UP request is DMA1 Channel 3, buffer -> CCR1
+static void MX_DMA_Init(void) {
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_tim3_up.Instance = DMA1_Channel3;
+    hdma_tim3_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim3_up.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim3_up.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim3_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.Mode = DMA_CIRCULAR;
+    hdma_tim3_up.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_tim3_up) != HAL_OK) {
+        while (1); // Error handling
+    }
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
 // Timer 3 initialization for PWM
 static void MX_TIM3_Init(void) {
     __HAL_RCC_TIM3_CLK_ENABLE(); // Enable Timer 3 clock
@@ -111,13 +179,13 @@ static void MX_TIM3_Init(void) {
     TIM_OC_InitTypeDef sConfigOC = {0};
 
     htim3.Instance = TIM3;
-    htim3.Init.Prescaler = 48 - 1;  // Prescaler for 1 MHz timer clock
+    htim3.Init.Prescaler = PWM_PLAN_PSC(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);  // 48 - 1 at 48 MHz
     htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim3.Init.Period = 1000 - 1;  // Period for 1 kHz PWM signal
+    htim3.Init.Period = PWM_PLAN_ARR(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);     // 1000 - 1: 1 kHz
     htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
     HAL_TIM_PWM_Init(&htim3);
 
-    // Configure PWM Channel 1
+    // Configure PWM Channel 1; the player writes the duty at every update
     sConfigOC.OCMode = TIM_OCMODE_PWM1;
     sConfigOC.Pulse = 0;  // Initial duty cycle (0%)
     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
@@ -20,6 +20,8 @@
  * - Configures PA5 in "Analog Mode" to make it high impedance.
  * - Configures PA6 as a PWM output using Timer 3 Channel 1.
  * - Outputs a PWM signal on PA6, gradually varying the duty cycle between 0% and 100%.
+ * - The duty ramp is a waveform table (lib/wave) played by DMA: every Timer 3 update copies
+ *   the next sample into CCR1 (lib/pwm_player), and the CPU sleeps in WFI between refills.
  * - The onboard LED connected to PA5 fades in and out due to the PWM signal applied indirectly via PA6.
  *
  * Hardware Setup:
@@ -33,13 +35,43 @@
  */
 
 #include "stm32f0xx_hal.h"
+#include "pwm.h"
+#include "pwm_player.h"
+#include "clk.h"
+#include "board.h"
+
+// Clock profile from lib/clk: SYSCLK, AHB /1, APB /1 (-DAPP_CLK_PROFILE=CLK_LP for 8 MHz);
+// 48 MHz by default, from the HSI48 where the board has one
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
+#define SYSCLK_HZ     CLK_HZ(APP_CLK_PROFILE)
+#define TIM_CLOCK_HZ  PWM_TIMER_CLOCK(SYSCLK_HZ, 1U, 1U)
+
+// TIM3 PWM: 1 kHz with at least 1000 duty steps, checked at compile time
+#define PWM_FREQ_HZ   1000U
+#define PWM_STEPS     1000U
+PWM_PLAN_ASSERT(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);
+
+// One fade in and out in ms: 0 -> 100 % -> 0 in steps of 1 %, 10 ms each
+#ifndef FADE_MS
+#define FADE_MS 2000U
+#endif
+
+// Linear ramp up and down, endless; step per PWM period of 1 ms
+static const pwm_player_wave_t fade = {
+    wave_triangle, WAVE_STEP(FADE_MS * PWM_FREQ_HZ / 1000U), 0
+};
 
 // Function prototypes
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_TIM3_Init(void);
 
 TIM_HandleTypeDef htim3;
+DMA_HandleTypeDef hdma_tim3_up;
+pwm_player_t player;  // Global: the DMA reads its buffer
 
 int main(void) {
     // Initialize the HAL Library
@@ -48,58 +80,40 @@ int main(void) {
     // Configure the system clock
     SystemClock_Config();
 
-    // Initialize GPIO and Timer
+    // Initialize GPIO, DMA and Timer
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_TIM3_Init();
 
-    // Start PWM on Timer 3, Channel 1
-    HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_1);
+    // Start PWM on Timer 3, Channel 1, with the fade fed to CCR1 by DMA
+    if (pwm_player_start(&player, &htim3, TIM_CHANNEL_1, &hdma_tim3_up, &fade) != HAL_OK) {
+        while (1); // Error handling
+    }
 
-    uint32_t dutyCycle = 0;
-    uint8_t increasing = 1;
+    // Nothing uses HAL_Delay(): stop the 1 ms tick so only the DMA wakes the CPU
+    HAL_SuspendTick();
 
-    // Main loop
+    // Main loop: the DMA interrupt does the work
     while (1) {
-        // Adjust the duty cycle
-        __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_1, dutyCycle);
-
-        // Increment or decrement duty cycle
-        if (increasing) {
-            dutyCycle += 10;  // Increase brightness
-            if (dutyCycle >= 1000) increasing = 0;  // Reverse direction
-        } else {
-            dutyCycle -= 10;  // Decrease brightness
-            if (dutyCycle == 0) increasing = 1;  // Reverse direction
-        }
-
-        HAL_Delay(10); // Smooth fading
+        __WFI();
     }
 }
 
-// SysTick interrupt handler (required for HAL_Delay)
+// DMA interrupt handler: half/full buffer played, refill it
+void DMA1_Channel2_3_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&hdma_tim3_up);
+}
+
+// SysTick interrupt handler (HAL timebase, suspended once the player runs)
 void SysTick_Handler(void) {
     HAL_IncTick();
 }
 
-// System clock configuration
+// System clock configuration: APP_CLK_PROFILE (SYSCLK_HZ)
 void SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
-    RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
-    RCC_OscInitStruct.PLL.PLLMUL = RCC_PLL_MUL6;
-    RCC_OscInitStruct.PLL.PREDIV = RCC_PREDIV_DIV1;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
-
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_1);
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
 }
 
 // GPIO initialization
@@ -124,6 +138,26 @@ static void MX_GPIO_Init(void) {
     HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 }
 
+// DMA initialization: TIM3_UP request is DMA1 Channel 3, buffer -> CCR1
+static void MX_DMA_Init(void) {
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_tim3_up.Instance = DMA1_Channel3;
+    hdma_tim3_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim3_up.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim3_up.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim3_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.Mode = DMA_CIRCULAR;
+    hdma_tim3_up.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_tim3_up) != HAL_OK) {
+        while (1); // Error handling
+    }
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
 // Timer 3 initialization for PWM
 static void MX_TIM3_Init(void) {
     __HAL_RCC_TIM3_CLK_ENABLE(); // Enable Timer 3 clock
@@ -131,13 +165,13 @@ static void MX_TIM3_Init(void) {
     TIM_OC_InitTypeDef sConfigOC = {0};
 
     htim3.Instance = TIM3;
-    htim3.Init.Prescaler = 48 - 1;  // Prescaler for 1 MHz timer clock
+    htim3.Init.Prescaler = PWM_PLAN_PSC(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);  // 48 - 1 at 48 MHz
     htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim3.Init.Period = 1000 - 1;  // Period for 1 kHz PWM signal
+    htim3.Init.Period = PWM_PLAN_ARR(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);     // 1000 - 1: 1 kHz
     htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
     HAL_TIM_PWM_Init(&htim3);
 
-    // Configure PWM Channel 1
+    // Configure PWM Channel 1; the player writes the duty at every update
     sConfigOC.OCMode = TIM_OCMODE_PWM1;
     sConfigOC.Pulse = 0;  // Initial duty cycle (0%)
     sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
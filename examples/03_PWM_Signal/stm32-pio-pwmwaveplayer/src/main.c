@@ -0,0 +1,167 @@
+/*
+ * File: main.c
+ * Project: STM32 PlatformIO Playground - PWM Waveform Player Example
+ * Description:
+ * Plays LED waveforms (fades, breathing, triangle) on PA6 without the CPU.
+ * DMA1 Channel 3, triggered by every Timer 3 update, copies the next duty
+ * sample from a RAM buffer into CCR1 (shared lib/pwm_player). The CPU
+ * sleeps in WFI and only wakes at the half/full DMA interrupts, once per
+ * PWM_PLAYER_HALF PWM periods, to generate the next half of the buffer.
+ * The main loop queues the next pattern whenever the queue slot is free,
+ * so pattern changes happen exactly at the end of a cycle.
+ *
+ * Hardware Setup:
+ * - Configure PA5 (onboard LED) in analog mode (high impedance).
+ * - Generate PWM on PA6 using Timer 3, Channel 1 (1 kHz, 0-1000).
+ * - Connect PA6 to PA5 with a jumper wire.
+ */
+
+#include "stm32f0xx_hal.h"
+#include "pwm_player.h"
+#include "pwm.h"
+#include "clk.h"
+#include "board.h"
+
+// Clock profile from lib/clk: SYSCLK, AHB /1, APB /1 (-DAPP_CLK_PROFILE=CLK_LP for 8 MHz);
+// 48 MHz by default, from the HSI48 where the board has one
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
+#define SYSCLK_HZ     CLK_HZ(APP_CLK_PROFILE)
+#define TIM_CLOCK_HZ  PWM_TIMER_CLOCK(SYSCLK_HZ, 1U, 1U)
+
+// TIM3 PWM: 1 kHz with at least 1000 duty steps, checked at compile time
+#define PWM_FREQ_HZ   1000U
+#define PWM_STEPS     1000U
+PWM_PLAN_ASSERT(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);
+
+// Patterns played in turn; step = WAVE_STEP(PWM periods per cycle), 1 kHz PWM
+static const pwm_player_wave_t patterns[] = {
+    { wave_sine,       WAVE_STEP(2000), 3 },  // 2 s fade in/out, 3 times
+    { wave_breath,     WAVE_STEP(4000), 2 },  // 4 s breath: short peak, long rest
+    { wave_triangle,   WAVE_STEP(500),  6 },  // 0.5 s linear ramps
+    { wave_sine_gamma, WAVE_STEP(1000), 4 },  // 1 s fade corrected for the eye
+};
+#define PATTERN_COUNT (sizeof(patterns) / sizeof(patterns[0]))
+
+// Function prototypes
+void SystemClock_Config(void);
+static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
+static void MX_TIM3_Init(void);
+
+TIM_HandleTypeDef htim3;
+DMA_HandleTypeDef hdma_tim3_up;
+pwm_player_t player;  // Global: the DMA reads its buffer
+
+int main(void) {
+    // Initialize the HAL Library
+    HAL_Init();
+
+    // Configure the system clock
+    SystemClock_Config();
+
+    // Initialize GPIO, DMA and Timer
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_TIM3_Init();
+
+    if (pwm_player_start(&player, &htim3, TIM_CHANNEL_1, &hdma_tim3_up, &patterns[0]) != HAL_OK) {
+        while (1); // Error handling
+    }
+
+    // Nothing uses HAL_Delay(): stop the 1 ms tick so only the DMA wakes the CPU
+    HAL_SuspendTick();
+
+    uint32_t next = 1;
+
+    // Main loop
+    while (1) {
+        if (!pwm_player_pending(&player)) {
+            // Starts the player again if it ran out before the queue was refilled
+            pwm_player_queue(&player, &patterns[next]);
+            next = (next + 1) % PATTERN_COUNT;
+        }
+        __WFI();
+    }
+}
+
+// DMA interrupt handler: half/full buffer played, refill it
+void DMA1_Channel2_3_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&hdma_tim3_up);
+}
+
+// SysTick interrupt handler (HAL timebase, suspended once the player runs)
+void SysTick_Handler(void) {
+    HAL_IncTick();
+}
+
+// System clock configuration: APP_CLK_PROFILE (SYSCLK_HZ)
+void SystemClock_Config(void) {
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
+}
+
+// GPIO initialization
+static void MX_GPIO_Init(void) {
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    // Enable GPIOA clock
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    // Configure PA5 in Analog mode (high impedance)
+    GPIO_InitStruct.Pin = GPIO_PIN_5;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    // Configure PA6 for PWM (Timer 3 Channel 1)
+    GPIO_InitStruct.Pin = GPIO_PIN_6;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF1_TIM3;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+}
+
+// DMA initialization: TIM3_UP request is DMA1 Channel 3, buffer -> CCR1
+static void MX_DMA_Init(void) {
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_tim3_up.Instance = DMA1_Channel3;
+    hdma_tim3_up.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_tim3_up.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_tim3_up.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_tim3_up.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_tim3_up.Init.Mode = DMA_CIRCULAR;
+    hdma_tim3_up.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_tim3_up) != HAL_OK) {
+        while (1); // Error handling
+    }
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+// Timer 3 initialization for PWM
+static void MX_TIM3_Init(void) {
+    __HAL_RCC_TIM3_CLK_ENABLE(); // Enable Timer 3 clock
+
+    TIM_OC_InitTypeDef sConfigOC = {0};
+
+    htim3.Instance = TIM3;
+    htim3.Init.Prescaler = PWM_PLAN_PSC(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);  // 48 - 1 at 48 MHz
+    htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim3.Init.Period = PWM_PLAN_ARR(TIM_CLOCK_HZ, PWM_FREQ_HZ, PWM_STEPS);     // 1000 - 1: 1 kHz
+    htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    HAL_TIM_PWM_Init(&htim3);
+
+    // Configure PWM Channel 1; the player writes the duty at every update
+    sConfigOC.OCMode = TIM_OCMODE_PWM1;
+    sConfigOC.Pulse = 0;  // Initial duty cycle (0%)
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    HAL_TIM_PWM_ConfigChannel(&htim3, &sConfigOC, TIM_CHANNEL_1);
+}
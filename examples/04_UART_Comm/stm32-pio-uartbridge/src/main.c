@@ -0,0 +1,224 @@
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>  // for bool
+#include "ringbuf.h"
+#include "uart_bridge.h"
+#include "clk.h"
+#include "board.h"
+
+/* -------------------------------------------------------------------------
+   Global Handles & Buffers
+   ------------------------------------------------------------------------- */
+UART_HandleTypeDef huart1;    // Peer: PA9/PA10 (ESP32, adapter)
+UART_HandleTypeDef huart2;    // Host: PA2/PA3, ST-Link virtual COM port
+DMA_HandleTypeDef hdma_usart1_tx;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart2_tx;
+DMA_HandleTypeDef hdma_usart2_rx;
+
+/* Baud rate of each side; they may differ (the slower side sets the pace) */
+#ifndef APP_VCP_BAUD
+#define APP_VCP_BAUD  115200U
+#endif
+#ifndef APP_PEER_BAUD
+#define APP_PEER_BAUD 115200U
+#endif
+
+/* Clock profile from lib/clk: 48 MHz, for the highest baud rates */
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE BOARD_CLK_FAST
+#endif
+
+/*
+ * One ring per direction, filled by the circular RX DMA and sent from in
+ * place by the other USART's TX DMA. It absorbs what arrives while a span
+ * is on the wire, and a burst from a faster sender (1 KB on the F030,
+ * scaled with the RAM of the board).
+ */
+#define BRIDGE_RING_SIZE BOARD_BUF_SIZE(1024)
+BOARD_RAM_ASSERT(2 * BRIDGE_RING_SIZE);
+
+RINGBUF_DEFINE(toPeerRing, BRIDGE_RING_SIZE);
+RINGBUF_DEFINE(toHostRing, BRIDGE_RING_SIZE);
+
+/* Counters per direction (watch them in the debugger): bytes, spans,
+   drops, errors, peak ring fill */
+uart_bridge_t toPeer;    // USART2 RX -> USART1 TX
+uart_bridge_t toHost;    // USART1 RX -> USART2 TX
+
+/* -------------------------------------------------------------------------
+   Function Prototypes
+   ------------------------------------------------------------------------- */
+void SystemClock_Config(void);
+static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
+static void MX_UART_Init(UART_HandleTypeDef *huart, USART_TypeDef *usart, uint32_t baud);
+static void MX_UART_DMA_Init(DMA_HandleTypeDef *hdma, DMA_Channel_TypeDef *channel,
+                             uint32_t direction, uint32_t mode, uint32_t priority);
+
+/* -------------------------------------------------------------------------
+   main()
+   ------------------------------------------------------------------------- */
+int main(void)
+{
+    /* 1. Init HAL (sets up SysTick, etc.) */
+    HAL_Init();
+
+    /* 2. Configure system clock (48 MHz by default) */
+    SystemClock_Config();
+
+    /* 3. Initialize peripherals: GPIO (LED), DMA, USART1 and USART2 */
+    MX_GPIO_Init();
+    MX_DMA_Init();
+    MX_UART_Init(&huart1, USART1, APP_PEER_BAUD);
+    MX_UART_Init(&huart2, USART2, APP_VCP_BAUD);
+
+    /*
+     * 4. DMA channels (RX circular, TX one span at a time):
+     *      USART1_TX => DMA1_Channel2, USART1_RX => DMA1_Channel3
+     *      USART2_TX => DMA1_Channel4, USART2_RX => DMA1_Channel5
+     */
+    MX_UART_DMA_Init(&hdma_usart1_tx, BOARD_USART1_TX_DMA, DMA_MEMORY_TO_PERIPH, DMA_NORMAL, DMA_PRIORITY_LOW);
+    BOARD_DMA_ROUTE(BOARD_USART1_TX_REQ);
+    __HAL_LINKDMA(&huart1, hdmatx, hdma_usart1_tx);
+    MX_UART_DMA_Init(&hdma_usart1_rx, BOARD_USART1_RX_DMA, DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, DMA_PRIORITY_HIGH);
+    BOARD_DMA_ROUTE(BOARD_USART1_RX_REQ);
+    __HAL_LINKDMA(&huart1, hdmarx, hdma_usart1_rx);
+    MX_UART_DMA_Init(&hdma_usart2_tx, BOARD_USART2_TX_DMA, DMA_MEMORY_TO_PERIPH, DMA_NORMAL, DMA_PRIORITY_LOW);
+    BOARD_DMA_ROUTE(BOARD_USART2_TX_REQ);
+    __HAL_LINKDMA(&huart2, hdmatx, hdma_usart2_tx);
+    MX_UART_DMA_Init(&hdma_usart2_rx, BOARD_USART2_RX_DMA, DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, DMA_PRIORITY_HIGH);
+    BOARD_DMA_ROUTE(BOARD_USART2_RX_REQ);
+    __HAL_LINKDMA(&huart2, hdmarx, hdma_usart2_rx);
+
+    /* 5. Forward both ways; from here on only interrupts move data */
+    if (uart_bridge_start(&toPeer, &huart2, &huart1, &toPeerRing) != HAL_OK ||
+        uart_bridge_start(&toHost, &huart1, &huart2, &toHostRing) != HAL_OK)
+    {
+        while (1);
+    }
+
+    /* 6. LED on once a byte was lost or damaged in either direction */
+    while (1)
+    {
+        bool lost = (toPeer.drops | toPeer.errors | toHost.drops | toHost.errors) != 0U;
+
+        HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, lost ? GPIO_PIN_SET : GPIO_PIN_RESET);
+        __WFI();
+    }
+}
+
+/* -------------------------------------------------------------------------
+   SystemClock_Config
+   APP_CLK_PROFILE from lib/clk: the fastest clock of the board by default.
+-------------------------------------------------------------------------- */
+void SystemClock_Config(void)
+{
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK)
+    {
+        while (1);
+    }
+}
+
+/* -------------------------------------------------------------------------
+   GPIO Init
+   - Configure PA5 (User LED) as push-pull output
+-------------------------------------------------------------------------- */
+static void MX_GPIO_Init(void)
+{
+    board_led_init();
+}
+
+/* -------------------------------------------------------------------------
+   DMA Init
+   - Enable DMA1 clock
+   - NVIC for DMA1 Channel2_3 (USART1) and Channel4_5 (USART2)
+-------------------------------------------------------------------------- */
+static void MX_DMA_Init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    HAL_NVIC_SetPriority(BOARD_USART1_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(BOARD_USART1_DMA_IRQn);
+    HAL_NVIC_SetPriority(BOARD_USART2_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(BOARD_USART2_DMA_IRQn);
+}
+
+/* -------------------------------------------------------------------------
+   USART Init
+   - Pins and clock from lib/board (USART1 PA9/PA10, USART2 PA2/PA3, AF1)
+   - 8N1 at `baud`; 8x oversampling above PCLK / 16 (up to 6 Mbaud at 48 MHz)
+   - USART IRQ delivers the idle-line event and line errors
+-------------------------------------------------------------------------- */
+static void MX_UART_Init(UART_HandleTypeDef *huart, USART_TypeDef *usart, uint32_t baud)
+{
+    board_uart_pins_init(usart);
+
+    huart->Instance          = usart;
+    huart->Init.BaudRate     = baud;
+    huart->Init.WordLength   = UART_WORDLENGTH_8B;
+    huart->Init.StopBits     = UART_STOPBITS_1;
+    huart->Init.Parity       = UART_PARITY_NONE;
+    huart->Init.Mode         = UART_MODE_TX_RX;
+    huart->Init.HwFlowCtl    = UART_HWCONTROL_NONE;
+    huart->Init.OverSampling = (baud > CLK_HZ(APP_CLK_PROFILE) / 16U) ? UART_OVERSAMPLING_8
+                                                                      : UART_OVERSAMPLING_16;
+    if (HAL_UART_Init(huart) != HAL_OK)
+    {
+        while (1);
+    }
+
+    HAL_NVIC_SetPriority((usart == USART2) ? USART2_IRQn : USART1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ((usart == USART2) ? USART2_IRQn : USART1_IRQn);
+}
+
+/* -------------------------------------------------------------------------
+   DMA channel Init for one USART direction (byte wide, memory increments)
+-------------------------------------------------------------------------- */
+static void MX_UART_DMA_Init(DMA_HandleTypeDef *hdma, DMA_Channel_TypeDef *channel,
+                             uint32_t direction, uint32_t mode, uint32_t priority)
+{
+    hdma->Instance                 = channel;
+    hdma->Init.Direction           = direction;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode                = mode;
+    hdma->Init.Priority            = priority;
+    if (HAL_DMA_Init(hdma) != HAL_OK)
+    {
+        while (1);
+    }
+}
+
+/* -------------------------------------------------------------------------
+   IRQ Handlers: idle line and errors from each USART, RX half/full and
+   TX complete from the DMA. Each DMA vector serves one channel of each
+   direction (Channel2_3: USART1 TX and RX, Channel4_5: USART2 TX and RX).
+-------------------------------------------------------------------------- */
+void USART1_IRQHandler(void)
+{
+    uart_bridge_usart_irq(&toHost);
+}
+
+void USART2_IRQHandler(void)
+{
+    uart_bridge_usart_irq(&toPeer);
+}
+
+void BOARD_USART1_DMA_IRQHandler(void)
+{
+    uart_bridge_dma_irq(&toPeer);
+    uart_bridge_dma_irq(&toHost);
+}
+
+void BOARD_USART2_DMA_IRQHandler(void)
+{
+    uart_bridge_dma_irq(&toPeer);
+    uart_bridge_dma_irq(&toHost);
+}
+
+void SysTick_Handler(void)
+{
+    HAL_IncTick();
+}
@@ -1,21 +1,104 @@
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include <string.h>
+#include "link_protocol.h"
+#if LINK_BINARY
+#include "frame.h"
+#endif
 
 #define UART_BAUDRATE 115200
 #define MAX_MSG_LEN 64  // Reduced buffer size for simplicity
 
 HardwareSerial SerialSTM32(1); // RX=19, TX=18
 
+#if LINK_BINARY
+frame_rx_t frameRx;          // Collects COBS bytes up to the 0x00 delimiter
+uint16_t heartbeatSeq = 0;
+#else
 char receivedMsg[MAX_MSG_LEN];
 uint16_t msgIndex = 0;
+#endif
 
 void setup() {
     Serial.begin(115200);
     SerialSTM32.begin(UART_BAUDRATE, SERIAL_8N1, 19, 18);
     Serial.println("UART Communication Started");
+#if LINK_BINARY
+    frame_rx_init(&frameRx);
+    Serial.println("Link mode: binary frames (COBS + CRC-16)");
+#endif
 }
 
+#if LINK_BINARY
+// Encode one frame and write it to the STM32
+static void sendFrame(uint8_t type, const void *payload, uint8_t len) {
+    uint8_t out[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    size_t n = frame_encode(type, (const uint8_t *)payload, len, out, sizeof(out));
+    SerialSTM32.write(out, n);
+}
+
+static void handleFrame(const frame_t &frame) {
+    switch (frame.type) {
+    case LINK_MSG_HEARTBEAT: {
+        // Our own sample, echoed back: the timestamp gives the round trip
+        link_sensor_t sample;
+        if (frame.len != sizeof(sample)) break;
+        memcpy(&sample, frame.payload, sizeof(sample));
+        Serial.printf("Received: Heartbeat seq=%u temp=%.2f C rtt=%lu ms\n",
+                      sample.seq, sample.tempCx100 / 100.0f,
+                      (unsigned long)(millis() - sample.uptimeMs));
+        break;
+    }
+    case LINK_MSG_ECHO_SENT:
+        Serial.println("Received: Echo Sent");
+        break;
+    case LINK_MSG_STATUS: {
+        link_status_t status;
+        if (frame.len != sizeof(status)) break;
+        memcpy(&status, frame.payload, sizeof(status));
+        Serial.printf("Received: Status uptime=%lu ms dropped=%lu frame errors=%lu\n",
+                      (unsigned long)status.uptimeMs, (unsigned long)status.rxDropped,
+                      (unsigned long)status.frameErrors);
+        break;
+    }
+    case LINK_MSG_STATS: {
+        link_stats_t stats;
+        if (frame.len != sizeof(stats)) break;
+        memcpy(&stats, frame.payload, sizeof(stats));
+        Serial.printf("Received: Stats tx=%lu dma=%lu copied=%lu rejected=%lu dropped=%lu\n",
+                      (unsigned long)stats.txBytes, (unsigned long)stats.txTransfers,
+                      (unsigned long)stats.txCopied, (unsigned long)stats.txRejected,
+                      (unsigned long)stats.replyDropped);
+        break;
+    }
+    default:
+        Serial.printf("Received: unknown frame type 0x%02X\n", frame.type);
+        break;
+    }
+}
+
+// Read whatever is available in chunks and decode complete frames
+static void receiveFrames() {
+    uint8_t chunk[64];
+    while (SerialSTM32.available()) {
+        size_t n = SerialSTM32.read(chunk, sizeof(chunk));
+        uint16_t off = 0;
+        while (off < n) {
+            uint16_t used;
+            frame_t frame;
+            if (frame_rx_push(&frameRx, &chunk[off], (uint16_t)(n - off), &used, &frame)) {
+                handleFrame(frame);
+            }
+            off += used;
+        }
+    }
+}
+#endif
+
 void loop() {
+#if LINK_BINARY
+    receiveFrames();
+#else
     // Receive data and assemble into messages
     while (SerialSTM32.available()) {
         char c = SerialSTM32.read();
@@ -44,13 +127,24 @@ void loop() {
             }
         }
     }
+#endif
 
     // Send heartbeat every 2 seconds
     static unsigned long lastSend = 0;
     if (millis() - lastSend > 2000) {
+#if LINK_BINARY
+        // Heartbeat carries a sensor sample; ask for the STM32 TX stats every 5th
+        link_sensor_t sample = { (uint32_t)millis(), (int16_t)(temperatureRead() * 100.0f), heartbeatSeq++ };
+        sendFrame(LINK_MSG_HEARTBEAT, &sample, sizeof(sample));
+        if (sample.seq % 5 == 4) {
+            sendFrame(LINK_MSG_STATS_REQ, NULL, 0);
+        }
+        Serial.printf("Sent: Heartbeat seq=%u\n", sample.seq);
+#else
         String heartbeatMsg = "Heartbeat\r\n"; // Heartbeat without prefix
         SerialSTM32.print(heartbeatMsg); // Send without prefix
         Serial.println("Sent: Heartbeat"); // Local display without directional prefix
+#endif
         lastSend = millis();
     }
 }
@@ -1,188 +1,522 @@
 #include "stm32f0xx_hal.h"
 #include <string.h>
 #include <stdbool.h>
-
-#define RXBUF_SIZE 128
-#define TXBUF_SIZE 256 // Increased buffer size
+#include "ringbuf.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "task.h"
+#include "clk.h"
+#include "board.h"
+#include "boot.h"
+#include "link_protocol.h"
+#if LINK_BINARY
+#include "frame.h"
+#endif
+
+#define RXBUF_SIZE BOARD_BUF_SIZE(128) // Power of two, scaled with the RAM
+#define TXBUF_SIZE BOARD_BUF_SIZE(128) // Power of two, only for generated text (literals are sent in place)
 #define MESSAGE_BUFFER_SIZE 64
+BOARD_RAM_ASSERT(RXBUF_SIZE + TXBUF_SIZE + MESSAGE_BUFFER_SIZE);
+#define LINK_TIMEOUT_MS 5000 // No heartbeat for this long: link down (the ESP32 sends one every 2 s)
+
+// Clock profile from lib/clk (8 MHz HSI, no PLL)
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE CLK_LP
+#endif
+
+// Fast boot: "STM32 Ready" right after the clock and a register-level
+// USART1 set-up, the LED and the scheduler after it. Stages: -DBOOT_TRACE=1
+// with a BOOT_PULSE_PORT/PIN, see boot.h
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT 0
+#endif
+
+// Flow control on the link (lib/uart_rx): UART_RX_FLOW_RTS (RTS on PA12,
+// CTS on PA11) or UART_RX_FLOW_XONXOFF (text link only). The peer is
+// stopped at APP_FLOW_HIGH bytes in rxRing and let go at APP_FLOW_LOW
+#ifndef APP_FLOW
+#define APP_FLOW UART_RX_FLOW_NONE
+#endif
+#ifndef APP_FLOW_HIGH
+#define APP_FLOW_HIGH (RXBUF_SIZE / 2)
+#endif
+#ifndef APP_FLOW_LOW
+#define APP_FLOW_LOW (RXBUF_SIZE / 4)
+#endif
+_Static_assert(!(LINK_BINARY && APP_FLOW == UART_RX_FLOW_XONXOFF),
+               "XON/XOFF bytes occur inside binary frames: use UART_RX_FLOW_RTS");
+_Static_assert(APP_FLOW != UART_RX_FLOW_RTS || BOARD_USART1_HAS_FLOW,
+               "RTS/CTS needs the flow control lines of USART1 on " BOARD_NAME);
 
 UART_HandleTypeDef huart1;
-
-volatile uint8_t rxBuf[RXBUF_SIZE];
-volatile uint16_t rxHead = 0, rxTail = 0;
-volatile uint8_t txBuf[TXBUF_SIZE];
-volatile uint16_t txHead = 0, txTail = 0;
-volatile bool txBusy = false;
-uint8_t rxByte;
-
+DMA_HandleTypeDef hdma_usart1_tx;
+
+RINGBUF_DEFINE(rxRing, RXBUF_SIZE);
+RINGBUF_DEFINE(txRing, TXBUF_SIZE);
+uart_tx_t txQueue; // DMA transmit engine (descriptor queue + txRing for copies)
+// Receive engine (IT mode) filling rxRing. Until App_Start() starts it,
+// its IRQ handler only passes the TX interrupts to the HAL
+static uart_rx_t linkRx = { .huart = &huart1, .mode = UART_RX_MODE_IT };
+
+// Tickless scheduler tasks (lib/task): the core sleeps between them
+static task_t ledTask;      // LED blink, 500 ms
+static task_t statusTask;   // Status message, 3 s
+static task_t linkTask;     // Received bytes, posted by the RX interrupt
+static task_t timeoutTask;  // Link watchdog, pushed back by every heartbeat
+static task_t ledOffTask;   // Ends the flash of the link-down LED pattern
+static volatile bool statusRetry; // Status did not fit the TX queue
+static bool linkUp = true;  // Until the first timeout: blink as before
+
+// Replies that did not fit the TX queue wait here for the next TX
+// completion. One of each kind can wait; another one meanwhile is dropped
+#define REPLY_HEARTBEAT (1u << 0)
+#define REPLY_ECHO_SENT (1u << 1)
+#define REPLY_TOO_LONG  (1u << 2) // Text link only
+#define REPLY_STATS     (1u << 3)
+static volatile uint8_t replyRetry;
+static uint32_t replyDrops; // Replies dropped, reported in the stats
+
+#if LINK_BINARY
+// Frame receiver (collects COBS bytes up to the 0x00 delimiter)
+static frame_rx_t frameRx;
+// Heartbeat sample to echo (kept until the echo is queued)
+static uint8_t heartbeatEcho[FRAME_MAX_PAYLOAD];
+static uint8_t heartbeatEchoLen;
+// "Echo Sent" never changes: encoded once, then sent by reference
+static uint8_t echoSentFrame[FRAME_ENCODED_SIZE(0)];
+static uint16_t echoSentLen;
+#else
 // Message buffering for complete messages
 volatile uint8_t messageBuffer[MESSAGE_BUFFER_SIZE];
 volatile uint16_t messageIndex = 0;
+#endif
 
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
-static void UART_Transmit_Data(const char *str);
+#if !LINK_BINARY
+static bool UART_Transmit_Data(const char *str);
+static bool UART_Send_Stats(void);
+#endif
+static void Link_Init(void);
+static void Link_Process(void);
+static bool Link_Send_Status(void);
+static bool Link_Send_Reply(uint8_t reply);
+static void Link_Reply(uint8_t reply);
+static void Link_Retry(void);
+static void Link_Alive(void);
+static void Link_Timeout(void *ctx);
+static void Led_Start(void *ctx);
+static void Led_Toggle(void *ctx);
+static void Led_Flash(void *ctx);
+static void Led_Off(void *ctx);
+static void Status_Task(void *ctx);
+static void Link_Task(void *ctx);
+static void App_Start(void);
+static void Link_Hello(void);
 
 int main(void) {
+    BOOT_START();
     HAL_Init();
+    BOOT_MARK("hal");
     SystemClock_Config();
+    BOOT_MARK("clock");
+#if !APP_FAST_BOOT
     MX_GPIO_Init();
+#endif
+    MX_DMA_Init();
     MX_USART1_UART_Init();
+    uart_tx_init(&txQueue, &huart1, &txRing);
+    Link_Init();
+    BOOT_MARK("usart");
+
+#if APP_FAST_BOOT
+    Link_Hello();
+    BOOT_MARK("hello queued"); // TX DMA started; the wire follows
+    MX_GPIO_Init();
+    App_Start();
+    BOOT_MARK("deferred");
+#else
+    App_Start();
+    BOOT_MARK("scheduler");
+    Link_Hello();
+    BOOT_MARK("hello queued");
+#endif
+    BOOT_DONE();
+
+    // Run due tasks, sleep in WFI until the next deadline or interrupt
+    while (1) {
+        task_run();
+    }
+}
+
+// Scheduler, reception and the periodic tasks
+static void App_Start(void) {
+    // Scheduler on TIM6 replaces the HAL_GetTick() polling: no 1 ms tick
+    task_init();
+    HAL_SuspendTick();
+    task_add(&linkTask, Link_Task, NULL);
+
+    const uart_rx_flow_t flow = {
+        .mode = APP_FLOW,
+        .high = APP_FLOW_HIGH,
+        .low = APP_FLOW_LOW,
+        .rtsPort = BOARD_USART1_RTS_PORT,
+        .rtsPin = BOARD_USART1_RTS_PIN,
+        .tx = &txQueue,
+    };
+    if (uart_rx_start(&linkRx, &huart1, &rxRing, UART_RX_MODE_IT) != HAL_OK ||
+        uart_rx_flow(&linkRx, &flow) != HAL_OK) {
+        while (1);
+    }
 
-    HAL_UART_Receive_IT(&huart1, &rxByte, 1);
+    // LED blink at startup: on for 200 ms, then blink every 500 ms
+    HAL_GPIO_TogglePin(BOARD_LED_PORT, BOARD_LED_PIN);
+    task_after(&ledTask, 200, Led_Start, NULL);
 
-    // LED blink at startup
-    HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-    HAL_Delay(200);
-    HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
+    // Send status every 3 seconds to stagger with heartbeat
+    task_every(&statusTask, 3000, Status_Task, NULL);
+    task_after(&timeoutTask, LINK_TIMEOUT_MS, Link_Timeout, NULL);
+}
 
+// First bytes on the link
+static void Link_Hello(void) {
+#if LINK_BINARY
+    // A lone delimiter makes the ESP32 drop any partial frame it holds
+    static const uint8_t frameSync = 0x00;
+    uart_tx_send_ref(&txQueue, &frameSync, 1, NULL, NULL);
+#else
     // Send startup message
     UART_Transmit_Data("STM32 Ready\r\n");
+#endif
+}
 
-    while (1) {
-        // Process received bytes into complete messages
-        while (rxHead != rxTail) {
-            uint8_t c = rxBuf[rxTail];
-            rxTail = (rxTail + 1) % RXBUF_SIZE;
-
-            if (c == '\r') {
-                // Ignore carriage return
-                continue;
-            }
+// --- Tasks ---
+static void Led_Start(void *ctx) {
+    (void)ctx;
+    HAL_GPIO_TogglePin(BOARD_LED_PORT, BOARD_LED_PIN);
+    task_every(&ledTask, 500, Led_Toggle, NULL);
+}
+
+static void Led_Toggle(void *ctx) {
+    (void)ctx;
+    HAL_GPIO_TogglePin(BOARD_LED_PORT, BOARD_LED_PIN);
+}
+
+// Link down: a 100 ms flash every 2 s
+static void Led_Flash(void *ctx) {
+    (void)ctx;
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_SET);
+    task_after(&ledOffTask, 100, Led_Off, NULL);
+}
 
-            if (c == '\n') {
-                // End of message
-                if (messageIndex > 0) {
-                    messageBuffer[messageIndex] = '\0'; // Null-terminate
+static void Led_Off(void *ctx) {
+    (void)ctx;
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_RESET);
+}
 
-                    // Check if the message is a heartbeat
-                    if (strcmp((char*)messageBuffer, "Heartbeat") == 0) {
-                        // Echo back the heartbeat without prefix
-                        UART_Transmit_Data("Heartbeat\r\n");
-                    }
+static void Status_Task(void *ctx) {
+    (void)ctx;
+    // If the TX queue is full, retry when a transfer completes
+    statusRetry = !Link_Send_Status();
+}
 
-                    // Optionally, send a confirmation message
-                    UART_Transmit_Data("Echo Sent\r\n"); // Echo Sent without prefix
+// Process received bytes (text lines or binary frames)
+static void Link_Task(void *ctx) {
+    (void)ctx;
+    Link_Retry();
+    Link_Process();
+    uart_rx_flow_poll(&linkRx); // Drained: let a stopped peer go on
+}
 
-                    // Reset message index
-                    messageIndex = 0;
+// A heartbeat arrived: push the watchdog back (O(1) on the timer wheel)
+static void Link_Alive(void) {
+    task_after(&timeoutTask, LINK_TIMEOUT_MS, Link_Timeout, NULL);
+    if (!linkUp) {
+        linkUp = true;
+        task_cancel(&ledOffTask);
+        task_every(&ledTask, 500, Led_Toggle, NULL);
+    }
+}
+
+static void Link_Timeout(void *ctx) {
+    (void)ctx;
+    linkUp = false;
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_RESET);
+    task_every(&ledTask, 2000, Led_Flash, NULL);
+}
+
+// Queue a reply. If the TX queue is full, or older replies still wait
+// (they go first), it waits for Link_Retry()
+static void Link_Reply(uint8_t reply) {
+    if ((replyRetry & reply) != 0u) {
+        replyDrops++; // One of this kind is already waiting
+    } else if (replyRetry != 0u || !Link_Send_Reply(reply)) {
+        replyRetry |= reply;
+    }
+}
+
+// Queue the waiting replies; stops at the first that still does not fit
+// (the next TX completion posts the link task again)
+static void Link_Retry(void) {
+    for (uint8_t reply = REPLY_HEARTBEAT; reply <= REPLY_STATS && replyRetry != 0u; reply <<= 1) {
+        if ((replyRetry & reply) != 0u) {
+            if (!Link_Send_Reply(reply)) {
+                return;
+            }
+            replyRetry &= (uint8_t)~reply;
+        }
+    }
+}
+
+#if !LINK_BINARY
+// --- Text link: newline-terminated ASCII ---
+static void Link_Init(void) {
+}
+
+// Assemble received bytes into lines and answer them
+static void Link_Process(void) {
+    uint8_t c;
+    while (ringbuf_get(&rxRing, &c)) {
+        if (c == '\r') {
+            // Ignore carriage return
+            continue;
+        }
+
+        if (c == '\n') {
+            // End of message
+            if (messageIndex > 0) {
+                messageBuffer[messageIndex] = '\0'; // Null-terminate
+
+                // Check if the message is a heartbeat
+                if (strcmp((char*)messageBuffer, "Heartbeat") == 0) {
+                    Link_Alive();
+                    // Echo back the heartbeat without prefix
+                    Link_Reply(REPLY_HEARTBEAT);
+                } else if (strcmp((char*)messageBuffer, "Stats") == 0) {
+                    // Report TX engine counters
+                    Link_Reply(REPLY_STATS);
                 }
+
+                // Optionally, send a confirmation message
+                Link_Reply(REPLY_ECHO_SENT); // Echo Sent without prefix
+
+                // Reset message index
+                messageIndex = 0;
+            }
+        } else {
+            if (messageIndex < (MESSAGE_BUFFER_SIZE - 1)) {
+                // Add to buffer
+                messageBuffer[messageIndex++] = c;
             } else {
-                if (messageIndex < (MESSAGE_BUFFER_SIZE - 1)) {
-                    // Add to buffer
-                    messageBuffer[messageIndex++] = c;
-                } else {
-                    // Buffer overflow handling
-                    UART_Transmit_Data("Error: Msg too long\r\n");
-                    messageIndex = 0;
-                }
+                // Buffer overflow handling
+                Link_Reply(REPLY_TOO_LONG);
+                messageIndex = 0;
             }
         }
+    }
+}
 
-        // Send status every 3 seconds to stagger with heartbeat
-        static uint32_t lastSend = 0;
-        if (HAL_GetTick() - lastSend > 3000) { // 3000ms
-            UART_Transmit_Data("Status: OK\r\n"); // Status message without prefix
-            lastSend = HAL_GetTick();
-        }
+// Status message without prefix
+static bool Link_Send_Status(void) {
+    return UART_Transmit_Data("Status: OK\r\n");
+}
+
+// Queue one reply, false if the TX queue is full
+static bool Link_Send_Reply(uint8_t reply) {
+    switch (reply) {
+    case REPLY_HEARTBEAT:
+        return UART_Transmit_Data("Heartbeat\r\n");
+    case REPLY_ECHO_SENT:
+        return UART_Transmit_Data("Echo Sent\r\n");
+    case REPLY_TOO_LONG:
+        return UART_Transmit_Data("Error: Msg too long\r\n");
+    default:
+        return UART_Send_Stats(); // Built when sent: the counters are current
+    }
+}
+
+#else
+// --- Binary link: COBS frames, see link_protocol.h ---
+// Encode a frame and queue a copy of it
+static bool Link_Send_Frame(uint8_t type, const void *payload, uint8_t len) {
+    uint8_t out[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    size_t n = frame_encode(type, (const uint8_t *)payload, len, out, sizeof(out));
+    return (n != 0u) && uart_tx_write(&txQueue, out, (uint16_t)n);
+}
 
-        // Toggle LED every 500ms
-        static uint32_t lastToggle = 0;
-        if (HAL_GetTick() - lastToggle > 500) {
-            HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-            lastToggle = HAL_GetTick();
+static void Link_Init(void) {
+    frame_rx_init(&frameRx);
+    echoSentLen = (uint16_t)frame_encode(LINK_MSG_ECHO_SENT, NULL, 0,
+                                         echoSentFrame, sizeof(echoSentFrame));
+}
+
+static void Link_Handle_Frame(const frame_t *frame) {
+    switch (frame->type) {
+    case LINK_MSG_HEARTBEAT:
+        Link_Alive();
+        // Echo the sensor sample back unchanged, then confirm. A newer
+        // sample replaces one still waiting for the queue
+        memcpy(heartbeatEcho, frame->payload, frame->len);
+        heartbeatEchoLen = frame->len;
+        Link_Reply(REPLY_HEARTBEAT);
+        Link_Reply(REPLY_ECHO_SENT);
+        break;
+
+    case LINK_MSG_STATS_REQ:
+        Link_Reply(REPLY_STATS);
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Feed whole contiguous spans of the RX ring to the frame receiver
+static void Link_Process(void) {
+    const uint8_t *span;
+    uint16_t avail, used;
+    frame_t frame;
+
+    while ((avail = ringbuf_peek_span(&rxRing, &span)) > 0u) {
+        bool complete = frame_rx_push(&frameRx, span, avail, &used, &frame);
+        ringbuf_skip(&rxRing, used);
+        if (complete) {
+            Link_Handle_Frame(&frame);
         }
     }
 }
 
+static bool Link_Send_Status(void) {
+    link_status_t status = {
+        task_now(), ringbuf_overflows(&rxRing), frameRx.errors + frameRx.overflows
+    };
+    return Link_Send_Frame(LINK_MSG_STATUS, &status, sizeof(status));
+}
+
+// Queue one reply, false if the TX queue is full
+static bool Link_Send_Reply(uint8_t reply) {
+    switch (reply) {
+    case REPLY_HEARTBEAT:
+        return Link_Send_Frame(LINK_MSG_HEARTBEAT, heartbeatEcho, heartbeatEchoLen);
+    case REPLY_ECHO_SENT:
+        return uart_tx_send_ref(&txQueue, echoSentFrame, echoSentLen, NULL, NULL);
+    default: {
+        link_stats_t stats = {
+            txQueue.bytes, txQueue.transfers, txQueue.copied, txQueue.rejected, replyDrops
+        };
+        return Link_Send_Frame(LINK_MSG_STATS, &stats, sizeof(stats));
+    }
+    }
+}
+#endif
+
 // --- UART Interrupt Callbacks ---
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
     if (huart->Instance == USART1) {
-        rxBuf[rxHead] = rxByte;
-        uint16_t nextHead = (rxHead + 1) % RXBUF_SIZE;
-        if (nextHead != rxTail) { // Prevent buffer overflow
-            rxHead = nextHead;
-        } else {
-            // Buffer overflow handling (optional)
-            // Implement logging or additional handling here if needed
-        }
-        HAL_UART_Receive_IT(&huart1, &rxByte, 1);
+        uart_rx_on_cplt(&linkRx); // Dropped and counted if full, XON/XOFF taken out
+        task_post(&linkTask);
     }
 }
 
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
     if (huart->Instance == USART1) {
-        txTail = (txTail + 1) % TXBUF_SIZE; // Move to next byte
-        if (txTail != txHead) {
-            // Cast away volatile to match function signature
-            HAL_UART_Transmit_IT(&huart1, (uint8_t*)&txBuf[txTail], 1);
-        } else {
-            txBusy = false; // TX buffer empty
-        }
+        uart_rx_on_error(&linkRx); // Counts the error, re-arms reception
     }
 }
 
-// --- Helper Functions ---
-static void UART_Transmit_Data(const char *str) {
-    for (uint16_t i = 0; i < strlen(str); i++) {
-        uint16_t nextHead = (txHead + 1) % TXBUF_SIZE;
-        if (nextHead == txTail) {
-            // Buffer is full, handle overflow
-            // For simplicity, skip sending this byte or implement a counter
-            break;
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart->Instance == USART1) {
+        // DMA span is out: release it and start the next one
+        uart_tx_on_cplt(&txQueue);
+        if (statusRetry) {
+            task_post(&statusTask);
+        }
+        if (replyRetry != 0u) {
+            task_post(&linkTask);
         }
-        txBuf[txHead] = str[i];
-        txHead = nextHead;
-    }
-    if (!txBusy) {
-        txBusy = true;
-        HAL_UART_Transmit_IT(&huart1, (uint8_t*)&txBuf[txTail], 1); // Cast away volatile
     }
 }
 
-void SystemClock_Config(void) {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+// --- Helper Functions ---
+#if !LINK_BINARY
+// Queue a string literal for DMA transmit straight from flash (no copy).
+// Returns false (nothing queued) when the TX queue is full, so the caller
+// can retry instead of truncating. Use uart_tx_write() for RAM text that
+// may change before it is sent.
+static bool UART_Transmit_Data(const char *str) {
+    return uart_tx_send_ref(&txQueue, (const uint8_t *)str, (uint16_t)strlen(str), NULL, NULL);
+}
 
-    __HAL_RCC_PWR_CLK_ENABLE();
+// Append an unsigned number in decimal, returns the new end of string
+static char *appendU32(char *p, uint32_t value) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + (value % 10u));
+        value /= 10u;
+    } while (value != 0u);
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
 
-    RCC_OscInitStruct.OscillatorType = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState = RCC_PLL_NONE;
-    HAL_RCC_OscConfig(&RCC_OscInitStruct);
+// "Stats: tx=<bytes> dma=<transfers> copied=<bytes> rejected=<writes> dropped=<replies>"
+static bool UART_Send_Stats(void) {
+    char msg[96];
+    char *p = msg;
+    memcpy(p, "Stats: tx=", 10); p += 10;
+    p = appendU32(p, txQueue.bytes);
+    memcpy(p, " dma=", 5); p += 5;
+    p = appendU32(p, txQueue.transfers);
+    memcpy(p, " copied=", 8); p += 8;
+    p = appendU32(p, txQueue.copied);
+    memcpy(p, " rejected=", 10); p += 10;
+    p = appendU32(p, txQueue.rejected);
+    memcpy(p, " dropped=", 9); p += 9;
+    p = appendU32(p, replyDrops);
+    memcpy(p, "\r\n", 2); p += 2;
+    return uart_tx_write(&txQueue, (const uint8_t *)msg, (uint16_t)(p - msg)); // msg is on the stack: copy
+}
+#endif
 
-    RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
-    RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0);
+// System clock configuration: APP_CLK_PROFILE
+void SystemClock_Config(void) {
+#if APP_FAST_BOOT
+    if (APP_CLK_PROFILE == CLK_LP) {
+        return; // The reset clock: HSI on, no PLL, no wait state
+    }
+#endif
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK) {
+        while (1);
+    }
 }
 
 static void MX_GPIO_Init(void) {
-    __HAL_RCC_GPIOA_CLK_ENABLE();
+    board_led_init();
+}
+
+static void MX_DMA_Init(void) {
+#if !APP_FAST_BOOT
+    __HAL_RCC_DMA1_CLK_ENABLE(); // A fast boot has board_boot_init() do it
+#endif
 
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = GPIO_PIN_5;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
+    // USART1 TX is on DMA1 Channel2
+    HAL_NVIC_SetPriority(BOARD_USART1_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(BOARD_USART1_DMA_IRQn);
 }
 
 static void MX_USART1_UART_Init(void) {
-    __HAL_RCC_USART1_CLK_ENABLE();
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = GPIO_PIN_9 | GPIO_PIN_10;
-    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+#if APP_FAST_BOOT
+    board_boot_init(USART1); // Clocks and pins by register
+#else
+    board_uart_pins_init(USART1);
+#endif
+    if (APP_FLOW == UART_RX_FLOW_RTS) {
+        board_uart_flow_init(); // RTS stays high until App_Start()
+    }
 
     huart1.Instance = USART1;
     huart1.Init.BaudRate = 115200;
@@ -190,16 +524,44 @@ static void MX_USART1_UART_Init(void) {
     huart1.Init.StopBits = UART_STOPBITS_1;
     huart1.Init.Parity = UART_PARITY_NONE;
     huart1.Init.Mode = UART_MODE_TX_RX;
-    huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    huart1.Init.HwFlowCtl = (APP_FLOW == UART_RX_FLOW_RTS) ? UART_HWCONTROL_CTS : UART_HWCONTROL_NONE;
     huart1.Init.OverSampling = UART_OVERSAMPLING_16;
-    HAL_UART_Init(&huart1);
+#if APP_FAST_BOOT
+    if (boot_uart_init(&huart1) != HAL_OK) {
+#else
+    if (HAL_UART_Init(&huart1) != HAL_OK) {
+#endif
+        while (1);
+    }
+
+    hdma_usart1_tx.Instance = BOARD_USART1_TX_DMA;
+    hdma_usart1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_usart1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_usart1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.Mode = DMA_NORMAL;
+    hdma_usart1_tx.Init.Priority = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK) {
+        while (1);
+    }
+    BOARD_DMA_ROUTE(BOARD_USART1_TX_REQ);
+    __HAL_LINKDMA(&huart1, hdmatx, hdma_usart1_tx);
 
     HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USART1_IRQn);
 }
 
 void USART1_IRQHandler(void) {
-    HAL_UART_IRQHandler(&huart1);
+    uart_rx_irq(&linkRx); // Sends a pending XON/XOFF, the rest goes to the HAL
+}
+
+void BOARD_USART1_DMA_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&hdma_usart1_tx);
+}
+
+void TIM6_IRQHandler(void) {
+    task_timer_irq();
 }
 
 void SysTick_Handler(void) {
@@ -0,0 +1,55 @@
+/*
+ * File: link_protocol.h
+ * Project: STM32 PlatformIO Playground - STM32F030 <-> ESP32-C3 UART link
+ * Description:
+ * Message types and payloads of the binary link mode (LINK_BINARY=1),
+ * shared by STM32F030_UART and ESP32C3_UART. Frames are built with the
+ * shared lib/frame (COBS + CRC-16).
+ *
+ * Payloads are little-endian, which both MCUs are natively. Copy them in
+ * and out with memcpy: the payload inside a frame is not aligned, and the
+ * Cortex-M0 faults on unaligned word loads.
+ */
+
+#ifndef LINK_PROTOCOL_H
+#define LINK_PROTOCOL_H
+
+#include <stdint.h>
+
+/* 0 = newline-terminated text (default), 1 = COBS frames. Both sides must match. */
+#ifndef LINK_BINARY
+#define LINK_BINARY 0
+#endif
+
+/* Message types */
+#define LINK_MSG_HEARTBEAT  0x01  // ESP32 -> STM32, echoed back unchanged. link_sensor_t
+#define LINK_MSG_ECHO_SENT  0x02  // STM32 -> ESP32 after each heartbeat, no payload
+#define LINK_MSG_STATUS     0x03  // STM32 -> ESP32 every 3 s. link_status_t
+#define LINK_MSG_STATS_REQ  0x04  // ESP32 -> STM32, no payload
+#define LINK_MSG_STATS      0x05  // STM32 -> ESP32. link_stats_t
+
+/* Heartbeat: a sensor sample from the ESP32 */
+typedef struct
+{
+    uint32_t uptimeMs;
+    int16_t  tempCx100;     // Die temperature in 0.01 degC
+    uint16_t seq;
+} link_sensor_t;
+
+typedef struct
+{
+    uint32_t uptimeMs;
+    uint32_t rxDropped;     // Bytes lost in the STM32 RX ring
+    uint32_t frameErrors;   // Frames rejected (COBS / length / CRC)
+} link_status_t;
+
+typedef struct
+{
+    uint32_t txBytes;
+    uint32_t txTransfers;
+    uint32_t txCopied;
+    uint32_t txRejected;
+    uint32_t replyDropped;  // Replies dropped while one of the kind waited for the queue
+} link_stats_t;
+
+#endif /* LINK_PROTOCOL_H */
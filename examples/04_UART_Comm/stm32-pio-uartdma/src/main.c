@@ -1,6 +1,10 @@
 #include "stm32f0xx_hal.h"
 #include <string.h>   // for strlen, memcpy
 #include <stdbool.h>  // for bool
+#include "ringbuf.h"
+#include "uart_tx.h"
+#include "clk.h"
+#include "board.h"
 
 /* -------------------------------------------------------------------------
    Global Handles & Buffers
@@ -9,20 +13,44 @@ UART_HandleTypeDef huart1;
 DMA_HandleTypeDef hdma_usart1_tx;
 DMA_HandleTypeDef hdma_usart1_rx;
 
-/* We'll receive exactly 4 bytes, then echo them. */
-#define RX_SIZE 4
-
-/* The initial greeting message to send at startup */
-static uint8_t txGreeting[] = "DMA UART Demo: Send 4 bytes to see LED toggle + echo!\r\n";
-
-/* Buffer to hold the 4 incoming bytes */
-static uint8_t rxBuffer[RX_SIZE];
-
-/* We’ll build an echoed message by appending \r\n to the 4 bytes */
-static uint8_t txEchoBuf[RX_SIZE + 2];
-
-/* Flag to indicate if a DMA TX is currently in progress */
-volatile bool txInProgress = false;
+/*
+ * Receive packets of any length into a ring of RX_BUF_COUNT buffers: the
+ * DMA fills one while the main loop echoes the oldest finished ones. A
+ * packet ends when the line goes idle for one character time, or when the
+ * buffer is full (longer packets continue in the next buffer). With three
+ * buffers the DMA still has one to go on with while the main loop waits
+ * for echo queue space with one and the next is already full.
+ */
+#define RX_BUF_SIZE  64   // Max bytes per DMA reception
+#define RX_BUF_COUNT 3
+#define RX_NEXT(i)   (((i) + 1u == RX_BUF_COUNT) ? 0u : (uint8_t)((i) + 1u))
+#define TXBUF_SIZE  BOARD_BUF_SIZE(256)   // Echo queue (power of two, scaled with the RAM)
+BOARD_RAM_ASSERT(RX_BUF_COUNT * RX_BUF_SIZE + TXBUF_SIZE);
+
+/* Clock profile from lib/clk (8 MHz HSI, no PLL) */
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE CLK_LP
+#endif
+
+/* The initial greeting message to send at startup (sent from flash) */
+static const uint8_t txGreeting[] = "DMA UART Demo: Send any text to see LED toggle + echo!\r\n";
+
+/* Receive buffers; rxLen[i] != 0 means buffer i holds a packet */
+static uint8_t rxBuf[RX_BUF_COUNT][RX_BUF_SIZE];
+static volatile uint16_t rxLen[RX_BUF_COUNT];
+static volatile uint8_t rxActive = 0;   // Buffer the DMA is filling
+static uint8_t rxProcess = 0;           // Next buffer the main loop echoes
+
+/* Echo queue: packets are copied here and sent by DMA in order */
+RINGBUF_DEFINE(txRing, TXBUF_SIZE);
+static uart_tx_t uartTx;
+
+/* Counters (watch them in the debugger) */
+volatile uint32_t rxPackets  = 0;   // Idle-line / buffer-full events
+volatile uint32_t rxBytes    = 0;
+volatile uint32_t rxOverruns = 0;   // Packets lost: every other buffer was still full
+volatile uint32_t echoTrimmed = 0;  // Line ends left out because the echo queue was filling up
+volatile uint32_t rxErrors   = 0;   // Line errors reported by the HAL
 
 /* -------------------------------------------------------------------------
    Function Prototypes
@@ -31,6 +59,8 @@ void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
+static HAL_StatusTypeDef Start_Rx(void);
+static bool Echo_Packet(const uint8_t *data, uint16_t len);
 
 /* -------------------------------------------------------------------------
    main()
@@ -47,62 +77,106 @@ int main(void)
     MX_GPIO_Init();
     MX_DMA_Init();
     MX_USART1_UART_Init();
+    uart_tx_init(&uartTx, &huart1, &txRing);
 
-    /* 4. Transmit a greeting message once via DMA */
-    txInProgress = true;
-    if (HAL_UART_Transmit_DMA(&huart1, txGreeting, strlen((char*)txGreeting)) != HAL_OK)
-    {
-        /* If TX start fails, stay here */
-        while (1);
-    }
+    /* 4. Queue the greeting (DMA reads it straight from flash) */
+    uart_tx_send_ref(&uartTx, txGreeting, sizeof(txGreeting) - 1, NULL, NULL);
 
-    /* 5. Start a DMA-based reception of 4 bytes */
-    if (HAL_UART_Receive_DMA(&huart1, rxBuffer, RX_SIZE) != HAL_OK)
+    /* 5. Start variable-length reception into the first buffer */
+    if (Start_Rx() != HAL_OK)
     {
         /* If RX start fails, stay here */
         while (1);
     }
 
-    /* 6. Main loop does nothing else. 
-          LED toggles & echo happen in the RX callback. */
+    /* 6. Echo completed packets in the order they arrived */
     while (1)
     {
-        // Idle. Everything is callback-driven.
+        uint16_t len = rxLen[rxProcess];
+        if (len != 0u)
+        {
+            /* If the echo queue is full, keep the buffer and retry */
+            if (Echo_Packet(rxBuf[rxProcess], len))
+            {
+                HAL_GPIO_TogglePin(BOARD_LED_PORT, BOARD_LED_PIN);
+                rxLen[rxProcess] = 0;       // Hand the buffer back to the DMA
+                rxProcess = RX_NEXT(rxProcess);
+            }
+        }
     }
 }
 
 /* -------------------------------------------------------------------------
-   SystemClock_Config
-   Using HSI (8 MHz) as system clock, no PLL.
+   Start_Rx
+   Receive into the active buffer until idle line or buffer full. In normal
+   DMA mode the HAL would also report the half-transfer point, which is not
+   a packet boundary, so that interrupt is switched off.
 -------------------------------------------------------------------------- */
-void SystemClock_Config(void)
+static HAL_StatusTypeDef Start_Rx(void)
+{
+    HAL_StatusTypeDef status = HAL_UARTEx_ReceiveToIdle_DMA(&huart1, rxBuf[rxActive], RX_BUF_SIZE);
+    if (status == HAL_OK)
+    {
+        __HAL_DMA_DISABLE_IT(&hdma_usart1_rx, DMA_IT_HT);
+    }
+    return status;
+}
+
+/* -------------------------------------------------------------------------
+   Echo_Packet
+   Copy the packet into the echo queue, plus \r\n if it ended at an idle
+   line without a line end of its own (a buffer-full packet goes on in the
+   next one). The line end is appended here and both go in with a single
+   write: written separately, the packet would start on an idle queue and
+   the \r\n follow as a second transfer. One DMA transfer then (two if the
+   packet wraps around the end of the ring).
+
+   The \r\n makes the echo longer than the input, so back-to-back short
+   packets would send faster than the line can. It is only added while
+   the queue keeps room for another full packet after it: once the queue
+   backs up, the output falls back to the input rate and no packet is lost
+   (echoTrimmed counts the line ends left out).
+-------------------------------------------------------------------------- */
+static bool Echo_Packet(const uint8_t *data, uint16_t len)
 {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    /* Enable power clock */
-    __HAL_RCC_PWR_CLK_ENABLE();
-
-    /* 1) HSI on, no PLL */
-    RCC_OscInitStruct.OscillatorType       = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState            = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState        = RCC_PLL_NONE;
-    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    static uint8_t echo[RX_BUF_SIZE + 2u];
+    bool lineEnd = len < RX_BUF_SIZE && data[len - 1u] != '\r' && data[len - 1u] != '\n';
+    uint16_t room = uart_tx_free(&uartTx);
+    uint16_t out = len;
+
+    if (room < len || uart_tx_slots(&uartTx) < 2u)
     {
-        while (1); // Error
+        uart_tx_poll(&uartTx);  // Restarts the queue if the HAL refused a transfer
+        return false;
+    }
+
+    memcpy(echo, data, len);
+    if (lineEnd)
+    {
+        /* Room for the line end and a whole packet after it */
+        if (room >= len + 2u * 2u + RX_BUF_SIZE)
+        {
+            echo[out++] = '\r';
+            echo[out++] = '\n';
+        }
+        else
+        {
+            echoTrimmed++;
+        }
     }
+    uart_tx_write(&uartTx, echo, out);
+    return true;
+}
 
-    /* 2) Set SYSCLK source, no division */
-    RCC_ClkInitStruct.ClockType      = (RCC_CLOCKTYPE_SYSCLK | 
-                                        RCC_CLOCKTYPE_HCLK   | 
-                                        RCC_CLOCKTYPE_PCLK1);
-    RCC_ClkInitStruct.SYSCLKSource   = RCC_SYSCLKSOURCE_HSI;
-    RCC_ClkInitStruct.AHBCLKDivider  = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK)
+/* -------------------------------------------------------------------------
+   SystemClock_Config
+   APP_CLK_PROFILE from lib/clk: HSI (8 MHz), no PLL by default.
+-------------------------------------------------------------------------- */
+void SystemClock_Config(void)
+{
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK)
     {
-        while (1); // Error
+        while (1);
     }
 }
 
@@ -113,17 +187,7 @@ void SystemClock_Config(void)
 -------------------------------------------------------------------------- */
 static void MX_GPIO_Init(void)
 {
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin   = GPIO_PIN_5;
-    GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull  = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-
-    /* Start LED off */
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
+    board_led_init();
 }
 
 /* -------------------------------------------------------------------------
@@ -136,8 +200,8 @@ static void MX_DMA_Init(void)
     __HAL_RCC_DMA1_CLK_ENABLE();
 
     /* NVIC config for DMA1 Channel 2 & 3 */
-    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
-    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+    HAL_NVIC_SetPriority(BOARD_USART1_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(BOARD_USART1_DMA_IRQn);
 }
 
 /* -------------------------------------------------------------------------
@@ -150,17 +214,7 @@ static void MX_DMA_Init(void)
 -------------------------------------------------------------------------- */
 static void MX_USART1_UART_Init(void)
 {
-    /* Enable USART1 clock */
-    __HAL_RCC_USART1_CLK_ENABLE();
-
-    /* Configure PA9 and PA10 in Alternate Function mode for USART1 */
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
-    GPIO_InitStruct.Mode      = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull      = GPIO_NOPULL;
-    GPIO_InitStruct.Speed     = GPIO_SPEED_FREQ_LOW;
-    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    board_uart_pins_init(USART1);
 
     /* Basic UART param config */
     huart1.Instance          = USART1;
@@ -179,7 +233,7 @@ static void MX_USART1_UART_Init(void)
     /* ----------------------
        DMA for TX (Channel 2)
        ---------------------- */
-    hdma_usart1_tx.Instance                 = DMA1_Channel2;
+    hdma_usart1_tx.Instance                 = BOARD_USART1_TX_DMA;
     hdma_usart1_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
     hdma_usart1_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
     hdma_usart1_tx.Init.MemInc              = DMA_MINC_ENABLE;
@@ -192,31 +246,45 @@ static void MX_USART1_UART_Init(void)
         while (1);
     }
     /* Link TX DMA to UART1 */
+    BOARD_DMA_ROUTE(BOARD_USART1_TX_REQ);
     __HAL_LINKDMA(&huart1, hdmatx, hdma_usart1_tx);
 
     /* ----------------------
        DMA for RX (Channel 3)
        ---------------------- */
-    hdma_usart1_rx.Instance                 = DMA1_Channel3;
+    hdma_usart1_rx.Instance                 = BOARD_USART1_RX_DMA;
     hdma_usart1_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
     hdma_usart1_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
     hdma_usart1_rx.Init.MemInc              = DMA_MINC_ENABLE;
     hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart1_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
     hdma_usart1_rx.Init.Mode                = DMA_NORMAL;
-    hdma_usart1_rx.Init.Priority            = DMA_PRIORITY_LOW;
+    hdma_usart1_rx.Init.Priority            = DMA_PRIORITY_HIGH;
     if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
     {
         while (1);
     }
     /* Link RX DMA to UART1 */
+    BOARD_DMA_ROUTE(BOARD_USART1_RX_REQ);
     __HAL_LINKDMA(&huart1, hdmarx, hdma_usart1_rx);
+
+    /* USART1 IRQ delivers the idle-line event */
+    HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+}
+
+/* -------------------------------------------------------------------------
+   USART1 IRQ Handler (idle line, errors)
+-------------------------------------------------------------------------- */
+void USART1_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&huart1);
 }
 
 /* -------------------------------------------------------------------------
    DMA IRQ Handler for Channels 2 & 3
 -------------------------------------------------------------------------- */
-void DMA1_Channel2_3_IRQHandler(void)
+void BOARD_USART1_DMA_IRQHandler(void)
 {
     HAL_DMA_IRQHandler(&hdma_usart1_tx);
     HAL_DMA_IRQHandler(&hdma_usart1_rx);
@@ -226,47 +294,54 @@ void DMA1_Channel2_3_IRQHandler(void)
    UART Callbacks
 -------------------------------------------------------------------------- */
 
-/* TX Complete Callback */
+/* TX Complete Callback: release the sent echo and start the next one */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART1)
     {
-        txInProgress = false;
+        uart_tx_on_cplt(&uartTx);
+    }
+}
 
-        /* // Another debug message:
-        char doneMsg[] = "DMA TX complete.\r\n";
-        HAL_UART_Transmit(huart, (uint8_t*)doneMsg, strlen(doneMsg), HAL_MAX_DELAY); */
+/*
+ * RX Event Callback: the line went idle (or the buffer filled) after Size
+ * bytes. Switch the DMA to the other buffer right away so no byte is
+ * missed, and leave this one to the main loop.
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart->Instance == USART1)
+    {
+        uint8_t done = rxActive;
+        uint8_t next = RX_NEXT(done);
 
+        rxPackets++;
+        rxBytes += Size;
+
+        if (rxLen[next] == 0u)
+        {
+            rxLen[done] = Size;
+            rxActive    = next;
+        }
+        else
+        {
+            /* Main loop still holds the next buffer: drop this packet */
+            rxOverruns++;
+        }
+        Start_Rx();
     }
 }
 
-/* RX Complete Callback (4 bytes arrived) */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+/* Error Callback: count it; restart RX if the HAL aborted the reception */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART1)
     {
-        /* Toggle LED so we know 4 bytes arrived */
-        HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-        /* 
-        // ---- Blocking debug print ---- 
-        char debugMsg[] = "Got 4 bytes! Echoing...\r\n";
-        // Blocking transmit to ensure it definitely appears if TX lines are correct
-        HAL_UART_Transmit(huart, (uint8_t*)debugMsg, strlen(debugMsg), HAL_MAX_DELAY); */
-
-        /* Build an echo with \r\n appended */
-        memcpy(txEchoBuf, rxBuffer, RX_SIZE);
-        txEchoBuf[RX_SIZE]   = '\r';
-        txEchoBuf[RX_SIZE+1] = '\n';
-
-        /* Send that echo if TX is free */
-        if (!txInProgress)
+        rxErrors++;
+        if (huart->RxState == HAL_UART_STATE_READY)
         {
-            txInProgress = true;
-            HAL_UART_Transmit_DMA(&huart1, txEchoBuf, RX_SIZE + 2);
+            Start_Rx();
         }
-
-        /* Restart RX for another 4 bytes */
-        HAL_UART_Receive_DMA(&huart1, rxBuffer, RX_SIZE);
     }
 }
 
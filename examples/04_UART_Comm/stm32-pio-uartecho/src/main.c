@@ -1,13 +1,41 @@
 #include "stm32f0xx_hal.h"
 #include <string.h>
+#include "task.h"
+#include "hwio.h"
+#include "prof.h"
+#include "clk.h"
+#include "board.h"
+
+#define ECHO_POLL_MS 1U // Receive polling period: RDR holds one byte, a second one between polls is lost
+
+/* Clock profile from lib/clk (8 MHz HSI, no PLL) */
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE CLK_LP
+#endif
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
 
+/* LED and console through lib/hwio: registers, LL or HAL per HW_BACKEND */
+static const hw_pin_t led = HW_PIN(BOARD_LED_PORT, BOARD_LED_PIN_NUM);
+static const hw_uart_t console = HW_UART(USART1, &huart1);
+
+/* Profiled regions (build with -DPROF_ENABLE=1) */
+enum { PROF_TOGGLE, PROF_PUTC, PROF_COUNT };
+
+/* Tasks of the tickless scheduler (lib/task) */
+static task_t blinkTask;
+static task_t echoTask;
+
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_USART1_UART_Init(void);
+static void Blink(void *ctx);
+static void Echo(void *ctx);
+#if PROF_ENABLE
+static void MeasureBackend(void);
+#endif
 
 /**
   * @brief  The application entry point.
@@ -26,55 +54,126 @@ int main(void)
 
     /* 4. Print "UART is initialised" message */
     const char *initMsg = "UART is initialised\r\n";
-    HAL_UART_Transmit(&huart1, (uint8_t *)initMsg, strlen(initMsg), HAL_MAX_DELAY);
-
-    /* 5. Main loop: blink LED and do echo */
+    hw_uart_write(console, initMsg, strlen(initMsg));
+#if PROF_ENABLE
+    MeasureBackend();
+#endif
+
+    /* 5. Scheduler on TIM6 replaces HAL_Delay(): stop the 1 ms SysTick */
+    task_init();
+    HAL_SuspendTick();
+    task_every(&blinkTask, 500, Blink, NULL);
+    task_every(&echoTask, ECHO_POLL_MS, Echo, NULL);
+
+    /* 6. Main loop: run due tasks, sleep in WFI until the next one */
     while (1)
     {
-        /* A) Toggle the user LED on PA5 every 500ms */
-        HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-        HAL_Delay(500);
-
-        /* B) Echo any received bytes (non-blocking check) */
-        uint8_t rxByte;
-        if (HAL_UART_Receive(&huart1, &rxByte, 1, 1) == HAL_OK)
-        {
-            HAL_UART_Transmit(&huart1, &rxByte, 1, HAL_MAX_DELAY);
-        }
+        task_run();
     }
 }
 
 /**
-  * @brief  System Clock Configuration
-  *         HSI = 8 MHz, no PLL, SysClk = 8 MHz.
+  * @brief  Toggle the user LED on PA5 (every 500 ms)
   */
-void SystemClock_Config(void)
+static void Blink(void *ctx)
+{
+    (void)ctx;
+    hw_pin_toggle(led);
+}
+
+/**
+  * @brief  Poll USART1 and send back the received byte (every ECHO_POLL_MS)
+  */
+static void Echo(void *ctx)
 {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    /* Enable PWR clock */
-    __HAL_RCC_PWR_CLK_ENABLE();
-
-    /* 1) Configure HSI oscillator */
-    RCC_OscInitStruct.OscillatorType       = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState            = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState        = RCC_PLL_NONE; // No PLL
-    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    uint8_t c;
+
+    (void)ctx;
+    /* Timeout 0: take what RDR holds now, never wait */
+    while (HAL_UART_Receive(&huart1, &c, 1, 0) == HAL_OK)
     {
-        /* Initialization Error */
-        while (1);
+        hw_uart_putc(console, c);
     }
+    /* Bytes that came faster than the polls were lost; keep receiving */
+    __HAL_UART_CLEAR_OREFLAG(&huart1);
+}
 
-    /* 2) Initialize CPU, AHB, and APB clocks to 8MHz */
-    RCC_ClkInitStruct.ClockType      = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource   = RCC_SYSCLKSOURCE_HSI;  // 8MHz
-    RCC_ClkInitStruct.AHBCLKDivider  = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK)
+#if PROF_ENABLE
+static void PrintU32(uint32_t v)
+{
+    char buf[10];
+    uint8_t n = 0;
+
+    do
+    {
+        buf[n++] = (char)('0' + v % 10U);
+        v /= 10U;
+    } while (v != 0U);
+    while (n != 0U)
+    {
+        hw_uart_putc(console, (uint8_t)buf[--n]);
+    }
+}
+
+static void PrintStat(const char *name, uint8_t region)
+{
+    prof_stat_t st;
+
+    if (prof_get(region, &st))
+    {
+        hw_uart_write(console, name, strlen(name));
+        PrintU32(st.min);
+        hw_uart_write(console, " avg ", 5);
+        PrintU32(st.sum / st.count);
+        hw_uart_write(console, " max ", 5);
+        PrintU32(st.max);
+        hw_uart_write(console, " cycles\r\n", 9);
+    }
+}
+
+/**
+  * @brief  Time one LED toggle and one byte sent with an empty TDR, 16 times
+  *         each, and print the cycles for the backend this build uses
+  */
+static void MeasureBackend(void)
+{
+    const char *backend = hw_backend_name();
+
+    PROF_INIT();
+    for (uint8_t i = 0; i < 16U; i++)
+    {
+        PROF_BEGIN(PROF_TOGGLE);
+        hw_pin_toggle(led);
+        PROF_END(PROF_TOGGLE);
+    }
+    for (uint8_t i = 0; i < 16U; i++)
+    {
+        hw_uart_flush(console);
+        PROF_BEGIN(PROF_PUTC);
+        hw_uart_putc(console, '.');
+        PROF_END(PROF_PUTC);
+    }
+    hw_uart_write(console, "\r\nhwio ", 7);
+    hw_uart_write(console, backend, strlen(backend));
+    hw_uart_write(console, "\r\n", 2);
+    PrintStat("toggle: min ", PROF_TOGGLE);
+    PrintStat("putc:   min ", PROF_PUTC);
+}
+#endif
+
+void TIM6_IRQHandler(void)
+{
+    task_timer_irq();
+}
+
+/**
+  * @brief  System Clock Configuration
+  *         APP_CLK_PROFILE: HSI = 8 MHz, no PLL, SysClk = 8 MHz by default.
+  */
+void SystemClock_Config(void)
+{
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK)
     {
-        /* Initialization Error */
         while (1);
     }
 }
@@ -85,20 +184,7 @@ void SystemClock_Config(void)
   */
 static void MX_GPIO_Init(void)
 {
-    /* Enable GPIOA clock */
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-
-    /* Configure PA5 for the user LED */
-    GPIO_InitStruct.Pin   = GPIO_PIN_5;
-    GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull  = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-
-    /* Optional: start with LED off */
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
+    board_led_init();
 }
 
 /**
@@ -106,18 +192,7 @@ static void MX_GPIO_Init(void)
   */
 static void MX_USART1_UART_Init(void)
 {
-    /* Enable USART1 and GPIOA clocks */
-    __HAL_RCC_USART1_CLK_ENABLE();
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    /* Configure PA9 (TX) and PA10 (RX) in Alternate Function (AF1) */
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
-    GPIO_InitStruct.Mode      = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull      = GPIO_NOPULL;
-    GPIO_InitStruct.Speed     = GPIO_SPEED_FREQ_LOW;
-    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    board_uart_pins_init(USART1);
 
     /* Configure the UART parameters */
     huart1.Instance          = USART1;
@@ -140,6 +215,7 @@ static void MX_USART1_UART_Init(void)
    --------------------------------------------------------------------------
    By default, STM32Cube projects include a weak SysTick_Handler() that calls 
    HAL_IncTick(). If yours doesn't, or if you need to override it, do:
+   (the tick only runs until the scheduler starts)
 */
 
 void SysTick_Handler(void)
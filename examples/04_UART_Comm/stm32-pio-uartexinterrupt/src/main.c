@@ -1,5 +1,17 @@
 #include "stm32f0xx_hal.h"
 #include <string.h>
+#include <stdbool.h>
+#include "ringbuf.h"
+#include "task.h"
+#include "clk.h"
+#include "board.h"
+
+#define TXBUF_SIZE BOARD_BUF_SIZE(64) // Echo queue size (power of two, scaled with the RAM)
+
+/* Clock profile from lib/clk (8 MHz HSI, no PLL) */
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE CLK_LP
+#endif
 
 /* --------------------------------------------------------------------------
    Global variables
@@ -9,17 +21,26 @@ UART_HandleTypeDef huart1;
 /* We'll store one incoming byte in this buffer for each interrupt */
 volatile uint8_t rxByte = 0;
 
+/* Echo queue: bytes received while a transmit is still running wait here */
+RINGBUF_DEFINE(txRing, TXBUF_SIZE);
+volatile bool txBusy = false;
+
+/* LED blink, a periodic task of the tickless scheduler (lib/task) */
+static task_t blinkTask;
+
 /* Function Prototypes */
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_USART1_UART_Init(void);
+static void UART_Start_Next_Tx(void);
+static void Blink(void *ctx);
 
 /* --------------------------------------------------------------------------
    main()
    -------------------------------------------------------------------------- */
 int main(void)
 {
-    /* 1. Initialize HAL (including SysTick for HAL_Delay) */
+    /* 1. Initialize HAL (including SysTick, used until the scheduler starts) */
     HAL_Init();
 
     /* 2. Configure system clock (8 MHz HSI, no PLL) */
@@ -36,48 +57,35 @@ int main(void)
     /* 5. Start the first receive interrupt for 1 byte */
     HAL_UART_Receive_IT(&huart1, (uint8_t *)&rxByte, 1);
 
-    /* 6. Main loop */
+    /* 6. Blink LED every 500 ms so we know MCU is running: TIM6 wakes the
+          core for each toggle, the 1 ms SysTick is not needed any more */
+    task_init();
+    HAL_SuspendTick();
+    task_every(&blinkTask, 500, Blink, NULL);
+
+    /* 7. Main loop: sleep until the next toggle or UART interrupt */
     while (1)
     {
-        /* Blink LED every 500 ms so we know MCU is running */
-        HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
-        HAL_Delay(500);
+        task_run();
     }
 }
 
+static void Blink(void *ctx)
+{
+    (void)ctx;
+    HAL_GPIO_TogglePin(BOARD_LED_PORT, BOARD_LED_PIN);
+}
+
 /* --------------------------------------------------------------------------
    System Clock Configuration
    --------------------------------------------------------------------------
-   HSI = 8 MHz, no PLL => SystemCoreClock=8 MHz
-   Adjust if you want 48 MHz by enabling PLL, etc.
+   APP_CLK_PROFILE from lib/clk: HSI = 8 MHz, no PLL by default
+   (-DAPP_CLK_PROFILE=CLK_PERF for 48 MHz from the PLL)
 -------------------------------------------------------------------------- */
 void SystemClock_Config(void)
 {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
-
-    /* Enable power interface clock */
-    __HAL_RCC_PWR_CLK_ENABLE();
-
-    /* 1) Initialize the RCC Oscillators (HSI) */
-    RCC_OscInitStruct.OscillatorType       = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState            = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState        = RCC_PLL_NONE;
-    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK)
     {
-        /* Initialization Error */
-        while (1);
-    }
-
-    /* 2) Initialize the CPU, AHB, and APB busses clocks */
-    RCC_ClkInitStruct.ClockType      = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1;
-    RCC_ClkInitStruct.SYSCLKSource   = RCC_SYSCLKSOURCE_HSI; // 8 MHz
-    RCC_ClkInitStruct.AHBCLKDivider  = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK)
-    {
-        /* Initialization Error */
         while (1);
     }
 }
@@ -90,20 +98,7 @@ void SystemClock_Config(void)
 -------------------------------------------------------------------------- */
 static void MX_GPIO_Init(void)
 {
-    /* Enable GPIOA clock */
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-
-    /* Configure PA5 for the user LED (Push-Pull, no Pull-up) */
-    GPIO_InitStruct.Pin   = GPIO_PIN_5;
-    GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull  = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
-
-    /* Start with LED off */
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
+    board_led_init();
 }
 
 /* --------------------------------------------------------------------------
@@ -115,18 +110,8 @@ static void MX_GPIO_Init(void)
 -------------------------------------------------------------------------- */
 static void MX_USART1_UART_Init(void)
 {
-    /* 1) Enable clocks */
-    __HAL_RCC_USART1_CLK_ENABLE();
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    /* 2) Configure GPIO pins for TX & RX in AF mode */
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
-    GPIO_InitStruct.Mode      = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull      = GPIO_NOPULL;
-    GPIO_InitStruct.Speed     = GPIO_SPEED_FREQ_LOW;
-    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    /* 1-2) Clocks and TX/RX pins in AF1 (board.h) */
+    board_uart_pins_init(USART1);
 
     /* 3) Configure UART parameters */
     huart1.Instance          = USART1;
@@ -156,8 +141,12 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART1)
     {
-        /* Echo the received byte back (non-blocking) */
-        HAL_UART_Transmit_IT(&huart1, (uint8_t *)&rxByte, 1);
+        /* Queue the byte for echo (non-blocking), start TX if idle */
+        ringbuf_put(&txRing, rxByte);
+        if (!txBusy)
+        {
+            UART_Start_Next_Tx();
+        }
 
         /* Prepare to receive next byte */
         HAL_UART_Receive_IT(&huart1, (uint8_t *)&rxByte, 1);
@@ -167,11 +156,35 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 /* --------------------------------------------------------------------------
    UART Transmit Complete Callback
    --------------------------------------------------------------------------
-   You can add code here if you need to do something after a transmit finishes.
+   The echoed byte is out: drop it from the queue and send the next one.
 -------------------------------------------------------------------------- */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-    /* For this example, we don't need extra actions after TX completes. */
+    if (huart->Instance == USART1)
+    {
+        ringbuf_skip(&txRing, 1);
+        UART_Start_Next_Tx();
+    }
+}
+
+/* --------------------------------------------------------------------------
+   UART_Start_Next_Tx
+   --------------------------------------------------------------------------
+   Transmit the oldest queued byte straight from the ring, or go idle.
+   Only called from USART1 interrupt context, so no locking is needed.
+-------------------------------------------------------------------------- */
+static void UART_Start_Next_Tx(void)
+{
+    const uint8_t *span;
+    if (ringbuf_peek_span(&txRing, &span) > 0)
+    {
+        txBusy = true;
+        HAL_UART_Transmit_IT(&huart1, (uint8_t *)span, 1);
+    }
+    else
+    {
+        txBusy = false;
+    }
 }
 
 /* --------------------------------------------------------------------------
@@ -185,6 +198,16 @@ void USART1_IRQHandler(void)
     HAL_UART_IRQHandler(&huart1);
 }
 
+/* --------------------------------------------------------------------------
+   TIM6_IRQHandler
+   --------------------------------------------------------------------------
+   Scheduler timer: the next task deadline has been reached
+-------------------------------------------------------------------------- */
+void TIM6_IRQHandler(void)
+{
+    task_timer_irq();
+}
+
 /* --------------------------------------------------------------------------
    SysTick_Handler
    --------------------------------------------------------------------------
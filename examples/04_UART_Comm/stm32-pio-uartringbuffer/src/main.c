@@ -1,25 +1,168 @@
 #include "stm32f0xx_hal.h"
 #include <string.h>
 #include <stdbool.h>
+#include "ringbuf.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+#include "cmd.h"
+#include "pwm.h"
+#include "prof.h"
+#include "clk.h"
+#include "board.h"
+#include "boot.h"
 
 /* ------------------------------------------------
    Configuration
    ------------------------------------------------ */
-#define RXBUF_SIZE   128  // Ring buffer size
-#define CMDLINE_SIZE  64  // Max single command length
+#define RXBUF_SIZE   BOARD_BUF_SIZE(128)  // Ring buffer size (power of two, scaled with the RAM)
+#define CMDLINE_SIZE  64                  // Max single command length
+#define TXBUF_SIZE   BOARD_BUF_SIZE(32)   // Copy ring for numbers (literals are sent in place)
+BOARD_RAM_ASSERT(RXBUF_SIZE + TXBUF_SIZE + CMDLINE_SIZE);
+
+#ifndef UART_BAUDRATE
+#define UART_BAUDRATE 115200
+#endif
+
+/* Clock profile at reset ("clk" switches it): CLK_LP, CLK_PERF, CLK_HSI48 */
+#ifndef APP_CLK_PROFILE
+#define APP_CLK_PROFILE CLK_LP
+#endif
+
+/*
+ * Fast boot: the banner goes out right after HAL_Init(), the clock and
+ * a register-level USART1 set-up; LED, PWM, command table check and
+ * reception follow it. Time the stages with -DBOOT_TRACE=1 ("boot").
+ */
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT 0
+#endif
+
+/* PWM outputs at reset ("pwm freq" changes them) */
+#define PWM_FREQ_HZ  1000
+#define PWM_STEPS    1000  // Minimum duty resolution
+
+/*
+ * Receive mode (override with build_flags = -DAPP_RX_MODE=...):
+ *   UART_RX_MODE_DMA : DMA1 Channel3 writes into the ring in circular
+ *                      mode, idle-line + half/full IRQs publish the head
+ *   UART_RX_MODE_IT  : one interrupt per byte (the original approach)
+ *   UART_RX_MODE_FAST: one interrupt per byte, RDR read into the ring
+ *                      by uart_rx_irq() without the HAL
+ */
+#ifndef APP_RX_MODE
+#define APP_RX_MODE  UART_RX_MODE_DMA
+#endif
+
+/*
+ * Flow control (build_flags = -DAPP_FLOW=...), so a paste or file
+ * transfer faster than the commands run is paused instead of lost:
+ *   UART_RX_FLOW_NONE   : none (the original behaviour)
+ *   UART_RX_FLOW_RTS    : RTS on PA12 (GPIO), CTS on PA11 (USART)
+ *   UART_RX_FLOW_XONXOFF: XOFF/XON sent and obeyed, text only
+ * The sender is stopped at APP_FLOW_HIGH bytes in the ring and let go
+ * at APP_FLOW_LOW. DMA mode only sees the fill at its half/full/idle
+ * events, so it stops earlier.
+ */
+#ifndef APP_FLOW
+#define APP_FLOW  UART_RX_FLOW_NONE
+#endif
+#ifndef APP_FLOW_HIGH
+#define APP_FLOW_HIGH  ((APP_RX_MODE == UART_RX_MODE_DMA) ? RXBUF_SIZE / 4 : RXBUF_SIZE / 2)
+#endif
+#ifndef APP_FLOW_LOW
+#define APP_FLOW_LOW   (APP_FLOW_HIGH / 2)
+#endif
+_Static_assert(APP_FLOW != UART_RX_FLOW_RTS || BOARD_USART1_HAS_FLOW,
+               "RTS/CTS needs the flow control lines of USART1 on " BOARD_NAME);
+
+/*
+ * Profiled regions (build with -DPROF_ENABLE=1, read with "prof")
+ */
+enum
+{
+    PROF_UART_IRQ,
+    PROF_DMA_IRQ,
+    PROF_RX_CPLT,
+    PROF_RX_EVENT,
+    PROF_COMMAND,
+    PROF_COUNT
+};
+_Static_assert(PROF_COUNT <= PROF_REGIONS, "raise PROF_REGIONS");
+
+#if PROF_ENABLE
+static const char *const profNames[PROF_COUNT] = {
+    "usart1 irq", "dma irq", "rx cplt", "rx event", "command",
+};
+#endif
 
 /*
  * Global UART handle and ring buffer variables
  */
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
+
+/* Ring buffer for RX data (ISR/DMA = producer, main loop = consumer) */
+RINGBUF_DEFINE(rxRing, RXBUF_SIZE);
 
-/* Ring buffer for RX data */
-static volatile uint8_t rxRingBuf[RXBUF_SIZE];
-static volatile uint16_t head = 0;  // Next free position
-static volatile uint16_t tail = 0;  // Oldest available byte
+/* Receive engine filling rxRing */
+static uart_rx_t uartRx;
 
-/* We'll receive incoming bytes one at a time via interrupt. */
-static uint8_t rxByte;
+/* Transmit queue: literals go out by DMA straight from flash */
+RINGBUF_DEFINE(txRing, TXBUF_SIZE);
+static uart_tx_t uartTx;
+
+/*
+ * PWM outputs, driven by the shared pwm engine. "pwm duty"
+ * takes one value per channel in this order:
+ *   TIM3 CH1..CH4 : PA6, PA7, PB0, PB1 (AF1)
+ *   TIM1 CH1      : PA8 (AF2; CH2/CH3 pins are USART1)
+ *   TIM15 CH1/CH2 : PB14, PB15 (AF1)
+ *   TIM16 CH1     : PB8 (AF2)
+ *   TIM17 CH1     : PB9 (AF2)
+ * TIM15..TIM17 only where the part has them.
+ */
+typedef struct
+{
+    pwm_t *pwm;
+    TIM_TypeDef *tim;
+    uint8_t channels;
+    const char *name;
+} pwm_out_t;
+
+static pwm_t pwmTim3, pwmTim1;
+#if defined(TIM15)
+static pwm_t pwmTim15;
+#endif
+#if defined(TIM16)
+static pwm_t pwmTim16;
+#endif
+#if defined(TIM17)
+static pwm_t pwmTim17;
+#endif
+
+static const pwm_out_t pwmOuts[] = {
+    { &pwmTim3,  TIM3,  PWM_CH_ALL,            "TIM3"  },
+    { &pwmTim1,  TIM1,  PWM_CH(1),             "TIM1"  },
+#if defined(TIM15)
+    { &pwmTim15, TIM15, PWM_CH(1) | PWM_CH(2), "TIM15" },
+#endif
+#if defined(TIM16)
+    { &pwmTim16, TIM16, PWM_CH(1),             "TIM16" },
+#endif
+#if defined(TIM17)
+    { &pwmTim17, TIM17, PWM_CH(1),             "TIM17" },
+#endif
+};
+#define PWM_OUT_COUNT ((uint8_t)(sizeof(pwmOuts) / sizeof(pwmOuts[0])))
+
+/* Frequency and resolution "pwm freq" asked for, redone after a clock switch */
+static uint32_t pwmFreq = PWM_FREQ_HZ;
+static uint32_t pwmSteps = PWM_STEPS;
+
+/* Runs after every clock switch, see clockChanged() */
+static clk_hook_t clockHook;
+static volatile bool retimeFailed;
 
 /* Command line buffer + index */
 static char cmdLine[CMDLINE_SIZE];
@@ -30,14 +173,51 @@ static uint16_t cmdIndex = 0;
  */
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
+static void MX_PWM_Init(void);
+static void appInit(void);
+static void rxStart(void);
+static void pwmSync(void);
+static void clockChanged(void *ctx);
 
-/* Blocking transmit of a string */
+/* Queue a string literal / unsigned number for DMA transmit */
 static void print(const char *str);
+static void printU32(uint32_t value);
 
 /* Process a completed command line */
 static void processCommand(const char *cmd);
 
+/* Command handlers */
+static void cmdBoot(const char *args);
+static void cmdClk(const char *args);
+static void cmdHelp(const char *args);
+static void cmdPing(const char *args);
+static void cmdProf(const char *args);
+static void cmdPwm(const char *args);
+static void cmdStats(const char *args);
+static void cmdLedOn(const char *args);
+static void cmdLedOff(const char *args);
+static void cmdVersion(const char *args);
+
+/*
+ * Command table, kept in flash. Must stay sorted by
+ * (name length, name): lookup is a binary search.
+ */
+static const cmd_t commands[] = {
+    CMD_ENTRY("clk",     cmdClk),
+    CMD_ENTRY("pwm",     cmdPwm),
+    CMD_ENTRY("boot",    cmdBoot),
+    CMD_ENTRY("help",    cmdHelp),
+    CMD_ENTRY("ping",    cmdPing),
+    CMD_ENTRY("prof",    cmdProf),
+    CMD_ENTRY("stats",   cmdStats),
+    CMD_ENTRY("led on",  cmdLedOn),
+    CMD_ENTRY("led off", cmdLedOff),
+    CMD_ENTRY("version", cmdVersion),
+};
+static const cmd_table_t cmdTable = CMD_TABLE(commands);
+
 /*
  * ------------------------------------------------
  * main()
@@ -46,30 +226,51 @@ static void processCommand(const char *cmd);
 int main(void)
 {
     /* 1) HAL init */
+    BOOT_START();
     HAL_Init();
+    BOOT_MARK("hal");
 
-    /* 2) Configure system clock (8 MHz HSI, no PLL) */
+    /* 2) Configure system clock (APP_CLK_PROFILE, 8 MHz HSI by default) */
     SystemClock_Config();
+    BOOT_MARK("clock");
 
-    /* 3) Initialize GPIO (for LED on PA5) and USART1 */
-    MX_GPIO_Init();
+#if !APP_FAST_BOOT
+    /* 3) LED on PA5, PWM outputs, command table */
+    appInit();
+    BOOT_MARK("gpio, pwm");
+#endif
+
+    /* 4) DMA and USART1, the TX queue */
+    MX_DMA_Init();
     MX_USART1_UART_Init();
+    uart_tx_init(&uartTx, &huart1, &txRing);
+    BOOT_MARK("usart");
 
-    /* 4) Start 1-byte interrupt-based RX. */
-    HAL_UART_Receive_IT(&huart1, &rxByte, 1);
+#if !APP_FAST_BOOT
+    /* 5) Start reception into the ring buffer */
+    rxStart();
+    BOOT_MARK("rx");
+#endif
 
     print("\r\nRing Buffer UART Example\r\n");
-    print("Type commands: help, led on, led off, ping, version\r\n");
+    BOOT_MARK("banner queued");    // TX DMA started; the wire follows
+    print("Type commands: boot, help, led on, led off, ping, version, stats, prof, pwm, clk\r\n");
+
+#if APP_FAST_BOOT
+    /* 3, 5) The rest while the banner goes out */
+    rxStart();
+    appInit();
+    BOOT_MARK("deferred");
+#endif
+    BOOT_DONE();
+    PROF_INIT();
 
     while (1)
     {
-        /* Check if the ring buffer has data */
-        while (tail != head)
+        /* Drain the ring buffer */
+        uint8_t c;
+        while (ringbuf_get(&rxRing, &c))
         {
-            /* Get next char from ring buffer */
-            uint8_t c = rxRingBuf[tail];
-            tail = (tail + 1) % RXBUF_SIZE;
-
             /* Check if it's newline => process command */
             if (c == '\r' || c == '\n')
             {
@@ -85,6 +286,12 @@ int main(void)
             }
             else
             {
+                /* DMA mode leaves received XON/XOFF in the ring */
+                if (APP_FLOW == UART_RX_FLOW_XONXOFF && (c == UART_RX_XON || c == UART_RX_XOFF))
+                {
+                    continue;
+                }
+
                 /* Accumulate into cmdLine if space remains */
                 if (cmdIndex < (CMDLINE_SIZE - 1))
                 {
@@ -97,29 +304,110 @@ int main(void)
                 }
             }
         }
+
+        /* Drained: let a stopped sender go on */
+        uart_rx_flow_poll(&uartRx);
         // ... Possibly do other tasks
     }
 }
 
+/*
+ * ------------------------------------------------
+ * appInit() / rxStart()
+ * ------------------------------------------------
+ * Init steps the banner does not need (after it in a
+ * fast boot) and the start of reception.
+ */
+static void appInit(void)
+{
+    MX_GPIO_Init();
+    MX_PWM_Init();
+    clk_on_change(&clockHook, clockChanged, NULL);
+    if (!cmd_table_valid(&cmdTable))
+    {
+        while (1); // commands[] is not sorted
+    }
+}
+
+static void rxStart(void)
+{
+    const uart_rx_flow_t flow = {
+        .mode    = APP_FLOW,
+        .high    = APP_FLOW_HIGH,
+        .low     = APP_FLOW_LOW,
+        .rtsPort = BOARD_USART1_RTS_PORT,
+        .rtsPin  = BOARD_USART1_RTS_PIN,
+        .tx      = &uartTx,
+    };
+
+    if (uart_rx_start(&uartRx, &huart1, &rxRing, APP_RX_MODE) != HAL_OK ||
+        uart_rx_flow(&uartRx, &flow) != HAL_OK)
+    {
+        while (1);
+    }
+}
+
 /*
  * ------------------------------------------------
  * HAL_UART_RxCpltCallback
  * ------------------------------------------------
- * Called whenever 1 byte is received via interrupt.
- * We store that byte in the ring buffer, then re-arm.
+ * IT mode: called whenever 1 byte is received.
+ * uart_rx stores it in the ring buffer and re-arms.
  */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
+    PROF_BEGIN(PROF_RX_CPLT);
     if (huart->Instance == USART1)
     {
-        // Store byte in ring buffer
-        rxRingBuf[head] = rxByte;
-        head = (head + 1) % RXBUF_SIZE;
+        uart_rx_on_cplt(&uartRx);
+    }
+    PROF_END(PROF_RX_CPLT);
+}
 
-        // Optional: handle ring buffer overflow if head == tail
+/*
+ * ------------------------------------------------
+ * HAL_UART_TxCpltCallback
+ * ------------------------------------------------
+ * TX DMA finished: release the sent descriptors and
+ * start the next one.
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart_tx_on_cplt(&uartTx);
+    }
+}
 
-        // Re-arm to receive next byte
-        HAL_UART_Receive_IT(&huart1, &rxByte, 1);
+/*
+ * ------------------------------------------------
+ * HAL_UARTEx_RxEventCallback
+ * ------------------------------------------------
+ * DMA mode: called on DMA half/full transfer and on
+ * USART idle line. Size is the DMA write offset,
+ * which uart_rx publishes as the new ring head.
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    PROF_BEGIN(PROF_RX_EVENT);
+    if (huart->Instance == USART1)
+    {
+        uart_rx_on_event(&uartRx, Size);
+    }
+    PROF_END(PROF_RX_EVENT);
+}
+
+/*
+ * ------------------------------------------------
+ * HAL_UART_ErrorCallback
+ * ------------------------------------------------
+ * Count the line error and restart reception.
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART1)
+    {
+        uart_rx_on_error(&uartRx);
     }
 }
 
@@ -127,81 +415,455 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
  * ------------------------------------------------
  * processCommand()
  * ------------------------------------------------
- * Simple command parser: help, led on/off, ping,
- * version. Unknown => "Unknown command".
+ * Look the line up in cmdTable (binary search) and
+ * run its handler. Unknown => "Unknown command".
  */
 static void processCommand(const char *cmd)
 {
-    if (strcmp(cmd, "help") == 0)
+    PROF_BEGIN(PROF_COMMAND);
+    if (!cmd_dispatch(&cmdTable, cmd))
     {
-        print("Commands:\r\n  help\r\n  led on\r\n  led off\r\n  ping\r\n  version\r\n");
+        print("Unknown command\r\n");
     }
-    else if (strcmp(cmd, "led on") == 0)
+    PROF_END(PROF_COMMAND);
+}
+
+/* ---- Command handlers ---------------------------------------------------- */
+static void cmdHelp(const char *args)
+{
+    (void)args;
+    print("Commands:\r\n");
+    for (uint16_t i = 0; i < cmdTable.count; i++)
     {
-        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_SET);
-        print("LED ON\r\n");
+        print("  ");
+        print(cmdTable.cmds[i].name);
+        print("\r\n");
     }
-    else if (strcmp(cmd, "led off") == 0)
+}
+
+static void cmdLedOn(const char *args)
+{
+    (void)args;
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_SET);
+    print("LED ON\r\n");
+}
+
+static void cmdLedOff(const char *args)
+{
+    (void)args;
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_RESET);
+    print("LED OFF\r\n");
+}
+
+static void cmdPing(const char *args)
+{
+    (void)args;
+    print("pong\r\n");
+}
+
+static void cmdVersion(const char *args)
+{
+    (void)args;
+    print("v1.0.0\r\n");
+}
+
+static void cmdStats(const char *args)
+{
+    (void)args;
+    print("rx mode: ");
+    print((uartRx.mode == UART_RX_MODE_DMA) ? "dma" : (uartRx.mode == UART_RX_MODE_FAST) ? "fast" : "it");
+    print("\r\nrx bytes: ");
+    printU32(uartRx.bytes);
+    print("\r\nrx irqs: ");
+    printU32(uartRx.events);
+    print("\r\ndropped: ");
+    printU32(ringbuf_overflows(&rxRing));
+    print("\r\nline errors: ");
+    printU32(uartRx.errors);
+    if (uartRx.mode == UART_RX_MODE_FAST)
     {
-        HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
-        print("LED OFF\r\n");
+        print(" (overrun ");
+        printU32(uartRx.overruns);
+        print(", framing ");
+        printU32(uartRx.framing);
+        print(", noise ");
+        printU32(uartRx.noise);
+        print(")");
     }
-    else if (strcmp(cmd, "ping") == 0)
+    print("\r\nflow: ");
+    print((APP_FLOW == UART_RX_FLOW_RTS) ? "rts/cts" : (APP_FLOW == UART_RX_FLOW_XONXOFF) ? "xon/xoff" : "none");
+    if (APP_FLOW != UART_RX_FLOW_NONE)
     {
-        print("pong\r\n");
+        print(", stops ");
+        printU32(uartRx.stops);
+        print(uartRx.stopped ? ", stopped" : ", running");
+        print(uartTx.held != 0U ? ", tx held" : "");
     }
-    else if (strcmp(cmd, "version") == 0)
+    print("\r\ntx dma: ");
+    printU32(uartTx.transfers);
+    print("\r\ntx copied: ");
+    printU32(uartTx.copied);
+    print("\r\ntx errors: ");
+    printU32(uartTx.errors);
+    print("\r\n");
+}
+
+/*
+ * "boot" : the start-up stages, each with the time from
+ *          the start of main() to its end and its length
+ *          (microseconds; CPU time on the host simulation)
+ */
+static void cmdBoot(const char *args)
+{
+    (void)args;
+#if BOOT_TRACE
+    uint8_t n;
+    const boot_stage_t *stages = boot_trace(&n);
+    uint32_t prev = 0;
+
+    print("stage: end length (us)\r\n");
+    for (uint8_t i = 0; i < n && i < BOOT_STAGES; i++)
     {
-        print("v1.0.0\r\n");
+        print(stages[i].stage);
+        print(": ");
+        printU32(stages[i].us);
+        print(" ");
+        printU32(stages[i].us - prev);
+        print("\r\n");
+        prev = stages[i].us;
     }
-    else
+#else
+    print("boot trace off, build with -DBOOT_TRACE=1\r\n");
+#endif
+}
+
+/*
+ * "prof"       : count/min/avg/max cycles per region
+ * "prof trace" : the last regions, oldest first
+ * "prof reset" : clear both
+ * The command itself is profiled, so its line shows
+ * the previous "prof" runs.
+ */
+static void cmdProf(const char *args)
+{
+#if PROF_ENABLE
+    if (strcmp(args, "reset") == 0)
     {
-        print("Unknown command\r\n");
+        prof_reset();
+        print("prof cleared\r\n");
+        return;
+    }
+    if (strcmp(args, "trace") == 0)
+    {
+        static prof_event_t events[PROF_TRACE_LEN];
+        uint8_t n = prof_trace(events, PROF_TRACE_LEN);
+        for (uint8_t i = 0; i < n; i++)
+        {
+            printU32(events[i].start);
+            print(" ");
+            print(profNames[events[i].region]);
+            print(" ");
+            printU32(events[i].ticks);
+            print("\r\n");
+        }
+        return;
+    }
+
+    print("region: count min avg max (cycles, ");
+    printU32(prof_overhead());
+    print(" overhead removed)\r\n");
+    for (uint8_t r = 0; r < PROF_COUNT; r++)
+    {
+        prof_stat_t st;
+        if (!prof_get(r, &st))
+        {
+            continue;
+        }
+        print(profNames[r]);
+        print(": ");
+        printU32(st.count);
+        print(" ");
+        printU32(st.min);
+        print(" ");
+        printU32(st.sum / st.count);
+        print(" ");
+        printU32(st.max);
+        print("\r\n");
+    }
+#else
+    (void)args;
+    print("profiler off, build with -DPROF_ENABLE=1\r\n");
+#endif
+}
+
+/* Parse an unsigned decimal number, skipping leading spaces */
+static bool parseU32(const char **text, uint32_t *value)
+{
+    const char *s = *text;
+    uint32_t v = 0;
+
+    while (*s == ' ')
+    {
+        s++;
+    }
+    if (*s < '0' || *s > '9')
+    {
+        return false;
+    }
+    while (*s >= '0' && *s <= '9')
+    {
+        v = v * 10u + (uint32_t)(*s++ - '0');
+    }
+    *text = s;
+    *value = v;
+    return true;
+}
+
+/* Restart all PWM counters together, so the timers keep one phase */
+static void pwmSync(void)
+{
+    pwm_t *engines[PWM_OUT_COUNT];
+    for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+    {
+        engines[i] = pwmOuts[i].pwm;
+    }
+    pwm_sync(engines, PWM_OUT_COUNT);
+}
+
+static void printPwm(void)
+{
+    for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+    {
+        const pwm_t *pwm = pwmOuts[i].pwm;
+        print(pwmOuts[i].name);
+        print(": ");
+        printU32(pwm->timing.freq);
+        print(" Hz, ");
+        printU32(pwm_period(pwm));
+        print(" steps, duty");
+        for (uint8_t ch = 1; ch <= PWM_CHANNELS; ch++)
+        {
+            if ((pwm->channels & PWM_CH(ch)) != 0U)
+            {
+                print(" ");
+                printU32(pwm_get_duty(pwm, ch));
+            }
+        }
+        print("\r\n");
+    }
+}
+
+/*
+ * "pwm"                  : frequency, resolution and duties
+ * "pwm freq <hz> [steps]": retime all outputs (duty ratios kept)
+ * "pwm duty <d> ..."     : duties in 1/1000, one per channel in
+ *                          pwmOuts order; missing ones unchanged
+ * All outputs change on the same update event.
+ */
+static void cmdPwm(const char *args)
+{
+    uint32_t value;
+
+    if (strncmp(args, "freq", 4) == 0)
+    {
+        const char *s = args + 4;
+        uint32_t steps = PWM_STEPS;
+        if (!parseU32(&s, &value))
+        {
+            print("usage: pwm freq <hz> [steps]\r\n");
+            return;
+        }
+        (void)parseU32(&s, &steps);
+
+        /* All timers share the clock: check once, before changing any */
+        pwm_timing_t timing;
+        if (!pwm_calc(pwm_timer_clock(), value, steps, &timing))
+        {
+            print("out of range\r\n");
+            return;
+        }
+        for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+        {
+            (void)pwm_set_freq(pwmOuts[i].pwm, value, steps);
+        }
+        pwmSync();
+        pwmFreq = value;
+        pwmSteps = steps;
+    }
+    else if (strncmp(args, "duty", 4) == 0)
+    {
+        const char *s = args + 4;
+        for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+        {
+            pwm_hold(pwmOuts[i].pwm);
+        }
+        for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+        {
+            pwm_t *pwm = pwmOuts[i].pwm;
+            for (uint8_t ch = 1; ch <= PWM_CHANNELS; ch++)
+            {
+                if ((pwm->channels & PWM_CH(ch)) != 0U && parseU32(&s, &value))
+                {
+                    if (value > 1000u)
+                    {
+                        value = 1000u;
+                    }
+                    pwm_stage(pwm, ch, (uint16_t)((value * pwm_period(pwm) + 500u) / 1000u));
+                }
+            }
+        }
+        for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+        {
+            pwm_release(pwmOuts[i].pwm);
+        }
     }
+    else if (args[0] != '\0')
+    {
+        print("usage: pwm [freq <hz> [steps] | duty <d1> <d2> ...]\r\n");
+        return;
+    }
+    printPwm();
+}
+
+/*
+ * ------------------------------------------------
+ * clockChanged()
+ * ------------------------------------------------
+ * clk hook, interrupts masked: reload the USART1
+ * baud rate divider and replan the PWM timers for
+ * the new clock (duty ratios kept). PWM falls back
+ * to fewer steps if the clock is too slow for the
+ * "pwm freq" ones; a setting still out of reach
+ * keeps its old registers and "clk" reports it.
+ */
+static void clockChanged(void *ctx)
+{
+    (void)ctx;
+    if (clk_retime_uart(&huart1) != HAL_OK)
+    {
+        retimeFailed = true;
+    }
+    for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+    {
+        /* Too slow a clock for the steps: same frequency, the steps it gives */
+        if (pwm_set_freq(pwmOuts[i].pwm, pwmFreq, pwmSteps) != HAL_OK &&
+            pwm_set_freq(pwmOuts[i].pwm, pwmFreq, pwm_timer_clock() / pwmFreq) != HAL_OK)
+        {
+            retimeFailed = true;
+        }
+    }
+    pwmSync();
+}
+
+static void printClk(void)
+{
+    print("clock: ");
+    print(clk_name(clk_profile()));
+    print(", sysclk ");
+    printU32(HAL_RCC_GetSysClockFreq());
+    print(" Hz, pclk ");
+    printU32(HAL_RCC_GetPCLK1Freq());
+    print(" Hz, usart1 brr ");
+    printU32(USART1->BRR);
+    print("\r\n");
+}
+
+/*
+ * "clk"                  : profile, clocks and baud divider
+ * "clk lp|perf|hsi48"    : switch profile (hsi48 on the
+ *                          F072/F091 only); UART and PWM
+ *                          are retimed by clockChanged()
+ * The transmitter is drained first: a frame on the line
+ * while the baud rate changes would be garbled.
+ */
+static void cmdClk(const char *args)
+{
+    clk_profile_t profile;
+
+    if (args[0] != '\0')
+    {
+        if (!clk_find(args, &profile))
+        {
+            print("usage: clk [lp | perf");
+            print(CLK_HAS_HSI48 ? " | hsi48]\r\n" : "]\r\n");
+            return;
+        }
+        while (!uart_tx_idle(&uartTx) || __HAL_UART_GET_FLAG(&huart1, UART_FLAG_TC) == RESET)
+        {
+            uart_tx_poll(&uartTx); // Last queued frame still on the line
+        }
+        retimeFailed = false;
+        if (clk_switch(profile) != HAL_OK)
+        {
+            print("clock switch failed\r\n");
+        }
+        if (retimeFailed)
+        {
+            print("retime: baud rate or pwm setting not reachable at this clock\r\n");
+        }
+    }
+    printClk();
 }
 
 /*
  * ------------------------------------------------
  * print()
  * ------------------------------------------------
- * Blocking transmit of a string for simplicity
+ * Queue a string that stays valid (a literal in
+ * flash) without copying it. Only waits if all
+ * descriptors are in use.
  */
 static void print(const char *str)
 {
-    HAL_UART_Transmit(&huart1, (uint8_t*)str, strlen(str), HAL_MAX_DELAY);
+    while (uart_tx_slots(&uartTx) == 0U)
+    {
+        uart_tx_poll(&uartTx); // TX complete interrupt frees a slot
+    }
+    uart_tx_send_ref(&uartTx, (const uint8_t *)str, (uint16_t)strlen(str), NULL, NULL);
 }
 
 /*
  * ------------------------------------------------
- * SystemClock_Config()
+ * printU32()
  * ------------------------------------------------
- * Use internal HSI @ 8 MHz, no PLL.
+ * Print an unsigned number in decimal (no printf)
  */
-void SystemClock_Config(void)
+static void printU32(uint32_t value)
 {
-    RCC_OscInitTypeDef RCC_OscInitStruct = {0};
-    RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+    char buf[11];
+    char *p = &buf[sizeof(buf) - 1];
 
-    __HAL_RCC_PWR_CLK_ENABLE();
+    *p = '\0';
+    do
+    {
+        *--p = (char)('0' + (value % 10u));
+        value /= 10u;
+    } while (value != 0u);
 
-    // 1) HSI on
-    RCC_OscInitStruct.OscillatorType       = RCC_OSCILLATORTYPE_HSI;
-    RCC_OscInitStruct.HSIState            = RCC_HSI_ON;
-    RCC_OscInitStruct.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
-    RCC_OscInitStruct.PLL.PLLState        = RCC_PLL_NONE;
-    if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
+    /* buf is on the stack, so it goes through the copy ring */
+    uint16_t len = (uint16_t)(&buf[sizeof(buf) - 1] - p);
+    while (!uart_tx_write(&uartTx, (const uint8_t *)p, len))
     {
-        while (1);
+        // Wait for the ring to drain
     }
+}
 
-    // 2) SysClk = HSI
-    RCC_ClkInitStruct.ClockType      = (RCC_CLOCKTYPE_SYSCLK |
-                                        RCC_CLOCKTYPE_HCLK   |
-                                        RCC_CLOCKTYPE_PCLK1);
-    RCC_ClkInitStruct.SYSCLKSource   = RCC_SYSCLKSOURCE_HSI;
-    RCC_ClkInitStruct.AHBCLKDivider  = RCC_SYSCLK_DIV1;
-    RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-    if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK)
+/*
+ * ------------------------------------------------
+ * SystemClock_Config()
+ * ------------------------------------------------
+ * APP_CLK_PROFILE from lib/clk (8 MHz HSI, no PLL
+ * by default).
+ */
+void SystemClock_Config(void)
+{
+#if APP_FAST_BOOT
+    if (APP_CLK_PROFILE == CLK_LP)
+    {
+        return; // The reset clock: HSI on, no PLL, no wait state
+    }
+#endif
+    if (clk_init(APP_CLK_PROFILE) != HAL_OK)
     {
         while (1);
     }
@@ -211,71 +873,193 @@ void SystemClock_Config(void)
  * ------------------------------------------------
  * MX_GPIO_Init()
  * ------------------------------------------------
- * Enable GPIOA, config PA5 as LED output
+ * LED output (PA5 on every board), off
  */
 static void MX_GPIO_Init(void)
 {
-    __HAL_RCC_GPIOA_CLK_ENABLE();
+    board_led_init();
+}
 
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin   = GPIO_PIN_5;
-    GPIO_InitStruct.Mode  = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull  = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+/*
+ * ------------------------------------------------
+ * MX_DMA_Init()
+ * ------------------------------------------------
+ * Enable DMA1 and the IRQ of the USART1 channels
+ * (board.h: TX on Channel2, RX on Channel3).
+ */
+static void MX_DMA_Init(void)
+{
+#if !APP_FAST_BOOT
+    __HAL_RCC_DMA1_CLK_ENABLE(); // A fast boot has board_boot_init() do it
+#endif
 
-    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_RESET);
+    HAL_NVIC_SetPriority(BOARD_USART1_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(BOARD_USART1_DMA_IRQn);
 }
 
 /*
  * ------------------------------------------------
  * MX_USART1_UART_Init()
  * ------------------------------------------------
- * Configure PA9 (TX), PA10 (RX) @ 115200, 8N1.
- * Also enable NVIC for USART1.
+ * Configure PA9 (TX), PA10 (RX) @ UART_BAUDRATE, 8N1;
+ * with RTS flow control also PA11 (CTS) and PA12 (RTS).
+ * Link the board's USART1 RX (circular) and TX
+ * (normal) DMA channels and enable NVIC for USART1.
  */
 static void MX_USART1_UART_Init(void)
 {
-    __HAL_RCC_USART1_CLK_ENABLE();
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-
-    // TX/RX pins in AF1
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
-    GPIO_InitStruct.Mode      = GPIO_MODE_AF_PP;
-    GPIO_InitStruct.Pull      = GPIO_NOPULL;
-    GPIO_InitStruct.Speed     = GPIO_SPEED_FREQ_LOW;
-    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
-    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    // Clocks, TX/RX pins in AF1 (by register in a fast boot)
+#if APP_FAST_BOOT
+    board_boot_init(USART1);
+#else
+    board_uart_pins_init(USART1);
+#endif
+    if (APP_FLOW == UART_RX_FLOW_RTS)
+    {
+        board_uart_flow_init(); // RTS stays high until rxStart()
+    }
 
     // UART config
     huart1.Instance          = USART1;
-    huart1.Init.BaudRate     = 115200;
+    huart1.Init.BaudRate     = UART_BAUDRATE;
     huart1.Init.WordLength   = UART_WORDLENGTH_8B;
     huart1.Init.StopBits     = UART_STOPBITS_1;
     huart1.Init.Parity       = UART_PARITY_NONE;
     huart1.Init.Mode         = UART_MODE_TX_RX;
-    huart1.Init.HwFlowCtl    = UART_HWCONTROL_NONE;
+    huart1.Init.HwFlowCtl    = (APP_FLOW == UART_RX_FLOW_RTS) ? UART_HWCONTROL_CTS : UART_HWCONTROL_NONE;
     huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+#if APP_FAST_BOOT
+    if (boot_uart_init(&huart1) != HAL_OK)
+#else
     if (HAL_UART_Init(&huart1) != HAL_OK)
+#endif
     {
         while (1);
     }
 
+    // RX DMA: circular, so it never needs re-arming
+    hdma_usart1_rx.Instance                 = BOARD_USART1_RX_DMA;
+    hdma_usart1_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    hdma_usart1_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_usart1_rx.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.Mode                = DMA_CIRCULAR;
+    hdma_usart1_rx.Init.Priority            = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
+    {
+        while (1);
+    }
+    BOARD_DMA_ROUTE(BOARD_USART1_RX_REQ);
+    __HAL_LINKDMA(&huart1, hdmarx, hdma_usart1_rx);
+
+    // TX DMA: one transfer per queued descriptor
+    hdma_usart1_tx.Instance                 = BOARD_USART1_TX_DMA;
+    hdma_usart1_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma_usart1_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_usart1_tx.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.Mode                = DMA_NORMAL;
+    hdma_usart1_tx.Init.Priority            = DMA_PRIORITY_LOW;
+    if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK)
+    {
+        while (1);
+    }
+    BOARD_DMA_ROUTE(BOARD_USART1_TX_REQ);
+    __HAL_LINKDMA(&huart1, hdmatx, hdma_usart1_tx);
+
     // Enable USART1 interrupts in NVIC
     HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
     HAL_NVIC_EnableIRQ(USART1_IRQn);
 }
 
+/*
+ * ------------------------------------------------
+ * MX_PWM_Init()
+ * ------------------------------------------------
+ * Output pins of pwmOuts[] in their timer AF, then
+ * every timer at PWM_FREQ_HZ, all duties 0.
+ */
+static void MX_PWM_Init(void)
+{
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Mode  = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull  = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+
+    // TIM3 CH1..CH4
+    GPIO_InitStruct.Pin       = GPIO_PIN_6 | GPIO_PIN_7;
+    GPIO_InitStruct.Alternate = GPIO_AF1_TIM3;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+    GPIO_InitStruct.Pin       = GPIO_PIN_0 | GPIO_PIN_1;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    // TIM1 CH1
+    GPIO_InitStruct.Pin       = GPIO_PIN_8;
+    GPIO_InitStruct.Alternate = GPIO_AF2_TIM1;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+#if defined(TIM15)
+    // TIM15 CH1/CH2
+    GPIO_InitStruct.Pin       = GPIO_PIN_14 | GPIO_PIN_15;
+    GPIO_InitStruct.Alternate = GPIO_AF1_TIM15;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+#endif
+#if defined(TIM16)
+    // TIM16 CH1
+    GPIO_InitStruct.Pin       = GPIO_PIN_8;
+    GPIO_InitStruct.Alternate = GPIO_AF2_TIM16;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+#endif
+#if defined(TIM17)
+    // TIM17 CH1
+    GPIO_InitStruct.Pin       = GPIO_PIN_9;
+    GPIO_InitStruct.Alternate = GPIO_AF2_TIM17;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+#endif
+
+    for (uint8_t i = 0; i < PWM_OUT_COUNT; i++)
+    {
+        if (pwm_init(pwmOuts[i].pwm, pwmOuts[i].tim, pwmOuts[i].channels,
+                     PWM_FREQ_HZ, PWM_STEPS) != HAL_OK)
+        {
+            while (1);
+        }
+    }
+    pwmSync();
+}
+
 /*
  * ------------------------------------------------
  * USART1_IRQHandler()
  * ------------------------------------------------
- * If not in a separate stm32f0xx_it.c, define it here:
+ * uart_rx takes the received byte itself in FAST
+ * mode and hands everything else to the HAL.
  */
 void USART1_IRQHandler(void)
 {
-    HAL_UART_IRQHandler(&huart1);
+    PROF_BEGIN(PROF_UART_IRQ);
+    uart_rx_irq(&uartRx);
+    PROF_END(PROF_UART_IRQ);
+}
+
+/*
+ * ------------------------------------------------
+ * BOARD_USART1_DMA_IRQHandler()
+ * ------------------------------------------------
+ * TX DMA (Channel2) and RX DMA half/full transfer
+ * events (Channel3) share this vector.
+ */
+void BOARD_USART1_DMA_IRQHandler(void)
+{
+    PROF_BEGIN(PROF_DMA_IRQ);
+    HAL_DMA_IRQHandler(&hdma_usart1_tx);
+    HAL_DMA_IRQHandler(&hdma_usart1_rx);
+    PROF_END(PROF_DMA_IRQ);
 }
 
 /* 
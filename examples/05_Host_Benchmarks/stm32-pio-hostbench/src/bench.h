@@ -0,0 +1,34 @@
+/*
+ * File: bench.h
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Minimal timing helpers shared by the host benchmarks.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Monotonic host time in nanoseconds */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Print one result line: total time, cost per item and items per second */
+static inline void bench_report(const char *name, uint64_t ns, uint64_t items, const char *unit)
+{
+    double perItem = (double)ns / (double)items;
+    double perSec  = (double)items * 1e9 / (double)ns;
+    printf("%-32s %8.3f ns/%s  %10.2f M%s/s\n", name, perItem, unit, perSec / 1e6, unit);
+}
+
+/* Keeps results alive so the compiler cannot drop the measured work */
+static volatile uint32_t benchSink;
+
+#endif /* BENCH_H */
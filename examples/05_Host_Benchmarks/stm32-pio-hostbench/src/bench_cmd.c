@@ -0,0 +1,144 @@
+/*
+ * File: bench_cmd.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Command lookup cost: the strcmp() if/else chain the examples used
+ * against the shared cmd library's sorted table, for a production-sized
+ * command set.
+ *
+ * The command set is every "<group> <action>" pair of 8 groups and
+ * 8 actions (64 commands, 6..12 characters). Lookups cycle through all
+ * of them in a shuffled order plus one unknown command in eight, so the
+ * chain pays its average (and, for unknowns, worst) case.
+ *
+ * Variants:
+ *   strcmp-chain : linear strcmp() over the commands in declaration
+ *                  order, as processCommand() did
+ *   cmd-find     : cmd_find() binary search over (length, name)
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "cmd.h"
+
+#define GROUPS    8
+#define ACTIONS   8
+#define NCMDS     (GROUPS * ACTIONS)
+#define NQUERIES  1024
+#define ROUNDS    20000u
+
+static const char *const groups[GROUPS]   = { "led", "pwm", "adc", "gpio", "uart", "clk", "prof", "sys" };
+static const char *const actions[ACTIONS] = { "on", "off", "get", "set", "read", "reset", "status", "info" };
+
+static char names[NCMDS][16];
+static cmd_t sorted[NCMDS];
+static cmd_table_t table = { sorted, NCMDS };
+
+static const char *queries[NQUERIES];
+static uint16_t queryLen[NQUERIES];
+static char unknown[8][16];
+
+static void handler(const char *args)
+{
+    (void)args;
+}
+
+static int sort_entries(const void *a, const void *b)
+{
+    const cmd_t *x = a;
+    const cmd_t *y = b;
+    return cmd_compare(x->name, x->len, y->name, y->len);
+}
+
+/* Index of the matching command in declaration order, or -1 */
+static int lookup_chain(const char *line)
+{
+    for (int i = 0; i < NCMDS; i++)
+    {
+        if (strcmp(line, names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void bench_chain(void)
+{
+    uint32_t sum = 0;
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (int q = 0; q < NQUERIES; q++)
+        {
+            sum += (uint32_t)lookup_chain(queries[q]);
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("strcmp-chain", t1 - t0, (uint64_t)ROUNDS * NQUERIES, "lookup");
+}
+
+static void bench_find(void)
+{
+    uint32_t sum = 0;
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (int q = 0; q < NQUERIES; q++)
+        {
+            sum += (uint32_t)(uintptr_t)cmd_find(&table, queries[q], queryLen[q]);
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("cmd-find", t1 - t0, (uint64_t)ROUNDS * NQUERIES, "lookup");
+}
+
+int main(void)
+{
+    int errors = 0;
+
+    for (int g = 0; g < GROUPS; g++)
+    {
+        for (int a = 0; a < ACTIONS; a++)
+        {
+            char *n = names[g * ACTIONS + a];
+            snprintf(n, sizeof(names[0]), "%s %s", groups[g], actions[a]);
+            sorted[g * ACTIONS + a] = (cmd_t){ n, (uint8_t)strlen(n), handler };
+        }
+        snprintf(unknown[g], sizeof(unknown[0]), "%s stop", groups[g]);
+    }
+    qsort(sorted, NCMDS, sizeof(sorted[0]), sort_entries);
+    if (!cmd_table_valid(&table))
+    {
+        printf("table not sorted\n");
+        return 1;
+    }
+
+    /* Shuffled queries, one unknown in eight */
+    for (int q = 0; q < NQUERIES; q++)
+    {
+        queries[q] = ((q & 7) == 7) ? unknown[rand() % GROUPS] : names[rand() % NCMDS];
+        queryLen[q] = (uint16_t)strlen(queries[q]);
+    }
+
+    /* Both lookups must agree before timing them */
+    for (int q = 0; q < NQUERIES; q++)
+    {
+        int idx = lookup_chain(queries[q]);
+        const cmd_t *c = cmd_find(&table, queries[q], queryLen[q]);
+        if ((idx < 0) != (c == NULL) || (c != NULL && c->name != names[idx]))
+        {
+            printf("mismatch for \"%s\"\n", queries[q]);
+            errors++;
+        }
+    }
+
+    printf("Command lookup: %d commands, %d queries x %u rounds\n", NCMDS, NQUERIES, ROUNDS);
+    bench_chain();
+    bench_find();
+    printf("lookup check: %d mismatches (expect 0)\n", errors);
+    return (errors == 0) ? 0 : 1;
+}
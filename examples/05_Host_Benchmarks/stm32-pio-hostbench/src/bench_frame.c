@@ -0,0 +1,274 @@
+/*
+ * File: bench_frame.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Checks and throughput of the shared frame library (COBS + CRC-16)
+ * against the newline-terminated text protocol of the STM32 <-> ESP32
+ * link (examples/04_UART_Comm/stm32-pio-uartcommesp32).
+ *
+ * Checks (the program exits non-zero if one fails):
+ *   - CRC-16/CCITT-FALSE check value ("123456789" -> 0x29B1)
+ *   - encode/decode round trip for every payload length, with random,
+ *     all-zero and all-0xFF payloads (the COBS 254-byte block edge)
+ *   - a stream of frames fed to frame_rx_push() in random-size chunks
+ *   - every single-bit error in a frame is rejected
+ *
+ * Throughput: one heartbeat carrying a link_sensor_t, either as
+ *   text   : "Heartbeat <seq> <temp> <uptime>\r\n", snprintf() to send,
+ *            per-character line assembly + strtol() to receive
+ *   binary : frame_encode() to send, frame_rx_push() + memcpy() to receive
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "frame.h"
+#include "link_protocol.h"
+
+#define ROUNDS      2000000u
+#define STREAM_LEN  200
+#define UART_BPS    11520u   // 115200 baud 8N1 = 11520 bytes/s
+
+static int failures;
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/* ---- Correctness ------------------------------------------------------- */
+
+static void check_round_trip(const uint8_t *payload, uint8_t len)
+{
+    uint8_t enc[FRAME_ENCODED_SIZE(255)];
+    frame_t f;
+    size_t n = frame_encode(0x42, payload, len, enc, sizeof(enc));
+
+    check(n != 0 && n <= FRAME_ENCODED_SIZE((size_t)len), "encoded size");
+    check(enc[n - 1] == 0x00 && memchr(enc, 0x00, n - 1) == NULL, "single delimiter");
+    check(frame_decode(enc, n - 1, &f) == FRAME_OK, "decode");
+    check(f.type == 0x42 && f.len == len && memcmp(f.payload, payload, len) == 0, "payload");
+}
+
+static void run_checks(void)
+{
+    uint8_t payload[255];
+    uint8_t enc[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+
+    check(frame_crc16(0xFFFF, (const uint8_t *)"123456789", 9) == 0x29B1, "crc check value");
+
+    for (int len = 0; len <= 255; len++)
+    {
+        for (int i = 0; i < len; i++)
+        {
+            payload[i] = (uint8_t)rand();
+        }
+        check_round_trip(payload, (uint8_t)len);
+        memset(payload, 0x00, sizeof(payload));
+        check_round_trip(payload, (uint8_t)len);
+        memset(payload, 0xFF, sizeof(payload));
+        check_round_trip(payload, (uint8_t)len);
+    }
+
+    /* Stream of frames, fed in chunks of 1..32 bytes */
+    static uint8_t stream[STREAM_LEN * FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    size_t streamLen = 0;
+    uint32_t lenSum = 0, gotSum = 0;
+    for (int i = 0; i < STREAM_LEN; i++)
+    {
+        uint8_t len = (uint8_t)(rand() % (FRAME_MAX_PAYLOAD + 1));
+        for (int j = 0; j < len; j++)
+        {
+            payload[j] = (uint8_t)(rand() & 3);   // Plenty of zeros
+        }
+        streamLen += frame_encode((uint8_t)i, payload, len, &stream[streamLen], FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD));
+        lenSum += len;
+    }
+    frame_rx_t rx;
+    frame_rx_init(&rx);
+    size_t pos = 0;
+    uint32_t frames = 0;
+    while (pos < streamLen)
+    {
+        uint16_t chunk = (uint16_t)(1 + rand() % 32);
+        if (chunk > streamLen - pos)
+        {
+            chunk = (uint16_t)(streamLen - pos);
+        }
+        uint16_t off = 0;
+        while (off < chunk)
+        {
+            uint16_t used;
+            frame_t f;
+            if (frame_rx_push(&rx, &stream[pos + off], (uint16_t)(chunk - off), &used, &f))
+            {
+                check(f.type == (uint8_t)frames, "stream order");
+                gotSum += f.len;
+                frames++;
+            }
+            off = (uint16_t)(off + used);
+        }
+        pos += chunk;
+    }
+    check(frames == STREAM_LEN && gotSum == lenSum && rx.errors == 0, "stream decode");
+
+    /* Every single-bit error must be rejected */
+    for (int i = 0; i < 16; i++)
+    {
+        payload[i] = (uint8_t)rand();
+    }
+    size_t n = frame_encode(LINK_MSG_STATUS, payload, 16, enc, sizeof(enc));
+    uint32_t accepted = 0;
+    for (size_t byte = 0; byte < n - 1; byte++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            uint8_t bad[sizeof(enc)];
+            memcpy(bad, enc, n);
+            bad[byte] ^= (uint8_t)(1u << bit);
+            frame_rx_init(&rx);
+            for (size_t off = 0; off < n;)
+            {
+                uint16_t used;
+                frame_t f;
+                accepted += frame_rx_push(&rx, &bad[off], (uint16_t)(n - off), &used, &f);
+                off += used;
+            }
+        }
+    }
+    check(accepted == 0, "bit errors rejected");
+    printf("checks: %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+}
+
+/* ---- Throughput -------------------------------------------------------- */
+
+static link_sensor_t sample_for(uint32_t i)
+{
+    link_sensor_t s = { 1000u + i * 2000u, (int16_t)(2000 + (int)(i % 1000u)), (uint16_t)i };
+    return s;
+}
+
+static void bench_text(void)
+{
+    char line[64];
+    char rxLine[64];
+    uint16_t rxIndex = 0;
+    uint32_t sum = 0;
+    uint64_t wire = 0;
+
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        link_sensor_t s = sample_for(r);
+        int n = snprintf(line, sizeof(line), "Heartbeat %u %d %lu\r\n",
+                         s.seq, s.tempCx100, (unsigned long)s.uptimeMs);
+        wire += (uint64_t)n;
+
+        /* Receiver: same per-character loop as the firmwares */
+        for (int i = 0; i < n; i++)
+        {
+            char c = line[i];
+            if (c == '\r')
+            {
+                continue;
+            }
+            if (c == '\n')
+            {
+                rxLine[rxIndex] = '\0';
+                if (strncmp(rxLine, "Heartbeat ", 10) == 0)
+                {
+                    char *p = &rxLine[10];
+                    link_sensor_t out;
+                    out.seq       = (uint16_t)strtoul(p, &p, 10);
+                    out.tempCx100 = (int16_t)strtol(p, &p, 10);
+                    out.uptimeMs  = (uint32_t)strtoul(p, &p, 10);
+                    sum += out.seq + out.uptimeMs;
+                }
+                rxIndex = 0;
+            }
+            else if (rxIndex < sizeof(rxLine) - 1)
+            {
+                rxLine[rxIndex++] = c;
+            }
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("text heartbeat", t1 - t0, ROUNDS, "msg");
+    printf("%-32s %8.1f B/msg  max %6.0f msg/s at 115200 baud\n", "",
+           (double)wire / ROUNDS, UART_BPS / ((double)wire / ROUNDS));
+}
+
+static void bench_binary(void)
+{
+    uint8_t enc[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    frame_rx_t rx;
+    uint32_t sum = 0;
+    uint64_t wire = 0;
+
+    frame_rx_init(&rx);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        link_sensor_t s = sample_for(r);
+        size_t n = frame_encode(LINK_MSG_HEARTBEAT, (const uint8_t *)&s, sizeof(s), enc, sizeof(enc));
+        wire += n;
+
+        /* Receiver: whole span at once, as from a DMA ring */
+        uint16_t used;
+        frame_t f;
+        if (frame_rx_push(&rx, enc, (uint16_t)n, &used, &f) && f.type == LINK_MSG_HEARTBEAT)
+        {
+            link_sensor_t out;
+            memcpy(&out, f.payload, sizeof(out));
+            sum += out.seq + out.uptimeMs;
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("binary heartbeat", t1 - t0, ROUNDS, "msg");
+    printf("%-32s %8.1f B/msg  max %6.0f msg/s at 115200 baud\n", "",
+           (double)wire / ROUNDS, UART_BPS / ((double)wire / ROUNDS));
+    check(rx.frames == ROUNDS, "binary bench frames");
+}
+
+static void bench_codec_bytes(void)
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t enc[FRAME_ENCODED_SIZE(FRAME_MAX_PAYLOAD)];
+    frame_t f;
+    uint32_t sum = 0;
+
+    for (int i = 0; i < FRAME_MAX_PAYLOAD; i++)
+    {
+        payload[i] = (uint8_t)rand();
+    }
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        payload[0] = (uint8_t)r;
+        size_t n = frame_encode(LINK_MSG_STATUS, payload, FRAME_MAX_PAYLOAD, enc, sizeof(enc));
+        if (frame_decode(enc, n - 1, &f) == FRAME_OK)
+        {
+            sum += f.payload[0];
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("encode+decode 64 B payload", t1 - t0, (uint64_t)ROUNDS * FRAME_MAX_PAYLOAD, "B");
+}
+
+int main(void)
+{
+    run_checks();
+
+    printf("Heartbeat with sensor sample, %u messages each way\n", ROUNDS);
+    bench_text();
+    bench_binary();
+    bench_codec_bytes();
+    return (failures == 0) ? 0 : 1;
+}
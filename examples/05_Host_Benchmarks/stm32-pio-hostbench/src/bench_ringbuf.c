@@ -0,0 +1,153 @@
+/*
+ * File: bench_ringbuf.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Per-byte cost of the shared ringbuf library against the ad-hoc
+ * `% RXBUF_SIZE` ring buffers the UART examples used before.
+ *
+ * Traffic pattern: the producer pushes a burst, the consumer drains it,
+ * like an ISR filling the buffer between two passes of the main loop.
+ *
+ * Variants:
+ *   modulo-const   : the old example code, size is a constant 128
+ *                    (the compiler can turn the % into a mask)
+ *   modulo-runtime : same code with the size held in a variable, as any
+ *                    reusable version needs; on Cortex-M0 every % is a
+ *                    call to __aeabi_uidivmod
+ *   ringbuf-byte   : ringbuf_put() / ringbuf_get()
+ *   ringbuf-bulk   : ringbuf_write() / ringbuf_read() on whole bursts
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "ringbuf.h"
+
+#define RXBUF_SIZE  128
+#define BURST       64
+#define ROUNDS      2000000u
+
+/* ---- Legacy modulo ring buffer (copied from the old examples) ---------- */
+static volatile uint8_t modBuf[RXBUF_SIZE];
+static volatile uint16_t modHead = 0, modTail = 0;
+static volatile uint16_t modSize = RXBUF_SIZE;
+
+static void bench_modulo_const(const uint8_t *burst)
+{
+    uint32_t sum = 0;
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (uint16_t i = 0; i < BURST; i++)
+        {
+            uint16_t nextHead = (modHead + 1) % RXBUF_SIZE;
+            if (nextHead != modTail)
+            {
+                modBuf[modHead] = burst[i];
+                modHead = nextHead;
+            }
+        }
+        while (modHead != modTail)
+        {
+            sum += modBuf[modTail];
+            modTail = (modTail + 1) % RXBUF_SIZE;
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("modulo-const", t1 - t0, (uint64_t)ROUNDS * BURST, "B");
+}
+
+static void bench_modulo_runtime(const uint8_t *burst)
+{
+    uint32_t sum = 0;
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (uint16_t i = 0; i < BURST; i++)
+        {
+            uint16_t nextHead = (modHead + 1) % modSize;
+            if (nextHead != modTail)
+            {
+                modBuf[modHead] = burst[i];
+                modHead = nextHead;
+            }
+        }
+        while (modHead != modTail)
+        {
+            sum += modBuf[modTail];
+            modTail = (modTail + 1) % modSize;
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("modulo-runtime", t1 - t0, (uint64_t)ROUNDS * BURST, "B");
+}
+
+/* ---- Shared ringbuf library ------------------------------------------- */
+RINGBUF_DEFINE(ring, RXBUF_SIZE);
+
+static void bench_ringbuf_byte(const uint8_t *burst)
+{
+    uint32_t sum = 0;
+    uint8_t c;
+    ringbuf_reset(&ring);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (uint16_t i = 0; i < BURST; i++)
+        {
+            ringbuf_put(&ring, burst[i]);
+        }
+        while (ringbuf_get(&ring, &c))
+        {
+            sum += c;
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("ringbuf-byte", t1 - t0, (uint64_t)ROUNDS * BURST, "B");
+}
+
+static void bench_ringbuf_bulk(const uint8_t *burst)
+{
+    uint32_t sum = 0;
+    uint8_t out[BURST];
+    ringbuf_reset(&ring);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        ringbuf_write(&ring, burst, BURST);
+        uint16_t n = ringbuf_read(&ring, out, BURST);
+        sum += out[r % n];
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("ringbuf-bulk", t1 - t0, (uint64_t)ROUNDS * BURST, "B");
+}
+
+int main(void)
+{
+    uint8_t burst[BURST];
+    for (int i = 0; i < BURST; i++)
+    {
+        burst[i] = (uint8_t)rand();
+    }
+
+    printf("Ring buffer: %u rounds of %u-byte bursts, %u-byte buffer\n",
+           ROUNDS, BURST, RXBUF_SIZE);
+    bench_modulo_const(burst);
+    bench_modulo_runtime(burst);
+    bench_ringbuf_byte(burst);
+    bench_ringbuf_bulk(burst);
+
+    /* Overflow accounting sanity check: 3 bursts into a 128-byte buffer */
+    ringbuf_reset(&ring);
+    for (int i = 0; i < 3; i++)
+    {
+        ringbuf_write(&ring, burst, BURST);
+    }
+    printf("overflow check: used=%u dropped=%lu (expect 128 / 64)\n",
+           ringbuf_used(&ring), (unsigned long)ringbuf_overflows(&ring));
+    return (ringbuf_used(&ring) == RXBUF_SIZE && ringbuf_overflows(&ring) == BURST) ? 0 : 1;
+}
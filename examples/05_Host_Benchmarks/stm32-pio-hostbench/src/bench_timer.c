@@ -0,0 +1,243 @@
+/*
+ * File: bench_timer.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Software timer cost per tick for thousands of timers: the polling the
+ * examples did, a deadline-sorted list, and the shared wheel library.
+ *
+ * Every timer is periodic (10..5000 ticks, random phase) and each tick
+ * four random timers are pushed back to a new deadline, as a heartbeat
+ * timeout is on every message. The same pseudo-random schedule drives
+ * all variants, and their fire counts and checksums must agree.
+ *
+ * Variants:
+ *   poll        : `(int32_t)(now - due) >= 0` for every timer on every
+ *                 tick, as the HAL_GetTick() main loops did
+ *   sorted-list : doubly linked list in deadline order; a tick looks at
+ *                 the head, a (re)start walks to its place
+ *   wheel       : wheel_start() / wheel_tick() from the wheel library
+ */
+
+#include <string.h>
+#include "bench.h"
+#include "wheel.h"
+
+#define MAX_TIMERS  4096
+#define RESTARTS    4               // Timers pushed back per tick
+#define TICKS       20000u
+
+static const int sizes[] = { 256, 1024, 4096 };
+
+typedef struct
+{
+    uint32_t fires;
+    uint32_t sum;
+} result_t;
+
+static uint32_t period[MAX_TIMERS];
+static uint32_t phase[MAX_TIMERS];
+static uint16_t restartId[TICKS][RESTARTS];
+static uint16_t restartDelay[TICKS][RESTARTS];
+static result_t result;
+
+static uint32_t lcg = 12345u;
+
+static uint32_t rnd(void)
+{
+    lcg = lcg * 1103515245u + 12345u;
+    return lcg >> 8;
+}
+
+static inline void fire(uint32_t id, uint32_t now)
+{
+    result.fires++;
+    result.sum += (id * 2654435761u) ^ now;
+}
+
+/* --- poll: one deadline per timer, all checked every tick --- */
+
+static uint32_t due[MAX_TIMERS];
+
+static void run_poll(int n)
+{
+    uint32_t now = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        due[i] = phase[i];
+    }
+    for (uint32_t tick = 0; tick < TICKS; tick++)
+    {
+        for (int r = 0; r < RESTARTS; r++)
+        {
+            uint16_t id = restartId[tick][r];
+            if (id < n)
+            {
+                due[id] = now + restartDelay[tick][r];
+            }
+        }
+        now++;
+        for (int i = 0; i < n; i++)
+        {
+            if ((int32_t)(now - due[i]) >= 0)
+            {
+                due[i] += period[i];
+                fire((uint32_t)i, now);
+            }
+        }
+    }
+}
+
+/* --- sorted-list: earliest deadline at the head --- */
+
+typedef struct node
+{
+    struct node *next, *prev;
+    uint32_t due;
+    uint32_t id;
+} node_t;
+
+static node_t nodes[MAX_TIMERS];
+static node_t head;                // Sentinel: head.next is the earliest
+
+static void list_unlink(node_t *x)
+{
+    x->prev->next = x->next;
+    x->next->prev = x->prev;
+}
+
+static void list_insert(node_t *x, uint32_t now)
+{
+    node_t *p = &head;
+    while (p->next != &head && p->next->due - now <= x->due - now)
+    {
+        p = p->next;
+    }
+    x->next = p->next;
+    x->prev = p;
+    p->next->prev = x;
+    p->next = x;
+}
+
+static void run_list(int n)
+{
+    uint32_t now = 0;
+
+    head.next = head.prev = &head;
+    for (int i = 0; i < n; i++)
+    {
+        nodes[i].id = (uint32_t)i;
+        nodes[i].due = phase[i];
+        list_insert(&nodes[i], now);
+    }
+    for (uint32_t tick = 0; tick < TICKS; tick++)
+    {
+        for (int r = 0; r < RESTARTS; r++)
+        {
+            uint16_t id = restartId[tick][r];
+            if (id < n)
+            {
+                list_unlink(&nodes[id]);
+                nodes[id].due = now + restartDelay[tick][r];
+                list_insert(&nodes[id], now);
+            }
+        }
+        now++;
+        while (head.next != &head && (int32_t)(now - head.next->due) >= 0)
+        {
+            node_t *x = head.next;
+            list_unlink(x);
+            x->due += period[x->id];
+            list_insert(x, now);
+            fire(x->id, now);
+        }
+    }
+}
+
+/* --- wheel --- */
+
+static wheel_t wheel;
+static wheel_timer_t timers[MAX_TIMERS];
+
+static void on_expiry(void *ctx)
+{
+    fire((uint32_t)(uintptr_t)ctx, wheel_now(&wheel));
+}
+
+static void run_wheel(int n)
+{
+    wheel_init(&wheel);
+    memset(timers, 0, sizeof(timers));
+    for (int i = 0; i < n; i++)
+    {
+        wheel_start(&wheel, &timers[i], phase[i], period[i], on_expiry, (void *)(uintptr_t)i);
+    }
+    for (uint32_t tick = 0; tick < TICKS; tick++)
+    {
+        for (int r = 0; r < RESTARTS; r++)
+        {
+            uint16_t id = restartId[tick][r];
+            if (id < n)
+            {
+                wheel_start(&wheel, &timers[id], restartDelay[tick][r], period[id],
+                            on_expiry, (void *)(uintptr_t)id);
+            }
+        }
+        wheel_tick(&wheel);
+    }
+}
+
+static result_t measure(const char *name, void (*run)(int), int n)
+{
+    char label[40];
+    uint64_t t0, t1;
+
+    result = (result_t){ 0 };
+    t0 = bench_now_ns();
+    run(n);
+    t1 = bench_now_ns();
+    benchSink = result.sum;
+    snprintf(label, sizeof(label), "%-11s %4d timers", name, n);
+    bench_report(label, t1 - t0, TICKS, "tick");
+    return result;
+}
+
+int main(void)
+{
+    int errors = 0;
+
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        period[i] = 10u + rnd() % 4991u;
+        phase[i] = 1u + rnd() % period[i];
+    }
+    for (uint32_t t = 0; t < TICKS; t++)
+    {
+        for (int r = 0; r < RESTARTS; r++)
+        {
+            restartId[t][r] = (uint16_t)(rnd() % MAX_TIMERS);   // Only ids below n apply
+            restartDelay[t][r] = (uint16_t)(100u + rnd() % 4901u);
+        }
+    }
+
+    printf("Software timers: periods 10..5000 ticks, %d restarts per tick, %u ticks\n",
+           RESTARTS, TICKS);
+    printf("wheel: %d levels x %u slots, %u bytes\n", WHEEL_LEVELS, WHEEL_SLOTS,
+           (unsigned)sizeof(wheel_t));
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        result_t a = measure("poll", run_poll, n);
+        result_t b = measure("sorted-list", run_list, n);
+        result_t c = measure("wheel", run_wheel, n);
+
+        if (a.fires != b.fires || a.fires != c.fires || a.sum != b.sum || a.sum != c.sum)
+        {
+            printf("mismatch at %d timers: fires %u/%u/%u\n", n, a.fires, b.fires, c.fires);
+            errors++;
+        }
+        printf("%d timers: %u expiries\n", n, a.fires);
+    }
+    printf("expiry check: %d mismatches (expect 0)\n", errors);
+    return (errors == 0) ? 0 : 1;
+}
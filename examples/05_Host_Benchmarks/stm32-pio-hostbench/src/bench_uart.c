@@ -0,0 +1,789 @@
+/*
+ * File: bench_uart.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Compares the receive strategies of the UART examples under the same
+ * command traffic, running the firmware on the HAL simulation (lib/halsim)
+ * with a scripted byte source on USART1 RX. The uart_rx strategies run
+ * the shared library; the others repeat the receive code of the example
+ * they are named after (same calls, buffer sizes and callbacks, the F030
+ * sizes), with the example's echo replaced by the common reply below:
+ *
+ *   polled : uartecho: a 1 ms periodic poll, HAL_UART_Receive() with a
+ *            timeout of 0, and a blocking HAL_UART_Transmit() reply
+ *   it     : uartexinterrupt: HAL_UART_Receive_IT() per byte, the line
+ *            handled in the RX callback, the reply sent one byte per
+ *            HAL_UART_Transmit_IT() straight from a 64-byte ring
+ *   ring   : uartringbuffer: uart_rx in circular DMA mode into a 128-byte
+ *            ring, lines parsed in the main loop, replies through uart_tx
+ *   dma    : uartdma: HAL_UARTEx_ReceiveToIdle_DMA() into 3 x 64-byte
+ *            buffers, handed to the main loop, replies through uart_tx
+ *   dma4   : uartdma as it was first written: HAL_UART_Receive_DMA() of
+ *            exactly 4 bytes, restarted in the RX callback, the reply
+ *            sent by DMA from the callback and dropped while one is out
+ *   hal    : uart_rx in interrupt mode (uartringbuffer IT), the HAL IRQ
+ *            handler and callback per byte, replies through uart_tx
+ *   fast   : uart_rx in FAST mode (uartringbuffer FAST), the register-level
+ *            handler putting RDR into the ring, replies through uart_tx
+ *
+ * Every command is "ping NNNNN\r" (11 bytes) and is answered "ok NNNNN\r\n"
+ * (10 bytes), so the reply never needs more of the line than the request.
+ * Traffic patterns:
+ *
+ *   steady : commands back to back at line rate
+ *   burst  : -b commands (default 8), then -g ms of idle line (default 10)
+ *   sparse : one command, then the second -g gap of idle line (default 2)
+ *
+ * Per run (one forked process each) the table shows:
+ *   B/s      command bytes the application received per second of traffic
+ *   p50..max latency from the end of a command's '\r' frame on RX to the
+ *            end of its reply's '\n' frame on TX, in microseconds
+ *   isr/B    USART1 + DMA1_Channel2_3 handlers per byte sent to the MCU
+ *            (TX side interrupts included)
+ *   drop     bytes sent that never reached the application
+ *   ovr      of those, bytes the USART overran
+ *   full     replies refused because the TX queue was full (or, in dma4,
+ *            busy)
+ *   lost     commands without a reply
+ *
+ * Virtual time runs at -s <speed> of the wall clock (default 0.05) so the
+ * host keeps up with per-byte interrupts; latencies are in virtual time
+ * but the handlers run at host speed, not at the Cortex-M0's 8 MHz.
+ *
+ * Usage: program [-r baud,...] [-p pattern,...] [-t strategy,...]
+ *                [-b burst] [-g burst_ms[,sparse_ms]] [-n commands] [-s speed]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "bench.h"
+#include "halsim.h"
+#include "ringbuf.h"
+#include "uart_rx.h"
+#include "uart_tx.h"
+
+#define CMD_LEN        11      // "ping NNNNN\r"
+#define REPLY_LEN      10      // "ok NNNNN\r\n"
+#define BURST_LEN      8u      // Defaults of -b and -g
+#define BURST_GAP_MS   10u
+#define SPARSE_GAP_MS  2u
+#define DRAIN_MS       50u     // Idle time after the last command before reporting
+#define LINE_QUEUE     256u    // Bytes the feeder keeps ahead of the receiver
+#define PCLK_HZ        8000000u
+
+#define RX_RING_SIZE   128     // uartringbuffer RXBUF_SIZE
+#define TX_RING_SIZE   256     // uartdma TXBUF_SIZE, the uart_tx copy ring
+#define IT_RING_SIZE   64      // uartexinterrupt TXBUF_SIZE
+#define RX_BUF_SIZE    64      // uartdma
+#define RX_BUF_COUNT   3
+#define RX_NEXT(i)     (((i) + 1u == RX_BUF_COUNT) ? 0u : (uint8_t)((i) + 1u))
+#define RX4_SIZE       4       // uartdma before ReceiveToIdle
+#define POLL_MS        1u      // uartecho ECHO_POLL_MS
+
+enum { S_POLLED, S_IT, S_RING, S_DMA, S_DMA4, S_HAL, S_FAST };
+#define STRATEGY_IS(id) (strategy == &strategies[id])
+
+typedef struct
+{
+    const char *name;
+    void (*start)(void);
+    void (*poll)(void);
+    bool (*send)(const uint8_t *data, uint16_t len);
+} strategy_t;
+
+typedef struct
+{
+    const char *name;
+    uint32_t every;            // Commands between gaps (0 = no gaps)
+    uint32_t gapMs;
+} pattern_t;
+
+/* -------------------------------------------------------------------------
+   Firmware side
+   ------------------------------------------------------------------------- */
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
+
+static const strategy_t *strategy;
+static volatile sig_atomic_t benchDone;
+
+static uint8_t rxStorage[RX_RING_SIZE];
+static uint8_t txStorage[TX_RING_SIZE];
+static ringbuf_t rxRing;
+static ringbuf_t txRing;
+static uart_rx_t uartRx;
+static uart_tx_t uartTx;
+
+static uint8_t rxByte;                     // it: landing byte
+static volatile uint8_t txBusy;            // it: a 1-byte transmit is running
+
+static uint8_t rxBuf[RX_BUF_COUNT][RX_BUF_SIZE];  // dma: packets, rxLen != 0 = full
+static volatile uint16_t rxLen[RX_BUF_COUNT];
+static volatile uint8_t rxActive;
+static uint8_t rxProcess;
+
+static uint8_t rx4[RX4_SIZE];              // dma4: fixed-size reception
+static uint8_t tx4[REPLY_LEN];
+static volatile uint8_t tx4Busy;
+
+static uint32_t lastPoll;                  // polled: tick of the last poll
+
+static char line[16];
+static uint8_t lineLen;
+static volatile uint32_t appBytes;         // Bytes handed to the line parser
+static volatile uint32_t replyDrops;       // Replies refused by a full TX queue
+
+/* Common application: answer "ping N\r" with "ok N\r\n" */
+static void app_byte(uint8_t c)
+{
+    appBytes++;
+    if (c == '\r')
+    {
+        if (lineLen == CMD_LEN - 1 && memcmp(line, "ping ", 5) == 0)
+        {
+            uint8_t reply[REPLY_LEN] = { 'o', 'k', ' ' };
+            memcpy(&reply[3], &line[5], 5);
+            reply[8] = '\r';
+            reply[9] = '\n';
+            if (!strategy->send(reply, REPLY_LEN))
+            {
+                replyDrops++;
+            }
+        }
+        lineLen = 0;
+    }
+    else if (lineLen < sizeof(line))
+    {
+        line[lineLen++] = (char)c;
+    }
+}
+
+/* ---- polled ---- */
+static void polled_start(void)
+{
+}
+
+/* The echo task of uartecho, run every POLL_MS */
+static void polled_poll(void)
+{
+    uint8_t c;
+
+    if (HAL_GetTick() - lastPoll < POLL_MS)
+    {
+        return;
+    }
+    lastPoll = HAL_GetTick();
+    while (HAL_UART_Receive(&huart1, &c, 1, 0) == HAL_OK)
+    {
+        app_byte(c);
+    }
+    __HAL_UART_CLEAR_OREFLAG(&huart1);
+}
+
+static bool polled_send(const uint8_t *data, uint16_t len)
+{
+    return HAL_UART_Transmit(&huart1, (uint8_t *)data, len, HAL_MAX_DELAY) == HAL_OK;
+}
+
+/* ---- it ---- */
+static void it_start(void)
+{
+    HAL_UART_Receive_IT(&huart1, &rxByte, 1);
+}
+
+static void it_poll(void)
+{
+}
+
+/* UART_Start_Next_Tx() of uartexinterrupt: the oldest byte straight from the ring */
+static void it_kick(void)
+{
+    const uint8_t *span;
+
+    if (ringbuf_peek_span(&txRing, &span) > 0)
+    {
+        txBusy = 1;
+        HAL_UART_Transmit_IT(&huart1, (uint8_t *)span, 1);
+    }
+    else
+    {
+        txBusy = 0;
+    }
+}
+
+/* Called from the RX callback, like the echo in uartexinterrupt */
+static bool it_send(const uint8_t *data, uint16_t len)
+{
+    if (ringbuf_free(&txRing) < len)
+    {
+        return false;
+    }
+    ringbuf_write(&txRing, data, len);
+    if (!txBusy)
+    {
+        it_kick();
+    }
+    return true;
+}
+
+/* ---- ring ---- */
+static void ring_start(void)
+{
+    uart_rx_start(&uartRx, &huart1, &rxRing, UART_RX_MODE_DMA);
+}
+
+static void hal_start(void)
+{
+    uart_rx_start(&uartRx, &huart1, &rxRing, UART_RX_MODE_IT);
+}
+
+static void fast_start(void)
+{
+    uart_rx_start(&uartRx, &huart1, &rxRing, UART_RX_MODE_FAST);
+}
+
+static void ring_poll(void)
+{
+    uint8_t c;
+    while (ringbuf_get(&rxRing, &c))
+    {
+        app_byte(c);
+    }
+}
+
+static bool dma_send(const uint8_t *data, uint16_t len)
+{
+    return uart_tx_write(&uartTx, data, len);
+}
+
+/* ---- dma ---- */
+static void dma_rx_start(void)
+{
+    if (HAL_UARTEx_ReceiveToIdle_DMA(&huart1, rxBuf[rxActive], RX_BUF_SIZE) == HAL_OK)
+    {
+        __HAL_DMA_DISABLE_IT(&hdma_usart1_rx, DMA_IT_HT);
+    }
+}
+
+static void dma_poll(void)
+{
+    uint16_t len = rxLen[rxProcess];
+    if (len != 0u)
+    {
+        for (uint16_t i = 0; i < len; i++)
+        {
+            app_byte(rxBuf[rxProcess][i]);
+        }
+        rxLen[rxProcess] = 0;
+        rxProcess = RX_NEXT(rxProcess);
+    }
+}
+
+/* ---- dma4 ---- */
+static void dma4_start(void)
+{
+    HAL_UART_Receive_DMA(&huart1, rx4, RX4_SIZE);
+}
+
+static void dma4_poll(void)
+{
+}
+
+/* Called from the RX callback; the first uartdma sent an echo only while TX was free */
+static bool dma4_send(const uint8_t *data, uint16_t len)
+{
+    if (tx4Busy)
+    {
+        return false;
+    }
+    memcpy(tx4, data, len);
+    tx4Busy = 1;
+    HAL_UART_Transmit_DMA(&huart1, tx4, len);
+    return true;
+}
+
+static const strategy_t strategies[] =
+{
+    { "polled", polled_start, polled_poll, polled_send },
+    { "it",     it_start,     it_poll,     it_send     },
+    { "ring",   ring_start,   ring_poll,   dma_send    },
+    { "dma",    dma_rx_start, dma_poll,    dma_send    },
+    { "dma4",   dma4_start,   dma4_poll,   dma4_send   },
+    { "hal",    hal_start,    ring_poll,   dma_send    },
+    { "fast",   fast_start,   ring_poll,   dma_send    },
+};
+
+#define STRATEGIES (sizeof(strategies) / sizeof(strategies[0]))
+
+static void MX_DMA_Init(uint32_t rxMode)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma_usart1_rx.Instance                 = DMA1_Channel3;
+    hdma_usart1_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+    hdma_usart1_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_usart1_rx.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_rx.Init.Mode                = rxMode;
+    hdma_usart1_rx.Init.Priority            = DMA_PRIORITY_HIGH;
+    HAL_DMA_Init(&hdma_usart1_rx);
+    __HAL_LINKDMA(&huart1, hdmarx, hdma_usart1_rx);
+
+    hdma_usart1_tx.Instance                 = DMA1_Channel2;
+    hdma_usart1_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma_usart1_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma_usart1_tx.Init.MemInc              = DMA_MINC_ENABLE;
+    hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    hdma_usart1_tx.Init.Mode                = DMA_NORMAL;
+    hdma_usart1_tx.Init.Priority            = DMA_PRIORITY_LOW;
+    HAL_DMA_Init(&hdma_usart1_tx);
+    __HAL_LINKDMA(&huart1, hdmatx, hdma_usart1_tx);
+
+    HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+static void MX_USART1_UART_Init(uint32_t baud)
+{
+    __HAL_RCC_USART1_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    GPIO_InitStruct.Pin       = GPIO_PIN_9 | GPIO_PIN_10;
+    GPIO_InitStruct.Mode      = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull      = GPIO_NOPULL;
+    GPIO_InitStruct.Speed     = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = GPIO_AF1_USART1;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    huart1.Instance          = USART1;
+    huart1.Init.BaudRate     = baud;
+    huart1.Init.WordLength   = UART_WORDLENGTH_8B;
+    huart1.Init.StopBits     = UART_STOPBITS_1;
+    huart1.Init.Parity       = UART_PARITY_NONE;
+    huart1.Init.Mode         = UART_MODE_TX_RX;
+    huart1.Init.HwFlowCtl    = UART_HWCONTROL_NONE;
+    huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+    HAL_UART_Init(&huart1);
+
+    HAL_NVIC_SetPriority(USART1_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(USART1_IRQn);
+}
+
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (STRATEGY_IS(S_IT))
+    {
+        app_byte(rxByte);
+        HAL_UART_Receive_IT(huart, &rxByte, 1);
+    }
+    else if (STRATEGY_IS(S_DMA4))
+    {
+        for (uint16_t i = 0; i < RX4_SIZE; i++)
+        {
+            app_byte(rx4[i]);
+        }
+        HAL_UART_Receive_DMA(huart, rx4, RX4_SIZE);
+    }
+    else if (STRATEGY_IS(S_HAL))
+    {
+        uart_rx_on_cplt(&uartRx);
+    }
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+    if (STRATEGY_IS(S_IT))
+    {
+        ringbuf_skip(&txRing, 1);
+        it_kick();
+    }
+    else if (STRATEGY_IS(S_DMA4))
+    {
+        tx4Busy = 0;
+    }
+    else
+    {
+        uart_tx_on_cplt(&uartTx);
+    }
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    (void)huart;
+    if (STRATEGY_IS(S_RING))
+    {
+        uart_rx_on_event(&uartRx, Size);
+    }
+    else if (STRATEGY_IS(S_DMA))
+    {
+        uint8_t done = rxActive;
+        uint8_t next = RX_NEXT(done);
+
+        if (rxLen[next] == 0u)
+        {
+            rxLen[done] = Size;
+            rxActive    = next;
+        }
+        dma_rx_start();
+    }
+}
+
+/* Keep receiving after an overrun; uartexinterrupt itself would stop here */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return;
+    }
+    if (STRATEGY_IS(S_IT))
+    {
+        HAL_UART_Receive_IT(huart, &rxByte, 1);
+    }
+    else if (STRATEGY_IS(S_RING) || STRATEGY_IS(S_HAL))
+    {
+        uart_rx_on_error(&uartRx);
+    }
+    else if (STRATEGY_IS(S_DMA))
+    {
+        dma_rx_start();
+    }
+    else if (STRATEGY_IS(S_DMA4))
+    {
+        dma4_start();
+    }
+}
+
+void USART1_IRQHandler(void)
+{
+    /* uart_rx needs its own handler in every mode, as in uartringbuffer */
+    if (STRATEGY_IS(S_RING) || STRATEGY_IS(S_HAL) || STRATEGY_IS(S_FAST))
+    {
+        uart_rx_irq(&uartRx);
+    }
+    else
+    {
+        HAL_UART_IRQHandler(&huart1);
+    }
+}
+
+void DMA1_Channel2_3_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_usart1_tx);
+    HAL_DMA_IRQHandler(&hdma_usart1_rx);
+}
+
+void SysTick_Handler(void)
+{
+    HAL_IncTick();
+}
+
+/* -------------------------------------------------------------------------
+   Host side: traffic and measurement
+   ------------------------------------------------------------------------- */
+static pattern_t patterns[] =          // Burst length and gaps set by -b and -g
+{
+    { "steady", 0,         0             },
+    { "burst",  BURST_LEN, BURST_GAP_MS  },
+    { "sparse", 1,         SPARSE_GAP_MS },
+};
+
+#define PATTERNS (sizeof(patterns) / sizeof(patterns[0]))
+
+static uint32_t cmdCount = 200;
+static uint32_t baudRate;
+static const pattern_t *pattern;
+static uint64_t *rxEndNs;      // Command k's '\r' taken by the receiver
+static uint64_t *txEndNs;      // Reply k's '\n' off the TX pin
+static uint64_t firstRxNs, lastRxNs;
+static uint32_t cmdSeen;
+static char txLine[16];
+static uint8_t txLineLen;
+
+static void on_rx(void *ctx, uint8_t byte, uint64_t timeNs)
+{
+    (void)ctx;
+    if (firstRxNs == 0)
+    {
+        firstRxNs = timeNs;
+    }
+    lastRxNs = timeNs;
+    if (byte == '\r')
+    {
+        if (cmdSeen < cmdCount)
+        {
+            rxEndNs[cmdSeen] = timeNs;
+        }
+        cmdSeen++;
+    }
+}
+
+static void on_tx(void *ctx, uint8_t byte, uint64_t timeNs)
+{
+    (void)ctx;
+    if (byte != '\n')
+    {
+        if (txLineLen < sizeof(txLine))
+        {
+            txLine[txLineLen++] = (char)byte;
+        }
+        return;
+    }
+    if (txLineLen == REPLY_LEN - 1 && memcmp(txLine, "ok ", 3) == 0)
+    {
+        uint32_t seq = (uint32_t)strtoul(&txLine[3], NULL, 10);
+        if (seq < cmdCount && txEndNs[seq] == 0)
+        {
+            txEndNs[seq] = timeNs;
+        }
+    }
+    txLineLen = 0;
+}
+
+static uint32_t line_queued(void)
+{
+    halsim_uart_stats_t st;
+    halsim_uart_stats(USART1, &st);
+    return st.rxQueued;
+}
+
+/* Byte source: runs beside the simulator, paced by the RX line queue */
+static void *feeder(void *arg)
+{
+    (void)arg;
+    uint32_t frameNs = (uint32_t)(10000000000ull / baudRate);
+    uint32_t gapFrames = (uint32_t)((uint64_t)pattern->gapMs * 1000000u / frameNs);
+    char cmd[CMD_LEN + 1];
+
+    for (uint32_t i = 0; i < cmdCount; i++)
+    {
+        snprintf(cmd, sizeof(cmd), "ping %05u\r", (unsigned)(i % 100000u));
+        while (line_queued() > LINE_QUEUE || !halsim_uart_inject(USART1, (const uint8_t *)cmd, CMD_LEN))
+        {
+            usleep(200);
+        }
+        if (pattern->every != 0 && (i + 1) % pattern->every == 0)
+        {
+            while (!halsim_uart_inject_idle(USART1, gapFrames))
+            {
+                usleep(200);
+            }
+        }
+    }
+    while (line_queued() != 0)
+    {
+        usleep(1000);
+    }
+    uint64_t end = halsim_now_ns() + DRAIN_MS * 1000000ull;
+    while (halsim_now_ns() < end)
+    {
+        usleep(1000);
+    }
+    benchDone = 1;
+    return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_us(const uint64_t *sorted, uint32_t n, double p)
+{
+    if (n == 0)
+    {
+        return 0.0;
+    }
+    uint32_t i = (uint32_t)(p * (double)(n - 1) + 0.5);
+    return (double)sorted[i] / 1000.0;
+}
+
+/* One measurement, in a fresh process: the simulation cannot be restarted */
+static void run_one(const strategy_t *s, uint32_t baud, const pattern_t *p)
+{
+    pthread_t th;
+    halsim_uart_stats_t st;
+
+    strategy = s;
+    baudRate = baud;
+    pattern  = p;
+    rxEndNs = calloc(cmdCount, sizeof(uint64_t));
+    txEndNs = calloc(cmdCount, sizeof(uint64_t));
+    if (rxEndNs == NULL || txEndNs == NULL)
+    {
+        _exit(1);
+    }
+
+    halsim_uart_attach(USART1, on_tx, NULL);
+    halsim_uart_watch_rx(USART1, on_rx, NULL);
+    HAL_Init();
+
+    MX_DMA_Init((s == &strategies[S_RING]) ? DMA_CIRCULAR : DMA_NORMAL);
+    MX_USART1_UART_Init(baud);
+    ringbuf_init(&rxRing, rxStorage, sizeof(rxStorage));
+    ringbuf_init(&txRing, txStorage, (s == &strategies[S_IT]) ? IT_RING_SIZE : sizeof(txStorage));
+    uart_tx_init(&uartTx, &huart1, &txRing);
+    s->start();
+
+    pthread_create(&th, NULL, feeder, NULL);
+    while (!benchDone)
+    {
+        s->poll();
+    }
+    __disable_irq();
+
+    uint32_t injected = cmdCount * CMD_LEN;
+    uint32_t answered = 0;
+    uint64_t *lat = malloc(cmdCount * sizeof(uint64_t));
+    for (uint32_t i = 0; i < cmdCount; i++)
+    {
+        if (rxEndNs[i] != 0 && txEndNs[i] > rxEndNs[i])
+        {
+            lat[answered++] = txEndNs[i] - rxEndNs[i];
+        }
+    }
+    qsort(lat, answered, sizeof(uint64_t), cmp_u64);
+
+    double windowNs = (double)(lastRxNs - firstRxNs) + 10e9 / (double)baud;
+    uint32_t isrs = halsim_irq_count(USART1_IRQn) + halsim_irq_count(DMA1_Channel2_3_IRQn);
+    halsim_uart_stats(USART1, &st);
+
+    printf("%-8s %7u %-7s %9.0f %8.1f %8.1f %8.1f %8.1f %6.2f %6u %6u %5u %5u\n",
+           s->name, (unsigned)baud, p->name,
+           (double)appBytes * 1e9 / windowNs,
+           percentile_us(lat, answered, 0.50), percentile_us(lat, answered, 0.90),
+           percentile_us(lat, answered, 0.99), percentile_us(lat, answered, 1.00),
+           (double)isrs / (double)injected,
+           (unsigned)(injected - appBytes), (unsigned)st.rxOverruns,
+           (unsigned)replyDrops, (unsigned)(cmdCount - answered));
+    fflush(stdout);
+    _exit(0);
+}
+
+/* Comma-separated names -> bit mask over table entries */
+static uint32_t parse_names(const char *list, const void *table, size_t count, size_t stride)
+{
+    uint32_t mask = 0;
+    char buf[128];
+
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char *tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ","))
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+        {
+            const char *name = *(const char *const *)((const char *)table + i * stride);
+            if (strcmp(tok, name) == 0)
+            {
+                mask |= 1u << i;
+                break;
+            }
+        }
+        if (i == count)
+        {
+            fprintf(stderr, "unknown name: %s\n", tok);
+            exit(2);
+        }
+    }
+    return mask;
+}
+
+int main(int argc, char **argv)
+{
+    const char *bauds = "115200";
+    uint32_t strategyMask = (1u << STRATEGIES) - 1u;
+    uint32_t patternMask  = (1u << PATTERNS) - 1u;
+    double speed = 0.05;
+    char *end;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:p:t:b:g:n:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': bauds = optarg; break;
+        case 'p': patternMask  = parse_names(optarg, patterns, PATTERNS, sizeof(pattern_t)); break;
+        case 't': strategyMask = parse_names(optarg, strategies, STRATEGIES, sizeof(strategy_t)); break;
+        case 'b': patterns[1].every = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'g':
+            patterns[1].gapMs = (uint32_t)strtoul(optarg, &end, 10);
+            if (*end == ',')
+            {
+                patterns[2].gapMs = (uint32_t)strtoul(end + 1, NULL, 10);
+            }
+            break;
+        case 'n': cmdCount = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 's': speed = strtod(optarg, NULL); break;
+        default:
+            fprintf(stderr, "usage: %s [-r baud,...] [-p steady,burst,sparse] "
+                            "[-t polled,it,ring,dma,dma4,hal,fast] [-b burst] "
+                            "[-g burst_ms[,sparse_ms]] [-n commands] [-s speed]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (cmdCount == 0 || cmdCount > 100000u || speed <= 0.0)
+    {
+        fprintf(stderr, "need 1..100000 commands and a positive speed\n");
+        return 2;
+    }
+    if (patterns[1].every == 0 || patterns[1].gapMs > 1000u || patterns[2].gapMs > 1000u)
+    {
+        fprintf(stderr, "need a burst of 1 or more commands and gaps of 0..1000 ms\n");
+        return 2;
+    }
+    halsim_set_speed(speed);
+    setenv("HALSIM_TRACE", "none", 0);
+
+    printf("%u commands per run, virtual time at %.2fx wall clock, PCLK %u Hz\n",
+           (unsigned)cmdCount, speed, (unsigned)PCLK_HZ);
+    printf("burst: %u commands then %u ms idle, sparse: 1 command then %u ms idle\n\n",
+           (unsigned)patterns[1].every, (unsigned)patterns[1].gapMs, (unsigned)patterns[2].gapMs);
+    printf("%-8s %7s %-7s %9s %8s %8s %8s %8s %6s %6s %6s %5s %5s\n",
+           "strategy", "baud", "pattern", "B/s", "p50 us", "p90 us", "p99 us", "max us",
+           "isr/B", "drop", "ovr", "full", "lost");
+
+    char list[128];
+    snprintf(list, sizeof(list), "%s", bauds);
+    for (char *tok = strtok(list, ","); tok != NULL; tok = strtok(NULL, ","))
+    {
+        uint32_t baud = (uint32_t)strtoul(tok, NULL, 10);
+        if (baud == 0 || PCLK_HZ / baud < 16u)
+        {
+            fprintf(stderr, "baud %s: BRR must be >= 16 at %u Hz\n", tok, (unsigned)PCLK_HZ);
+            return 2;
+        }
+        for (size_t s = 0; s < STRATEGIES; s++)
+        {
+            for (size_t p = 0; p < PATTERNS; p++)
+            {
+                if (!(strategyMask & (1u << s)) || !(patternMask & (1u << p)))
+                {
+                    continue;
+                }
+                fflush(stdout);
+                pid_t pid = fork();
+                if (pid == 0)
+                {
+                    run_one(&strategies[s], baud, &patterns[p]);
+                }
+                int status = 0;
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                {
+                    printf("%-8s %7u %-7s  run failed\n", strategies[s].name,
+                           (unsigned)baud, patterns[p].name);
+                }
+            }
+        }
+    }
+    return 0;
+}
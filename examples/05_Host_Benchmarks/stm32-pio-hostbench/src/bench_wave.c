@@ -0,0 +1,83 @@
+/*
+ * File: bench_wave.c
+ * Project: STM32 PlatformIO Playground - Host Benchmarks
+ * Description:
+ * Cost of one breathing-LED duty update (examples/03_PWM_Signal/
+ * stm32-pio-pwmledbreathing), 0..1000 compare value:
+ *
+ *   sinf   : (sinf(phase) + 1) * 500 with a float phase and wrap, the
+ *            original code
+ *   wave   : wave_scale(wave_next()) on a Q15 table from the shared wave
+ *            library, one per built-in shape
+ *
+ * Check (the program exits non-zero if it fails): over one cycle the
+ * wave_sine output stays within 1 count of (1 - cos) / 2 computed in
+ * double precision, i.e. the table and interpolation lose nothing the
+ * 0..1000 timer resolution could show.
+ */
+
+#include <math.h>
+#include "bench.h"
+#include "wave.h"
+
+#define UPDATES   20000000u
+#define PERIOD    126u       // Updates per breath, as in the example
+
+static void bench_sinf(void)
+{
+    uint32_t sum = 0;
+    float phase = 0.0f;
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < UPDATES; i++)
+    {
+        sum += (uint32_t)((sinf(phase) + 1) * 500);
+        phase += 0.05f;
+        if (phase >= 2 * M_PI)
+        {
+            phase -= 2 * M_PI;
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report("sinf", t1 - t0, UPDATES, "update");
+}
+
+static void bench_table(const char *name, const uint16_t *table)
+{
+    uint32_t sum = 0;
+    wave_t w = WAVE_INIT(table, PERIOD);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < UPDATES; i++)
+    {
+        sum += wave_scale(wave_next(&w), 1000);
+    }
+    uint64_t t1 = bench_now_ns();
+    benchSink = sum;
+    bench_report(name, t1 - t0, UPDATES, "update");
+}
+
+int main(void)
+{
+    wave_t w = WAVE_INIT(wave_sine, PERIOD);
+    double worst = 0.0;
+
+    for (uint32_t k = 0; k < PERIOD; k++)
+    {
+        double ref = 1000.0 * (0.5 - 0.5 * cos(2.0 * M_PI * k / PERIOD));
+        double err = fabs((double)wave_scale(wave_next(&w), 1000) - ref);
+        if (err > worst)
+        {
+            worst = err;
+        }
+    }
+
+    printf("Breathing LED duty update, %u updates per cycle, %u updates\n", PERIOD, UPDATES);
+    bench_sinf();
+    bench_table("wave sine", wave_sine);
+    bench_table("wave sine gamma", wave_sine_gamma);
+    bench_table("wave triangle", wave_triangle);
+    bench_table("wave breath", wave_breath);
+    printf("table size: %u B each, max error vs double: %.2f counts of 1000 (limit 1)\n",
+           (unsigned)sizeof(wave_sine), worst);
+    return (worst <= 1.0) ? 0 : 1;
+}
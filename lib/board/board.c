@@ -0,0 +1,102 @@
+/*
+ * File: board.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Pin set-up shared by the examples, see board.h.
+ */
+
+#include "board.h"
+
+void board_led_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    HAL_GPIO_WritePin(BOARD_LED_PORT, BOARD_LED_PIN, GPIO_PIN_RESET);
+    gpio.Pin   = BOARD_LED_PIN;
+    gpio.Mode  = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull  = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(BOARD_LED_PORT, &gpio);
+}
+
+void board_uart_pins_init(USART_TypeDef *usart)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    gpio.Mode  = GPIO_MODE_AF_PP;
+    gpio.Pull  = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    if (usart == USART2)
+    {
+        __HAL_RCC_USART2_CLK_ENABLE();
+        gpio.Pin       = BOARD_USART2_PINS;
+        gpio.Alternate = BOARD_USART2_AF;
+        HAL_GPIO_Init(BOARD_USART2_PORT, &gpio);
+    }
+    else
+    {
+        __HAL_RCC_USART1_CLK_ENABLE();
+        gpio.Pin       = BOARD_USART1_PINS;
+        gpio.Alternate = BOARD_USART1_AF;
+        HAL_GPIO_Init(BOARD_USART1_PORT, &gpio);
+    }
+}
+
+void board_uart_flow_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    HAL_GPIO_WritePin(BOARD_USART1_RTS_PORT, BOARD_USART1_RTS_PIN, GPIO_PIN_SET);
+    gpio.Pin   = BOARD_USART1_RTS_PIN;
+    gpio.Mode  = GPIO_MODE_OUTPUT_PP;
+    gpio.Pull  = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(BOARD_USART1_RTS_PORT, &gpio);
+
+    /* Pulled down: an unconnected CTS lets the USART send */
+    gpio.Pin       = BOARD_USART1_CTS_PIN;
+    gpio.Mode      = GPIO_MODE_AF_PP;
+    gpio.Pull      = GPIO_PULLDOWN;
+    gpio.Alternate = BOARD_USART1_AF;
+    HAL_GPIO_Init(BOARD_USART1_CTS_PORT, &gpio);
+}
+
+/* Pins of `mask` in alternate function `af`; OTYPER, OSPEEDR and PUPDR
+   keep their reset values (push-pull, low speed, no pull) */
+static void board_pins_af(GPIO_TypeDef *port, uint32_t mask, uint32_t af)
+{
+    uint32_t moder = port->MODER;
+    uint32_t afr[2] = { port->AFR[0], port->AFR[1] };
+
+    for (uint32_t n = 0; n < 16U; n++)
+    {
+        if ((mask & (1UL << n)) != 0U)
+        {
+            moder = (moder & ~(3UL << (2U * n))) | (2UL << (2U * n));
+            afr[n >> 3] = (afr[n >> 3] & ~(0xFUL << (4U * (n & 7U)))) | (af << (4U * (n & 7U)));
+        }
+    }
+    port->AFR[0] = afr[0];
+    port->AFR[1] = afr[1];
+    port->MODER = moder;       // AF chosen before the pins switch to it
+}
+
+void board_boot_init(USART_TypeDef *usart)
+{
+    RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_DMAEN;
+    if (usart == USART2)
+    {
+        RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+        (void)RCC->APB1ENR;
+        board_pins_af(BOARD_USART2_PORT, BOARD_USART2_PINS, BOARD_USART2_AF);
+    }
+    else
+    {
+        RCC->APB2ENR |= RCC_APB2ENR_USART1EN;
+        (void)RCC->APB2ENR;
+        board_pins_af(BOARD_USART1_PORT, BOARD_USART1_PINS, BOARD_USART1_AF);
+    }
+}
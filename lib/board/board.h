@@ -0,0 +1,164 @@
+/*
+ * File: board.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Compile-time traits of the Nucleo-64 boards in the platformio.ini
+ * matrix, selected by the CMSIS part define each env passes:
+ *
+ *   env             part         flash   RAM    HSI48  DMA request routing
+ *   nucleo_f030r8   STM32F030x8   64 KB   8 KB  no     fixed per channel
+ *   nucleo_f070rb   STM32F070xB  128 KB  16 KB  no     fixed per channel
+ *   nucleo_f072rb   STM32F072xB  128 KB  16 KB  yes    fixed per channel
+ *   nucleo_f091rc   STM32F091xC  256 KB  32 KB  yes    DMA1_CSELR
+ *
+ * Everything here is a constant expression, so a size, a channel or a
+ * clock profile chosen from a trait costs nothing at run time and a
+ * combination that does not fit fails the build:
+ *
+ *     #define RXBUF_SIZE  BOARD_BUF_SIZE(128)     // 128 on the F030, 512 on the F091
+ *     BOARD_RAM_ASSERT(RXBUF_SIZE + TXBUF_SIZE);
+ *
+ *     hdma_usart1_rx.Instance = BOARD_USART1_RX_DMA;
+ *     HAL_DMA_Init(&hdma_usart1_rx);
+ *     BOARD_DMA_ROUTE(BOARD_USART1_RX_REQ);      // Only the F091 needs it
+ *
+ *     clk_init(BOARD_CLK_FAST);                  // HSI48 where there is one, else the PLL
+ *
+ * The four boards share the pinout the examples use: LED LD2 on PA5, B1
+ * on PC13 (active low), USART2 on PA2/PA3 to the ST-Link virtual COM
+ * port and USART1 on PA9/PA10 for an external adapter or peer. USART1
+ * also has its flow control lines on the morpho header: CTS on PA11,
+ * RTS on PA12. The ST-Link does not wire them for USART2.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "stm32f0xx_hal.h"
+#include "clk.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --- Part: memory and clocks (tools/size_report.py reads its flash and
+       RAM budgets from these lines: keep one "(N * 1024U)" per define) --- */
+
+#if defined(STM32F030x8)
+#define BOARD_NAME        "nucleo_f030r8"
+#define BOARD_FLASH_SIZE  (64U * 1024U)
+#define BOARD_RAM_SIZE    (8U * 1024U)
+#elif defined(STM32F070xB)
+#define BOARD_NAME        "nucleo_f070rb"
+#define BOARD_FLASH_SIZE  (128U * 1024U)
+#define BOARD_RAM_SIZE    (16U * 1024U)
+#elif defined(STM32F072xB)
+#define BOARD_NAME        "nucleo_f072rb"
+#define BOARD_FLASH_SIZE  (128U * 1024U)
+#define BOARD_RAM_SIZE    (16U * 1024U)
+#elif defined(STM32F091xC)
+#define BOARD_NAME        "nucleo_f091rc"
+#define BOARD_FLASH_SIZE  (256U * 1024U)
+#define BOARD_RAM_SIZE    (32U * 1024U)
+#else
+#error "board: no STM32F030x8, STM32F070xB, STM32F072xB or STM32F091xC define"
+#endif
+
+/* RAM kept for the stack, HAL handles and library state; the rest is for buffers */
+#ifndef BOARD_RAM_RESERVE
+#define BOARD_RAM_RESERVE (3U * 1024U)
+#endif
+
+/* A buffer sized for the 8 KB F030, scaled with the RAM of the board
+   (x2 on 16 KB, x4 on 32 KB); powers of two stay powers of two */
+#define BOARD_BUF_SIZE(size8k)  ((size8k) * (BOARD_RAM_SIZE / (8U * 1024U)))
+
+/* Fail the build when the application's buffers leave too little RAM */
+#define BOARD_RAM_ASSERT(bytes) \
+    _Static_assert((bytes) <= BOARD_RAM_SIZE - BOARD_RAM_RESERVE, \
+                   "buffers (" #bytes ") exceed the RAM of " BOARD_NAME)
+
+/* 48 MHz without waiting for a PLL lock where the part has the HSI48 */
+#define BOARD_HAS_HSI48   CLK_HAS_HSI48
+#define BOARD_CLK_FAST    (BOARD_HAS_HSI48 ? CLK_HSI48 : CLK_PERF)
+
+/* --- Pins --- */
+
+#define BOARD_LED_PORT        GPIOA
+#define BOARD_LED_PIN_NUM     5U
+#define BOARD_LED_PIN         GPIO_PIN_5
+
+#define BOARD_BUTTON_PORT     GPIOC
+#define BOARD_BUTTON_PIN      GPIO_PIN_13
+#define BOARD_BUTTON_ACTIVE_LOW true
+
+/* USART1: PA9 TX, PA10 RX (external adapter or peer) */
+#define BOARD_USART1_PORT     GPIOA
+#define BOARD_USART1_PINS     (GPIO_PIN_9 | GPIO_PIN_10)
+#define BOARD_USART1_AF       GPIO_AF1_USART1
+
+/* USART1 flow control: PA11 CTS in AF1, PA12 RTS as a GPIO for uart_rx
+   (low = the peer may send) */
+#define BOARD_USART1_HAS_FLOW 1
+#define BOARD_USART1_CTS_PORT GPIOA
+#define BOARD_USART1_CTS_PIN  GPIO_PIN_11
+#define BOARD_USART1_RTS_PORT GPIOA
+#define BOARD_USART1_RTS_PIN  GPIO_PIN_12
+
+/* USART2: PA2 TX, PA3 RX (ST-Link virtual COM port) */
+#define BOARD_USART2_PORT     GPIOA
+#define BOARD_USART2_PINS     (GPIO_PIN_2 | GPIO_PIN_3)
+#define BOARD_USART2_AF       GPIO_AF1_USART2
+#define BOARD_USART2_HAS_FLOW 0     // No RTS/CTS on the virtual COM port
+
+/* --- DMA request map (DMA1; the F072/F091 vectors take the F030 names
+       through the CMSIS aliases) --- */
+
+#define BOARD_USART1_TX_DMA         DMA1_Channel2
+#define BOARD_USART1_RX_DMA         DMA1_Channel3
+#define BOARD_USART1_DMA_IRQn       DMA1_Channel2_3_IRQn
+#define BOARD_USART1_DMA_IRQHandler DMA1_Channel2_3_IRQHandler
+
+#define BOARD_USART2_TX_DMA         DMA1_Channel4
+#define BOARD_USART2_RX_DMA         DMA1_Channel5
+#define BOARD_USART2_DMA_IRQn       DMA1_Channel4_5_IRQn
+#define BOARD_USART2_DMA_IRQHandler DMA1_Channel4_5_IRQHandler
+
+/* The F09x only connects a request to a channel through DMA1_CSELR (all
+   zero after reset: nothing reaches the USART channels); the others
+   have one fixed request per channel */
+#if defined(STM32F091xC)
+#define BOARD_USART1_TX_REQ   HAL_DMA1_CH2_USART1_TX
+#define BOARD_USART1_RX_REQ   HAL_DMA1_CH3_USART1_RX
+#define BOARD_USART2_TX_REQ   HAL_DMA1_CH4_USART2_TX
+#define BOARD_USART2_RX_REQ   HAL_DMA1_CH5_USART2_RX
+#define BOARD_DMA_ROUTE(req)  __HAL_DMA1_REMAP(req)
+#else
+#define BOARD_USART1_TX_REQ   0U
+#define BOARD_USART1_RX_REQ   0U
+#define BOARD_USART2_TX_REQ   0U
+#define BOARD_USART2_RX_REQ   0U
+#define BOARD_DMA_ROUTE(req)  ((void)(req))
+#endif
+
+/* LD2 as a push-pull output, off */
+void board_led_init(void);
+
+/* Clocks and AF pins of USART1 or USART2 (before HAL_UART_Init()) */
+void board_uart_pins_init(USART_TypeDef *usart);
+
+/* USART1 flow control pins: CTS in AF1 (for UART_HWCONTROL_CTS), RTS a
+   push-pull output, high (stop) until uart_rx_flow() lowers it */
+void board_uart_flow_init(void);
+
+/* The same for a fast boot, by register and from reset values: GPIOA
+   and DMA1 clocks in one write, the USART clock, TX/RX pins in AF1 (no
+   HAL_GPIO_Init() pin loop, one read-back for all clock enables) */
+void board_boot_init(USART_TypeDef *usart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOARD_H */
@@ -0,0 +1,142 @@
+/*
+ * File: boot.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Boot-phase trace and fast start-up helpers, see boot.h.
+ *
+ * The trace timer counts microseconds: at every mark the 16-bit count
+ * since the previous mark is added to a 32-bit total, and when the
+ * system clock has changed the prescaler is reloaded (UG restarts the
+ * count at 0). Marks are made from main() before the scheduler or any
+ * interrupt uses them, so nothing here is masked.
+ */
+
+#include "boot.h"
+#include "clk.h"
+#include "hwio.h"
+#ifdef HALSIM
+#include "halsim.h"
+#endif
+
+HAL_StatusTypeDef boot_uart_init(UART_HandleTypeDef *huart)
+{
+    USART_TypeDef *usart = huart->Instance;
+
+    usart->CR2 = huart->Init.StopBits;
+    usart->CR3 = huart->Init.HwFlowCtl | huart->Init.OneBitSampling;
+    usart->CR1 = huart->Init.WordLength | huart->Init.Parity |
+                 huart->Init.Mode | huart->Init.OverSampling;
+    if (clk_retime_uart(huart) != HAL_OK)     // BRR for the baud rate at this PCLK
+    {
+        return HAL_ERROR;
+    }
+    HW_REG_WRITE(usart->CR1, usart->CR1 | USART_CR1_UE);
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+#if BOOT_TRACE
+
+#if defined(BOOT_PULSE_PORT)
+static const hw_pin_t pulse = HW_PIN(BOOT_PULSE_PORT, BOOT_PULSE_PIN);
+#endif
+
+static boot_stage_t stages[BOOT_STAGES];
+static uint8_t count;
+
+#ifdef HALSIM
+static uint64_t startNs;
+#else
+static uint32_t elapsedUs;     // Up to the previous mark
+static uint16_t lastCnt;
+static uint32_t timerHz;       // Clock the prescaler is set for
+
+/* One tick per microsecond at the current clock (PCLK = HCLK in every
+   clk profile); UG loads PSC now and restarts the count */
+static void boot_prescale(void)
+{
+    timerHz = SystemCoreClock;
+    BOOT_TIM->PSC = timerHz / 1000000U - 1U;
+    BOOT_TIM->EGR = TIM_EGR_UG;
+    lastCnt = 0U;
+}
+#endif
+
+static uint32_t boot_now_us(void)
+{
+#ifdef HALSIM
+    return (uint32_t)((halsim_cpu_ns() - startNs) / 1000U);
+#else
+    uint16_t cnt = (uint16_t)BOOT_TIM->CNT;
+
+    elapsedUs += (uint16_t)(cnt - lastCnt);
+    lastCnt = cnt;
+    if (SystemCoreClock != timerHz)
+    {
+        boot_prescale();
+    }
+    return elapsedUs;
+#endif
+}
+
+void boot_start(void)
+{
+#ifdef HALSIM
+    startNs = halsim_cpu_ns();
+#else
+    BOOT_TIM_CLK_ENABLE();
+    BOOT_TIM->CR1 = 0U;
+    BOOT_TIM->ARR = 0xFFFFU;
+    boot_prescale();
+    elapsedUs = 0U;
+    BOOT_TIM->CR1 = TIM_CR1_CEN;
+#endif
+    count = 0U;
+
+#if defined(BOOT_PULSE_PORT)
+    /* Push-pull output, high: the first edge after NRST is main() */
+    BOOT_PULSE_CLK_ENABLE();
+    hw_pin_high(pulse);
+    BOOT_PULSE_PORT->MODER = (BOOT_PULSE_PORT->MODER & ~(3UL << (2U * BOOT_PULSE_PIN))) |
+                             (1UL << (2U * BOOT_PULSE_PIN));
+#endif
+}
+
+void boot_mark(const char *stage)
+{
+    uint32_t us = boot_now_us();
+
+#if defined(BOOT_PULSE_PORT)
+    hw_pin_toggle(pulse);
+#endif
+    if (count < BOOT_STAGES)
+    {
+        stages[count].stage = stage;
+        stages[count].us = us;
+    }
+    if (count < 0xFFU)
+    {
+        count++;
+    }
+}
+
+void boot_done(void)
+{
+#ifndef HALSIM
+    BOOT_TIM->CR1 = 0U;
+    BOOT_TIM_CLK_DISABLE();
+#endif
+}
+
+const boot_stage_t *boot_trace(uint8_t *n)
+{
+    *n = count;
+    return stages;
+}
+
+#endif /* BOOT_TRACE */
@@ -0,0 +1,114 @@
+/*
+ * File: boot.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Boot-phase trace and fast start-up helpers.
+ *
+ * Trace: BOOT_START() as the first statement of main() starts a 1 MHz
+ * count on a timer (TIM14 by default); BOOT_MARK() at the end of every
+ * init stage records the microseconds since then, and optionally toggles
+ * a pin, so a logic analyser on that pin and on NRST sees every stage
+ * boundary, including the time before main() (startup code, .data/.bss
+ * set-up) that no timer can see:
+ *
+ *     BOOT_START();
+ *     HAL_Init();
+ *     BOOT_MARK("hal");
+ *     SystemClock_Config();
+ *     BOOT_MARK("clock");
+ *     ...
+ *     print("Ready\r\n");
+ *     BOOT_MARK("ready queued");      // DMA started, not yet on the wire
+ *     BOOT_DONE();                    // Timer released (PROF_INIT() after this)
+ *
+ * boot_trace() hands the stages to the application to print. Build with
+ * -DBOOT_TRACE=1 to compile it in; otherwise the macros expand to
+ * nothing and the trace part of boot.c is empty. Pulses on a pin:
+ *
+ *     build_flags = -DBOOT_TRACE=1 -DBOOT_PULSE_PORT=GPIOC -DBOOT_PULSE_PIN=8
+ *                   -D"BOOT_PULSE_CLK_ENABLE()=__HAL_RCC_GPIOC_CLK_ENABLE()"
+ *
+ * The pin goes high at BOOT_START() and changes level at every mark.
+ * The prescaler follows SystemCoreClock at every mark, so the stage that
+ * switches the clock reads a few microseconds long (the ticks between
+ * the switch and its mark are counted at the old rate). A stage must
+ * end within 65 ms. The timer is the one prof.h uses: BOOT_DONE() before
+ * PROF_INIT(), or move one of them (define BOOT_TIM and both clock
+ * macros). On the host simulation the stamps are the CPU time of the
+ * simulated CPU thread (halsim_cpu_ns()): comparable between builds on
+ * one machine, not target microseconds.
+ *
+ * Fast start-up: boot_uart_init() is HAL_UART_Init() for a USART still
+ * at its reset values: CR1..CR3 and BRR written directly and the handle
+ * marked ready for the HAL transfer functions, without the MSP callback
+ * and the wait for TEACK/REACK. board_boot_init() does the clocks and
+ * pins. Everything the first byte does not need can then wait until
+ * after it.
+ */
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BOOT_TRACE
+#define BOOT_TRACE 0
+#endif
+
+/* Marks kept; later ones are counted but not stored */
+#ifndef BOOT_STAGES
+#define BOOT_STAGES 12
+#endif
+
+/* Another timer (e.g. TIM16): define BOOT_TIM and both clock macros */
+#ifndef BOOT_TIM
+#define BOOT_TIM TIM14
+#define BOOT_TIM_CLK_ENABLE()  __HAL_RCC_TIM14_CLK_ENABLE()
+#define BOOT_TIM_CLK_DISABLE() __HAL_RCC_TIM14_CLK_DISABLE()
+#endif
+
+typedef struct
+{
+    const char *stage;         // Name passed to BOOT_MARK()
+    uint32_t us;               // Microseconds from BOOT_START() to the mark
+} boot_stage_t;
+
+/* HAL_UART_Init() by register for a USART at its reset values (clock on,
+   pins set); HAL_ERROR if the baud rate is out of reach at this PCLK */
+HAL_StatusTypeDef boot_uart_init(UART_HandleTypeDef *huart);
+
+#if BOOT_TRACE
+
+void boot_start(void);
+
+/* End of a stage; `stage` must stay valid (a string literal) */
+void boot_mark(const char *stage);
+
+/* Stop the timer and release its clock */
+void boot_done(void);
+
+/* Recorded stages, oldest first; *count marks made (may exceed BOOT_STAGES) */
+const boot_stage_t *boot_trace(uint8_t *count);
+
+#define BOOT_START()        boot_start()
+#define BOOT_MARK(stage)    boot_mark(stage)
+#define BOOT_DONE()         boot_done()
+
+#else
+
+#define BOOT_START()        ((void)0)
+#define BOOT_MARK(stage)    ((void)0)
+#define BOOT_DONE()         ((void)0)
+
+#endif /* BOOT_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOOT_H */
@@ -0,0 +1,334 @@
+/*
+ * File: button.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Interrupt-driven push buttons, see button.h.
+ *
+ * Concurrency: the EXTI and scan timer interrupts own the button state
+ * and must not preempt each other (the timer gets BUTTON_IRQ_PRIORITY;
+ * give the EXTI interrupts the same). The queue is written by the timer
+ * interrupt and read by the main loop.
+ */
+
+#include "button.h"
+
+_Static_assert((BUTTON_QUEUE_LEN & (BUTTON_QUEUE_LEN - 1)) == 0 && BUTTON_QUEUE_LEN <= 256,
+               "BUTTON_QUEUE_LEN must be a power of two <= 256");
+_Static_assert(BUTTON_INTEGRATE >= 1U && BUTTON_INTEGRATE <= 255U, "BUTTON_INTEGRATE must fit in a uint8_t");
+_Static_assert(BUTTON_TICK_MS >= 1U && BUTTON_TICK_MS <= 65U, "BUTTON_TICK_MS must fit a 16-bit us timer");
+
+#define TICK_US     (BUTTON_TICK_MS * 1000U)
+#define QUEUE_MASK  ((uint32_t)BUTTON_QUEUE_LEN - 1U)
+
+typedef struct
+{
+    uint32_t edge;                 // Start of the change being debounced
+    uint32_t pressedAt;
+    uint32_t releasedAt;
+    uint8_t level;                 // Integrator, 0 = released .. BUTTON_INTEGRATE = pressed
+    bool pressed;                  // Debounced state
+    bool armed;                    // EXTI line unmasked
+    bool settling;                 // A change started at `edge` is being debounced
+    bool longDue;                  // Held, BUTTON_LONG not sent yet
+    bool doubleOpen;               // Released from a short press at `releasedAt`
+} button_state_t;
+
+static const button_config_t *buttons;
+static uint8_t buttonCount;
+static button_state_t state[BUTTON_MAX];
+static uint32_t timeBase;          // us at the last scan tick
+static bool running;
+
+static button_event_t queue[BUTTON_QUEUE_LEN];
+static volatile uint32_t queueHead, queueTail;   // Free-running
+static button_stats_t stats;
+
+/* Counter clock of the timers: PCLK, x2 when the APB prescaler divides */
+static uint32_t button_timer_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (pclk != HAL_RCC_GetHCLKFreq()) ? 2U * pclk : pclk;
+}
+
+/* Current time; an overflow whose interrupt is still pending counts too */
+static uint32_t button_now(void)
+{
+    if (!running)
+    {
+        return timeBase;
+    }
+    uint32_t cnt = BUTTON_TIM->CNT;
+    if ((BUTTON_TIM->SR & TIM_SR_UIF) != 0U && cnt < TICK_US / 2U)
+    {
+        cnt += TICK_US;
+    }
+    return timeBase + cnt;
+}
+
+static bool button_sample(const button_config_t *b)
+{
+    bool high = (b->port->IDR & b->pin) != 0U;
+    return high != b->activeLow;
+}
+
+static void button_post(uint8_t button, button_event_type_t type, uint32_t now, uint32_t latency)
+{
+    uint32_t head = queueHead;
+
+    if (head - queueTail > QUEUE_MASK)
+    {
+        stats.dropped++;
+        return;
+    }
+    queue[head & QUEUE_MASK] = (button_event_t){ button, (uint8_t)type, now, latency };
+    queueHead = head + 1U;
+}
+
+static void button_timer_start(void)
+{
+    if (!running)
+    {
+        BUTTON_TIM->CNT = 0U;
+        BUTTON_TIM->CR1 |= TIM_CR1_CEN;
+        running = true;
+    }
+}
+
+static void button_timer_stop(void)
+{
+    BUTTON_TIM->CR1 &= ~TIM_CR1_CEN;
+    BUTTON_TIM->SR = 0U;
+    running = false;
+}
+
+/* Unmask the line of a stable button; a change that slipped in before
+   the line was armed is picked up by the re-sample */
+static void button_arm(uint8_t i, uint32_t now)
+{
+    const button_config_t *b = &buttons[i];
+    button_state_t *s = &state[i];
+
+    EXTI->PR = b->pin;             // Edges of the bounce that was ignored
+    EXTI->IMR |= b->pin;
+    s->armed = true;
+    if (button_sample(b) != s->pressed)
+    {
+        EXTI->IMR &= ~(uint32_t)b->pin;
+        s->armed = false;
+        s->settling = true;
+        s->edge = now;
+    }
+}
+
+/* One integrator step; returns true while the button needs the scan timer */
+static bool button_scan(uint8_t i, uint32_t now)
+{
+    button_state_t *s = &state[i];
+    bool sample = button_sample(&buttons[i]);
+
+    if (sample && s->level < BUTTON_INTEGRATE)
+    {
+        s->level++;
+    }
+    else if (!sample && s->level > 0U)
+    {
+        s->level--;
+    }
+
+    if (sample != s->pressed && !s->settling)
+    {
+        s->settling = true;        // Seen by the scan before any edge
+        s->edge = now;
+    }
+
+    if (!s->pressed && s->level == BUTTON_INTEGRATE)
+    {
+        s->pressed = true;
+        s->settling = false;
+        s->longDue = true;
+        s->pressedAt = now;
+        button_post(i, BUTTON_PRESS, now, now - s->edge);
+        if (s->doubleOpen)
+        {
+            s->doubleOpen = false;
+            button_post(i, BUTTON_DOUBLE, now, now - s->edge);
+        }
+    }
+    else if (s->pressed && s->level == 0U)
+    {
+        s->pressed = false;
+        s->settling = false;
+        s->doubleOpen = s->longDue;    // No double-click after a long press
+        s->longDue = false;
+        s->releasedAt = now;
+        button_post(i, BUTTON_RELEASE, now, now - s->edge);
+    }
+    else if (s->level == (s->pressed ? BUTTON_INTEGRATE : 0U))
+    {
+        s->settling = false;       // A glitch that did not last
+    }
+
+    if (s->longDue && now - s->pressedAt >= BUTTON_LONG_MS * 1000U)
+    {
+        s->longDue = false;
+        button_post(i, BUTTON_LONG, now, now - s->pressedAt);
+    }
+    if (s->doubleOpen && now - s->releasedAt > BUTTON_DOUBLE_MS * 1000U)
+    {
+        s->doubleOpen = false;
+    }
+
+    if (!s->armed && !s->settling)
+    {
+        button_arm(i, now);
+    }
+    return !s->armed || s->settling || s->longDue || s->doubleOpen;
+}
+
+HAL_StatusTypeDef button_init(const button_config_t *config, uint8_t count)
+{
+    uint32_t lines = 0U;
+
+    if (count == 0U || count > BUTTON_MAX)
+    {
+        return HAL_ERROR;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if ((lines & config[i].pin) != 0U || config[i].pin == 0U ||
+            (config[i].pin & (config[i].pin - 1U)) != 0U)
+        {
+            return HAL_ERROR;      // One pin per button, one button per EXTI line
+        }
+        lines |= config[i].pin;
+    }
+
+    EXTI->IMR &= ~lines;
+    buttons = NULL;
+
+    BUTTON_TIM_CLK_ENABLE();
+    BUTTON_TIM->CR1 = TIM_CR1_URS;                 // Only overflows raise UIF
+    BUTTON_TIM->PSC = button_timer_clock() / 1000000U - 1U;
+    BUTTON_TIM->ARR = TICK_US - 1U;
+    BUTTON_TIM->EGR = TIM_EGR_UG;                  // Load PSC
+    BUTTON_TIM->SR = 0U;
+    BUTTON_TIM->DIER = TIM_DIER_UIE;
+    running = false;
+    timeBase = 0U;
+    queueHead = queueTail = 0U;
+    stats = (button_stats_t){ 0 };
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        button_state_t *s = &state[i];
+        *s = (button_state_t){ 0 };
+        s->pressed = button_sample(&config[i]);    // Held at reset: no event
+        s->level = s->pressed ? BUTTON_INTEGRATE : 0U;
+    }
+    buttons = config;
+    buttonCount = count;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        button_arm(i, 0U);
+        if (!state[i].armed)
+        {
+            button_timer_start();
+        }
+    }
+
+    HAL_NVIC_SetPriority(BUTTON_TIM_IRQn, BUTTON_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(BUTTON_TIM_IRQn);
+    return HAL_OK;
+}
+
+void button_exti(uint16_t pin)
+{
+    for (uint8_t i = 0; buttons != NULL && i < buttonCount; i++)
+    {
+        button_state_t *s = &state[i];
+
+        if (buttons[i].pin != pin)
+        {
+            continue;
+        }
+        if (!s->armed)
+        {
+            return;                // Pending bit of a masked line, seen with another line
+        }
+        EXTI->IMR &= ~(uint32_t)pin;               // Ignore the bounce
+        s->armed = false;
+        if (!s->settling)
+        {
+            s->settling = true;
+            s->edge = button_now();
+        }
+        stats.wakeups++;
+        button_timer_start();
+        return;
+    }
+}
+
+void button_timer_irq(void)
+{
+    bool busy = false;
+
+    if ((BUTTON_TIM->SR & TIM_SR_UIF) == 0U)
+    {
+        return;
+    }
+    BUTTON_TIM->SR = ~(uint32_t)TIM_SR_UIF;
+    timeBase += TICK_US;
+    stats.ticks++;
+
+    for (uint8_t i = 0; i < buttonCount; i++)
+    {
+        busy |= button_scan(i, timeBase);
+    }
+    if (!busy)
+    {
+        button_timer_stop();
+    }
+}
+
+void button_retime(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    BUTTON_TIM->PSC = button_timer_clock() / 1000000U - 1U;   // Preloaded: next overflow
+    if (!running)
+    {
+        BUTTON_TIM->EGR = TIM_EGR_UG;              // Load it now; URS: no UIF
+    }
+    __set_PRIMASK(primask);
+}
+
+bool button_get(button_event_t *ev)
+{
+    uint32_t tail = queueTail;
+
+    if (tail == queueHead)
+    {
+        return false;
+    }
+    *ev = queue[tail & QUEUE_MASK];
+    queueTail = tail + 1U;
+    return true;
+}
+
+bool button_pressed(uint8_t button)
+{
+    return button < buttonCount && state[button].pressed;
+}
+
+bool button_idle(void)
+{
+    return !running;
+}
+
+void button_stats(button_stats_t *out)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats;
+    __set_PRIMASK(primask);
+}
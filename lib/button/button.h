@@ -0,0 +1,150 @@
+/*
+ * File: button.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Interrupt-driven push buttons: debounce, press/release/long/double
+ * events, and no CPU time while nothing is pressed.
+ *
+ * Each button's pin is an EXTI line on both edges. The first edge of a
+ * button masks its line (the contact bounce would otherwise interrupt
+ * the core dozens of times), timestamps the press and starts a scan
+ * timer. Every BUTTON_TICK_MS the timer interrupt samples all buttons
+ * into an integrator per button: a pressed sample counts up, a released
+ * one down, and only a full (BUTTON_INTEGRATE) or empty integrator
+ * changes the debounced state. Once a button is stable again its line is
+ * unmasked; when every button is stable and no long-press or
+ * double-click window is open, the timer stops and the core can sleep
+ * until the next edge.
+ *
+ *     static const button_config_t buttons[] = {
+ *         { GPIOC, GPIO_PIN_13, true },            // Nucleo user button, active low
+ *     };
+ *     button_init(buttons, 1);
+ *
+ *     void HAL_GPIO_EXTI_Callback(uint16_t pin) { button_exti(pin); }
+ *     void TIM16_IRQHandler(void)               { button_timer_irq(); }
+ *
+ *     button_event_t ev;
+ *     while (button_get(&ev)) { ... }
+ *
+ * The application configures the pins (GPIO_MODE_IT_RISING_FALLING, pull)
+ * and enables the EXTI interrupts at BUTTON_IRQ_PRIORITY; button_init()
+ * samples every button before unmasking its line. Events are queued by the timer
+ * interrupt and read by the main loop (single producer, single consumer).
+ *
+ * Times are microseconds of the scan timer (1 MHz counter). They only
+ * advance while the timer runs, which is enough for every interval the
+ * state machine measures: a stopped timer means nothing was pending.
+ */
+
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Buttons handled (EXTI lines are per pin number: one button per number) */
+#ifndef BUTTON_MAX
+#define BUTTON_MAX 8
+#endif
+
+/* Scan period */
+#ifndef BUTTON_TICK_MS
+#define BUTTON_TICK_MS 5U
+#endif
+
+/* Agreeing samples for a state change: debounce time is up to this many ticks */
+#ifndef BUTTON_INTEGRATE
+#define BUTTON_INTEGRATE 4U
+#endif
+
+/* Held this long: BUTTON_LONG, once per press */
+#ifndef BUTTON_LONG_MS
+#define BUTTON_LONG_MS 800U
+#endif
+
+/* A press this soon after the release of a short press: BUTTON_DOUBLE */
+#ifndef BUTTON_DOUBLE_MS
+#define BUTTON_DOUBLE_MS 300U
+#endif
+
+/* Event queue depth (power of two) */
+#ifndef BUTTON_QUEUE_LEN
+#define BUTTON_QUEUE_LEN 16
+#endif
+
+/* Another timer: define BUTTON_TIM, BUTTON_TIM_IRQn and BUTTON_TIM_CLK_ENABLE() */
+#ifndef BUTTON_TIM
+#define BUTTON_TIM TIM16
+#define BUTTON_TIM_IRQn TIM16_IRQn
+#define BUTTON_TIM_CLK_ENABLE() __HAL_RCC_TIM16_CLK_ENABLE()
+#endif
+
+/* Scan timer priority; use the same for the buttons' EXTI interrupts */
+#ifndef BUTTON_IRQ_PRIORITY
+#define BUTTON_IRQ_PRIORITY 3U
+#endif
+
+typedef enum
+{
+    BUTTON_PRESS,                  // Debounced press
+    BUTTON_RELEASE,                // Debounced release
+    BUTTON_LONG,                   // Still held after BUTTON_LONG_MS
+    BUTTON_DOUBLE                  // Second press within BUTTON_DOUBLE_MS (after its BUTTON_PRESS)
+} button_event_type_t;
+
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint16_t pin;                  // GPIO_PIN_x
+    bool activeLow;                // Pressed reads 0 (pull-up and a switch to ground)
+} button_config_t;
+
+typedef struct
+{
+    uint8_t button;                // Index in the config table
+    uint8_t type;                  // button_event_type_t
+    uint32_t time;                 // When the event was posted, us
+    uint32_t latency;              // us since the edge that started it (LONG: held for)
+} button_event_t;
+
+typedef struct
+{
+    uint32_t wakeups;              // EXTI edges that started a debounce
+    uint32_t ticks;                // Scan timer interrupts
+    uint32_t dropped;              // Events lost to a full queue
+} button_stats_t;
+
+/* Take over `count` buttons (table kept, not copied) and the scan timer */
+HAL_StatusTypeDef button_init(const button_config_t *config, uint8_t count);
+
+/* Call from HAL_GPIO_EXTI_Callback() with the pin that fired */
+void button_exti(uint16_t pin);
+
+/* Call from the scan timer's IRQ handler */
+void button_timer_irq(void);
+
+/* Reload the 1 MHz prescaler after a clock change (a clk_on_change()
+   hook); it applies from the next scan tick */
+void button_retime(void);
+
+/* Take the oldest event; false if there is none */
+bool button_get(button_event_t *ev);
+
+/* Debounced state of a button */
+bool button_pressed(uint8_t button);
+
+/* True while the scan timer is stopped: nothing pending until the next edge */
+bool button_idle(void);
+
+void button_stats(button_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUTTON_H */
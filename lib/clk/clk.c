@@ -0,0 +1,226 @@
+/*
+ * File: clk.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Clock profiles, see clk.h.
+ *
+ * A switch starts the oscillator the new profile needs, moves SYSCLK
+ * over (the HAL orders the flash latency change around it and reloads
+ * SysTick), then stops the oscillator the old profile used. The PLL can
+ * only be set up while it does not clock the system, and every switch
+ * goes through a source other than the PLL, so it is set up only while
+ * idle. The SYSCLK move runs with interrupts enabled: the HAL bounds its
+ * waits on the oscillators and on RCC_CFGR_SWS with HAL_GetTick(), which
+ * only advances while SysTick interrupts. Only the hooks run masked.
+ */
+
+#include "clk.h"
+#include <string.h>
+
+static const char *const names[CLK_PROFILE_COUNT] = { "lp", "perf", "hsi48" };
+
+static clk_profile_t current = CLK_LP;    // The reset clock: HSI, no PLL
+static clk_hook_t *hooks;
+
+static uint32_t clk_sysclk_source(clk_profile_t profile)
+{
+    switch (profile)
+    {
+    case CLK_PERF:  return RCC_SYSCLKSOURCE_PLLCLK;
+#if CLK_HAS_HSI48
+    case CLK_HSI48: return RCC_SYSCLKSOURCE_HSI48;
+#endif
+    default:        return RCC_SYSCLKSOURCE_HSI;
+    }
+}
+
+/* Start (on) or stop the oscillator behind `profile`; nothing for the HSI */
+static HAL_StatusTypeDef clk_oscillator(clk_profile_t profile, bool on)
+{
+    RCC_OscInitTypeDef osc = {0};
+
+    if (profile == CLK_PERF)
+    {
+        osc.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+        osc.PLL.PLLState   = on ? RCC_PLL_ON : RCC_PLL_OFF;
+        osc.PLL.PLLSource  = RCC_PLLSOURCE_HSI;
+#if defined(STM32F072xB) || defined(STM32F091xC)
+        osc.PLL.PLLMUL     = RCC_PLL_MUL6;    // HSI / 1 * 6 = 48 MHz
+#else
+        osc.PLL.PLLMUL     = RCC_PLL_MUL12;   // F030/F070 PLL input is HSI / 2: 4 MHz * 12 = 48 MHz
+#endif
+        osc.PLL.PREDIV     = RCC_PREDIV_DIV1;
+        return HAL_RCC_OscConfig(&osc);
+    }
+#if CLK_HAS_HSI48
+    if (profile == CLK_HSI48)
+    {
+        osc.OscillatorType = RCC_OSCILLATORTYPE_HSI48;
+        osc.HSI48State     = on ? RCC_HSI48_ON : RCC_HSI48_OFF;
+        osc.PLL.PLLState   = RCC_PLL_NONE;
+        return HAL_RCC_OscConfig(&osc);
+    }
+#endif
+    return HAL_OK;
+}
+
+/* Move SYSCLK, HCLK and PCLK to `profile`; its oscillator runs */
+static HAL_StatusTypeDef clk_select(clk_profile_t profile)
+{
+    RCC_ClkInitTypeDef clk = {0};
+    bool tickSuspended = (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) == 0U;
+    HAL_StatusTypeDef status;
+
+    clk.ClockType      = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_PCLK1;
+    clk.SYSCLKSource   = clk_sysclk_source(profile);
+    clk.AHBCLKDivider  = RCC_SYSCLK_DIV1;
+    clk.APB1CLKDivider = RCC_HCLK_DIV1;
+    if (tickSuspended)
+    {
+        HAL_ResumeTick();    // The SWS timeout counts ticks
+    }
+    status = HAL_RCC_ClockConfig(&clk, (CLK_HZ(profile) > 24000000U) ? FLASH_LATENCY_1 : FLASH_LATENCY_0);
+
+    if (tickSuspended)
+    {
+        HAL_SuspendTick();
+    }
+    return status;
+}
+
+static bool clk_available(clk_profile_t profile)
+{
+    return profile < CLK_PROFILE_COUNT && (profile != CLK_HSI48 || CLK_HAS_HSI48);
+}
+
+HAL_StatusTypeDef clk_init(clk_profile_t profile)
+{
+    RCC_OscInitTypeDef osc = {0};
+
+    if (!clk_available(profile))
+    {
+        return HAL_ERROR;
+    }
+    __HAL_RCC_PWR_CLK_ENABLE();
+
+    osc.OscillatorType      = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState            = RCC_HSI_ON;
+    osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    osc.PLL.PLLState        = RCC_PLL_NONE;
+    if (HAL_RCC_OscConfig(&osc) != HAL_OK ||
+        clk_oscillator(profile, true) != HAL_OK ||
+        clk_select(profile) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    current = profile;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef clk_switch(clk_profile_t profile)
+{
+    clk_profile_t old = current;
+    uint32_t primask;
+    HAL_StatusTypeDef status;
+
+    if (!clk_available(profile))
+    {
+        return HAL_ERROR;
+    }
+    if (profile == old)
+    {
+        return HAL_OK;
+    }
+    if (clk_oscillator(profile, true) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    status = clk_select(profile);
+    if (status == HAL_OK)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        current = profile;
+        for (clk_hook_t *h = hooks; h != NULL; h = h->next)
+        {
+            h->fn(h->ctx);
+        }
+        __set_PRIMASK(primask);
+    }
+
+    /* Stop what the profile no longer uses (or what failed to take over) */
+    (void)clk_oscillator((status == HAL_OK) ? old : profile, false);
+    return status;
+}
+
+clk_profile_t clk_profile(void)
+{
+    return current;
+}
+
+const char *clk_name(clk_profile_t profile)
+{
+    return (profile < CLK_PROFILE_COUNT) ? names[profile] : "?";
+}
+
+bool clk_find(const char *name, clk_profile_t *profile)
+{
+    for (uint8_t i = 0; i < CLK_PROFILE_COUNT; i++)
+    {
+        if (strcmp(name, names[i]) == 0 && clk_available((clk_profile_t)i))
+        {
+            *profile = (clk_profile_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void clk_on_change(clk_hook_t *hook, clk_hook_fn fn, void *ctx)
+{
+    clk_hook_t **link = &hooks;
+
+    while (*link != NULL)
+    {
+        link = &(*link)->next;
+    }
+    hook->next = NULL;
+    hook->fn = fn;
+    hook->ctx = ctx;
+    *link = hook;
+}
+
+HAL_StatusTypeDef clk_retime_uart(UART_HandleTypeDef *huart)
+{
+    USART_TypeDef *usart = huart->Instance;
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    uint32_t baud = huart->Init.BaudRate;
+    uint32_t brr;
+    uint32_t cr1;
+
+    if (baud == 0U)
+    {
+        return HAL_ERROR;
+    }
+    if (huart->Init.OverSampling == UART_OVERSAMPLING_8)
+    {
+        uint32_t div = (2U * pclk + baud / 2U) / baud;
+        brr = (div & 0xFFF0U) | ((div & 0xFU) >> 1);
+    }
+    else
+    {
+        brr = (pclk + baud / 2U) / baud;
+    }
+    if (brr < 16U || brr > 0xFFFFU)
+    {
+        return HAL_ERROR;
+    }
+
+    /* BRR is only writable with the USART disabled; CR1 is restored as it was */
+    cr1 = usart->CR1;
+    usart->CR1 = cr1 & ~USART_CR1_UE;
+    usart->BRR = brr;
+    usart->CR1 = cr1;
+    return HAL_OK;
+}
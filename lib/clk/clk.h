@@ -0,0 +1,104 @@
+/*
+ * File: clk.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Named system clock profiles, set at start-up and switchable at run
+ * time, with hooks that retime the peripherals running from the clock.
+ *
+ *   CLK_LP    :  8 MHz HSI, PLL off, no flash wait state
+ *   CLK_PERF  : 48 MHz PLL from the HSI (HSI / 2 x 12 on the F030/F070,
+ *               HSI x 6 on the F072/F091), one wait state
+ *   CLK_HSI48 : 48 MHz straight from the HSI48 oscillator, PLL off
+ *               (F072/F091 only: CLK_HAS_HSI48)
+ *
+ * AHB and APB run undivided in every profile, so HCLK = PCLK = SYSCLK
+ * and the timers count at SYSCLK. CLK_HZ() gives that frequency as a
+ * constant expression for compile-time plans (PWM_PLAN_*):
+ *
+ *     void SystemClock_Config(void)
+ *     {
+ *         if (clk_init(APP_CLK_PROFILE) != HAL_OK) while (1);
+ *     }
+ *
+ * clk_switch() changes the profile while everything runs. SysTick is
+ * reloaded by the HAL (and stays suspended if it was); whatever else
+ * derives a rate from the clock registers a hook, which runs with
+ * interrupts masked right after the switch. The switch itself waits on
+ * HAL_GetTick(), so call clk_switch() with interrupts enabled:
+ *
+ *     static clk_hook_t uartHook;
+ *     clk_on_change(&uartHook, retimeUart, NULL);   // clk_retime_uart(&huart1)
+ *
+ * The libraries that own a timer provide the retiming: task_retime(),
+ * button_retime(), pwm_retime(). A frame on a UART line while the clock
+ * switches is lost: drain the transmitter first.
+ */
+
+#ifndef CLK_H
+#define CLK_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    CLK_LP = 0,
+    CLK_PERF,
+    CLK_HSI48,
+    CLK_PROFILE_COUNT
+} clk_profile_t;
+
+#if defined(RCC_HSI48_SUPPORT)
+#define CLK_HAS_HSI48 1
+#else
+#define CLK_HAS_HSI48 0
+#endif
+
+#define CLK_LP_HZ     8000000U
+#define CLK_PERF_HZ   48000000U
+#define CLK_HSI48_HZ  48000000U
+
+/* SYSCLK = HCLK = PCLK of a profile, usable in constant expressions */
+#define CLK_HZ(profile) \
+    ((profile) == CLK_LP ? CLK_LP_HZ : (profile) == CLK_PERF ? CLK_PERF_HZ : CLK_HSI48_HZ)
+
+typedef void (*clk_hook_fn)(void *ctx);
+
+typedef struct clk_hook
+{
+    struct clk_hook *next;
+    clk_hook_fn fn;
+    void *ctx;
+} clk_hook_t;
+
+/* Set up `profile` from reset (in place of the Cube SystemClock_Config() body) */
+HAL_StatusTypeDef clk_init(clk_profile_t profile);
+
+/* Switch to `profile` and run the hooks; HAL_ERROR if the part lacks it */
+HAL_StatusTypeDef clk_switch(clk_profile_t profile);
+
+clk_profile_t clk_profile(void);
+
+/* "lp", "perf", "hsi48" */
+const char *clk_name(clk_profile_t profile);
+
+/* Profile by name; false if unknown or not on this part */
+bool clk_find(const char *name, clk_profile_t *profile);
+
+/* Run `fn(ctx)` after every switch, in registration order; `hook` is
+   caller-owned and must stay valid */
+void clk_on_change(clk_hook_t *hook, clk_hook_fn fn, void *ctx);
+
+/* Reload BRR for the UART's configured baud rate at the current PCLK
+   (the USART is disabled for the write); HAL_ERROR if out of range */
+HAL_StatusTypeDef clk_retime_uart(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLK_H */
@@ -0,0 +1,96 @@
+/*
+ * File: cmd.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Binary search over a (length, name) sorted command table, see cmd.h.
+ */
+
+#include "cmd.h"
+#include <string.h>
+
+int cmd_compare(const char *a, uint8_t alen, const char *b, uint8_t blen)
+{
+    if (alen != blen)
+    {
+        return (alen < blen) ? -1 : 1;
+    }
+    return memcmp(a, b, alen);
+}
+
+bool cmd_table_valid(const cmd_table_t *table)
+{
+    for (uint16_t i = 1; i < table->count; i++)
+    {
+        const cmd_t *prev = &table->cmds[i - 1U];
+        const cmd_t *cur  = &table->cmds[i];
+
+        if (cmd_compare(prev->name, prev->len, cur->name, cur->len) >= 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const cmd_t *cmd_find(const cmd_table_t *table, const char *name, uint16_t len)
+{
+    uint16_t lo = 0;
+    uint16_t hi = table->count;
+
+    if (len > UINT8_MAX)
+    {
+        return NULL;
+    }
+
+    while (lo < hi)
+    {
+        uint16_t mid = (uint16_t)((lo + hi) / 2U);
+        const cmd_t *c = &table->cmds[mid];
+        int diff = cmd_compare(name, (uint8_t)len, c->name, c->len);
+
+        if (diff == 0)
+        {
+            return c;
+        }
+        if (diff < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = (uint16_t)(mid + 1U);
+        }
+    }
+    return NULL;
+}
+
+bool cmd_dispatch(const cmd_table_t *table, const char *line)
+{
+    size_t len = strlen(line);
+    const cmd_t *c;
+
+    c = cmd_find(table, line, (uint16_t)((len > UINT16_MAX) ? UINT16_MAX : len));
+    if (c != NULL)
+    {
+        c->fn("");
+        return true;
+    }
+
+    /* First word + arguments */
+    const char *space = memchr(line, ' ', len);
+    if (space == NULL)
+    {
+        return false;
+    }
+    c = cmd_find(table, line, (uint16_t)(space - line));
+    if (c == NULL)
+    {
+        return false;
+    }
+    while (*space == ' ')
+    {
+        space++;
+    }
+    c->fn(space);
+    return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * File: cmd.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Command registry with an O(log n) lookup over a const table.
+ *
+ * The table is a `static const` array, so it stays in flash. Each entry
+ * stores its name length, computed by the compiler with sizeof(), and
+ * the table must be written sorted by (length, name). Lookup is then a
+ * binary search where entries of a different length are rejected with
+ * one integer compare; only same-length names reach memcmp().
+ *
+ *     static const cmd_t commands[] = {
+ *         CMD_ENTRY("ping",    cmdPing),     // 4
+ *         CMD_ENTRY("led on",  cmdLedOn),    // 6
+ *         CMD_ENTRY("led off", cmdLedOff),   // 7
+ *     };
+ *     static const cmd_table_t cmdTable = CMD_TABLE(commands);
+ *
+ * C cannot sort or compare strings at compile time, so the order is
+ * checked once at startup with cmd_table_valid().
+ *
+ * The code has no HAL dependency and builds for the `native` platform too.
+ */
+
+#ifndef CMD_H
+#define CMD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Command handler. args is the text after the command word ("" if none). */
+typedef void (*cmd_fn)(const char *args);
+
+typedef struct
+{
+    const char *name;
+    uint8_t len;                   // strlen(name), filled in at compile time
+    cmd_fn fn;
+} cmd_t;
+
+typedef struct
+{
+    const cmd_t *cmds;
+    uint16_t count;
+} cmd_table_t;
+
+/* name must be a string literal */
+#define CMD_ENTRY(name, fn)  { (name), (uint8_t)(sizeof(name) - 1U), (fn) }
+#define CMD_TABLE(array)     { (array), (uint16_t)(sizeof(array) / sizeof((array)[0])) }
+
+/* Order of two names by (length, bytes): <0, 0 or >0 */
+int cmd_compare(const char *a, uint8_t alen, const char *b, uint8_t blen);
+
+/* True if the table is strictly sorted by (length, name) */
+bool cmd_table_valid(const cmd_table_t *table);
+
+/* Exact match of name[0..len), or NULL */
+const cmd_t *cmd_find(const cmd_table_t *table, const char *name, uint16_t len);
+
+/*
+ * Run the command for a NUL-terminated line. The whole line is tried
+ * first (so entries may contain spaces, e.g. "led on"), then its first
+ * word with the rest of the line passed as args. Returns false if no
+ * entry matched.
+ */
+bool cmd_dispatch(const cmd_table_t *table, const char *line);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMD_H */
@@ -0,0 +1,184 @@
+/*
+ * File: frame.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * COBS + CRC-16 framing, see frame.h.
+ */
+
+#include "frame.h"
+#include <string.h>
+
+/* CRC-16/CCITT-FALSE (poly 0x1021), 4 bits at a time: 32 bytes of flash */
+static const uint16_t crcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static inline uint16_t crc16_byte(uint16_t crc, uint8_t b)
+{
+    crc = (uint16_t)((crc << 4) ^ crcNibble[((crc >> 12) ^ (b >> 4)) & 0x0FU]);
+    crc = (uint16_t)((crc << 4) ^ crcNibble[((crc >> 12) ^ b) & 0x0FU]);
+    return crc;
+}
+
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+    while (len-- > 0U)
+    {
+        crc = crc16_byte(crc, *data++);
+    }
+    return crc;
+}
+
+/* ---- Encoder ----------------------------------------------------------- */
+
+typedef struct
+{
+    uint8_t *out;
+    size_t pos;       // Next output byte
+    size_t codePos;   // Where the current block's code byte goes
+    uint8_t code;     // Current block length + 1
+} cobs_enc_t;
+
+static inline void cobs_put(cobs_enc_t *e, uint8_t b)
+{
+    if (b != 0U)
+    {
+        e->out[e->pos++] = b;
+        e->code++;
+    }
+    if (b == 0U || e->code == 0xFFU)
+    {
+        e->out[e->codePos] = e->code;
+        e->codePos = e->pos++;
+        e->code = 1;
+    }
+}
+
+size_t frame_encode(uint8_t type, const uint8_t *payload, uint8_t len,
+                    uint8_t *out, size_t outSize)
+{
+    cobs_enc_t e = { out, 1, 0, 1 };
+    uint16_t crc = 0xFFFF;
+
+    if (outSize < FRAME_ENCODED_SIZE((size_t)len))
+    {
+        return 0;
+    }
+
+    cobs_put(&e, type);
+    cobs_put(&e, len);
+    crc = crc16_byte(crc16_byte(crc, type), len);
+    for (uint8_t i = 0; i < len; i++)
+    {
+        cobs_put(&e, payload[i]);
+        crc = crc16_byte(crc, payload[i]);
+    }
+    cobs_put(&e, (uint8_t)(crc >> 8));
+    cobs_put(&e, (uint8_t)crc);
+
+    out[e.codePos] = e.code;
+    out[e.pos++] = 0x00;
+    return e.pos;
+}
+
+/* ---- Decoder ----------------------------------------------------------- */
+
+frame_status_t frame_decode(uint8_t *buf, size_t len, frame_t *frame)
+{
+    size_t in = 0;
+    size_t outPos = 0;
+    uint16_t crc = 0xFFFF;
+
+    /* Output never overtakes input, so decoding in place is safe */
+    while (in < len)
+    {
+        uint8_t code = buf[in++];
+        if (code == 0U || in + code - 1U > len)
+        {
+            return FRAME_ERR_COBS;
+        }
+        for (uint8_t i = 1; i < code; i++)
+        {
+            uint8_t b = buf[in++];
+            buf[outPos++] = b;
+            crc = crc16_byte(crc, b);
+        }
+        if (code != 0xFFU && in < len)
+        {
+            buf[outPos++] = 0x00;
+            crc = crc16_byte(crc, 0x00);
+        }
+    }
+
+    if (outPos < FRAME_HEADER_SIZE + FRAME_CRC_SIZE)
+    {
+        return FRAME_ERR_SHORT;
+    }
+    if ((size_t)buf[1] + FRAME_HEADER_SIZE + FRAME_CRC_SIZE != outPos)
+    {
+        return FRAME_ERR_LEN;
+    }
+    if (crc != 0U)
+    {
+        return FRAME_ERR_CRC;
+    }
+
+    frame->type    = buf[0];
+    frame->len     = buf[1];
+    frame->payload = &buf[FRAME_HEADER_SIZE];
+    return FRAME_OK;
+}
+
+/* ---- Receiver ---------------------------------------------------------- */
+
+void frame_rx_init(frame_rx_t *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+bool frame_rx_push(frame_rx_t *rx, const uint8_t *data, uint16_t len,
+                   uint16_t *used, frame_t *frame)
+{
+    const uint8_t *end = memchr(data, 0x00, len);
+    uint16_t n = (end != NULL) ? (uint16_t)(end - data) : len;
+    bool ok = false;
+
+    *used = (end != NULL) ? (uint16_t)(n + 1U) : n;
+
+    if (!rx->discard)
+    {
+        if ((size_t)rx->len + n > sizeof(rx->buf))
+        {
+            rx->discard = true;
+            rx->overflows++;
+        }
+        else
+        {
+            memcpy(&rx->buf[rx->len], data, n);
+            rx->len = (uint16_t)(rx->len + n);
+        }
+    }
+
+    if (end == NULL)
+    {
+        return false;
+    }
+
+    /* Delimiter: decode the collected frame (empty frames are just padding) */
+    if (!rx->discard && rx->len > 0U)
+    {
+        if (frame_decode(rx->buf, rx->len, frame) == FRAME_OK)
+        {
+            rx->frames++;
+            ok = true;
+        }
+        else
+        {
+            rx->errors++;
+        }
+    }
+    rx->len = 0;
+    rx->discard = false;
+    return ok;
+}
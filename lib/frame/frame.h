@@ -0,0 +1,104 @@
+/*
+ * File: frame.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Binary framing for UART links: COBS-encoded frames with a type byte,
+ * a length byte and a CRC, delimited by 0x00.
+ *
+ * Frame before encoding:
+ *
+ *     +------+-----+-------------------+-----------------+
+ *     | type | len | payload (len B)   | CRC-16 (2 B, BE)|
+ *     +------+-----+-------------------+-----------------+
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, len and payload. The whole
+ * frame is then COBS-encoded, so it contains no 0x00, and a single 0x00
+ * ends it. A receiver that joins mid-stream or sees a corrupted byte
+ * resynchronises at the next 0x00.
+ *
+ * frame_decode() undoes the COBS encoding in place and checks length and
+ * CRC in the same pass (a CRC over data + its big-endian CRC is 0).
+ *
+ * The code has no HAL dependency and builds for the `native` platform
+ * and the ESP32 Arduino core too.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest payload a frame_rx_t accepts (the wire format allows 255) */
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD 64
+#endif
+
+#define FRAME_HEADER_SIZE  2U   // type + len
+#define FRAME_CRC_SIZE     2U
+
+/* Encoded size of a frame with an n-byte payload, excluding / including the 0x00 */
+#define FRAME_COBS_SIZE(n)    ((n) + 4U + ((n) + 4U) / 254U + 1U)
+#define FRAME_ENCODED_SIZE(n) (FRAME_COBS_SIZE(n) + 1U)
+
+typedef enum
+{
+    FRAME_OK = 0,
+    FRAME_ERR_COBS,      // Malformed COBS (a code byte points past the end)
+    FRAME_ERR_SHORT,     // Fewer bytes than header + CRC
+    FRAME_ERR_LEN,       // Length byte does not match the frame size
+    FRAME_ERR_CRC
+} frame_status_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t len;
+    const uint8_t *payload;   // Points into the decode buffer
+} frame_t;
+
+/* Receiver state: collects encoded bytes up to the delimiter */
+typedef struct
+{
+    uint8_t buf[FRAME_COBS_SIZE(FRAME_MAX_PAYLOAD)];
+    uint16_t len;
+    bool discard;                 // Current frame overflowed buf, drop it
+    uint32_t frames;              // Valid frames decoded
+    uint32_t errors;              // COBS / length / CRC failures
+    uint32_t overflows;           // Frames longer than FRAME_MAX_PAYLOAD
+} frame_rx_t;
+
+uint16_t frame_crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/*
+ * Encode one frame into out, including the trailing 0x00. Returns the
+ * number of bytes written, or 0 if out is smaller than
+ * FRAME_ENCODED_SIZE(len).
+ */
+size_t frame_encode(uint8_t type, const uint8_t *payload, uint8_t len,
+                    uint8_t *out, size_t outSize);
+
+/* Decode len encoded bytes (without the 0x00) in place */
+frame_status_t frame_decode(uint8_t *buf, size_t len, frame_t *frame);
+
+void frame_rx_init(frame_rx_t *rx);
+
+/*
+ * Feed received bytes. Consumes up to and including the first 0x00 and
+ * stores the count in *used; call again with the rest. Returns true when
+ * that delimiter completed a valid frame. frame->payload stays valid
+ * until the next call.
+ */
+bool frame_rx_push(frame_rx_t *rx, const uint8_t *data, uint16_t len,
+                   uint16_t *used, frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_H */
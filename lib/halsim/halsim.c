@@ -0,0 +1,1354 @@
+/*
+ * File: halsim.c
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * CPU side of the host simulation: virtual clock, simulator thread,
+ * NVIC and interrupt dispatch, Cortex-M intrinsics, HAL core, RCC and
+ * PWR, and the terminal endpoints of the USARTs. See halsim.h for the
+ * execution model.
+ */
+
+#define _GNU_SOURCE
+#include "halsim_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NO_IRQ         (-100)
+#define THREAD_PRIO    4U               // Execution priority of thread mode
+#define POLL_NS        1000000ULL       // Run the models at least every 1 ms
+#define SIM_SIGNAL     SIGUSR1
+
+/* ---- Globals the HAL and CMSIS provide ---- */
+uint32_t      SystemCoreClock = 8000000U;
+__IO uint32_t uwTick;
+static uint32_t uwTickPrio = THREAD_PRIO;   // Invalid until HAL_InitTick()
+
+uint32_t halsim_hclk = 8000000U;
+uint32_t halsim_pclk = 8000000U;
+unsigned halsim_trace_flags = HALSIM_TRACE_GPIO;
+
+/* ---- Options ---- */
+static double   optSpeed = 1.0;
+static bool     optFast;
+static uint64_t optStopNs;                  // 0 = run until main() returns
+static bool     optSpeedSet, optFastSet, optStopSet;
+
+/* ---- Virtual clock ---- */
+static bool     booted, started;
+static uint64_t wall0;
+static uint64_t skipNs;                     // Time skipped in fast mode (atomic)
+static uint64_t nextDeadline = HALSIM_NEVER; // Earliest model event (atomic)
+static uint64_t simSleepUntil;              // Virtual time the thread sleeps to (atomic)
+
+/* ---- CPU state ---- */
+static pthread_t cpuThread, simThread;
+static int       wakePipe[2] = { -1, -1 };
+static volatile sig_atomic_t lockDepth, inService, servicePending, sleeping;
+static volatile uint32_t primask;
+static volatile uint32_t serviceSeq, dispatchSeq;
+static volatile bool eventRegister;
+static bool     idling;                  // CPU asleep in __WFI()/__WFE(), see idle_end()
+static uint64_t idleStartNs, idleNs;
+static uint32_t wakeups;                 // Sleeps ended
+
+/* ---- NVIC ---- */
+static uint32_t nvicEnabled, nvicPending, nvicActive;
+static uint8_t  nvicPrio[HALSIM_IRQn_COUNT];
+static bool     systickPending, systickActive, systickMasked;
+static uint8_t  systickPrio = THREAD_PRIO - 1U;
+static int      activeIrq = NO_IRQ;
+static unsigned curPrio = THREAD_PRIO;
+static uint32_t irqCount[HALSIM_IRQn_COUNT + 1];   // [irq + 1], SysTick at 0
+
+/* ---- USART endpoints ---- */
+enum { EP_NONE, EP_STDIO, EP_PTY, EP_CALLBACK };
+
+typedef struct
+{
+    int inFd;
+    int outFd;
+    int mode;
+    halsim_uart_byte_fn tx;
+    void *ctx;
+    halsim_uart_byte_fn rxWatch;
+    void *rxCtx;
+} endpoint_t;
+
+static endpoint_t endpoints[HALSIM_UART_COUNT] = {
+    { -1, -1, EP_STDIO, NULL, NULL, NULL, NULL },
+    { -1, -1, EP_NONE,  NULL, NULL, NULL, NULL },
+};
+static const char *const uartNames[HALSIM_UART_COUNT] = { "USART1", "USART2" };
+
+/* ==========================================================================
+   Vector table: weak handlers, overridden by the example's own
+   ========================================================================== */
+static void default_handler(int irq);
+
+#define HALSIM_VECTOR(name, irq) \
+    __weak void name(void) { default_handler(irq); }
+
+HALSIM_VECTOR(SysTick_Handler,                   SysTick_IRQn)
+HALSIM_VECTOR(EXTI0_1_IRQHandler,                EXTI0_1_IRQn)
+HALSIM_VECTOR(EXTI2_3_IRQHandler,                EXTI2_3_IRQn)
+HALSIM_VECTOR(EXTI4_15_IRQHandler,               EXTI4_15_IRQn)
+HALSIM_VECTOR(DMA1_Channel1_IRQHandler,          DMA1_Channel1_IRQn)
+HALSIM_VECTOR(DMA1_Channel2_3_IRQHandler,        DMA1_Channel2_3_IRQn)
+HALSIM_VECTOR(DMA1_Channel4_5_IRQHandler,        DMA1_Channel4_5_IRQn)
+HALSIM_VECTOR(TIM1_BRK_UP_TRG_COM_IRQHandler,    TIM1_BRK_UP_TRG_COM_IRQn)
+HALSIM_VECTOR(TIM1_CC_IRQHandler,                TIM1_CC_IRQn)
+HALSIM_VECTOR(TIM3_IRQHandler,                   TIM3_IRQn)
+HALSIM_VECTOR(TIM6_IRQHandler,                   TIM6_IRQn)
+HALSIM_VECTOR(TIM14_IRQHandler,                  TIM14_IRQn)
+HALSIM_VECTOR(TIM15_IRQHandler,                  TIM15_IRQn)
+HALSIM_VECTOR(TIM16_IRQHandler,                  TIM16_IRQn)
+HALSIM_VECTOR(TIM17_IRQHandler,                  TIM17_IRQn)
+HALSIM_VECTOR(USART1_IRQHandler,                 USART1_IRQn)
+HALSIM_VECTOR(USART2_IRQHandler,                 USART2_IRQn)
+
+typedef struct
+{
+    int irq;
+    void (*handler)(void);
+    const char *name;
+} vector_t;
+
+static const vector_t vectors[] = {
+    { SysTick_IRQn,             SysTick_Handler,                "SysTick" },
+    { EXTI0_1_IRQn,             EXTI0_1_IRQHandler,             "EXTI0_1" },
+    { EXTI2_3_IRQn,             EXTI2_3_IRQHandler,             "EXTI2_3" },
+    { EXTI4_15_IRQn,            EXTI4_15_IRQHandler,            "EXTI4_15" },
+    { DMA1_Channel1_IRQn,       DMA1_Channel1_IRQHandler,       "DMA1_Channel1" },
+    { DMA1_Channel2_3_IRQn,     DMA1_Channel2_3_IRQHandler,     "DMA1_Channel2_3" },
+    { DMA1_Channel4_5_IRQn,     DMA1_Channel4_5_IRQHandler,     "DMA1_Channel4_5" },
+    { TIM1_BRK_UP_TRG_COM_IRQn, TIM1_BRK_UP_TRG_COM_IRQHandler, "TIM1_BRK_UP_TRG_COM" },
+    { TIM1_CC_IRQn,             TIM1_CC_IRQHandler,             "TIM1_CC" },
+    { TIM3_IRQn,                TIM3_IRQHandler,                "TIM3" },
+    { TIM6_IRQn,                TIM6_IRQHandler,                "TIM6" },
+    { TIM14_IRQn,               TIM14_IRQHandler,               "TIM14" },
+    { TIM15_IRQn,               TIM15_IRQHandler,               "TIM15" },
+    { TIM16_IRQn,               TIM16_IRQHandler,               "TIM16" },
+    { TIM17_IRQn,               TIM17_IRQHandler,               "TIM17" },
+    { USART1_IRQn,              USART1_IRQHandler,              "USART1" },
+    { USART2_IRQn,              USART2_IRQHandler,              "USART2" },
+};
+
+static const vector_t *vector_of(int irq)
+{
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        if (vectors[i].irq == irq)
+        {
+            return &vectors[i];
+        }
+    }
+    return NULL;
+}
+
+const char *halsim_irq_name(int irq)
+{
+    const vector_t *v = vector_of(irq);
+    return (v != NULL) ? v->name : "IRQ?";
+}
+
+/* An enabled IRQ without a handler: report once and stop taking it */
+static void default_handler(int irq)
+{
+    halsim_trace("unhandled IRQ %s, disabled", halsim_irq_name(irq));
+    if (irq == SysTick_IRQn)
+    {
+        systickMasked = true;
+    }
+    else if (irq >= 0)
+    {
+        nvicEnabled &= ~(1UL << irq);
+    }
+}
+
+/* ==========================================================================
+   Weak HAL hooks the examples may override
+   ========================================================================== */
+__weak void HAL_MspInit(void) { }
+
+/* ==========================================================================
+   Virtual clock and tracing
+   ========================================================================== */
+static uint64_t wall_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t halsim_now_ns(void)
+{
+    if (!booted)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&skipNs, __ATOMIC_ACQUIRE) +
+           (uint64_t)((double)(wall_ns() - wall0) * optSpeed);
+}
+
+void halsim_sync(void)
+{
+    halsim_lock();
+    halsim_unlock();
+}
+
+uint64_t halsim_idle_ns(void)
+{
+    return idleNs + (idling ? halsim_now_ns() - idleStartNs : 0U);
+}
+
+uint32_t halsim_cycles(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    double s = (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+    return (uint32_t)(uint64_t)(s * (double)halsim_hclk);
+}
+
+uint64_t halsim_cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/* Formatted into a local buffer and written with one write(): signal safe enough */
+void halsim_trace(const char *fmt, ...)
+{
+    char line[192];
+    va_list ap;
+    uint64_t now = halsim_now_ns();
+    int n = snprintf(line, sizeof(line), "[halsim %10.3f ms] ", (double)now / 1e6);
+
+    va_start(ap, fmt);
+    n += vsnprintf(&line[n], sizeof(line) - (size_t)n - 1U, fmt, ap);
+    va_end(ap);
+    if (n > (int)sizeof(line) - 2)
+    {
+        n = (int)sizeof(line) - 2;
+    }
+    line[n++] = '\n';
+    (void)!write(STDERR_FILENO, line, (size_t)n);
+}
+
+void halsim_wake(void)
+{
+    if (wakePipe[1] >= 0)
+    {
+        (void)!write(wakePipe[1], "w", 1);
+    }
+}
+
+static bool on_cpu_thread(void)
+{
+    return !started || pthread_equal(pthread_self(), cpuThread);
+}
+
+/* ==========================================================================
+   Model service and interrupt dispatch (CPU thread)
+   ========================================================================== */
+static int irq_next(void)
+{
+    int best = NO_IRQ;
+    unsigned bestPrio = THREAD_PRIO;
+    uint32_t ready = nvicPending & nvicEnabled;
+
+    if (systickPending && !systickMasked)
+    {
+        best = SysTick_IRQn;
+        bestPrio = systickPrio;
+    }
+    for (int irq = 0; ready != 0U; irq++, ready >>= 1)
+    {
+        if ((ready & 1U) != 0U && nvicPrio[irq] < bestPrio)
+        {
+            best = irq;
+            bestPrio = nvicPrio[irq];
+        }
+    }
+    return best;
+}
+
+static unsigned irq_prio(int irq)
+{
+    return (irq == SysTick_IRQn) ? systickPrio : nvicPrio[irq];
+}
+
+void halsim_pend_systick(void)
+{
+    systickPending = true;
+}
+
+/* Advance the peripherals to now and latch the IRQ lines. lockDepth > 0. */
+static void run_models(void)
+{
+    uint64_t deadline;
+
+    inService = 1;
+    do
+    {
+        servicePending = 0;
+        deadline = halsim_hw_step(halsim_now_ns());
+        nvicPending |= halsim_hw_levels() & ~nvicActive;
+    } while (servicePending);
+    inService = 0;
+
+    __atomic_store_n(&nextDeadline, deadline, __ATOMIC_RELEASE);
+    if (deadline < __atomic_load_n(&simSleepUntil, __ATOMIC_ACQUIRE))
+    {
+        halsim_wake();
+    }
+    serviceSeq++;
+}
+
+/* The core leaves sleep: the first handler it takes ends the idle time */
+static void idle_end(void)
+{
+    if (idling)
+    {
+        idleNs += halsim_now_ns() - idleStartNs;
+        idling = false;
+        wakeups++;
+    }
+}
+
+/* Take every pending IRQ that beats the current execution priority */
+static void dispatch(void)
+{
+    for (;;)
+    {
+        int irq;
+        int prevIrq;
+        unsigned prevPrio;
+        const vector_t *v;
+
+        lockDepth++;
+        irq = (primask == 0U) ? irq_next() : NO_IRQ;
+        if (irq == NO_IRQ || irq_prio(irq) >= curPrio)
+        {
+            lockDepth--;
+            return;
+        }
+
+        if (irq == SysTick_IRQn)
+        {
+            systickPending = false;
+            systickActive  = true;
+        }
+        else
+        {
+            nvicPending &= ~(1UL << irq);
+            nvicActive  |= 1UL << irq;
+        }
+        prevIrq  = activeIrq;
+        prevPrio = curPrio;
+        activeIrq = irq;
+        curPrio   = irq_prio(irq);
+        idle_end();
+        halsim_hw_isr_enter(irq);
+        if ((halsim_trace_flags & HALSIM_TRACE_IRQ) != 0U)
+        {
+            halsim_trace("irq %s", halsim_irq_name(irq));
+        }
+        v = vector_of(irq);
+        lockDepth--;
+
+        /* The handler runs unlocked: higher priority IRQs may preempt it */
+        if (v != NULL)
+        {
+            v->handler();
+        }
+
+        lockDepth++;
+        irqCount[irq + 1]++;
+        halsim_hw_isr_exit(irq);
+        if (irq == SysTick_IRQn)
+        {
+            systickActive = false;
+        }
+        else
+        {
+            nvicActive &= ~(1UL << irq);
+        }
+        activeIrq = prevIrq;
+        curPrio   = prevPrio;
+        run_models();
+        dispatchSeq++;
+        lockDepth--;
+    }
+}
+
+static void sim_service(void)
+{
+    lockDepth++;
+    run_models();
+    lockDepth--;
+    dispatch();
+}
+
+static void on_signal(int sig)
+{
+    int savedErrno = errno;
+
+    (void)sig;
+    servicePending = 1;
+    if (lockDepth == 0 && !inService)
+    {
+        sim_service();
+    }
+    errno = savedErrno;
+}
+
+static void sim_boot(void);
+
+void halsim_lock(void)
+{
+    lockDepth++;
+}
+
+void halsim_unlock(void)
+{
+    if (!booted)
+    {
+        sim_boot();
+    }
+    if (--lockDepth == 0 && !inService)
+    {
+        sim_service();
+    }
+}
+
+/* Sleep until `counter` moves or an IRQ is ready to wake the core;
+   `idle` counts the time asleep as CPU idle time */
+static void sleep_until_change(volatile uint32_t *counter, bool idle)
+{
+    sigset_t block, old, wait;
+    uint32_t seq;
+
+    if (!started)
+    {
+        return;
+    }
+
+    sigemptyset(&block);
+    sigaddset(&block, SIM_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    wait = old;
+    sigdelset(&wait, SIM_SIGNAL);
+
+    seq = *counter;
+    if (idle)
+    {
+        idleStartNs = halsim_now_ns();
+        idling = true;
+    }
+    sleeping = 1;
+    while (*counter == seq && irq_next() == NO_IRQ)
+    {
+        sigsuspend(&wait);
+    }
+    sleeping = 0;
+    idle_end();
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+void halsim_wait(void)
+{
+    sleep_until_change(&serviceSeq, false);
+}
+
+/* ==========================================================================
+   Cortex-M intrinsics and NVIC
+   ========================================================================== */
+void __disable_irq(void)
+{
+    primask = 1U;
+}
+
+void __enable_irq(void)
+{
+    __set_PRIMASK(0U);
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+    primask = priMask & 1U;
+    if (primask == 0U && lockDepth == 0 && !inService && irq_next() != NO_IRQ)
+    {
+        dispatch();
+    }
+}
+
+void __WFI(void)
+{
+    sleep_until_change(&dispatchSeq, true);
+}
+
+void __WFE(void)
+{
+    if (!eventRegister)
+    {
+        sleep_until_change(&dispatchSeq, true);
+    }
+    eventRegister = false;
+}
+
+void __SEV(void)
+{
+    eventRegister = true;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= 0)
+    {
+        halsim_lock();
+        nvicEnabled |= 1UL << IRQn;
+        halsim_unlock();
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn >= 0)
+    {
+        nvicEnabled &= ~(1UL << IRQn);
+    }
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    halsim_lock();
+    if (IRQn == SysTick_IRQn)
+    {
+        systickPending = true;
+    }
+    else if (IRQn >= 0)
+    {
+        nvicPending |= 1UL << IRQn;
+    }
+    halsim_unlock();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == SysTick_IRQn)
+    {
+        systickPending = false;
+    }
+    else if (IRQn >= 0)
+    {
+        nvicPending &= ~(1UL << IRQn);
+    }
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1U) > SysTick_LOAD_RELOAD_Msk)
+    {
+        return 1U;
+    }
+    halsim_lock();
+    SysTick->LOAD = ticks - 1U;
+    SysTick->VAL  = 0U;
+    systickPrio   = THREAD_PRIO - 1U;
+    systickMasked = false;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+    halsim_unlock();
+    return 0U;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)SubPriority;
+    if (IRQn == SysTick_IRQn)
+    {
+        systickPrio = (uint8_t)(PreemptPriority & 3U);
+    }
+    else if (IRQn >= 0)
+    {
+        nvicPrio[IRQn] = (uint8_t)(PreemptPriority & 3U);
+    }
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    NVIC_EnableIRQ(IRQn);
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    NVIC_DisableIRQ(IRQn);
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb)
+{
+    return SysTick_Config(TicksNumb);
+}
+
+/* ==========================================================================
+   HAL core
+   ========================================================================== */
+static void sim_start(void);
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    sim_boot();
+    sim_start();
+    if (HAL_InitTick(TICK_INT_PRIORITY) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    HAL_MspInit();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DeInit(void)
+{
+    return HAL_OK;
+}
+
+__weak HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+    if (SysTick_Config(SystemCoreClock / 1000U) != 0U || TickPriority >= THREAD_PRIO)
+    {
+        return HAL_ERROR;
+    }
+    HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+    uwTickPrio = TickPriority;
+    return HAL_OK;
+}
+
+__weak void HAL_IncTick(void)
+{
+    uwTick += 1U;
+}
+
+__weak uint32_t HAL_GetTick(void)
+{
+    return uwTick;
+}
+
+__weak void HAL_Delay(uint32_t Delay)
+{
+    uint32_t tickstart = HAL_GetTick();
+    uint32_t wait = Delay;
+
+    if (wait < HAL_MAX_DELAY)
+    {
+        wait += 1U;
+    }
+    /* Sleeps to spare the host, but counts as busy: the MCU's HAL_Delay() spins */
+    while ((HAL_GetTick() - tickstart) < wait)
+    {
+        sleep_until_change(&dispatchSeq, false);
+    }
+}
+
+void HAL_SuspendTick(void)
+{
+    SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+void HAL_ResumeTick(void)
+{
+    SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+}
+
+/* ==========================================================================
+   RCC / FLASH / PWR
+   ========================================================================== */
+#define HSI_HZ    8000000U
+#define HSE_HZ    8000000U
+#define HSI48_HZ  48000000U
+
+static struct
+{
+    bool hse;
+    bool hsi48;
+    bool pll;
+    uint32_t pllSource;
+    uint32_t pllMul;
+    uint32_t prediv;
+} osc;
+
+static uint32_t pll_hz(void)
+{
+    uint32_t in;
+    uint32_t mul = ((osc.pllMul >> 18) & 0xFU) + 2U;
+
+    switch (osc.pllSource)
+    {
+    case RCC_PLLSOURCE_HSE:   in = HSE_HZ / (osc.prediv + 1U); break;
+#if defined(STM32F072xB) || defined(STM32F091xC)
+    case RCC_PLLSOURCE_HSI:   in = HSI_HZ / (osc.prediv + 1U); break;
+    case RCC_PLLSOURCE_HSI48: in = HSI48_HZ / (osc.prediv + 1U); break;
+#endif
+    default:                  in = HSI_HZ / 2U; break;
+    }
+    return in * ((mul > 16U) ? 16U : mul);
+}
+
+static void update_clocks(void)
+{
+    static const uint16_t ahbDiv[8] = { 2, 4, 8, 16, 64, 128, 256, 512 };
+    uint32_t cfgr = RCC->CFGR;
+    uint32_t hpre = (cfgr >> 4) & 0xFU;
+    uint32_t ppre = (cfgr >> 8) & 0x7U;
+    uint32_t sysclk;
+
+    switch (cfgr & 0x3U)
+    {
+    case RCC_SYSCLKSOURCE_HSE:    sysclk = HSE_HZ; break;
+    case RCC_SYSCLKSOURCE_PLLCLK: sysclk = pll_hz(); break;
+    case RCC_SYSCLKSOURCE_HSI48:  sysclk = HSI48_HZ; break;
+    default:                      sysclk = HSI_HZ; break;
+    }
+    halsim_hclk = (hpre < 8U) ? sysclk : sysclk / ahbDiv[hpre - 8U];
+    halsim_pclk = (ppre < 4U) ? halsim_hclk : halsim_hclk / (2U << (ppre - 4U));
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    if (RCC_OscInitStruct == NULL)
+    {
+        return HAL_ERROR;
+    }
+    if ((RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSE) != 0U)
+    {
+        osc.hse = (RCC_OscInitStruct->HSEState != 0U);
+    }
+    if ((RCC_OscInitStruct->OscillatorType & RCC_OSCILLATORTYPE_HSI48) != 0U)
+    {
+#if defined(STM32F072xB) || defined(STM32F091xC)
+        osc.hsi48 = (RCC_OscInitStruct->HSI48State == RCC_HSI48_ON);
+#else
+        return HAL_ERROR;   // No HSI48 on this part
+#endif
+    }
+    if (RCC_OscInitStruct->PLL.PLLState != RCC_PLL_NONE)
+    {
+        /* The PLL cannot be reconfigured while it clocks the system */
+        if ((RCC->CFGR & 0x3U) == RCC_SYSCLKSOURCE_PLLCLK)
+        {
+            return HAL_ERROR;
+        }
+        osc.pll = (RCC_OscInitStruct->PLL.PLLState == RCC_PLL_ON);
+        if (osc.pll)
+        {
+            osc.pllSource = RCC_OscInitStruct->PLL.PLLSource;
+            osc.pllMul    = RCC_OscInitStruct->PLL.PLLMUL;
+            osc.prediv    = RCC_OscInitStruct->PLL.PREDIV;
+            RCC->CFGR = (RCC->CFGR & ~0x003F8000U) | osc.pllSource | osc.pllMul;
+            RCC->CFGR2 = osc.prediv;
+            RCC->CR |= (1UL << 24) | (1UL << 25);     // PLLON, PLLRDY
+        }
+        else
+        {
+            RCC->CR &= ~((1UL << 24) | (1UL << 25));
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+    uint32_t cfgr;
+
+    if (RCC_ClkInitStruct == NULL)
+    {
+        return HAL_ERROR;
+    }
+
+    halsim_lock();
+    FLASH->ACR = (FLASH->ACR & ~0x1U) | FLatency;
+    cfgr = RCC->CFGR;
+    if ((RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_HCLK) != 0U)
+    {
+        cfgr = (cfgr & ~0xF0U) | RCC_ClkInitStruct->AHBCLKDivider;
+    }
+    if ((RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_SYSCLK) != 0U)
+    {
+        uint32_t src = RCC_ClkInitStruct->SYSCLKSource;
+        bool ready = (src == RCC_SYSCLKSOURCE_HSI) ||
+                     (src == RCC_SYSCLKSOURCE_HSE && osc.hse) ||
+                     (src == RCC_SYSCLKSOURCE_PLLCLK && osc.pll) ||
+                     (src == RCC_SYSCLKSOURCE_HSI48 && osc.hsi48);
+        if (!ready)
+        {
+            halsim_unlock();
+            return HAL_ERROR;
+        }
+        cfgr = (cfgr & ~0xFU) | src | (src << 2);   // SW, SWS
+    }
+    if ((RCC_ClkInitStruct->ClockType & RCC_CLOCKTYPE_PCLK1) != 0U)
+    {
+        cfgr = (cfgr & ~0x700U) | RCC_ClkInitStruct->APB1CLKDivider;
+    }
+    RCC->CFGR = cfgr;
+    update_clocks();
+    SystemCoreClock = halsim_hclk;
+    if (halsim_hclk > 24000000U && (FLASH->ACR & 0x1U) == 0U)
+    {
+        halsim_trace("warning: %lu Hz with FLASH_LATENCY_0", (unsigned long)halsim_hclk);
+    }
+    halsim_unlock();
+
+    return HAL_InitTick(uwTickPrio);
+}
+
+uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+    switch (RCC->CFGR & 0x3U)
+    {
+    case RCC_SYSCLKSOURCE_HSE:    return HSE_HZ;
+    case RCC_SYSCLKSOURCE_PLLCLK: return pll_hz();
+    case RCC_SYSCLKSOURCE_HSI48:  return HSI48_HZ;
+    default:                      return HSI_HZ;
+    }
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return halsim_pclk;
+}
+
+void SystemCoreClockUpdate(void)
+{
+    SystemCoreClock = halsim_hclk;
+}
+
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry)
+{
+    (void)Regulator;
+    if (SLEEPEntry == PWR_SLEEPENTRY_WFI)
+    {
+        __WFI();
+    }
+    else
+    {
+        __SEV();
+        __WFE();
+        __WFE();
+    }
+}
+
+/* Wake-up from Stop runs on HSI with the PLL off, as on the MCU */
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+    HAL_PWR_EnterSLEEPMode(Regulator, STOPEntry);
+    halsim_lock();
+    osc.pll = false;
+    RCC->CR &= ~((1UL << 24) | (1UL << 25));
+    RCC->CFGR &= ~0xFU;
+    update_clocks();
+    halsim_unlock();
+}
+
+/* ==========================================================================
+   USART endpoints
+   ========================================================================== */
+static int open_pty(int uart)
+{
+    struct termios raw;
+    const char *name = uartNames[uart];
+    const char *path;
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 ||
+        (path = ptsname(master)) == NULL)
+    {
+        fprintf(stderr, "halsim: %s: no pty (%s)\n", name, strerror(errno));
+        return -1;
+    }
+
+    /* Keep the slave open (never closed) so the master does not see EIO
+       between terminal sessions */
+    int slave = open(path, O_RDWR | O_NOCTTY);
+    if (slave >= 0 && tcgetattr(slave, &raw) == 0)
+    {
+        cfmakeraw(&raw);
+        tcsetattr(slave, TCSANOW, &raw);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    fprintf(stderr, "halsim: %s on %s\n", name, path);
+    return master;
+}
+
+static void open_endpoints(void)
+{
+    bool stdioTaken = false;
+
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        endpoint_t *ep = &endpoints[i];
+
+        if (ep->mode == EP_STDIO && !stdioTaken)
+        {
+            ep->inFd  = STDIN_FILENO;
+            ep->outFd = STDOUT_FILENO;
+            stdioTaken = true;
+        }
+        else if (ep->mode == EP_PTY)
+        {
+            ep->inFd = ep->outFd = open_pty(i);
+        }
+    }
+}
+
+void halsim_uart_output(int uart, uint8_t byte, uint64_t timeNs)
+{
+    endpoint_t *ep = &endpoints[uart];
+
+    if (ep->mode == EP_CALLBACK)
+    {
+        if (ep->tx != NULL)
+        {
+            ep->tx(ep->ctx, byte, timeNs);
+        }
+    }
+    else if (ep->outFd >= 0)
+    {
+        (void)!write(ep->outFd, &byte, 1);
+    }
+}
+
+void halsim_uart_input(int uart, uint8_t byte, uint64_t timeNs)
+{
+    endpoint_t *ep = &endpoints[uart];
+
+    if (ep->rxWatch != NULL)
+    {
+        ep->rxWatch(ep->rxCtx, byte, timeNs);
+    }
+}
+
+/* ==========================================================================
+   Simulator thread
+   ========================================================================== */
+static void sim_stop(void)
+{
+    char buf[512];
+    size_t n = 0;
+    halsim_uart_stats_t st;
+    uint64_t now = halsim_now_ns();
+    uint64_t idle = halsim_idle_ns();
+
+    n += (size_t)snprintf(&buf[n], sizeof(buf) - n,
+                          "halsim: stopped at %.3f ms, cpu idle %.2f %%, %lu wakeups\n",
+                          (double)now / 1e6, now != 0U ? 100.0 * (double)idle / (double)now : 0.0,
+                          (unsigned long)wakeups);
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        halsim_hw_uart_stats(i, &st);
+        if (st.rxBytes != 0U || st.txBytes != 0U || st.rxOverruns != 0U)
+        {
+            n += (size_t)snprintf(&buf[n], sizeof(buf) - n,
+                                  "halsim: %s rx %lu, overruns %lu, tx %lu\n", uartNames[i],
+                                  (unsigned long)st.rxBytes, (unsigned long)st.rxOverruns,
+                                  (unsigned long)st.txBytes);
+        }
+    }
+    n += (size_t)snprintf(&buf[n], sizeof(buf) - n, "halsim: irqs");
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]) && n < sizeof(buf) - 40U; i++)
+    {
+        uint32_t count = irqCount[vectors[i].irq + 1];
+        if (count != 0U)
+        {
+            n += (size_t)snprintf(&buf[n], sizeof(buf) - n, " %s=%lu", vectors[i].name,
+                                  (unsigned long)count);
+        }
+    }
+    buf[n++] = '\n';
+    (void)!write(STDERR_FILENO, buf, n);
+    _exit(0);
+}
+
+static void read_inputs(fd_set *ready)
+{
+    uint8_t data[256];
+
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        endpoint_t *ep = &endpoints[i];
+        ssize_t got;
+        size_t room = halsim_hw_rx_free(i);
+
+        if (ep->inFd < 0 || !FD_ISSET(ep->inFd, ready) || room == 0U)
+        {
+            continue;
+        }
+        got = read(ep->inFd, data, (room < sizeof(data)) ? room : sizeof(data));
+        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR))
+        {
+            ep->inFd = -1;   // EOF: the line stays idle
+            continue;
+        }
+        for (ssize_t k = 0; k < got; k++)
+        {
+            halsim_hw_rx_push(i, data[k]);
+        }
+    }
+}
+
+/* select() on the wake pipe and the UART inputs for at most `ns` of wall time */
+static void sim_select(fd_set *ready, int maxFd, uint64_t ns)
+{
+    struct timeval tv = { (time_t)(ns / 1000000000ULL), (suseconds_t)((ns % 1000000000ULL) / 1000ULL) };
+
+    if (select(maxFd + 1, ready, NULL, NULL, &tv) <= 0)
+    {
+        FD_ZERO(ready);
+    }
+}
+
+static void *sim_thread(void *arg)
+{
+    uint32_t kickedSeq = 0;
+    bool kicked = false;
+
+    (void)arg;
+
+    for (;;)
+    {
+        uint64_t now = halsim_now_ns();
+        uint64_t due = __atomic_load_n(&nextDeadline, __ATOMIC_ACQUIRE);
+        fd_set ready;
+        int maxFd = wakePipe[0];
+
+        if (optStopNs != 0U && now >= optStopNs)
+        {
+            sim_stop();
+        }
+        if (due > now + POLL_NS)
+        {
+            due = now + POLL_NS;
+        }
+        if (optStopNs != 0U && due > optStopNs)
+        {
+            due = optStopNs;
+        }
+
+        FD_ZERO(&ready);
+        FD_SET(wakePipe[0], &ready);
+        for (int i = 0; i < HALSIM_UART_COUNT; i++)
+        {
+            int fd = endpoints[i].inFd;
+            if (fd >= 0 && halsim_hw_rx_free(i) != 0U)
+            {
+                FD_SET(fd, &ready);
+                maxFd = (fd > maxFd) ? fd : maxFd;
+            }
+        }
+
+        if (kicked && serviceSeq == kickedSeq)
+        {
+            /* The CPU has not taken the last signal yet. Block rather than
+               spin: on a single host core spinning starves the CPU thread.
+               Any service writes to the wake pipe while we wait here. */
+            __atomic_store_n(&simSleepUntil, HALSIM_NEVER - 1U, __ATOMIC_RELEASE);
+            if (serviceSeq == kickedSeq)
+            {
+                sim_select(&ready, maxFd, POLL_NS);
+            }
+            else
+            {
+                FD_ZERO(&ready);
+            }
+            __atomic_store_n(&simSleepUntil, 0, __ATOMIC_RELEASE);
+        }
+        else if (due > now && optFast && sleeping)
+        {
+            /* Nothing runs until the next event: jump to it */
+            __atomic_add_fetch(&skipNs, due - now, __ATOMIC_RELEASE);
+            sim_select(&ready, maxFd, 0U);
+        }
+        else if (due > now)
+        {
+            __atomic_store_n(&simSleepUntil, due, __ATOMIC_RELEASE);
+            sim_select(&ready, maxFd, (uint64_t)((double)(due - now) / optSpeed));
+            __atomic_store_n(&simSleepUntil, 0, __ATOMIC_RELEASE);
+        }
+        else
+        {
+            FD_ZERO(&ready);
+        }
+
+        if (FD_ISSET(wakePipe[0], &ready))
+        {
+            char drain[64];
+            (void)!read(wakePipe[0], drain, sizeof(drain));
+        }
+        read_inputs(&ready);
+
+        kickedSeq = serviceSeq;
+        kicked = true;
+        pthread_kill(cpuThread, SIM_SIGNAL);
+    }
+    return NULL;
+}
+
+/* ==========================================================================
+   Boot and options
+   ========================================================================== */
+static int parse_endpoint(const char *value, int fallback)
+{
+    if (value == NULL)  return fallback;
+    if (strcmp(value, "stdio") == 0) return EP_STDIO;
+    if (strcmp(value, "pty") == 0)   return EP_PTY;
+    if (strcmp(value, "none") == 0)  return EP_NONE;
+    fprintf(stderr, "halsim: unknown endpoint '%s'\n", value);
+    return fallback;
+}
+
+static void parse_trace(const char *value)
+{
+    char list[64];
+    char *save = NULL;
+
+    snprintf(list, sizeof(list), "%s", value);
+    halsim_trace_flags = 0U;
+    for (char *tok = strtok_r(list, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save))
+    {
+        if (strcmp(tok, "gpio") == 0)     halsim_trace_flags |= HALSIM_TRACE_GPIO;
+        else if (strcmp(tok, "pwm") == 0) halsim_trace_flags |= HALSIM_TRACE_PWM;
+        else if (strcmp(tok, "irq") == 0) halsim_trace_flags |= HALSIM_TRACE_IRQ;
+    }
+}
+
+static void sim_boot(void)
+{
+    const char *env;
+
+    if (booted)
+    {
+        return;
+    }
+
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        if (endpoints[i].mode != EP_CALLBACK)
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "HALSIM_%s", uartNames[i]);
+            endpoints[i].mode = parse_endpoint(getenv(name), endpoints[i].mode);
+        }
+    }
+    if (!optSpeedSet && (env = getenv("HALSIM_SPEED")) != NULL && strtod(env, NULL) > 0.0)
+    {
+        optSpeed = strtod(env, NULL);
+    }
+    if (!optFastSet && (env = getenv("HALSIM_FAST")) != NULL)
+    {
+        optFast = (strcmp(env, "1") == 0);
+    }
+    if (!optStopSet && (env = getenv("HALSIM_RUN_MS")) != NULL)
+    {
+        optStopNs = strtoull(env, NULL, 10) * 1000000ULL;
+    }
+    if ((env = getenv("HALSIM_TRACE")) != NULL)
+    {
+        parse_trace(env);
+    }
+
+    halsim_hw_reset();
+    update_clocks();
+    wall0  = wall_ns();
+    booted = true;
+
+    if ((env = getenv("HALSIM_GPIO")) != NULL)
+    {
+        halsim_hw_gpio_script(env);
+    }
+}
+
+static void sim_start(void)
+{
+    struct sigaction sa;
+    sigset_t block, old;
+
+    if (started)
+    {
+        return;
+    }
+
+    open_endpoints();
+    if (pipe(wakePipe) != 0)
+    {
+        perror("halsim: pipe");
+        exit(1);
+    }
+    fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sa.sa_flags   = SA_RESTART | SA_NODEFER;   // Nested: time advances inside handlers
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIM_SIGNAL, &sa, NULL);
+
+    /* Only the CPU thread takes the signal */
+    cpuThread = pthread_self();
+    sigemptyset(&block);
+    sigaddset(&block, SIM_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &block, &old);
+    if (pthread_create(&simThread, NULL, sim_thread, NULL) != 0)
+    {
+        perror("halsim: thread");
+        exit(1);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    started = true;
+}
+
+/* ==========================================================================
+   Control interface (halsim.h)
+   ========================================================================== */
+void halsim_set_speed(double factor)
+{
+    if (factor > 0.0)
+    {
+        optSpeed = factor;
+        optSpeedSet = true;
+    }
+}
+
+void halsim_set_fast(bool fast)
+{
+    optFast = fast;
+    optFastSet = true;
+}
+
+void halsim_stop_after_ms(uint32_t ms)
+{
+    optStopNs = (uint64_t)ms * 1000000ULL;
+    optStopSet = true;
+}
+
+void halsim_uart_attach(USART_TypeDef *uart, halsim_uart_byte_fn tx, void *ctx)
+{
+    int i = halsim_hw_uart_index(uart);
+
+    if (i >= 0)
+    {
+        endpoints[i].mode  = EP_CALLBACK;
+        endpoints[i].tx    = tx;
+        endpoints[i].ctx   = ctx;
+        endpoints[i].inFd  = -1;
+        endpoints[i].outFd = -1;
+    }
+}
+
+void halsim_uart_watch_rx(USART_TypeDef *uart, halsim_uart_byte_fn rx, void *ctx)
+{
+    int i = halsim_hw_uart_index(uart);
+
+    if (i >= 0)
+    {
+        endpoints[i].rxCtx   = ctx;
+        endpoints[i].rxWatch = rx;
+    }
+}
+
+/* From the CPU thread the line is updated at once, otherwise on the next poll */
+static void apply_input(void)
+{
+    if (on_cpu_thread())
+    {
+        halsim_lock();
+        halsim_unlock();
+    }
+    else
+    {
+        halsim_wake();
+    }
+}
+
+bool halsim_uart_inject(USART_TypeDef *uart, const uint8_t *data, size_t len)
+{
+    int i = halsim_hw_uart_index(uart);
+
+    if (i < 0 || halsim_hw_rx_free(i) < len)
+    {
+        return false;
+    }
+    for (size_t k = 0; k < len; k++)
+    {
+        halsim_hw_rx_push(i, data[k]);
+    }
+    apply_input();
+    return true;
+}
+
+bool halsim_uart_inject_idle(USART_TypeDef *uart, uint32_t frames)
+{
+    int i = halsim_hw_uart_index(uart);
+
+    if (i < 0 || !halsim_hw_rx_push(i, (uint16_t)(0x8000U | ((frames > 0x7FFFU) ? 0x7FFFU : frames))))
+    {
+        return false;
+    }
+    apply_input();
+    return true;
+}
+
+uint16_t halsim_uart_read(USART_TypeDef *uart)
+{
+    return halsim_hw_rdr_read(uart);
+}
+
+void halsim_reg_write(volatile uint32_t *reg, uint32_t value)
+{
+    halsim_lock();
+    *reg = value;
+    halsim_unlock();
+}
+
+void halsim_uart_stats(USART_TypeDef *uart, halsim_uart_stats_t *stats)
+{
+    int i = halsim_hw_uart_index(uart);
+
+    memset(stats, 0, sizeof(*stats));
+    if (i >= 0)
+    {
+        halsim_hw_uart_stats(i, stats);
+    }
+}
+
+void halsim_gpio_input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    halsim_hw_gpio_input(port, pin, state);
+    apply_input();
+}
+
+uint32_t halsim_irq_count(IRQn_Type irq)
+{
+    return ((int)irq >= -1 && (int)irq < HALSIM_IRQn_COUNT) ? irqCount[irq + 1] : 0U;
+}
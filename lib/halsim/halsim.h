@@ -0,0 +1,116 @@
+/*
+ * File: halsim.h
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Control interface of the host HAL simulation. The examples never call
+ * it; it is for host programs that drive an example (benchmarks, tests)
+ * and for the simulator options below.
+ *
+ * Execution model:
+ * - main() runs on the process main thread, which plays the CPU.
+ * - A simulator thread keeps a virtual clock and signals the CPU thread
+ *   whenever a peripheral event is due. The signal handler advances the
+ *   peripheral models (SysTick, USART shift registers, DMA channels,
+ *   timers, EXTI) up to "now" and then runs the pending IRQ handlers on
+ *   the CPU thread, so they preempt the main loop like real interrupts.
+ * - __disable_irq() defers handlers, not the hardware; __WFI() sleeps
+ *   until an interrupt is taken. A higher priority IRQ preempts a running
+ *   handler; equal priorities are taken SysTick first, then by IRQ number.
+ * - Virtual time follows the wall clock, so a host that cannot keep up
+ *   (busy links, sanitizers) sees late interrupts. Lower HALSIM_SPEED
+ *   rather than reading such overruns as firmware bugs.
+ *
+ * Environment variables, read by HAL_Init():
+ *
+ *   HALSIM_USART1=stdio|pty|none  USART1 endpoint (default stdio)
+ *   HALSIM_USART2=stdio|pty|none  USART2 endpoint (default none)
+ *   HALSIM_SPEED=<factor>         Virtual time per wall time (default 1)
+ *   HALSIM_FAST=1                 Skip ahead while the CPU sleeps in __WFI()
+ *   HALSIM_RUN_MS=<ms>            Exit after this much virtual time
+ *   HALSIM_TRACE=gpio,pwm,irq     stderr trace (default gpio, "none" = off)
+ *   HALSIM_GPIO=PC13=0@1000,...   Drive input pins at virtual times (ms)
+ *
+ * Timers load preloaded compare values (OCxPE) at the update event, which
+ * CR1.UDIS holds off; the pwm trace shows the values the output uses.
+ * Received bytes are held until the receiver is enabled, then arrive
+ * back to back at the configured baud rate. DMA buffers must be static
+ * or global, like on the MCU: register addresses are 32 bits wide.
+ */
+
+#ifndef HALSIM_H
+#define HALSIM_H
+
+#include "stm32f0xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Byte on a USART pin, called in interrupt context at timeNs */
+typedef void (*halsim_uart_byte_fn)(void *ctx, uint8_t byte, uint64_t timeNs);
+
+typedef struct
+{
+    uint32_t rxBytes;     // Bytes that reached RDR
+    uint32_t rxOverruns;  // Bytes lost because RDR was still full
+    uint32_t rxQueued;    // Bytes still waiting on the line
+    uint32_t txBytes;     // Bytes shifted out
+} halsim_uart_stats_t;
+
+/* Virtual time since HAL_Init() */
+uint64_t halsim_now_ns(void);
+
+/* Bring the peripheral models up to now: timer CNT registers are only
+   updated between events, which a main loop reading CNT may need */
+void halsim_sync(void);
+
+/* Virtual time the CPU spent asleep in __WFI()/__WFE() (idle), printed
+   as a percentage with the number of wake-ups when the simulation stops */
+uint64_t halsim_idle_ns(void);
+
+/* CPU time of the calling thread in HCLK cycles: a host stand-in for a
+   free-running cycle counter (timer CNT is only updated between events) */
+uint32_t halsim_cycles(void);
+
+/* The same CPU time in ns, independent of the clock profile (boot trace) */
+uint64_t halsim_cpu_ns(void);
+
+/* Options, also settable through the environment; call before HAL_Init() */
+void halsim_set_speed(double factor);
+void halsim_set_fast(bool fast);
+void halsim_stop_after_ms(uint32_t ms);
+
+/* Replace the USART's terminal with a callback (NULL = discard output) */
+void halsim_uart_attach(USART_TypeDef *uart, halsim_uart_byte_fn tx, void *ctx);
+
+/* Watch bytes as the receiver takes their frame, overrun or not (NULL = stop) */
+void halsim_uart_watch_rx(USART_TypeDef *uart, halsim_uart_byte_fn rx, void *ctx);
+
+/* Queue bytes on the USART's RX line; false if the line queue is full */
+bool halsim_uart_inject(USART_TypeDef *uart, const uint8_t *data, size_t len);
+
+/* Keep the RX line idle for `frames` character times after queued bytes */
+bool halsim_uart_inject_idle(USART_TypeDef *uart, uint32_t frames);
+
+void halsim_uart_stats(USART_TypeDef *uart, halsim_uart_stats_t *stats);
+
+/* Drive an input pin from outside, e.g. a button (EXTI edges included) */
+void halsim_gpio_input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+
+/* Read RDR with the MCU's side effect (clears RXNE), for register-level
+   drivers: a plain load of RDR has none on the host */
+uint16_t halsim_uart_read(USART_TypeDef *uart);
+
+/* Store to a peripheral register and let the models see it at once, as
+   the bus would (BSRR, BRR, TDR): a plain store waits for the next event,
+   and a second one before it replaces the first */
+void halsim_reg_write(volatile uint32_t *reg, uint32_t value);
+
+/* Handlers run for an IRQ (SysTick_IRQn included) */
+uint32_t halsim_irq_count(IRQn_Type irq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HALSIM_H */
@@ -0,0 +1,1325 @@
+/*
+ * File: halsim_hal.c
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * GPIO, DMA, UART and TIM drivers of the host simulation. They follow
+ * the STM32CubeF0 code paths closely (state machines, flag handling,
+ * callback order), since the examples' behaviour depends on them; the
+ * registers they program are the simulated ones in halsim_hw.c.
+ *
+ * Register writes the models must see at once are wrapped in
+ * halsim_lock()/halsim_unlock(). RDR is read and TDR written through
+ * halsim_hw_rdr_read()/halsim_hw_tdr_write() to get the flag side effects.
+ */
+
+#include "halsim_internal.h"
+
+#define UART_RX_ERRORS  (USART_ISR_PE | USART_ISR_FE | USART_ISR_ORE | USART_ISR_NE)
+#define HAL_DMA_ERROR_TE       0x00000001U
+#define HAL_DMA_ERROR_NO_XFER  0x00000004U
+
+/* ==========================================================================
+   Weak callbacks
+   ========================================================================== */
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) { UNUSED(GPIO_Pin); }
+__weak void HAL_UART_MspInit(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) { UNUSED(huart); }
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    UNUSED(huart);
+    UNUSED(Size);
+}
+__weak void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim) { UNUSED(htim); }
+__weak void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim) { UNUSED(htim); }
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) { UNUSED(htim); }
+
+/* ==========================================================================
+   GPIO
+   ========================================================================== */
+#define EXTI_MODE     0x10000000U
+#define EXTI_IT       0x00010000U
+#define EXTI_EVT      0x00020000U
+#define EXTI_RISING   0x00100000U
+#define EXTI_FALLING  0x00200000U
+
+static uint32_t gpio_port_code(const GPIO_TypeDef *port)
+{
+    return (port == GPIOA) ? 0U : (port == GPIOB) ? 1U : (port == GPIOC) ? 2U : 5U;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    halsim_lock();
+    for (uint32_t pos = 0; pos < 16U; pos++)
+    {
+        uint32_t bit = 1UL << pos;
+        uint32_t mode = GPIO_Init->Mode;
+
+        if ((GPIO_Init->Pin & bit) == 0U)
+        {
+            continue;
+        }
+
+        if ((mode & 3U) == 1U || (mode & 3U) == 2U)
+        {
+            MODIFY_REG(GPIOx->OSPEEDR, 3UL << (2U * pos), GPIO_Init->Speed << (2U * pos));
+            MODIFY_REG(GPIOx->OTYPER, bit, ((mode >> 4) & 1U) << pos);
+        }
+        if ((mode & 3U) != 3U)
+        {
+            MODIFY_REG(GPIOx->PUPDR, 3UL << (2U * pos), GPIO_Init->Pull << (2U * pos));
+        }
+        if ((mode & 3U) == 2U)
+        {
+            MODIFY_REG(GPIOx->AFR[pos >> 3], 0xFUL << (4U * (pos & 7U)),
+                       GPIO_Init->Alternate << (4U * (pos & 7U)));
+        }
+        MODIFY_REG(GPIOx->MODER, 3UL << (2U * pos), (mode & 3U) << (2U * pos));
+
+        if ((mode & EXTI_MODE) != 0U)
+        {
+            MODIFY_REG(SYSCFG->EXTICR[pos >> 2], 0xFUL << (4U * (pos & 3U)),
+                       gpio_port_code(GPIOx) << (4U * (pos & 3U)));
+            EXTI->IMR  = ((mode & EXTI_IT) != 0U)      ? (EXTI->IMR | bit)  : (EXTI->IMR & ~bit);
+            EXTI->EMR  = ((mode & EXTI_EVT) != 0U)     ? (EXTI->EMR | bit)  : (EXTI->EMR & ~bit);
+            EXTI->RTSR = ((mode & EXTI_RISING) != 0U)  ? (EXTI->RTSR | bit) : (EXTI->RTSR & ~bit);
+            EXTI->FTSR = ((mode & EXTI_FALLING) != 0U) ? (EXTI->FTSR | bit) : (EXTI->FTSR & ~bit);
+        }
+    }
+    halsim_unlock();
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+    halsim_lock();
+    for (uint32_t pos = 0; pos < 16U; pos++)
+    {
+        uint32_t bit = 1UL << pos;
+        if ((GPIO_Pin & bit) != 0U)
+        {
+            GPIOx->MODER   &= ~(3UL << (2U * pos));
+            GPIOx->PUPDR   &= ~(3UL << (2U * pos));
+            GPIOx->OTYPER  &= ~bit;
+            EXTI->IMR &= ~bit;
+            EXTI->EMR &= ~bit;
+            EXTI->RTSR &= ~bit;
+            EXTI->FTSR &= ~bit;
+        }
+    }
+    halsim_unlock();
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return ((GPIOx->IDR & GPIO_Pin) != 0U) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    halsim_lock();
+    if (PinState != GPIO_PIN_RESET)
+    {
+        GPIOx->BSRR = GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->BRR = GPIO_Pin;
+    }
+    halsim_unlock();
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    uint32_t odr;
+
+    halsim_lock();
+    odr = GPIOx->ODR;
+    GPIOx->BSRR = ((odr & GPIO_Pin) << 16) | (~odr & GPIO_Pin);
+    halsim_unlock();
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+    if (__HAL_GPIO_EXTI_GET_IT(GPIO_Pin) != 0U)
+    {
+        halsim_lock();
+        __HAL_GPIO_EXTI_CLEAR_IT(GPIO_Pin);
+        halsim_unlock();
+        HAL_GPIO_EXTI_Callback(GPIO_Pin);
+    }
+}
+
+/* ==========================================================================
+   DMA
+   ========================================================================== */
+#define DMA_FLAG_GI(h)  (0x1UL << (h)->ChannelIndex)
+#define DMA_FLAG_TC(h)  (0x2UL << (h)->ChannelIndex)
+#define DMA_FLAG_HT(h)  (0x4UL << (h)->ChannelIndex)
+#define DMA_FLAG_TE(h)  (0x8UL << (h)->ChannelIndex)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    uint32_t tmp;
+
+    if (hdma == NULL)
+    {
+        return HAL_ERROR;
+    }
+    hdma->State = HAL_DMA_STATE_BUSY;
+
+    tmp = hdma->Instance->CCR;
+    tmp &= ~(DMA_CCR_PINC | DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_CIRC | (0xFUL << 8) | (3UL << 12) | (1UL << 14));
+    tmp |= hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+           hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment |
+           hdma->Init.Mode | hdma->Init.Priority;
+    hdma->Instance->CCR = tmp;
+
+    hdma->DmaBaseAddress = DMA1;
+    hdma->ChannelIndex = (uint32_t)(hdma->Instance - DMA1_Channel1) * 4U;
+    hdma->ErrorCode = 0U;
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+    if (hdma == NULL)
+    {
+        return HAL_ERROR;
+    }
+    halsim_lock();
+    hdma->Instance->CCR = 0U;
+    hdma->Instance->CNDTR = 0U;
+    hdma->Instance->CPAR = 0U;
+    hdma->Instance->CMAR = 0U;
+    DMA1->IFCR = DMA_FLAG_GI(hdma);
+    halsim_unlock();
+    hdma->ErrorCode = 0U;
+    hdma->State = HAL_DMA_STATE_RESET;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+/* Start with full host pointers; the registers only keep 32 bits */
+static HAL_StatusTypeDef dma_start(DMA_HandleTypeDef *hdma, const volatile void *src,
+                                   const volatile void *dst, uint32_t len, bool it)
+{
+    const volatile void *mem;
+    const volatile void *periph;
+
+    if (hdma->Lock == HAL_LOCKED)
+    {
+        return HAL_BUSY;
+    }
+    hdma->Lock = HAL_LOCKED;
+    if (hdma->State != HAL_DMA_STATE_READY)
+    {
+        hdma->Lock = HAL_UNLOCKED;
+        return HAL_BUSY;
+    }
+    hdma->State = HAL_DMA_STATE_BUSY;
+    hdma->ErrorCode = 0U;
+
+    halsim_lock();
+    hdma->Instance->CCR &= ~DMA_CCR_EN;
+    DMA1->IFCR = DMA_FLAG_GI(hdma);
+    hdma->Instance->CNDTR = len;
+    if ((hdma->Init.Direction & DMA_MEMORY_TO_PERIPH) != 0U)
+    {
+        mem = src;
+        periph = dst;
+    }
+    else
+    {
+        mem = dst;
+        periph = src;
+    }
+    hdma->Instance->CPAR = (uint32_t)(uintptr_t)periph;
+    hdma->Instance->CMAR = (uint32_t)(uintptr_t)mem;
+    halsim_hw_dma_bind(hdma->Instance, (const void *)mem, periph);
+    if (it)
+    {
+        if (hdma->XferHalfCpltCallback != NULL)
+        {
+            hdma->Instance->CCR |= DMA_IT_TC | DMA_IT_HT | DMA_IT_TE;
+        }
+        else
+        {
+            hdma->Instance->CCR = (hdma->Instance->CCR | DMA_IT_TC | DMA_IT_TE) & ~DMA_IT_HT;
+        }
+    }
+    hdma->Instance->CCR |= DMA_CCR_EN;
+    halsim_unlock();
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    return dma_start(hdma, halsim_ptr(SrcAddress), halsim_ptr(DstAddress), DataLength, false);
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+    return dma_start(hdma, halsim_ptr(SrcAddress), halsim_ptr(DstAddress), DataLength, true);
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+    if (hdma->State != HAL_DMA_STATE_BUSY)
+    {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        hdma->Lock = HAL_UNLOCKED;
+        return HAL_ERROR;
+    }
+    halsim_lock();
+    hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE | DMA_CCR_EN);
+    DMA1->IFCR = DMA_FLAG_GI(hdma);
+    halsim_unlock();
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma)
+{
+    if (hdma->State != HAL_DMA_STATE_BUSY)
+    {
+        hdma->ErrorCode = HAL_DMA_ERROR_NO_XFER;
+        return HAL_ERROR;
+    }
+    halsim_lock();
+    hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE | DMA_CCR_EN);
+    DMA1->IFCR = DMA_FLAG_GI(hdma);
+    halsim_unlock();
+    hdma->State = HAL_DMA_STATE_READY;
+    hdma->Lock = HAL_UNLOCKED;
+    if (hdma->XferAbortCallback != NULL)
+    {
+        hdma->XferAbortCallback(hdma);
+    }
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+    uint32_t flags = DMA1->ISR;
+    uint32_t sources = hdma->Instance->CCR;
+
+    if ((flags & DMA_FLAG_HT(hdma)) != 0U && (sources & DMA_IT_HT) != 0U)
+    {
+        halsim_lock();
+        if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+        {
+            hdma->Instance->CCR &= ~DMA_IT_HT;
+        }
+        DMA1->IFCR = DMA_FLAG_HT(hdma);
+        halsim_unlock();
+        if (hdma->XferHalfCpltCallback != NULL)
+        {
+            hdma->XferHalfCpltCallback(hdma);
+        }
+    }
+    else if ((flags & DMA_FLAG_TC(hdma)) != 0U && (sources & DMA_IT_TC) != 0U)
+    {
+        halsim_lock();
+        if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+        {
+            hdma->Instance->CCR &= ~(DMA_IT_TE | DMA_IT_TC);
+            hdma->State = HAL_DMA_STATE_READY;
+        }
+        DMA1->IFCR = DMA_FLAG_TC(hdma);
+        halsim_unlock();
+        hdma->Lock = HAL_UNLOCKED;
+        if (hdma->XferCpltCallback != NULL)
+        {
+            hdma->XferCpltCallback(hdma);
+        }
+    }
+    else if ((flags & DMA_FLAG_TE(hdma)) != 0U && (sources & DMA_IT_TE) != 0U)
+    {
+        halsim_lock();
+        hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+        DMA1->IFCR = DMA_FLAG_GI(hdma);
+        halsim_unlock();
+        hdma->ErrorCode = HAL_DMA_ERROR_TE;
+        hdma->State = HAL_DMA_STATE_READY;
+        hdma->Lock = HAL_UNLOCKED;
+        if (hdma->XferErrorCallback != NULL)
+        {
+            hdma->XferErrorCallback(hdma);
+        }
+    }
+}
+
+/* ==========================================================================
+   UART
+   ========================================================================== */
+static void uart_cr_set(__IO uint32_t *reg, uint32_t bits)
+{
+    halsim_lock();
+    *reg |= bits;
+    halsim_unlock();
+}
+
+static void uart_cr_clear(__IO uint32_t *reg, uint32_t bits)
+{
+    halsim_lock();
+    *reg &= ~bits;
+    halsim_unlock();
+}
+
+static void uart_clear_flag(UART_HandleTypeDef *huart, uint32_t flags)
+{
+    halsim_lock();
+    huart->Instance->ICR = flags;
+    halsim_unlock();
+}
+
+static void uart_mask_computation(UART_HandleTypeDef *huart)
+{
+    bool parity = (huart->Init.Parity != UART_PARITY_NONE);
+
+    switch (huart->Init.WordLength)
+    {
+    case UART_WORDLENGTH_9B: huart->Mask = parity ? 0xFFU : 0x1FFU; break;
+    case UART_WORDLENGTH_7B: huart->Mask = parity ? 0x3FU : 0x7FU; break;
+    default:                 huart->Mask = parity ? 0x7FU : 0xFFU; break;
+    }
+}
+
+static void uart_end_rx_transfer(UART_HandleTypeDef *huart)
+{
+    uart_cr_clear(&huart->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE);
+    uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE);
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        uart_cr_clear(&huart->Instance->CR1, USART_CR1_IDLEIE);
+    }
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+}
+
+static void uart_end_tx_transfer(UART_HandleTypeDef *huart)
+{
+    uart_cr_clear(&huart->Instance->CR1, USART_CR1_TXEIE | USART_CR1_TCIE);
+    huart->TxISR = NULL;
+    huart->gState = HAL_UART_STATE_READY;
+}
+
+static HAL_StatusTypeDef uart_wait_flag(UART_HandleTypeDef *huart, uint32_t flag, FlagStatus status,
+                                        uint32_t tickstart, uint32_t timeout)
+{
+    while ((__HAL_UART_GET_FLAG(huart, flag) ? SET : RESET) == status)
+    {
+        if (timeout != HAL_MAX_DELAY)
+        {
+            if ((HAL_GetTick() - tickstart) > timeout || timeout == 0U)
+            {
+                uart_cr_clear(&huart->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_TXEIE);
+                uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE);
+                huart->gState = HAL_UART_STATE_READY;
+                huart->RxState = HAL_UART_STATE_READY;
+                huart->Lock = HAL_UNLOCKED;
+                return HAL_TIMEOUT;
+            }
+        }
+        halsim_wait();
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    USART_TypeDef *r;
+    uint32_t brr;
+
+    if (huart == NULL)
+    {
+        return HAL_ERROR;
+    }
+    if (huart->gState == HAL_UART_STATE_RESET)
+    {
+        huart->Lock = HAL_UNLOCKED;
+        HAL_UART_MspInit(huart);
+    }
+    huart->gState = HAL_UART_STATE_BUSY;
+    r = huart->Instance;
+
+    halsim_lock();
+    r->CR1 &= ~USART_CR1_UE;
+    r->CR1 = (r->CR1 & ~(USART_CR1_M0 | USART_CR1_M1 | USART_CR1_PCE | (1UL << 9) | USART_CR1_TE |
+                         USART_CR1_RE | USART_CR1_OVER8)) |
+             huart->Init.WordLength | huart->Init.Parity | huart->Init.Mode | huart->Init.OverSampling;
+    r->CR2 = (r->CR2 & ~(3UL << 12)) | huart->Init.StopBits;
+    r->CR3 = (r->CR3 & ~(USART_CR3_RTSE | USART_CR3_CTSE | (1UL << 11))) |
+             huart->Init.HwFlowCtl | huart->Init.OneBitSampling;
+
+    if (huart->Init.BaudRate == 0U)
+    {
+        halsim_unlock();
+        return HAL_ERROR;
+    }
+    if (huart->Init.OverSampling == UART_OVERSAMPLING_8)
+    {
+        uint32_t div = (2U * halsim_pclk + huart->Init.BaudRate / 2U) / huart->Init.BaudRate;
+        brr = (div & 0xFFF0U) | ((div & 0xFU) >> 1);
+    }
+    else
+    {
+        brr = UART_DIV_SAMPLING16(halsim_pclk, huart->Init.BaudRate);
+    }
+    if (brr < 16U || brr > 0xFFFFU)
+    {
+        halsim_unlock();
+        return HAL_ERROR;
+    }
+    r->BRR = brr;
+    r->CR1 |= USART_CR1_UE;
+    halsim_unlock();
+
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart)
+{
+    if (huart == NULL)
+    {
+        return HAL_ERROR;
+    }
+    halsim_lock();
+    huart->Instance->CR1 = 0U;
+    huart->Instance->CR2 = 0U;
+    huart->Instance->CR3 = 0U;
+    halsim_unlock();
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_RESET;
+    huart->RxState = HAL_UART_STATE_RESET;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    uint32_t tickstart;
+    const uint16_t *pdata16 = NULL;
+
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    if (huart->Lock == HAL_LOCKED)
+    {
+        return HAL_BUSY;
+    }
+    huart->Lock = HAL_LOCKED;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    tickstart = HAL_GetTick();
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    if (huart->Init.WordLength == UART_WORDLENGTH_9B && huart->Init.Parity == UART_PARITY_NONE)
+    {
+        pdata16 = (const uint16_t *)(const void *)pData;
+    }
+
+    while (huart->TxXferCount > 0U)
+    {
+        if (uart_wait_flag(huart, UART_FLAG_TXE, RESET, tickstart, Timeout) != HAL_OK)
+        {
+            return HAL_TIMEOUT;
+        }
+        if (pdata16 != NULL)
+        {
+            halsim_hw_tdr_write(huart->Instance, (uint16_t)(*pdata16++ & 0x1FFU));
+        }
+        else
+        {
+            halsim_hw_tdr_write(huart->Instance, *pData++);
+        }
+        huart->TxXferCount--;
+    }
+    if (uart_wait_flag(huart, UART_FLAG_TC, RESET, tickstart, Timeout) != HAL_OK)
+    {
+        return HAL_TIMEOUT;
+    }
+    huart->gState = HAL_UART_STATE_READY;
+    huart->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    uint32_t tickstart;
+    uint16_t *pdata16 = NULL;
+
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    if (huart->Lock == HAL_LOCKED)
+    {
+        return HAL_BUSY;
+    }
+    huart->Lock = HAL_LOCKED;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    tickstart = HAL_GetTick();
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    uart_mask_computation(huart);
+    if (huart->Init.WordLength == UART_WORDLENGTH_9B && huart->Init.Parity == UART_PARITY_NONE)
+    {
+        pdata16 = (uint16_t *)(void *)pData;
+    }
+
+    while (huart->RxXferCount > 0U)
+    {
+        if (uart_wait_flag(huart, UART_FLAG_RXNE, RESET, tickstart, Timeout) != HAL_OK)
+        {
+            return HAL_TIMEOUT;
+        }
+        if (pdata16 != NULL)
+        {
+            *pdata16++ = (uint16_t)(halsim_hw_rdr_read(huart->Instance) & huart->Mask);
+        }
+        else
+        {
+            *pData++ = (uint8_t)(halsim_hw_rdr_read(huart->Instance) & huart->Mask);
+        }
+        huart->RxXferCount--;
+    }
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+/* One character in interrupt transmit mode (UART_TxISR_8BIT) */
+static void uart_tx_isr(UART_HandleTypeDef *huart)
+{
+    if (huart->TxXferCount == 0U)
+    {
+        uart_cr_clear(&huart->Instance->CR1, USART_CR1_TXEIE);
+        uart_cr_set(&huart->Instance->CR1, USART_CR1_TCIE);
+        huart->TxISR = NULL;
+    }
+    else
+    {
+        halsim_hw_tdr_write(huart->Instance, *huart->pTxBuffPtr++);
+        huart->TxXferCount--;
+    }
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+    huart->TxISR = uart_tx_isr;
+    uart_cr_set(&huart->Instance->CR1, USART_CR1_TXEIE);
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef uart_start_receive_it(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    uart_mask_computation(huart);
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+    uart_cr_set(&huart->Instance->CR3, USART_CR3_EIE);
+    uart_cr_set(&huart->Instance->CR1, USART_CR1_RXNEIE |
+                ((huart->Init.Parity != UART_PARITY_NONE) ? USART_CR1_PEIE : 0U));
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    return uart_start_receive_it(huart, pData, Size);
+}
+
+static void uart_dma_transmit_cplt(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+    {
+        huart->TxXferCount = 0U;
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAT);
+        uart_cr_set(&huart->Instance->CR1, USART_CR1_TCIE);
+    }
+    else
+    {
+        HAL_UART_TxCpltCallback(huart);
+    }
+}
+
+static void uart_dma_tx_half_cplt(DMA_HandleTypeDef *hdma)
+{
+    HAL_UART_TxHalfCpltCallback((UART_HandleTypeDef *)hdma->Parent);
+}
+
+static void uart_dma_receive_cplt(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+    {
+        huart->RxXferCount = 0U;
+        uart_cr_clear(&huart->Instance->CR1, USART_CR1_PEIE);
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE | USART_CR3_DMAR);
+        huart->RxState = HAL_UART_STATE_READY;
+        if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+        {
+            uart_cr_clear(&huart->Instance->CR1, USART_CR1_IDLEIE);
+        }
+    }
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+    }
+    else
+    {
+        HAL_UART_RxCpltCallback(huart);
+    }
+}
+
+static void uart_dma_rx_half_cplt(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize / 2U));
+    }
+    else
+    {
+        HAL_UART_RxHalfCpltCallback(huart);
+    }
+}
+
+static void uart_dma_error(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    if (huart->gState == HAL_UART_STATE_BUSY_TX && (huart->Instance->CR3 & USART_CR3_DMAT) != 0U)
+    {
+        huart->TxXferCount = 0U;
+        uart_end_tx_transfer(huart);
+    }
+    if (huart->RxState == HAL_UART_STATE_BUSY_RX && (huart->Instance->CR3 & USART_CR3_DMAR) != 0U)
+    {
+        huart->RxXferCount = 0U;
+        uart_end_rx_transfer(huart);
+    }
+    huart->ErrorCode |= HAL_UART_ERROR_DMA;
+    HAL_UART_ErrorCallback(huart);
+}
+
+static void uart_dma_abort_on_error(DMA_HandleTypeDef *hdma)
+{
+    UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+    huart->RxXferCount = 0U;
+    huart->TxXferCount = 0U;
+    HAL_UART_ErrorCallback(huart);
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    if (huart->hdmatx != NULL)
+    {
+        huart->hdmatx->XferCpltCallback = uart_dma_transmit_cplt;
+        huart->hdmatx->XferHalfCpltCallback = uart_dma_tx_half_cplt;
+        huart->hdmatx->XferErrorCallback = uart_dma_error;
+        huart->hdmatx->XferAbortCallback = NULL;
+        if (dma_start(huart->hdmatx, pData, &huart->Instance->TDR, Size, true) != HAL_OK)
+        {
+            huart->ErrorCode = HAL_UART_ERROR_DMA;
+            huart->gState = HAL_UART_STATE_READY;
+            return HAL_ERROR;
+        }
+    }
+    uart_clear_flag(huart, UART_CLEAR_TCF);
+    uart_cr_set(&huart->Instance->CR3, USART_CR3_DMAT);
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef uart_start_receive_dma(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    if (huart->hdmarx != NULL)
+    {
+        huart->hdmarx->XferCpltCallback = uart_dma_receive_cplt;
+        huart->hdmarx->XferHalfCpltCallback = uart_dma_rx_half_cplt;
+        huart->hdmarx->XferErrorCallback = uart_dma_error;
+        huart->hdmarx->XferAbortCallback = NULL;
+        if (dma_start(huart->hdmarx, &huart->Instance->RDR, pData, Size, true) != HAL_OK)
+        {
+            huart->ErrorCode = HAL_UART_ERROR_DMA;
+            huart->RxState = HAL_UART_STATE_READY;
+            return HAL_ERROR;
+        }
+    }
+    if (huart->Init.Parity != UART_PARITY_NONE)
+    {
+        uart_cr_set(&huart->Instance->CR1, USART_CR1_PEIE);
+    }
+    uart_cr_set(&huart->Instance->CR3, USART_CR3_EIE | USART_CR3_DMAR);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    return uart_start_receive_dma(huart, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    (void)uart_start_receive_it(huart, pData, Size);
+    uart_clear_flag(huart, UART_CLEAR_IDLEF);
+    uart_cr_set(&huart->Instance->CR1, USART_CR1_IDLEIE);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    HAL_StatusTypeDef status;
+
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    if (pData == NULL || Size == 0U)
+    {
+        return HAL_ERROR;
+    }
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    status = uart_start_receive_dma(huart, pData, Size);
+    if (status == HAL_OK)
+    {
+        uart_clear_flag(huart, UART_CLEAR_IDLEF);
+        uart_cr_set(&huart->Instance->CR1, USART_CR1_IDLEIE);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart)
+{
+    if ((huart->Instance->CR3 & USART_CR3_DMAT) != 0U && huart->gState == HAL_UART_STATE_BUSY_TX)
+    {
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAT);
+        if (huart->hdmatx != NULL)
+        {
+            (void)HAL_DMA_Abort(huart->hdmatx);
+        }
+        uart_end_tx_transfer(huart);
+    }
+    if ((huart->Instance->CR3 & USART_CR3_DMAR) != 0U && huart->RxState == HAL_UART_STATE_BUSY_RX)
+    {
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAR);
+        if (huart->hdmarx != NULL)
+        {
+            (void)HAL_DMA_Abort(huart->hdmarx);
+        }
+        uart_end_rx_transfer(huart);
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+    uart_cr_clear(&huart->Instance->CR1, USART_CR1_TXEIE | USART_CR1_TCIE);
+    if ((huart->Instance->CR3 & USART_CR3_DMAT) != 0U)
+    {
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAT);
+        if (huart->hdmatx != NULL)
+        {
+            huart->hdmatx->XferAbortCallback = NULL;
+            (void)HAL_DMA_Abort(huart->hdmatx);
+        }
+    }
+    huart->TxXferCount = 0U;
+    huart->TxISR = NULL;
+    huart->gState = HAL_UART_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+    uart_cr_clear(&huart->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_IDLEIE);
+    uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE);
+    if ((huart->Instance->CR3 & USART_CR3_DMAR) != 0U)
+    {
+        uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAR);
+        if (huart->hdmarx != NULL)
+        {
+            huart->hdmarx->XferAbortCallback = NULL;
+            (void)HAL_DMA_Abort(huart->hdmarx);
+        }
+    }
+    huart->RxXferCount = 0U;
+    uart_clear_flag(huart, UART_CLEAR_OREF | UART_CLEAR_NEF | UART_CLEAR_PEF | UART_CLEAR_FEF);
+    halsim_lock();
+    huart->Instance->RQR = USART_RQR_RXFRQ;
+    halsim_unlock();
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart)
+{
+    (void)HAL_UART_AbortTransmit(huart);
+    (void)HAL_UART_AbortReceive(huart);
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    return HAL_OK;
+}
+
+/* One received character in interrupt mode (UART_RxISR_8BIT) */
+static void uart_rx_isr(UART_HandleTypeDef *huart)
+{
+    uint16_t data;
+
+    if (huart->RxState != HAL_UART_STATE_BUSY_RX)
+    {
+        halsim_lock();
+        huart->Instance->RQR = USART_RQR_RXFRQ;
+        halsim_unlock();
+        return;
+    }
+
+    data = halsim_hw_rdr_read(huart->Instance);
+    *huart->pRxBuffPtr++ = (uint8_t)(data & huart->Mask);
+    huart->RxXferCount--;
+    if (huart->RxXferCount != 0U)
+    {
+        return;
+    }
+
+    uart_cr_clear(&huart->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE);
+    uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE);
+    huart->RxState = HAL_UART_STATE_READY;
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+        uart_cr_clear(&huart->Instance->CR1, USART_CR1_IDLEIE);
+        if (__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE))
+        {
+            uart_clear_flag(huart, UART_CLEAR_IDLEF);
+        }
+        HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+    }
+    else
+    {
+        HAL_UART_RxCpltCallback(huart);
+    }
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+    uint32_t isrflags = huart->Instance->ISR;
+    uint32_t cr1its   = huart->Instance->CR1;
+    uint32_t cr3its   = huart->Instance->CR3;
+    uint32_t errorflags = isrflags & UART_RX_ERRORS;
+
+    if (errorflags == 0U && (isrflags & USART_ISR_RXNE) != 0U && (cr1its & USART_CR1_RXNEIE) != 0U)
+    {
+        uart_rx_isr(huart);
+        return;
+    }
+
+    if (errorflags != 0U && ((cr3its & USART_CR3_EIE) != 0U ||
+                             (cr1its & (USART_CR1_RXNEIE | USART_CR1_PEIE)) != 0U))
+    {
+        if ((isrflags & USART_ISR_PE) != 0U && (cr1its & USART_CR1_PEIE) != 0U)
+        {
+            uart_clear_flag(huart, UART_CLEAR_PEF);
+            huart->ErrorCode |= HAL_UART_ERROR_PE;
+        }
+        if ((isrflags & USART_ISR_FE) != 0U && (cr3its & USART_CR3_EIE) != 0U)
+        {
+            uart_clear_flag(huart, UART_CLEAR_FEF);
+            huart->ErrorCode |= HAL_UART_ERROR_FE;
+        }
+        if ((isrflags & USART_ISR_NE) != 0U && (cr3its & USART_CR3_EIE) != 0U)
+        {
+            uart_clear_flag(huart, UART_CLEAR_NEF);
+            huart->ErrorCode |= HAL_UART_ERROR_NE;
+        }
+        if ((isrflags & USART_ISR_ORE) != 0U &&
+            ((cr1its & USART_CR1_RXNEIE) != 0U || (cr3its & USART_CR3_EIE) != 0U))
+        {
+            uart_clear_flag(huart, UART_CLEAR_OREF);
+            huart->ErrorCode |= HAL_UART_ERROR_ORE;
+        }
+
+        if (huart->ErrorCode != HAL_UART_ERROR_NONE)
+        {
+            if ((isrflags & USART_ISR_RXNE) != 0U && (cr1its & USART_CR1_RXNEIE) != 0U)
+            {
+                uart_rx_isr(huart);
+            }
+
+            /* Overrun or any error during DMA reception is blocking */
+            if ((huart->Instance->CR3 & USART_CR3_DMAR) != 0U || (huart->ErrorCode & HAL_UART_ERROR_ORE) != 0U)
+            {
+                uart_end_rx_transfer(huart);
+                if ((huart->Instance->CR3 & USART_CR3_DMAR) != 0U)
+                {
+                    uart_cr_clear(&huart->Instance->CR3, USART_CR3_DMAR);
+                    if (huart->hdmarx != NULL)
+                    {
+                        huart->hdmarx->XferAbortCallback = uart_dma_abort_on_error;
+                        if (HAL_DMA_Abort_IT(huart->hdmarx) != HAL_OK)
+                        {
+                            huart->hdmarx->XferAbortCallback(huart->hdmarx);
+                        }
+                    }
+                    else
+                    {
+                        HAL_UART_ErrorCallback(huart);
+                    }
+                }
+                else
+                {
+                    HAL_UART_ErrorCallback(huart);
+                }
+            }
+            else
+            {
+                HAL_UART_ErrorCallback(huart);
+                huart->ErrorCode = HAL_UART_ERROR_NONE;
+            }
+        }
+        return;
+    }
+
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE &&
+        (isrflags & USART_ISR_IDLE) != 0U && (cr1its & USART_CR1_IDLEIE) != 0U)
+    {
+        uart_clear_flag(huart, UART_CLEAR_IDLEF);
+
+        if ((huart->Instance->CR3 & USART_CR3_DMAR) != 0U)
+        {
+            uint16_t remaining = (uint16_t)__HAL_DMA_GET_COUNTER(huart->hdmarx);
+            if (remaining > 0U && remaining < huart->RxXferSize)
+            {
+                huart->RxXferCount = remaining;
+                if ((huart->hdmarx->Instance->CCR & DMA_CCR_CIRC) == 0U)
+                {
+                    uart_cr_clear(&huart->Instance->CR1, USART_CR1_PEIE);
+                    uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE | USART_CR3_DMAR);
+                    huart->RxState = HAL_UART_STATE_READY;
+                    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+                    uart_cr_clear(&huart->Instance->CR1, USART_CR1_IDLEIE);
+                    (void)HAL_DMA_Abort(huart->hdmarx);
+                }
+                HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - huart->RxXferCount));
+            }
+        }
+        else
+        {
+            uint16_t received = (uint16_t)(huart->RxXferSize - huart->RxXferCount);
+            if (huart->RxXferCount > 0U && received > 0U)
+            {
+                uart_cr_clear(&huart->Instance->CR1, USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_IDLEIE);
+                uart_cr_clear(&huart->Instance->CR3, USART_CR3_EIE);
+                huart->RxState = HAL_UART_STATE_READY;
+                huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+                HAL_UARTEx_RxEventCallback(huart, received);
+            }
+        }
+        return;
+    }
+
+    /* Only an interrupt transmit has a TxISR: TXEIE set by someone else is theirs */
+    if ((isrflags & USART_ISR_TXE) != 0U && (cr1its & USART_CR1_TXEIE) != 0U)
+    {
+        if (huart->TxISR != NULL)
+        {
+            huart->TxISR(huart);
+        }
+        return;
+    }
+
+    if ((isrflags & USART_ISR_TC) != 0U && (cr1its & USART_CR1_TCIE) != 0U)
+    {
+        uart_cr_clear(&huart->Instance->CR1, USART_CR1_TCIE);
+        huart->gState = HAL_UART_STATE_READY;
+        HAL_UART_TxCpltCallback(huart);
+    }
+}
+
+HAL_UART_StateTypeDef HAL_UART_GetState(const UART_HandleTypeDef *huart)
+{
+    return (HAL_UART_StateTypeDef)(huart->gState | huart->RxState);
+}
+
+uint32_t HAL_UART_GetError(const UART_HandleTypeDef *huart)
+{
+    return huart->ErrorCode;
+}
+
+/* ==========================================================================
+   TIM
+   ========================================================================== */
+static bool tim_is_advanced(const TIM_TypeDef *tim)
+{
+    return tim == TIM1 || tim == TIM15 || tim == TIM16 || tim == TIM17;
+}
+
+static void tim_base_set_config(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *r = htim->Instance;
+
+    halsim_lock();
+    r->CR1 = (r->CR1 & ~(TIM_CR1_ARPE | (3UL << 8))) | htim->Init.AutoReloadPreload | htim->Init.ClockDivision;
+    r->ARR = htim->Init.Period;
+    r->PSC = htim->Init.Prescaler;
+    if (tim_is_advanced(r))
+    {
+        r->RCR = htim->Init.RepetitionCounter;
+    }
+    r->EGR = TIM_EGR_UG;
+    halsim_unlock();
+
+    /* The update event only loads the shadow registers: drop its flag */
+    if ((r->SR & TIM_SR_UIF) != 0U)
+    {
+        halsim_lock();
+        r->SR = (uint32_t)~TIM_SR_UIF;
+        halsim_unlock();
+    }
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+    if (htim == NULL)
+    {
+        return HAL_ERROR;
+    }
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        htim->Lock = HAL_UNLOCKED;
+        HAL_TIM_Base_MspInit(htim);
+    }
+    htim->State = HAL_TIM_STATE_BUSY;
+    tim_base_set_config(htim);
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim)
+{
+    if (htim == NULL)
+    {
+        return HAL_ERROR;
+    }
+    if (htim->State == HAL_TIM_STATE_RESET)
+    {
+        htim->Lock = HAL_UNLOCKED;
+        HAL_TIM_PWM_MspInit(htim);
+    }
+    htim->State = HAL_TIM_STATE_BUSY;
+    tim_base_set_config(htim);
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef tim_start(TIM_HandleTypeDef *htim, uint32_t dier)
+{
+    if (htim->State != HAL_TIM_STATE_READY)
+    {
+        return HAL_ERROR;
+    }
+    htim->State = HAL_TIM_STATE_BUSY;
+    halsim_lock();
+    htim->Instance->DIER |= dier;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    halsim_unlock();
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef tim_stop(TIM_HandleTypeDef *htim, uint32_t dier)
+{
+    halsim_lock();
+    htim->Instance->DIER &= ~dier;
+    if ((htim->Instance->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) == 0U)
+    {
+        htim->Instance->CR1 &= ~TIM_CR1_CEN;
+    }
+    halsim_unlock();
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    return tim_start(htim, 0U);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim)
+{
+    return tim_stop(htim, 0U);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    return tim_start(htim, TIM_DIER_UIE);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+{
+    return tim_stop(htim, TIM_DIER_UIE);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, const TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+    TIM_TypeDef *r = htim->Instance;
+    unsigned idx = Channel >> 2;                       // 0..3
+    __IO uint32_t *ccmr = (idx < 2U) ? &r->CCMR1 : &r->CCMR2;
+    unsigned shift = (idx & 1U) * 8U;
+    uint32_t ccerShift = idx * 4U;
+
+    if (htim->Lock == HAL_LOCKED)
+    {
+        return HAL_BUSY;
+    }
+    htim->Lock = HAL_LOCKED;
+    halsim_lock();
+    r->CCER &= ~(TIM_CCER_CC1E << ccerShift);
+    *ccmr = (*ccmr & ~(0xFFUL << shift)) | ((sConfig->OCMode | sConfig->OCFastMode | TIM_CCMR1_OC1PE) << shift);
+    r->CCER = (r->CCER & ~(0x2UL << ccerShift)) | (sConfig->OCPolarity << ccerShift);
+    (&r->CCR1)[idx] = sConfig->Pulse;
+    halsim_unlock();
+    htim->Lock = HAL_UNLOCKED;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    TIM_TypeDef *r = htim->Instance;
+
+    halsim_lock();
+    r->CCER |= TIM_CCER_CC1E << Channel;
+    if (tim_is_advanced(r))
+    {
+        r->BDTR |= TIM_BDTR_MOE;
+    }
+    r->CR1 |= TIM_CR1_CEN;
+    halsim_unlock();
+    htim->State = HAL_TIM_STATE_BUSY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    TIM_TypeDef *r = htim->Instance;
+
+    halsim_lock();
+    r->CCER &= ~(TIM_CCER_CC1E << Channel);
+    if ((r->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) == 0U)
+    {
+        r->BDTR &= ~TIM_BDTR_MOE;
+        r->CR1 &= ~TIM_CR1_CEN;
+    }
+    halsim_unlock();
+    htim->State = HAL_TIM_STATE_READY;
+    return HAL_OK;
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef *r = htim->Instance;
+    uint32_t ccFlags = r->SR & r->DIER & (TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF);
+
+    if (ccFlags != 0U)
+    {
+        halsim_lock();
+        r->SR = ~ccFlags;
+        halsim_unlock();
+    }
+    if ((r->SR & TIM_SR_UIF) != 0U && (r->DIER & TIM_DIER_UIE) != 0U)
+    {
+        halsim_lock();
+        r->SR = (uint32_t)~TIM_SR_UIF;
+        halsim_unlock();
+        HAL_TIM_PeriodElapsedCallback(htim);
+    }
+}
@@ -0,0 +1,1284 @@
+/*
+ * File: halsim_hw.c
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Peripheral models. halsim_hw_step() first reconciles what the firmware
+ * wrote since the last step (BSRR/BRR, write-to-clear flags, TDR, DMA
+ * enables, timer reloads), then plays the due events in time order:
+ * SysTick wraps, USART frames on the RX/TX lines, idle-line detection
+ * and timer updates. DMA requests are served as soon as the requesting
+ * peripheral raises them.
+ *
+ * Register reads have no side effects on the host, so the two that do on
+ * the MCU are emulated: reading RDR through the HAL or a DMA channel
+ * clears RXNE, and a USART handler that returns with RXNE still set and
+ * no new byte received is taken to have read RDR.
+ */
+
+#define _GNU_SOURCE
+#include "halsim_internal.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- Register blocks ---- */
+SysTick_Type        halsim_SysTick;
+SCB_Type            halsim_SCB;
+GPIO_TypeDef        halsim_GPIOA, halsim_GPIOB, halsim_GPIOC, halsim_GPIOF;
+USART_TypeDef       halsim_USART1, halsim_USART2;
+DMA_TypeDef         halsim_DMA1;
+DMA_Channel_TypeDef halsim_DMA1_Channel[5];
+TIM_TypeDef         halsim_TIM1, halsim_TIM3, halsim_TIM6, halsim_TIM14,
+                    halsim_TIM15, halsim_TIM16, halsim_TIM17;
+EXTI_TypeDef        halsim_EXTI;
+SYSCFG_TypeDef      halsim_SYSCFG;
+RCC_TypeDef         halsim_RCC;
+FLASH_TypeDef       halsim_FLASH;
+
+#define RX_QUEUE_SIZE   4096U
+#define PWM_TRACE_NS    100000000ULL    // At most one duty trace per channel per 100 ms
+#define SCRIPT_MAX      64U
+#define INPUT_MAX       64U
+#define ST_OWED_MAX     1000U           // Catch up at most one second of 1 ms ticks
+
+static uint64_t min_u64(uint64_t a, uint64_t b)
+{
+    return (a < b) ? a : b;
+}
+
+/* Registers hold 32-bit addresses; globals share the upper half with ours */
+void *halsim_ptr(uint32_t addr)
+{
+    uintptr_t high = (uintptr_t)&halsim_USART1 & ~(uintptr_t)0xFFFFFFFFU;
+    return (void *)(high | (uintptr_t)addr);
+}
+
+/* ==========================================================================
+   Models
+   ========================================================================== */
+typedef struct
+{
+    GPIO_TypeDef *r;
+    char name;
+    uint8_t exticr;         // Port code in SYSCFG_EXTICR
+    uint16_t boardHigh;     // Inputs pulled high on the board (Nucleo B1 on PC13)
+    uint16_t extLevel;
+    uint16_t extDriven;
+    uint16_t lastOdr;
+} gpio_model_t;
+
+typedef struct
+{
+    uint64_t time;
+    uint8_t port;
+    uint16_t pin;
+    uint8_t state;
+} pin_event_t;
+
+typedef struct
+{
+    USART_TypeDef *r;
+    IRQn_Type irq;
+    int txCh;
+    int rxCh;
+
+    pthread_mutex_t qLock;
+    uint16_t queue[RX_QUEUE_SIZE];
+    uint32_t qHead;
+    uint32_t qTail;
+
+    uint64_t rxDue;         // End of the frame being received
+    uint64_t idleDue;
+    uint64_t txDue;         // End of the frame being sent
+    uint64_t lineFree;      // RX line idle until (injected gaps)
+    uint16_t rxShift;
+    uint16_t txShift;
+    uint16_t hold;          // TDR contents not yet moved to the shifter
+    bool txShifting;
+    bool holdValid;
+    uint32_t rxSeq;
+    bool entryRxne;
+    uint32_t entrySeq;
+    bool     rxHeld;        // Next frame waits for the RX ISR
+    halsim_uart_stats_t stats;
+} uart_model_t;
+
+typedef struct
+{
+    uint32_t lastCcr;
+    uint32_t armedCmar, armedCpar;
+    uint16_t lastCndtr;     // CNDTR as the model left it
+    uint16_t total;
+    uintptr_t mem;
+    uintptr_t periph;
+    const void *boundMem;
+    const volatile void *boundPeriph;
+} dma_model_t;
+
+typedef struct
+{
+    TIM_TypeDef *r;
+    const char *name;
+    IRQn_Type irq;
+    IRQn_Type ccIrq;
+    int dmaCh;              // TIMx_UP request channel, -1 if none
+    bool running;
+    bool wrapOnly;          // Next overflow is from CNT > ARR: no update event
+    uint64_t baseT;
+    uint32_t baseCnt;
+    uint32_t arr;
+    uint32_t clk;
+    double tickNs;
+    uint64_t nextUpdate;
+    uint32_t hwSr;
+    uint32_t lastCnt;
+    uint32_t ccr[4];        // Active compare values (CCRx is the preload register)
+    uint32_t lastCcr[4];
+    uint64_t lastTrace[4];
+} tim_model_t;
+
+static gpio_model_t gpios[] = {
+    { &halsim_GPIOA, 'A', 0, 0,           0, 0, 0 },
+    { &halsim_GPIOB, 'B', 1, 0,           0, 0, 0 },
+    { &halsim_GPIOC, 'C', 2, GPIO_PIN_13, 0, 0, 0 },
+    { &halsim_GPIOF, 'F', 5, 0,           0, 0, 0 },
+};
+#define GPIO_COUNT (sizeof(gpios) / sizeof(gpios[0]))
+
+static uart_model_t uarts[HALSIM_UART_COUNT] = {
+    { .r = &halsim_USART1, .irq = USART1_IRQn, .txCh = 1, .rxCh = 2,
+      .qLock = PTHREAD_MUTEX_INITIALIZER },
+    { .r = &halsim_USART2, .irq = USART2_IRQn, .txCh = 3, .rxCh = 4,
+      .qLock = PTHREAD_MUTEX_INITIALIZER },
+};
+
+static dma_model_t dmas[5];
+
+static tim_model_t tims[] = {
+    { .r = &halsim_TIM1,  .name = "TIM1",  .irq = TIM1_BRK_UP_TRG_COM_IRQn, .ccIrq = TIM1_CC_IRQn, .dmaCh = 4 },
+    { .r = &halsim_TIM3,  .name = "TIM3",  .irq = TIM3_IRQn,  .ccIrq = TIM3_IRQn,  .dmaCh = 2 },
+    { .r = &halsim_TIM6,  .name = "TIM6",  .irq = TIM6_IRQn,  .ccIrq = TIM6_IRQn,  .dmaCh = -1 },
+    { .r = &halsim_TIM14, .name = "TIM14", .irq = TIM14_IRQn, .ccIrq = TIM14_IRQn, .dmaCh = -1 },
+    { .r = &halsim_TIM15, .name = "TIM15", .irq = TIM15_IRQn, .ccIrq = TIM15_IRQn, .dmaCh = 4 },
+    { .r = &halsim_TIM16, .name = "TIM16", .irq = TIM16_IRQn, .ccIrq = TIM16_IRQn, .dmaCh = 2 },
+    { .r = &halsim_TIM17, .name = "TIM17", .irq = TIM17_IRQn, .ccIrq = TIM17_IRQn, .dmaCh = 0 },
+};
+#define TIM_COUNT (sizeof(tims) / sizeof(tims[0]))
+
+static uint32_t hwPR;                    // EXTI pending lines
+
+static uint64_t stNext = HALSIM_NEVER;   // SysTick
+static uint64_t stPeriod;
+static uint32_t stCtrl, stLoad, stClk, stVal;
+static uint32_t stOwed;                  // Wraps missed while the host lagged
+
+static pin_event_t script[SCRIPT_MAX];   // HALSIM_GPIO
+static unsigned scriptLen, scriptPos;
+
+static pthread_mutex_t inputLock = PTHREAD_MUTEX_INITIALIZER;
+static pin_event_t inputs[INPUT_MAX];    // halsim_gpio_input() from any thread
+static unsigned inputHead, inputTail;
+
+static bool dma_request(int ch, uint64_t t);
+
+/* ==========================================================================
+   GPIO / EXTI
+   ========================================================================== */
+static void gpio_apply(unsigned port, uint16_t pin, uint8_t state)
+{
+    gpios[port].extDriven |= pin;
+    if (state != 0U)
+    {
+        gpios[port].extLevel |= pin;
+    }
+    else
+    {
+        gpios[port].extLevel &= (uint16_t)~pin;
+    }
+}
+
+static void gpio_reconcile(void)
+{
+    uint32_t pr = halsim_EXTI.PR;
+
+    /* EXTI_PR is write-1-to-clear; the published value always has the mark */
+    if ((pr & HALSIM_PR_MARK) == 0U)
+    {
+        hwPR &= ~pr;
+    }
+    if (halsim_EXTI.SWIER != 0U)
+    {
+        hwPR |= halsim_EXTI.SWIER & 0xFFFFU;
+        halsim_EXTI.SWIER = 0U;
+    }
+
+    pthread_mutex_lock(&inputLock);
+    while (inputTail != inputHead)
+    {
+        const pin_event_t *e = &inputs[inputTail % INPUT_MAX];
+        gpio_apply(e->port, e->pin, e->state);
+        inputTail++;
+    }
+    pthread_mutex_unlock(&inputLock);
+
+    for (unsigned p = 0; p < GPIO_COUNT; p++)
+    {
+        gpio_model_t *g = &gpios[p];
+        GPIO_TypeDef *r = g->r;
+        uint32_t bsrr = r->BSRR;
+        uint32_t brr  = r->BRR;
+        uint16_t odr, idr = 0U, outputs = 0U, changed;
+
+        if (bsrr != 0U)
+        {
+            r->ODR = (r->ODR & ~(bsrr >> 16)) | (bsrr & 0xFFFFU);
+            r->BSRR = 0U;
+        }
+        if (brr != 0U)
+        {
+            r->ODR &= ~brr;
+            r->BRR = 0U;
+        }
+        odr = (uint16_t)r->ODR;
+
+        for (unsigned pin = 0; pin < 16U; pin++)
+        {
+            uint16_t bit = (uint16_t)(1U << pin);
+            uint32_t mode = (r->MODER >> (2U * pin)) & 3U;
+            uint32_t pull = (r->PUPDR >> (2U * pin)) & 3U;
+            bool level;
+
+            if (mode == 1U)
+            {
+                outputs |= bit;
+                level = (odr & bit) != 0U;
+                if ((r->OTYPER & bit) != 0U && (g->extDriven & bit) != 0U && (g->extLevel & bit) == 0U)
+                {
+                    level = false;   // Open drain pulled low from outside
+                }
+            }
+            else if ((g->extDriven & bit) != 0U)
+            {
+                level = (g->extLevel & bit) != 0U;
+            }
+            else if (pull != 0U)
+            {
+                level = (pull == 1U);
+            }
+            else
+            {
+                level = (g->boardHigh & bit) != 0U;
+            }
+            idr |= level ? bit : 0U;
+        }
+
+        /* Edges on lines routed to this port */
+        changed = (uint16_t)(idr ^ r->IDR);
+        for (unsigned line = 0; changed != 0U && line < 16U; line++)
+        {
+            uint16_t bit = (uint16_t)(1U << line);
+            uint32_t src = (halsim_SYSCFG.EXTICR[line >> 2] >> (4U * (line & 3U))) & 0xFU;
+
+            if ((changed & bit) == 0U || src != g->exticr)
+            {
+                continue;
+            }
+            if (((idr & bit) != 0U && (halsim_EXTI.RTSR & bit) != 0U) ||
+                ((idr & bit) == 0U && (halsim_EXTI.FTSR & bit) != 0U))
+            {
+                hwPR |= bit;
+            }
+        }
+        r->IDR = idr;
+
+        if ((halsim_trace_flags & HALSIM_TRACE_GPIO) != 0U)
+        {
+            uint16_t diff = (uint16_t)((odr ^ g->lastOdr) & outputs);
+            for (unsigned pin = 0; diff != 0U; pin++, diff >>= 1)
+            {
+                if ((diff & 1U) != 0U)
+                {
+                    halsim_trace("P%c%u = %u", g->name, pin, (odr >> pin) & 1U);
+                }
+            }
+        }
+        g->lastOdr = odr;
+    }
+}
+
+/* "PC13=0@1000,PC13=1@1150": drive pins at virtual times in ms */
+void halsim_hw_gpio_script(const char *spec)
+{
+    const char *s = spec;
+
+    while (*s != '\0' && scriptLen < SCRIPT_MAX)
+    {
+        char portName;
+        unsigned pin, state;
+        unsigned long ms;
+        int used = 0;
+
+        if (sscanf(s, " P%c%u=%u@%lu%n", &portName, &pin, &state, &ms, &used) != 4 || pin > 15U)
+        {
+            fprintf(stderr, "halsim: bad HALSIM_GPIO entry at '%s'\n", s);
+            return;
+        }
+        for (unsigned p = 0; p < GPIO_COUNT; p++)
+        {
+            if (gpios[p].name == portName)
+            {
+                unsigned k = scriptLen++;
+                /* Keep the list sorted by time */
+                while (k > 0U && script[k - 1U].time > ms * 1000000ULL)
+                {
+                    script[k] = script[k - 1U];
+                    k--;
+                }
+                script[k] = (pin_event_t){ ms * 1000000ULL, (uint8_t)p, (uint16_t)(1U << pin),
+                                           (uint8_t)(state != 0U) };
+            }
+        }
+        s += used;
+        if (*s == ',')
+        {
+            s++;
+        }
+    }
+}
+
+void halsim_hw_gpio_input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    for (unsigned p = 0; p < GPIO_COUNT; p++)
+    {
+        if (gpios[p].r == port)
+        {
+            pthread_mutex_lock(&inputLock);
+            if (inputHead - inputTail < INPUT_MAX)
+            {
+                inputs[inputHead % INPUT_MAX] = (pin_event_t){ 0, (uint8_t)p, pin, (uint8_t)state };
+                inputHead++;
+            }
+            pthread_mutex_unlock(&inputLock);
+        }
+    }
+}
+
+/* ==========================================================================
+   USART
+   ========================================================================== */
+int halsim_hw_uart_index(const USART_TypeDef *uart)
+{
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        if (uarts[i].r == uart)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uart_model_t *uart_of(const volatile void *reg, bool tdr)
+{
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        if (reg == (tdr ? (const volatile void *)&uarts[i].r->TDR : (const volatile void *)&uarts[i].r->RDR))
+        {
+            return &uarts[i];
+        }
+    }
+    return NULL;
+}
+
+/* Frame time from BRR, word length and stop bits at the current PCLK */
+static uint64_t uart_frame_ns(const uart_model_t *u)
+{
+    uint32_t cr1 = u->r->CR1;
+    uint32_t brr = u->r->BRR;
+    uint32_t bits = 1U + (((cr1 & USART_CR1_M1) != 0U) ? 7U : ((cr1 & USART_CR1_M0) != 0U) ? 9U : 8U) +
+                    (((u->r->CR2 & USART_CR2_STOP_1) != 0U) ? 2U : 1U);
+    double div;
+
+    if (brr == 0U)
+    {
+        return (uint64_t)(bits * 1e9 / 115200.0);
+    }
+    div = ((cr1 & USART_CR1_OVER8) != 0U) ? (double)((brr & 0xFFF0U) | ((brr & 0x7U) << 1)) / 2.0
+                                          : (double)brr;
+    return (uint64_t)(bits * 1e9 * div / (double)halsim_pclk);
+}
+
+static bool uart_rx_enabled(const uart_model_t *u)
+{
+    return (u->r->CR1 & (USART_CR1_UE | USART_CR1_RE)) == (USART_CR1_UE | USART_CR1_RE);
+}
+
+/* Start the next queued frame on the RX line, after any injected gap */
+static void uart_rx_start(uart_model_t *u, uint64_t t)
+{
+    uint64_t frame = uart_frame_ns(u);
+
+    if (u->rxDue != HALSIM_NEVER || !uart_rx_enabled(u))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&u->qLock);
+    while (u->qTail != u->qHead)
+    {
+        uint16_t item = u->queue[u->qTail % RX_QUEUE_SIZE];
+        u->qTail++;
+        if ((item & 0x8000U) != 0U)
+        {
+            u->lineFree = (u->lineFree > t ? u->lineFree : t) + (item & 0x7FFFU) * frame;
+            continue;
+        }
+
+        uint64_t start = (u->lineFree > t) ? u->lineFree : t;
+        if (start < u->idleDue)
+        {
+            u->idleDue = HALSIM_NEVER;   // Line never went idle for a full frame
+        }
+        u->rxShift = item;
+        u->rxDue = start + frame;
+        break;
+    }
+    pthread_mutex_unlock(&u->qLock);
+}
+
+/* A frame late by less than a frame keeps the line's pace. Later than
+   that, `now` rather than `t` starts the next frame: when the host ran
+   late, a backlog still arrives at line rate from the CPU's point of view */
+static void uart_rx_done(uart_model_t *u, uint64_t t, uint64_t now)
+{
+    USART_TypeDef *r = u->r;
+
+    if (now - t < uart_frame_ns(u))
+    {
+        now = t;
+    }
+
+    u->rxDue = HALSIM_NEVER;
+    u->lineFree = t;
+    halsim_uart_input((int)(u - uarts), (uint8_t)u->rxShift, now);   // When the CPU can see it
+    if (uart_rx_enabled(u))
+    {
+        if ((r->ISR & USART_ISR_RXNE) != 0U)
+        {
+            u->stats.rxOverruns++;
+            if ((r->CR3 & USART_CR3_OVRDIS) != 0U)
+            {
+                r->RDR = u->rxShift;
+                u->stats.rxBytes++;
+                u->rxSeq++;
+            }
+            else
+            {
+                r->ISR |= USART_ISR_ORE;
+            }
+        }
+        else
+        {
+            r->RDR = u->rxShift;
+            r->ISR |= USART_ISR_RXNE;
+            u->stats.rxBytes++;
+            u->rxSeq++;
+            /* Hold the next frame until the ISR has run at least once: when
+               the host falls behind, frames would otherwise land back to back
+               before the CPU got any time and always overrun */
+            u->rxHeld = (r->CR1 & USART_CR1_RXNEIE) != 0U;
+        }
+        u->idleDue = now + uart_frame_ns(u);
+        if ((r->CR3 & USART_CR3_DMAR) != 0U && (r->ISR & USART_ISR_RXNE) != 0U)
+        {
+            dma_request(u->rxCh, t);
+        }
+    }
+    uart_rx_start(u, now);
+}
+
+/* Move TDR to the shifter and let the TX DMA refill it */
+static void uart_tx_pump(uart_model_t *u, uint64_t t)
+{
+    USART_TypeDef *r = u->r;
+
+    for (;;)
+    {
+        if (!u->txShifting && u->holdValid)
+        {
+            u->txShift = u->hold;
+            u->holdValid = false;
+            u->txShifting = true;
+            u->txDue = t + uart_frame_ns(u);
+            r->ISR |= USART_ISR_TXE;
+        }
+        if ((r->CR3 & USART_CR3_DMAT) != 0U && (r->ISR & USART_ISR_TXE) != 0U &&
+            !u->holdValid && dma_request(u->txCh, t))
+        {
+            continue;
+        }
+        break;
+    }
+}
+
+static void uart_tdr_load(uart_model_t *u, uint16_t data)
+{
+    if ((u->r->CR1 & (USART_CR1_UE | USART_CR1_TE)) != (USART_CR1_UE | USART_CR1_TE))
+    {
+        return;
+    }
+    u->hold = data & 0x1FFU;
+    u->holdValid = true;
+    u->r->ISR &= ~(USART_ISR_TXE | USART_ISR_TC);
+}
+
+static void uart_tx_done(uart_model_t *u, uint64_t t)
+{
+    halsim_uart_output((int)(u - uarts), (uint8_t)u->txShift, t);
+    u->stats.txBytes++;
+    u->txShifting = false;
+    u->txDue = HALSIM_NEVER;
+    uart_tx_pump(u, t);
+    if (!u->txShifting && !u->holdValid)
+    {
+        u->r->ISR |= USART_ISR_TC;
+    }
+}
+
+static void uart_reconcile(uart_model_t *u, uint64_t now)
+{
+    USART_TypeDef *r = u->r;
+    uint32_t icr = r->ICR;
+
+    if (icr != 0U)
+    {
+        uint32_t clear = icr & (USART_ICR_PECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_ORECF |
+                                USART_ICR_IDLECF | USART_ICR_TCCF | USART_ICR_CTSCF);
+        r->ISR &= ~clear;
+        r->ICR = 0U;
+    }
+    if ((r->RQR & USART_RQR_RXFRQ) != 0U)
+    {
+        r->ISR &= ~USART_ISR_RXNE;
+    }
+    r->RQR = 0U;
+
+    if ((r->CR1 & USART_CR1_UE) == 0U)
+    {
+        /* Disabled: shifters stop, flags back to reset */
+        u->txShifting = false;
+        u->holdValid = false;
+        u->txDue = HALSIM_NEVER;
+        u->rxDue = HALSIM_NEVER;
+        u->idleDue = HALSIM_NEVER;
+        u->rxHeld = false;
+        r->ISR = USART_ISR_TXE | USART_ISR_TC;
+        r->TDR = HALSIM_TDR_EMPTY;
+        return;
+    }
+
+    if (r->TDR != HALSIM_TDR_EMPTY)
+    {
+        uint16_t data = (uint16_t)r->TDR;
+        r->TDR = HALSIM_TDR_EMPTY;
+        uart_tdr_load(u, data);
+    }
+    uart_tx_pump(u, now);
+
+    if ((r->CR3 & USART_CR3_DMAR) != 0U && (r->ISR & USART_ISR_RXNE) != 0U)
+    {
+        dma_request(u->rxCh, now);
+    }
+    if ((r->CR1 & USART_CR1_RE) == 0U)
+    {
+        u->rxDue = HALSIM_NEVER;
+    }
+    if ((r->ISR & USART_ISR_RXNE) == 0U || (r->CR1 & USART_CR1_RXNEIE) == 0U)
+    {
+        u->rxHeld = false;
+    }
+    uart_rx_start(u, now);
+}
+
+static bool uart_level(const uart_model_t *u)
+{
+    uint32_t isr = u->r->ISR;
+    uint32_t cr1 = u->r->CR1;
+    bool eie = (u->r->CR3 & USART_CR3_EIE) != 0U;
+
+    return ((isr & USART_ISR_RXNE) != 0U && (cr1 & USART_CR1_RXNEIE) != 0U) ||
+           ((isr & USART_ISR_ORE) != 0U && ((cr1 & USART_CR1_RXNEIE) != 0U || eie)) ||
+           ((isr & USART_ISR_IDLE) != 0U && (cr1 & USART_CR1_IDLEIE) != 0U) ||
+           ((isr & USART_ISR_TXE) != 0U && (cr1 & USART_CR1_TXEIE) != 0U) ||
+           ((isr & USART_ISR_TC) != 0U && (cr1 & USART_CR1_TCIE) != 0U) ||
+           ((isr & USART_ISR_PE) != 0U && (cr1 & USART_CR1_PEIE) != 0U) ||
+           ((isr & (USART_ISR_FE | USART_ISR_NE)) != 0U && eie);
+}
+
+uint16_t halsim_hw_rdr_read(USART_TypeDef *uart)
+{
+    uint16_t data;
+
+    halsim_lock();
+    data = (uint16_t)(uart->RDR & 0x1FFU);
+    uart->ISR &= ~USART_ISR_RXNE;
+    halsim_unlock();
+    return data;
+}
+
+void halsim_hw_tdr_write(USART_TypeDef *uart, uint16_t data)
+{
+    halsim_lock();
+    uart->TDR = data;
+    halsim_unlock();
+}
+
+bool halsim_hw_rx_push(int uart, uint16_t item)
+{
+    uart_model_t *u = &uarts[uart];
+    bool ok;
+
+    pthread_mutex_lock(&u->qLock);
+    ok = (u->qHead - u->qTail) < RX_QUEUE_SIZE;
+    if (ok)
+    {
+        u->queue[u->qHead % RX_QUEUE_SIZE] = item;
+        u->qHead++;
+    }
+    pthread_mutex_unlock(&u->qLock);
+    return ok;
+}
+
+size_t halsim_hw_rx_free(int uart)
+{
+    uart_model_t *u = &uarts[uart];
+    size_t used;
+
+    pthread_mutex_lock(&u->qLock);
+    used = u->qHead - u->qTail;
+    pthread_mutex_unlock(&u->qLock);
+    return RX_QUEUE_SIZE - used;
+}
+
+void halsim_hw_uart_stats(int uart, halsim_uart_stats_t *stats)
+{
+    *stats = uarts[uart].stats;
+    stats->rxQueued = (uint32_t)(RX_QUEUE_SIZE - halsim_hw_rx_free(uart));
+}
+
+/* ==========================================================================
+   DMA
+   ========================================================================== */
+void halsim_hw_dma_bind(DMA_Channel_TypeDef *ch, const void *mem, const volatile void *periph)
+{
+    dma_model_t *m = &dmas[ch - halsim_DMA1_Channel];
+
+    m->boundMem = mem;
+    m->boundPeriph = periph;
+}
+
+static uintptr_t dma_resolve(uint32_t reg, const volatile void *bound)
+{
+    if (bound != NULL && (uint32_t)(uintptr_t)bound == reg)
+    {
+        return (uintptr_t)bound;
+    }
+    return (uintptr_t)halsim_ptr(reg);
+}
+
+static void dma_arm(int ch)
+{
+    DMA_Channel_TypeDef *c = &halsim_DMA1_Channel[ch];
+    dma_model_t *m = &dmas[ch];
+
+    m->total  = (uint16_t)c->CNDTR;
+    m->lastCndtr = m->total;
+    m->armedCmar = c->CMAR;
+    m->armedCpar = c->CPAR;
+    m->mem    = dma_resolve(c->CMAR, m->boundMem);
+    m->periph = dma_resolve(c->CPAR, m->boundPeriph);
+}
+
+static uint32_t load_n(uintptr_t addr, unsigned size)
+{
+    switch (size)
+    {
+    case 1U:  return *(volatile uint8_t *)addr;
+    case 2U:  return *(volatile uint16_t *)addr;
+    default:  return *(volatile uint32_t *)addr;
+    }
+}
+
+static void store_n(uintptr_t addr, uint32_t value, unsigned size)
+{
+    switch (size)
+    {
+    case 1U:  *(volatile uint8_t *)addr = (uint8_t)value; break;
+    case 2U:  *(volatile uint16_t *)addr = (uint16_t)value; break;
+    default:  *(volatile uint32_t *)addr = value; break;
+    }
+}
+
+/* One transfer for a peripheral request; false if the channel cannot serve it */
+static bool dma_request(int ch, uint64_t t)
+{
+    DMA_Channel_TypeDef *c;
+    dma_model_t *m;
+    uint32_t ccr, idx, value;
+    unsigned psize, msize;
+    uintptr_t mem, periph;
+    uart_model_t *u;
+
+    if (ch < 0)
+    {
+        return false;
+    }
+    c = &halsim_DMA1_Channel[ch];
+    m = &dmas[ch];
+    ccr = c->CCR;
+    if ((ccr & DMA_CCR_EN) == 0U || (uint16_t)c->CNDTR == 0U)
+    {
+        return false;
+    }
+
+    idx    = (uint32_t)m->total - (uint16_t)c->CNDTR;
+    psize  = 1U << ((ccr >> 8) & 3U);
+    msize  = 1U << ((ccr >> 10) & 3U);
+    mem    = m->mem + (((ccr & DMA_CCR_MINC) != 0U) ? idx * msize : 0U);
+    periph = m->periph + (((ccr & DMA_CCR_PINC) != 0U) ? idx * psize : 0U);
+
+    if ((ccr & DMA_CCR_DIR) != 0U)
+    {
+        value = load_n(mem, msize);
+        if ((u = uart_of((const volatile void *)periph, true)) != NULL)
+        {
+            uart_tdr_load(u, (uint16_t)value);
+        }
+        else
+        {
+            store_n(periph, value, psize);
+        }
+    }
+    else
+    {
+        if ((u = uart_of((const volatile void *)periph, false)) != NULL)
+        {
+            value = u->r->RDR & 0x1FFU;
+            u->r->ISR &= ~USART_ISR_RXNE;
+        }
+        else
+        {
+            value = load_n(periph, psize);
+        }
+        store_n(mem, value, msize);
+    }
+
+    c->CNDTR = (uint16_t)(c->CNDTR - 1U);
+    if ((uint32_t)m->total - c->CNDTR == m->total / 2U)
+    {
+        halsim_DMA1.ISR |= 0x5UL << (4U * (unsigned)ch);   // GIF | HTIF
+    }
+    if (c->CNDTR == 0U)
+    {
+        halsim_DMA1.ISR |= 0x3UL << (4U * (unsigned)ch);   // GIF | TCIF
+        if ((ccr & DMA_CCR_CIRC) != 0U)
+        {
+            c->CNDTR = m->total;
+        }
+    }
+    m->lastCndtr = (uint16_t)c->CNDTR;
+    (void)t;
+    return true;
+}
+
+static void dma_reconcile(void)
+{
+    uint32_t ifcr = halsim_DMA1.IFCR;
+
+    if (ifcr != 0U)
+    {
+        for (unsigned ch = 0; ch < 5U; ch++)
+        {
+            if ((ifcr & (1UL << (4U * ch))) != 0U)
+            {
+                ifcr |= 0xFUL << (4U * ch);   // CGIF clears all flags of the channel
+            }
+        }
+        halsim_DMA1.ISR &= ~ifcr;
+        halsim_DMA1.IFCR = 0U;
+    }
+    for (int ch = 0; ch < 5; ch++)
+    {
+        DMA_Channel_TypeDef *c = &halsim_DMA1_Channel[ch];
+        dma_model_t *m = &dmas[ch];
+        uint32_t ccr = c->CCR;
+
+        /* A driver may toggle EN within one locked section: a rewritten
+           CNDTR/CMAR/CPAR on an enabled channel also starts a new transfer */
+        if ((ccr & DMA_CCR_EN) != 0U &&
+            ((m->lastCcr & DMA_CCR_EN) == 0U || (uint16_t)c->CNDTR != m->lastCndtr ||
+             c->CMAR != m->armedCmar || c->CPAR != m->armedCpar))
+        {
+            dma_arm(ch);
+        }
+        m->lastCcr = ccr;
+    }
+}
+
+/* ==========================================================================
+   Timers
+   ========================================================================== */
+static uint32_t tim_clock(void)
+{
+    /* x2 when the APB prescaler divides */
+    return (halsim_pclk != halsim_hclk) ? 2U * halsim_pclk : halsim_pclk;
+}
+
+static bool tim_has_events(const tim_model_t *tm)
+{
+    return (tm->r->DIER & (TIM_DIER_UIE | TIM_DIER_UDE)) != 0U || (tm->r->CR1 & TIM_CR1_OPM) != 0U;
+}
+
+static uint32_t tim_counter(const tim_model_t *tm, uint64_t now)
+{
+    if (!tm->running || now <= tm->baseT)
+    {
+        return tm->baseCnt;
+    }
+    return tm->baseCnt + (uint32_t)((double)(now - tm->baseT) / tm->tickNs);
+}
+
+/* Restart the time base at `t` with counter value `cnt`, loading ARR and PSC */
+static void tim_rebase(tim_model_t *tm, uint64_t t, uint32_t cnt)
+{
+    tm->baseT   = t;
+    tm->baseCnt = cnt & 0xFFFFU;
+    tm->arr     = tm->r->ARR & 0xFFFFU;
+    tm->clk     = tim_clock();
+    tm->tickNs  = ((tm->r->PSC & 0xFFFFU) + 1U) * 1e9 / (double)tm->clk;
+    tm->wrapOnly = tm->baseCnt > tm->arr;
+
+    if (!tm->running)
+    {
+        tm->nextUpdate = HALSIM_NEVER;
+    }
+    else
+    {
+        uint32_t left = tm->wrapOnly ? 0x10000U - tm->baseCnt : tm->arr + 1U - tm->baseCnt;
+        tm->nextUpdate = t + (uint64_t)(left * tm->tickNs);
+    }
+}
+
+/* Compare preload: with OCxPE set, CCRx reaches the output at an update event */
+static bool tim_ccr_preloaded(const tim_model_t *tm, unsigned ch)
+{
+    uint32_t ccmr = (ch < 2U) ? tm->r->CCMR1 : tm->r->CCMR2;
+    return (ccmr & (TIM_CCMR1_OC1PE << (8U * (ch & 1U)))) != 0U;
+}
+
+static void tim_load_ccr(tim_model_t *tm, bool update)
+{
+    volatile uint32_t *ccr = &tm->r->CCR1;
+    for (unsigned ch = 0; ch < 4U; ch++)
+    {
+        if (update || !tim_ccr_preloaded(tm, ch))
+        {
+            tm->ccr[ch] = ccr[ch] & 0xFFFFU;
+        }
+    }
+}
+
+static void tim_update(tim_model_t *tm, uint64_t now)
+{
+    TIM_TypeDef *r = tm->r;
+    uint64_t t = tm->nextUpdate;
+
+    if (tm->wrapOnly)
+    {
+        tim_rebase(tm, t, 0U);
+        return;
+    }
+
+    /* Without anything to trigger, fold all elapsed periods into one */
+    if (!tim_has_events(tm))
+    {
+        uint64_t period = (uint64_t)((tm->arr + 1U) * tm->tickNs);
+        if (period != 0U && now > t + period)
+        {
+            t += ((now - t) / period) * period;
+        }
+    }
+
+    if ((r->CR1 & TIM_CR1_UDIS) != 0U)
+    {
+        /* The counter wraps, but ARR, PSC and the compare values stay as they are */
+        tm->baseT = t;
+        tm->baseCnt = 0U;
+        tm->nextUpdate = t + (uint64_t)((tm->arr + 1U) * tm->tickNs);
+        return;
+    }
+    tm->hwSr |= TIM_SR_UIF;
+    tim_load_ccr(tm, true);                // Before the DMA writes the next preload value
+    if ((r->DIER & TIM_DIER_UDE) != 0U)
+    {
+        dma_request(tm->dmaCh, t);
+    }
+    if ((r->CR1 & TIM_CR1_OPM) != 0U)
+    {
+        r->CR1 &= ~TIM_CR1_CEN;
+        tm->running = false;
+    }
+    tim_rebase(tm, t, 0U);
+}
+
+static void tim_reconcile(tim_model_t *tm, uint64_t now)
+{
+    TIM_TypeDef *r = tm->r;
+    bool cen = (r->CR1 & TIM_CR1_CEN) != 0U;
+    uint32_t cnt;
+
+    /* SR is rc_w0: a written 0 clears, a written 1 keeps */
+    if (r->SR != tm->hwSr)
+    {
+        tm->hwSr &= r->SR;
+    }
+
+    while (tm->running && tm->nextUpdate <= now)
+    {
+        tim_update(tm, now);
+    }
+    cnt = tim_counter(tm, now);
+    tim_load_ccr(tm, false);
+
+    if ((r->EGR & TIM_EGR_UG) != 0U)
+    {
+        r->EGR = 0U;
+        if ((r->CR1 & TIM_CR1_URS) == 0U)
+        {
+            tm->hwSr |= TIM_SR_UIF;
+        }
+        tim_load_ccr(tm, true);
+        tm->running = cen;
+        tim_rebase(tm, now, 0U);
+        return;
+    }
+    if (r->CNT != tm->lastCnt)
+    {
+        tm->running = cen;
+        tim_rebase(tm, now, r->CNT);
+        return;
+    }
+    /* ARR without preload and the clock apply at once, PSC at the next update */
+    if (cen != tm->running || tm->clk != tim_clock() ||
+        ((r->CR1 & TIM_CR1_ARPE) == 0U && (r->ARR & 0xFFFFU) != tm->arr))
+    {
+        tm->running = cen;
+        tim_rebase(tm, now, cnt);
+    }
+}
+
+static void tim_publish(tim_model_t *tm, uint64_t now)
+{
+    TIM_TypeDef *r = tm->r;
+    uint32_t cnt = tim_counter(tm, now);
+
+    if (!tm->wrapOnly && cnt > tm->arr)
+    {
+        cnt = tm->arr;
+    }
+    r->CNT = cnt & 0xFFFFU;
+    tm->lastCnt = r->CNT;
+    r->SR = tm->hwSr;
+
+    if ((halsim_trace_flags & HALSIM_TRACE_PWM) != 0U)
+    {
+        for (unsigned ch = 0; ch < 4U; ch++)
+        {
+            if ((r->CCER & (1UL << (4U * ch))) != 0U && tm->ccr[ch] != tm->lastCcr[ch] &&
+                now - tm->lastTrace[ch] >= PWM_TRACE_NS)
+            {
+                tm->lastCcr[ch] = tm->ccr[ch];
+                tm->lastTrace[ch] = now;
+                halsim_trace("%s CH%u duty %lu/%lu", tm->name, ch + 1U,
+                             (unsigned long)tm->ccr[ch], (unsigned long)tm->arr + 1UL);
+            }
+        }
+    }
+}
+
+/* ==========================================================================
+   SysTick
+   ========================================================================== */
+static void systick_reconcile(uint64_t now)
+{
+    uint32_t ctrl = halsim_SysTick.CTRL & 0x7U;
+    uint32_t load = halsim_SysTick.LOAD & SysTick_LOAD_RELOAD_Msk;
+    uint32_t clk  = ((ctrl & SysTick_CTRL_CLKSOURCE_Msk) != 0U) ? halsim_hclk : halsim_hclk / 8U;
+
+    if (ctrl == stCtrl && load == stLoad && clk == stClk && halsim_SysTick.VAL == stVal)
+    {
+        return;
+    }
+    stCtrl = ctrl;
+    stLoad = load;
+    stClk  = clk;
+    stOwed = 0U;
+    stPeriod = (uint64_t)((load + 1ULL) * 1000000000ULL / clk);
+    stNext = ((ctrl & SysTick_CTRL_ENABLE_Msk) != 0U && stPeriod != 0U) ? now + stPeriod : HALSIM_NEVER;
+}
+
+static void systick_wrap(uint64_t now)
+{
+    halsim_SysTick.CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+    if ((halsim_SysTick.CTRL & SysTick_CTRL_TICKINT_Msk) != 0U)
+    {
+        halsim_pend_systick();
+    }
+    stNext += stPeriod;
+    if (stNext <= now)
+    {
+        /* The host thread was late, not the target: replay the missed ticks
+           one exception at a time so HAL_GetTick() keeps virtual time */
+        uint64_t missed = (now - stNext) / stPeriod + 1U;
+        stNext += missed * stPeriod;
+        stOwed = (stOwed + missed > ST_OWED_MAX) ? ST_OWED_MAX : (uint32_t)(stOwed + missed);
+    }
+}
+
+static void systick_publish(uint64_t now)
+{
+    if (stNext != HALSIM_NEVER && stNext > now)
+    {
+        uint64_t left = (stNext - now) * stClk / 1000000000ULL;
+        halsim_SysTick.VAL = (uint32_t)((left > stLoad) ? stLoad : left);
+    }
+    stVal = halsim_SysTick.VAL;
+}
+
+/* ==========================================================================
+   Step, IRQ lines, reset
+   ========================================================================== */
+uint64_t halsim_hw_step(uint64_t now)
+{
+    uint64_t deadline = HALSIM_NEVER;
+
+    gpio_reconcile();
+    dma_reconcile();
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        uart_reconcile(&uarts[i], now);
+    }
+    for (unsigned i = 0; i < TIM_COUNT; i++)
+    {
+        tim_reconcile(&tims[i], now);
+    }
+    systick_reconcile(now);
+
+    /* Play due events in time order */
+    for (;;)
+    {
+        uint64_t t = stNext;
+        int kind = 0;
+        void *who = NULL;
+
+        if (scriptPos < scriptLen && script[scriptPos].time < t)
+        {
+            t = script[scriptPos].time;
+            kind = 1;
+        }
+        for (int i = 0; i < HALSIM_UART_COUNT; i++)
+        {
+            uart_model_t *u = &uarts[i];
+            if (u->rxDue < t && !u->rxHeld) { t = u->rxDue; kind = 2; who = u; }
+            if (u->idleDue < t) { t = u->idleDue; kind = 3; who = u; }
+            if (u->txDue < t)   { t = u->txDue;   kind = 4; who = u; }
+        }
+        for (unsigned i = 0; i < TIM_COUNT; i++)
+        {
+            if (tims[i].running && tims[i].nextUpdate < t)
+            {
+                t = tims[i].nextUpdate;
+                kind = 5;
+                who = &tims[i];
+            }
+        }
+        if (t > now)
+        {
+            break;
+        }
+
+        switch (kind)
+        {
+        case 0:
+            systick_wrap(now);
+            break;
+        case 1:
+            gpio_apply(script[scriptPos].port, script[scriptPos].pin, script[scriptPos].state);
+            scriptPos++;
+            gpio_reconcile();
+            break;
+        case 2:
+            uart_rx_done(who, t, now);
+            break;
+        case 3:
+            ((uart_model_t *)who)->idleDue = HALSIM_NEVER;
+            if (uart_rx_enabled(who))
+            {
+                ((uart_model_t *)who)->r->ISR |= USART_ISR_IDLE;
+            }
+            break;
+        default:
+            if (kind == 4)
+            {
+                uart_tx_done(who, t);
+            }
+            else
+            {
+                tim_update(who, now);
+            }
+            break;
+        }
+        dma_reconcile();
+    }
+
+    /* Publish derived registers and find the next event worth waking for */
+    for (unsigned i = 0; i < TIM_COUNT; i++)
+    {
+        tim_publish(&tims[i], now);
+        if (tims[i].running && tim_has_events(&tims[i]))
+        {
+            deadline = min_u64(deadline, tims[i].nextUpdate);
+        }
+    }
+    systick_publish(now);
+    halsim_EXTI.PR = hwPR | HALSIM_PR_MARK;
+
+    deadline = min_u64(deadline, stNext);
+    if (scriptPos < scriptLen)
+    {
+        deadline = min_u64(deadline, script[scriptPos].time);
+    }
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        uint64_t rx = uarts[i].rxHeld ? HALSIM_NEVER : uarts[i].rxDue;
+        deadline = min_u64(deadline, min_u64(rx, min_u64(uarts[i].idleDue, uarts[i].txDue)));
+    }
+    return deadline;
+}
+
+uint32_t halsim_hw_levels(void)
+{
+    uint32_t lv = 0U;
+    uint32_t pr = hwPR & halsim_EXTI.IMR;
+    static const IRQn_Type dmaIrq[5] = { DMA1_Channel1_IRQn, DMA1_Channel2_3_IRQn, DMA1_Channel2_3_IRQn,
+                                         DMA1_Channel4_5_IRQn, DMA1_Channel4_5_IRQn };
+
+    if ((pr & 0x0003U) != 0U) lv |= 1UL << EXTI0_1_IRQn;
+    if ((pr & 0x000CU) != 0U) lv |= 1UL << EXTI2_3_IRQn;
+    if ((pr & 0xFFF0U) != 0U) lv |= 1UL << EXTI4_15_IRQn;
+
+    for (unsigned ch = 0; ch < 5U; ch++)
+    {
+        /* TCIF/HTIF/TEIF line up with TCIE/HTIE/TEIE */
+        if ((((halsim_DMA1.ISR >> (4U * ch)) & halsim_DMA1_Channel[ch].CCR) & 0xEU) != 0U)
+        {
+            lv |= 1UL << dmaIrq[ch];
+        }
+    }
+    for (unsigned i = 0; i < TIM_COUNT; i++)
+    {
+        uint32_t active = tims[i].hwSr & tims[i].r->DIER;
+        if ((active & TIM_SR_UIF) != 0U)
+        {
+            lv |= 1UL << tims[i].irq;
+        }
+        if ((active & 0x1EU) != 0U)
+        {
+            lv |= 1UL << tims[i].ccIrq;
+        }
+    }
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        if (uart_level(&uarts[i]))
+        {
+            lv |= 1UL << uarts[i].irq;
+        }
+    }
+    return lv;
+}
+
+void halsim_hw_isr_enter(int irq)
+{
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        uart_model_t *u = &uarts[i];
+        if (u->irq == irq)
+        {
+            u->entryRxne = (u->r->ISR & USART_ISR_RXNE) != 0U && (u->r->CR1 & USART_CR1_RXNEIE) != 0U;
+            u->entrySeq = u->rxSeq;
+            if (u->rxHeld)
+            {
+                /* On time the line keeps its pace; when the ISR came late,
+                   leave it half a frame to read RDR */
+                uint64_t earliest = halsim_now_ns() + uart_frame_ns(u) / 2U;
+                u->rxHeld = false;
+                if (u->rxDue != HALSIM_NEVER && u->rxDue < earliest)
+                {
+                    u->rxDue = earliest;
+                }
+            }
+        }
+    }
+}
+
+/* A handler that saw RXNE and returned without a new byte arriving read RDR */
+void halsim_hw_isr_exit(int irq)
+{
+    if (irq == SysTick_IRQn && stOwed != 0U &&
+        (halsim_SysTick.CTRL & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk)) ==
+            (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk))
+    {
+        stOwed--;
+        halsim_pend_systick();
+    }
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        uart_model_t *u = &uarts[i];
+        if (u->irq == irq && u->entryRxne && u->entrySeq == u->rxSeq)
+        {
+            u->r->ISR &= ~USART_ISR_RXNE;
+        }
+    }
+}
+
+void halsim_hw_reset(void)
+{
+    memset(&halsim_SysTick, 0, sizeof(halsim_SysTick));
+    halsim_SysTick.CALIB = 6000U;
+    halsim_SCB.CPUID = 0x410CC200U;   // Cortex-M0 r0p0
+
+    halsim_GPIOA.MODER = 0x28000000U;  // PA13/PA14 on SWD
+    halsim_GPIOA.PUPDR = 0x24000000U;
+    halsim_GPIOA.IDR = 0x6000U;        // Levels at reset, so boot sees no edges
+    halsim_GPIOC.IDR = GPIO_PIN_13;
+
+    for (int i = 0; i < HALSIM_UART_COUNT; i++)
+    {
+        uarts[i].r->ISR = USART_ISR_TXE | USART_ISR_TC;
+        uarts[i].r->TDR = HALSIM_TDR_EMPTY;
+        uarts[i].rxDue = uarts[i].idleDue = uarts[i].txDue = HALSIM_NEVER;
+    }
+    for (unsigned i = 0; i < TIM_COUNT; i++)
+    {
+        tims[i].r->ARR = 0xFFFFU;
+        tims[i].arr = 0xFFFFU;
+        tims[i].clk = tim_clock();
+        tims[i].tickNs = 1e9 / (double)tims[i].clk;
+        tims[i].nextUpdate = HALSIM_NEVER;
+    }
+    halsim_EXTI.PR = HALSIM_PR_MARK;
+    halsim_RCC.CR = 0x00000083U;       // HSION, HSIRDY
+    halsim_FLASH.ACR = 0x00000030U;
+}
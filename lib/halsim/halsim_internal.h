@@ -0,0 +1,64 @@
+/*
+ * File: halsim_internal.h
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Interfaces between the three parts of the simulator:
+ *
+ * - halsim.c      CPU model: virtual clock, simulator thread, NVIC,
+ *                 intrinsics, HAL core/RCC/PWR and the terminal endpoints.
+ * - halsim_hw.c   Peripheral models: GPIO/EXTI, USART, DMA, timers and
+ *                 SysTick, advanced by halsim_hw_step().
+ * - halsim_hal.c  GPIO/DMA/UART/TIM drivers written against the registers,
+ *                 mirroring the STM32CubeF0 code paths.
+ *
+ * Model state is only touched on the CPU thread, either from the signal
+ * handler or between halsim_lock() and halsim_unlock().
+ */
+
+#ifndef HALSIM_INTERNAL_H
+#define HALSIM_INTERNAL_H
+
+#include "halsim.h"
+
+#define HALSIM_NEVER       UINT64_MAX
+#define HALSIM_TDR_EMPTY   0xFFFFFFFFUL   // TDR value meaning "not written"
+#define HALSIM_PR_MARK     (1UL << 31)    // Always set in the published EXTI->PR
+#define HALSIM_UART_COUNT  2
+
+#define HALSIM_TRACE_GPIO  0x01U
+#define HALSIM_TRACE_PWM   0x02U
+#define HALSIM_TRACE_IRQ   0x04U
+
+/* ---- halsim.c ---- */
+extern uint32_t halsim_hclk;
+extern uint32_t halsim_pclk;
+extern unsigned halsim_trace_flags;
+
+void halsim_lock(void);
+void halsim_unlock(void);           // Runs the models, then pending IRQs if allowed
+void halsim_wait(void);             // Sleep until the models ran again
+void halsim_wake(void);             // Make the simulator thread re-read its deadline
+void halsim_trace(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void halsim_uart_output(int uart, uint8_t byte, uint64_t timeNs);
+void halsim_uart_input(int uart, uint8_t byte, uint64_t timeNs);   // RX frame done
+const char *halsim_irq_name(int irq);
+void halsim_pend_systick(void);
+
+/* ---- halsim_hw.c ---- */
+void     halsim_hw_reset(void);
+uint64_t halsim_hw_step(uint64_t now);          // Returns the next event time
+uint32_t halsim_hw_levels(void);                // Bit n = IRQn line high
+void     halsim_hw_isr_enter(int irq);
+void     halsim_hw_isr_exit(int irq);
+void     halsim_hw_dma_bind(DMA_Channel_TypeDef *ch, const void *mem, const volatile void *periph);
+uint16_t halsim_hw_rdr_read(USART_TypeDef *uart);          // Read RDR, clear RXNE
+void     halsim_hw_tdr_write(USART_TypeDef *uart, uint16_t data);
+int      halsim_hw_uart_index(const USART_TypeDef *uart);  // -1 if unknown
+bool     halsim_hw_rx_push(int uart, uint16_t item);       // item 0x8000 | n = n idle frames
+size_t   halsim_hw_rx_free(int uart);
+void     halsim_hw_uart_stats(int uart, halsim_uart_stats_t *stats);
+void     halsim_hw_gpio_input(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void     halsim_hw_gpio_script(const char *spec);
+void     *halsim_ptr(uint32_t addr);
+
+#endif /* HALSIM_INTERNAL_H */
@@ -0,0 +1,978 @@
+/*
+ * File: stm32f0xx_hal.h
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Host stand-in for the STM32CubeF0 HAL header, used by the `native`
+ * PlatformIO environments. It declares the subset of the HAL, CMSIS
+ * register blocks and Cortex-M intrinsics the examples use, with the
+ * same names and signatures as the real headers, so every main.c builds
+ * unchanged.
+ *
+ * Peripherals are plain structs in host memory. halsim.c models the
+ * parts with side effects (SysTick, USART shift registers, DMA channels,
+ * timers, EXTI) against a virtual clock and calls the example's own IRQ
+ * handlers; see halsim.h.
+ *
+ * Write-to-clear registers are applied when the model next runs, which
+ * is immediately for the HAL calls and at the end of every handler.
+ * EXTI->PR reads with bit 31 set so a write can be told from a stale
+ * value.
+ */
+
+#ifndef STM32F0XX_HAL_H
+#define STM32F0XX_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Behave like the smallest board of the matrix */
+#ifndef HALSIM
+#define HALSIM 1
+#endif
+#if !defined(STM32F030x8) && !defined(STM32F070xB) && !defined(STM32F072xB) && !defined(STM32F091xC)
+#define STM32F030x8
+#endif
+
+#define __IO volatile
+#define __weak __attribute__((weak))
+#define UNUSED(x) ((void)(x))
+
+/* ==========================================================================
+   Status / common types
+   ========================================================================== */
+typedef enum
+{
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    HAL_UNLOCKED = 0x00U,
+    HAL_LOCKED   = 0x01U
+} HAL_LockTypeDef;
+
+typedef enum { RESET = 0U, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0U, ENABLE = !DISABLE } FunctionalState;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+#define SET_BIT(REG, BIT)     ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)   ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)    ((REG) & (BIT))
+#define WRITE_REG(REG, VAL)   ((REG) = (VAL))
+#define READ_REG(REG)         ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) \
+    WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+/* ==========================================================================
+   Cortex-M0 core
+   ========================================================================== */
+typedef enum
+{
+    NonMaskableInt_IRQn      = -14,
+    HardFault_IRQn           = -13,
+    SVC_IRQn                 = -5,
+    PendSV_IRQn              = -2,
+    SysTick_IRQn             = -1,
+    WWDG_IRQn                = 0,
+    RTC_IRQn                 = 2,
+    FLASH_IRQn               = 3,
+    RCC_IRQn                 = 4,
+    EXTI0_1_IRQn             = 5,
+    EXTI2_3_IRQn             = 6,
+    EXTI4_15_IRQn            = 7,
+    DMA1_Channel1_IRQn       = 9,
+    DMA1_Channel2_3_IRQn     = 10,
+    DMA1_Channel4_5_IRQn     = 11,
+    ADC1_IRQn                = 12,
+    TIM1_BRK_UP_TRG_COM_IRQn = 13,
+    TIM1_CC_IRQn             = 14,
+    TIM3_IRQn                = 16,
+    TIM6_IRQn                = 17,
+    TIM14_IRQn               = 19,
+    TIM15_IRQn               = 20,
+    TIM16_IRQn               = 21,
+    TIM17_IRQn               = 22,
+    I2C1_IRQn                = 23,
+    I2C2_IRQn                = 24,
+    SPI1_IRQn                = 25,
+    SPI2_IRQn                = 26,
+    USART1_IRQn              = 27,
+    USART2_IRQn              = 28,
+    HALSIM_IRQn_COUNT        = 32
+} IRQn_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __IO uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+    __IO uint32_t CPUID;
+    __IO uint32_t ICSR;
+    uint32_t RESERVED0;
+    __IO uint32_t AIRCR;
+    __IO uint32_t SCR;
+    __IO uint32_t CCR;
+} SCB_Type;
+
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFUL)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1UL << 1)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+
+extern SysTick_Type halsim_SysTick;
+extern SCB_Type     halsim_SCB;
+#define SysTick (&halsim_SysTick)
+#define SCB     (&halsim_SCB)
+
+void     __disable_irq(void);
+void     __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t priMask);
+void     __WFI(void);
+void     __WFE(void);
+void     __SEV(void);
+#define  __NOP()  do { } while (0)
+#define  __DSB()  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define  __DMB()  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define  __ISB()  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+void     NVIC_EnableIRQ(IRQn_Type IRQn);
+void     NVIC_DisableIRQ(IRQn_Type IRQn);
+void     NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void     NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t SysTick_Config(uint32_t ticks);
+
+extern uint32_t SystemCoreClock;
+void SystemCoreClockUpdate(void);
+
+/* ==========================================================================
+   Peripheral register blocks
+   ========================================================================== */
+typedef struct
+{
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+    __IO uint32_t BRR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t CR3;
+    __IO uint32_t BRR;
+    __IO uint32_t GTPR;
+    __IO uint32_t RTOR;
+    __IO uint32_t RQR;
+    __IO uint32_t ISR;
+    __IO uint32_t ICR;
+    __IO uint32_t RDR;
+    __IO uint32_t TDR;
+} USART_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CCR;
+    __IO uint32_t CNDTR;
+    __IO uint32_t CPAR;
+    __IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t ISR;
+    __IO uint32_t IFCR;
+    __IO uint32_t CSELR;           // F09x request routing, kept but not modelled
+} DMA_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t IMR;
+    __IO uint32_t EMR;
+    __IO uint32_t RTSR;
+    __IO uint32_t FTSR;
+    __IO uint32_t SWIER;
+    __IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CFGR1;
+    uint32_t      RESERVED;
+    __IO uint32_t EXTICR[4];
+    __IO uint32_t CFGR2;
+} SYSCFG_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t CR;
+    __IO uint32_t CFGR;
+    __IO uint32_t CIR;
+    __IO uint32_t APB2RSTR;
+    __IO uint32_t APB1RSTR;
+    __IO uint32_t AHBENR;
+    __IO uint32_t APB2ENR;
+    __IO uint32_t APB1ENR;
+    __IO uint32_t BDCR;
+    __IO uint32_t CSR;
+    __IO uint32_t AHBRSTR;
+    __IO uint32_t CFGR2;
+    __IO uint32_t CFGR3;
+    __IO uint32_t CR2;
+} RCC_TypeDef;
+
+typedef struct
+{
+    __IO uint32_t ACR;
+    __IO uint32_t KEYR;
+    __IO uint32_t OPTKEYR;
+    __IO uint32_t SR;
+    __IO uint32_t CR;
+} FLASH_TypeDef;
+
+extern GPIO_TypeDef        halsim_GPIOA, halsim_GPIOB, halsim_GPIOC, halsim_GPIOF;
+extern USART_TypeDef       halsim_USART1, halsim_USART2;
+extern DMA_TypeDef         halsim_DMA1;
+extern DMA_Channel_TypeDef halsim_DMA1_Channel[5];
+extern TIM_TypeDef         halsim_TIM1, halsim_TIM3, halsim_TIM6, halsim_TIM14,
+                           halsim_TIM15, halsim_TIM16, halsim_TIM17;
+extern EXTI_TypeDef        halsim_EXTI;
+extern SYSCFG_TypeDef      halsim_SYSCFG;
+extern RCC_TypeDef         halsim_RCC;
+extern FLASH_TypeDef       halsim_FLASH;
+
+#define GPIOA          (&halsim_GPIOA)
+#define GPIOB          (&halsim_GPIOB)
+#define GPIOC          (&halsim_GPIOC)
+#define GPIOF          (&halsim_GPIOF)
+#define USART1         (&halsim_USART1)
+#define USART2         (&halsim_USART2)
+#define DMA1           (&halsim_DMA1)
+#define DMA1_Channel1  (&halsim_DMA1_Channel[0])
+#define DMA1_Channel2  (&halsim_DMA1_Channel[1])
+#define DMA1_Channel3  (&halsim_DMA1_Channel[2])
+#define DMA1_Channel4  (&halsim_DMA1_Channel[3])
+#define DMA1_Channel5  (&halsim_DMA1_Channel[4])
+#define TIM1           (&halsim_TIM1)
+#define TIM3           (&halsim_TIM3)
+#define TIM6           (&halsim_TIM6)
+#define TIM14          (&halsim_TIM14)
+#define TIM15          (&halsim_TIM15)
+#define TIM16          (&halsim_TIM16)
+#define TIM17          (&halsim_TIM17)
+#define EXTI           (&halsim_EXTI)
+#define SYSCFG         (&halsim_SYSCFG)
+#define RCC            (&halsim_RCC)
+#define FLASH          (&halsim_FLASH)
+
+/* ---- USART bits ---- */
+#define USART_CR1_UE        (1UL << 0)
+#define USART_CR1_RE        (1UL << 2)
+#define USART_CR1_TE        (1UL << 3)
+#define USART_CR1_IDLEIE    (1UL << 4)
+#define USART_CR1_RXNEIE    (1UL << 5)
+#define USART_CR1_TCIE      (1UL << 6)
+#define USART_CR1_TXEIE     (1UL << 7)
+#define USART_CR1_PEIE      (1UL << 8)
+#define USART_CR1_PCE       (1UL << 10)
+#define USART_CR1_M0        (1UL << 12)
+#define USART_CR1_OVER8     (1UL << 15)
+#define USART_CR1_M1        (1UL << 28)
+#define USART_CR2_STOP_1    (1UL << 13)
+#define USART_CR3_EIE       (1UL << 0)
+#define USART_CR3_DMAR      (1UL << 6)
+#define USART_CR3_DMAT      (1UL << 7)
+#define USART_CR3_RTSE      (1UL << 8)
+#define USART_CR3_CTSE      (1UL << 9)
+#define USART_CR3_CTSIE     (1UL << 10)
+#define USART_CR3_OVRDIS    (1UL << 12)
+#define USART_ISR_PE        (1UL << 0)
+#define USART_ISR_FE        (1UL << 1)
+#define USART_ISR_NE        (1UL << 2)
+#define USART_ISR_ORE       (1UL << 3)
+#define USART_ISR_IDLE      (1UL << 4)
+#define USART_ISR_RXNE      (1UL << 5)
+#define USART_ISR_TC        (1UL << 6)
+#define USART_ISR_TXE       (1UL << 7)
+#define USART_ISR_CTS       (1UL << 10)
+#define USART_ISR_BUSY      (1UL << 16)
+#define USART_ICR_PECF      (1UL << 0)
+#define USART_ICR_FECF      (1UL << 1)
+#define USART_ICR_NCF       (1UL << 2)
+#define USART_ICR_ORECF     (1UL << 3)
+#define USART_ICR_IDLECF    (1UL << 4)
+#define USART_ICR_TCCF      (1UL << 6)
+#define USART_ICR_CTSCF     (1UL << 9)
+#define USART_RQR_RXFRQ     (1UL << 3)
+
+/* ---- DMA bits ---- */
+#define DMA_CCR_EN          (1UL << 0)
+#define DMA_CCR_TCIE        (1UL << 1)
+#define DMA_CCR_HTIE        (1UL << 2)
+#define DMA_CCR_TEIE        (1UL << 3)
+#define DMA_CCR_DIR         (1UL << 4)
+#define DMA_CCR_CIRC        (1UL << 5)
+#define DMA_CCR_PINC        (1UL << 6)
+#define DMA_CCR_MINC        (1UL << 7)
+
+/* ---- TIM bits ---- */
+#define TIM_CR1_CEN         (1UL << 0)
+#define TIM_CR1_UDIS        (1UL << 1)
+#define TIM_CR1_URS         (1UL << 2)
+#define TIM_CR1_OPM         (1UL << 3)
+#define TIM_CR1_ARPE        (1UL << 7)
+#define TIM_DIER_UIE        (1UL << 0)
+#define TIM_DIER_CC1IE      (1UL << 1)
+#define TIM_DIER_UDE        (1UL << 8)
+#define TIM_SR_UIF          (1UL << 0)
+#define TIM_SR_CC1IF        (1UL << 1)
+#define TIM_SR_CC2IF        (1UL << 2)
+#define TIM_SR_CC3IF        (1UL << 3)
+#define TIM_SR_CC4IF        (1UL << 4)
+#define TIM_EGR_UG          (1UL << 0)
+#define TIM_CCMR1_OC1PE     (1UL << 3)
+#define TIM_CCMR1_OC2PE     (1UL << 11)
+#define TIM_CCMR2_OC3PE     (1UL << 3)
+#define TIM_CCMR2_OC4PE     (1UL << 11)
+#define TIM_CCER_CC1E       (1UL << 0)
+#define TIM_CCER_CC2E       (1UL << 4)
+#define TIM_CCER_CC3E       (1UL << 8)
+#define TIM_CCER_CC4E       (1UL << 12)
+#define TIM_BDTR_MOE        (1UL << 15)
+
+/* ---- RCC bits (only the ones the examples touch directly) ---- */
+#define RCC_AHBENR_DMAEN    (1UL << 0)
+#define RCC_AHBENR_GPIOAEN  (1UL << 17)
+#define RCC_AHBENR_GPIOBEN  (1UL << 18)
+#define RCC_AHBENR_GPIOCEN  (1UL << 19)
+#define RCC_APB2ENR_SYSCFGEN (1UL << 0)
+#define RCC_APB2ENR_TIM1EN  (1UL << 11)
+#define RCC_APB2ENR_USART1EN (1UL << 14)
+#define RCC_APB2ENR_TIM15EN (1UL << 16)
+#define RCC_APB2ENR_TIM16EN (1UL << 17)
+#define RCC_APB2ENR_TIM17EN (1UL << 18)
+#define RCC_APB1ENR_TIM3EN  (1UL << 1)
+#define RCC_APB1ENR_TIM6EN  (1UL << 4)
+#define RCC_APB1ENR_TIM14EN (1UL << 8)
+#define RCC_APB1ENR_USART2EN (1UL << 17)
+#define RCC_APB1ENR_PWREN   (1UL << 28)
+
+/* ==========================================================================
+   HAL core
+   ========================================================================== */
+#ifndef TICK_INT_PRIORITY
+#define TICK_INT_PRIORITY 3U
+#endif
+
+extern __IO uint32_t uwTick;
+
+HAL_StatusTypeDef HAL_Init(void);
+void     HAL_MspInit(void);
+HAL_StatusTypeDef HAL_DeInit(void);
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
+void     HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+void     HAL_Delay(uint32_t Delay);
+void     HAL_SuspendTick(void);
+void     HAL_ResumeTick(void);
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb);
+
+/* ==========================================================================
+   RCC / FLASH / PWR
+   ========================================================================== */
+#define RCC_OSCILLATORTYPE_NONE   0x00000000U
+#define RCC_OSCILLATORTYPE_HSE    0x00000001U
+#define RCC_OSCILLATORTYPE_HSI    0x00000002U
+#define RCC_OSCILLATORTYPE_LSE    0x00000004U
+#define RCC_OSCILLATORTYPE_LSI    0x00000008U
+#define RCC_OSCILLATORTYPE_HSI14  0x00000010U
+#define RCC_OSCILLATORTYPE_HSI48  0x00000020U
+
+#define RCC_HSI_OFF               0x00000000U
+#define RCC_HSI_ON                0x00000001U
+#define RCC_HSI48_OFF             0x00000000U
+#define RCC_HSI48_ON              0x00000001U
+#define RCC_HSICALIBRATION_DEFAULT 0x10U
+
+#define RCC_PLL_NONE              0x00000000U
+#define RCC_PLL_OFF               0x00000001U
+#define RCC_PLL_ON                0x00000002U
+#if defined(STM32F072xB) || defined(STM32F091xC)
+#define RCC_HSI48_SUPPORT                       // As stm32f0xx_hal_rcc.h for these parts
+#define RCC_PLLSOURCE_HSI         0x00008000U   // HSI / PREDIV
+#define RCC_PLLSOURCE_HSI48       0x00018000U   // HSI48 / PREDIV
+#else
+#define RCC_PLLSOURCE_HSI         0x00000000U   // HSI / 2
+#endif
+#define RCC_PLLSOURCE_HSE         0x00010000U
+#define RCC_PLL_MUL2              0x00000000U
+#define RCC_PLL_MUL3              0x00040000U
+#define RCC_PLL_MUL4              0x00080000U
+#define RCC_PLL_MUL5              0x000C0000U
+#define RCC_PLL_MUL6              0x00100000U
+#define RCC_PLL_MUL8              0x00180000U
+#define RCC_PLL_MUL10             0x00200000U
+#define RCC_PLL_MUL12             0x00280000U
+#define RCC_PLL_MUL16             0x00380000U
+#define RCC_PREDIV_DIV1           0x00000000U
+#define RCC_PREDIV_DIV2           0x00000001U
+
+#define RCC_CLOCKTYPE_SYSCLK      0x00000001U
+#define RCC_CLOCKTYPE_HCLK        0x00000002U
+#define RCC_CLOCKTYPE_PCLK1       0x00000004U
+#define RCC_SYSCLKSOURCE_HSI      0x00000000U
+#define RCC_SYSCLKSOURCE_HSE      0x00000001U
+#define RCC_SYSCLKSOURCE_PLLCLK   0x00000002U
+#define RCC_SYSCLKSOURCE_HSI48    0x00000003U
+#define RCC_SYSCLK_DIV1           0x00000000U
+#define RCC_SYSCLK_DIV2           0x00000080U
+#define RCC_SYSCLK_DIV4           0x00000090U
+#define RCC_SYSCLK_DIV8           0x000000A0U
+#define RCC_HCLK_DIV1             0x00000000U
+#define RCC_HCLK_DIV2             0x00000400U
+#define RCC_HCLK_DIV4             0x00000500U
+
+#define FLASH_LATENCY_0           0x00000000U
+#define FLASH_LATENCY_1           0x00000001U
+
+typedef struct
+{
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLMUL;
+    uint32_t PREDIV;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    uint32_t LSEState;
+    uint32_t HSIState;
+    uint32_t HSICalibrationValue;
+    uint32_t HSI14State;
+    uint32_t HSI14CalibrationValue;
+    uint32_t HSI48State;
+    uint32_t LSIState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+} RCC_ClkInitTypeDef;
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+uint32_t HAL_RCC_GetSysClockFreq(void);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+#define HALSIM_CLK_ENABLE(REG, BIT)   do { SET_BIT(RCC->REG, (BIT)); (void)READ_BIT(RCC->REG, (BIT)); } while (0)
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  HALSIM_CLK_ENABLE(AHBENR, RCC_AHBENR_GPIOAEN)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  HALSIM_CLK_ENABLE(AHBENR, RCC_AHBENR_GPIOBEN)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  HALSIM_CLK_ENABLE(AHBENR, RCC_AHBENR_GPIOCEN)
+#define __HAL_RCC_DMA1_CLK_ENABLE()   HALSIM_CLK_ENABLE(AHBENR, RCC_AHBENR_DMAEN)
+#define __HAL_RCC_SYSCFG_CLK_ENABLE() HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_SYSCFGEN)
+#define __HAL_RCC_USART1_CLK_ENABLE() HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_USART1EN)
+#define __HAL_RCC_TIM1_CLK_ENABLE()   HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_TIM1EN)
+#define __HAL_RCC_TIM15_CLK_ENABLE()  HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_TIM15EN)
+#define __HAL_RCC_TIM16_CLK_ENABLE()  HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_TIM16EN)
+#define __HAL_RCC_TIM17_CLK_ENABLE()  HALSIM_CLK_ENABLE(APB2ENR, RCC_APB2ENR_TIM17EN)
+#define __HAL_RCC_TIM3_CLK_ENABLE()   HALSIM_CLK_ENABLE(APB1ENR, RCC_APB1ENR_TIM3EN)
+#define __HAL_RCC_TIM6_CLK_ENABLE()   HALSIM_CLK_ENABLE(APB1ENR, RCC_APB1ENR_TIM6EN)
+#define __HAL_RCC_TIM14_CLK_ENABLE()  HALSIM_CLK_ENABLE(APB1ENR, RCC_APB1ENR_TIM14EN)
+#define __HAL_RCC_USART2_CLK_ENABLE() HALSIM_CLK_ENABLE(APB1ENR, RCC_APB1ENR_USART2EN)
+#define __HAL_RCC_PWR_CLK_ENABLE()    HALSIM_CLK_ENABLE(APB1ENR, RCC_APB1ENR_PWREN)
+
+#define PWR_MAINREGULATOR_ON      0x00000000U
+#define PWR_LOWPOWERREGULATOR_ON  0x00000001U
+#define PWR_SLEEPENTRY_WFI        0x01U
+#define PWR_SLEEPENTRY_WFE        0x02U
+#define PWR_STOPENTRY_WFI         0x01U
+#define PWR_STOPENTRY_WFE         0x02U
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry);
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+/* ==========================================================================
+   GPIO
+   ========================================================================== */
+typedef enum
+{
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0     ((uint16_t)0x0001U)
+#define GPIO_PIN_1     ((uint16_t)0x0002U)
+#define GPIO_PIN_2     ((uint16_t)0x0004U)
+#define GPIO_PIN_3     ((uint16_t)0x0008U)
+#define GPIO_PIN_4     ((uint16_t)0x0010U)
+#define GPIO_PIN_5     ((uint16_t)0x0020U)
+#define GPIO_PIN_6     ((uint16_t)0x0040U)
+#define GPIO_PIN_7     ((uint16_t)0x0080U)
+#define GPIO_PIN_8     ((uint16_t)0x0100U)
+#define GPIO_PIN_9     ((uint16_t)0x0200U)
+#define GPIO_PIN_10    ((uint16_t)0x0400U)
+#define GPIO_PIN_11    ((uint16_t)0x0800U)
+#define GPIO_PIN_12    ((uint16_t)0x1000U)
+#define GPIO_PIN_13    ((uint16_t)0x2000U)
+#define GPIO_PIN_14    ((uint16_t)0x4000U)
+#define GPIO_PIN_15    ((uint16_t)0x8000U)
+#define GPIO_PIN_All   ((uint16_t)0xFFFFU)
+
+#define GPIO_MODE_INPUT        0x00000000U
+#define GPIO_MODE_OUTPUT_PP    0x00000001U
+#define GPIO_MODE_OUTPUT_OD    0x00000011U
+#define GPIO_MODE_AF_PP        0x00000002U
+#define GPIO_MODE_AF_OD        0x00000012U
+#define GPIO_MODE_ANALOG       0x00000003U
+#define GPIO_MODE_IT_RISING         0x10110000U
+#define GPIO_MODE_IT_FALLING        0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+
+#define GPIO_NOPULL            0x00000000U
+#define GPIO_PULLUP            0x00000001U
+#define GPIO_PULLDOWN          0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW    0x00000000U
+#define GPIO_SPEED_FREQ_MEDIUM 0x00000001U
+#define GPIO_SPEED_FREQ_HIGH   0x00000003U
+
+#define GPIO_AF0_USART1        ((uint8_t)0x00U)
+#define GPIO_AF1_USART1        ((uint8_t)0x01U)
+#define GPIO_AF1_USART2        ((uint8_t)0x01U)
+#define GPIO_AF1_TIM3          ((uint8_t)0x01U)
+#define GPIO_AF2_TIM1          ((uint8_t)0x02U)
+#define GPIO_AF0_TIM15         ((uint8_t)0x00U)
+#define GPIO_AF1_TIM15         ((uint8_t)0x01U)
+#define GPIO_AF2_TIM16         ((uint8_t)0x02U)
+#define GPIO_AF2_TIM17         ((uint8_t)0x02U)
+#define GPIO_AF4_TIM14         ((uint8_t)0x04U)
+
+void          HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void          HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin);
+void          HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+#define __HAL_GPIO_EXTI_GET_IT(__EXTI_LINE__)   (EXTI->PR & (__EXTI_LINE__))
+#define __HAL_GPIO_EXTI_CLEAR_IT(__EXTI_LINE__) (EXTI->PR = (__EXTI_LINE__))
+
+/* ==========================================================================
+   DMA
+   ========================================================================== */
+typedef enum
+{
+    HAL_DMA_STATE_RESET   = 0x00U,
+    HAL_DMA_STATE_READY   = 0x01U,
+    HAL_DMA_STATE_BUSY    = 0x02U,
+    HAL_DMA_STATE_TIMEOUT = 0x03U
+} HAL_DMA_StateTypeDef;
+
+typedef struct
+{
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    DMA_Channel_TypeDef  *Instance;
+    DMA_InitTypeDef       Init;
+    HAL_LockTypeDef       Lock;
+    __IO HAL_DMA_StateTypeDef State;
+    void                 *Parent;
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferAbortCallback)(struct __DMA_HandleTypeDef *hdma);
+    __IO uint32_t         ErrorCode;
+    DMA_TypeDef          *DmaBaseAddress;
+    uint32_t              ChannelIndex;
+} DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY   0x00000000U
+#define DMA_MEMORY_TO_PERIPH   DMA_CCR_DIR
+#define DMA_MEMORY_TO_MEMORY   (1UL << 14)
+#define DMA_PINC_ENABLE        DMA_CCR_PINC
+#define DMA_PINC_DISABLE       0x00000000U
+#define DMA_MINC_ENABLE        DMA_CCR_MINC
+#define DMA_MINC_DISABLE       0x00000000U
+#define DMA_PDATAALIGN_BYTE     0x00000000U
+#define DMA_PDATAALIGN_HALFWORD (1UL << 8)
+#define DMA_PDATAALIGN_WORD     (2UL << 8)
+#define DMA_MDATAALIGN_BYTE     0x00000000U
+#define DMA_MDATAALIGN_HALFWORD (1UL << 10)
+#define DMA_MDATAALIGN_WORD     (2UL << 10)
+#define DMA_NORMAL             0x00000000U
+#define DMA_CIRCULAR           DMA_CCR_CIRC
+#define DMA_PRIORITY_LOW       0x00000000U
+#define DMA_PRIORITY_MEDIUM    (1UL << 12)
+#define DMA_PRIORITY_HIGH      (2UL << 12)
+#define DMA_PRIORITY_VERY_HIGH (3UL << 12)
+#define DMA_IT_TC              DMA_CCR_TCIE
+#define DMA_IT_HT              DMA_CCR_HTIE
+#define DMA_IT_TE              DMA_CCR_TEIE
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma);
+void              HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)   ((__HANDLE__)->Instance->CNDTR)
+#define __HAL_DMA_ENABLE(__HANDLE__)        ((__HANDLE__)->Instance->CCR |= DMA_CCR_EN)
+#define __HAL_DMA_DISABLE(__HANDLE__)       ((__HANDLE__)->Instance->CCR &= ~DMA_CCR_EN)
+#define __HAL_DMA_ENABLE_IT(__HANDLE__, __IT__)  ((__HANDLE__)->Instance->CCR |= (__IT__))
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __IT__) ((__HANDLE__)->Instance->CCR &= ~(__IT__))
+
+/* F09x: requests reach a channel only through DMA1_CSELR (stm32f0xx_hal_dma.h) */
+#if defined(STM32F091xC)
+#define HAL_DMA1_CH2_USART1_TX 0x10000080U
+#define HAL_DMA1_CH3_USART1_RX 0x20000800U
+#define HAL_DMA1_CH4_USART2_TX 0x30009000U
+#define HAL_DMA1_CH5_USART2_RX 0x40090000U
+#define __HAL_DMA1_REMAP(__REQUEST__)                                                    \
+    do {                                                                                 \
+        DMA1->CSELR &= ~((uint32_t)0x0FU << (((__REQUEST__) >> 28U) * 4U));              \
+        DMA1->CSELR |= (uint32_t)((__REQUEST__) & 0x0FFFFFFFU);                          \
+    } while (0)
+#endif
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__) \
+    do {                                                             \
+        (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);         \
+        (__DMA_HANDLE__).Parent = (__HANDLE__);                      \
+    } while (0)
+
+/* ==========================================================================
+   UART
+   ========================================================================== */
+typedef enum
+{
+    HAL_UART_STATE_RESET      = 0x00U,
+    HAL_UART_STATE_READY      = 0x20U,
+    HAL_UART_STATE_BUSY       = 0x24U,
+    HAL_UART_STATE_BUSY_TX    = 0x21U,
+    HAL_UART_STATE_BUSY_RX    = 0x22U,
+    HAL_UART_STATE_BUSY_TX_RX = 0x23U,
+    HAL_UART_STATE_ERROR      = 0xE0U
+} HAL_UART_StateTypeDef;
+
+typedef uint32_t HAL_UART_RxTypeTypeDef;
+#define HAL_UART_RECEPTION_STANDARD  0x00000000U
+#define HAL_UART_RECEPTION_TOIDLE    0x00000001U
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+    uint32_t OneBitSampling;
+} UART_InitTypeDef;
+
+typedef struct
+{
+    uint32_t AdvFeatureInit;
+} UART_AdvFeatureInitTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+    USART_TypeDef            *Instance;
+    UART_InitTypeDef          Init;
+    UART_AdvFeatureInitTypeDef AdvancedInit;
+    const uint8_t            *pTxBuffPtr;
+    uint16_t                  TxXferSize;
+    __IO uint16_t             TxXferCount;
+    uint8_t                  *pRxBuffPtr;
+    uint16_t                  RxXferSize;
+    __IO uint16_t             RxXferCount;
+    uint16_t                  Mask;
+    __IO HAL_UART_RxTypeTypeDef ReceptionType;
+    DMA_HandleTypeDef        *hdmatx;
+    DMA_HandleTypeDef        *hdmarx;
+    HAL_LockTypeDef           Lock;
+    __IO HAL_UART_StateTypeDef gState;
+    __IO HAL_UART_StateTypeDef RxState;
+    __IO uint32_t             ErrorCode;
+    void (*TxISR)(struct __UART_HandleTypeDef *huart);    // Interrupt transmit only, as the HAL's
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_7B     (1UL << 28)
+#define UART_WORDLENGTH_8B     0x00000000U
+#define UART_WORDLENGTH_9B     (1UL << 12)
+#define UART_STOPBITS_1        0x00000000U
+#define UART_STOPBITS_2        (2UL << 12)
+#define UART_PARITY_NONE       0x00000000U
+#define UART_PARITY_EVEN       (1UL << 10)
+#define UART_PARITY_ODD        ((1UL << 10) | (1UL << 9))
+#define UART_MODE_RX           USART_CR1_RE
+#define UART_MODE_TX           USART_CR1_TE
+#define UART_MODE_TX_RX        (USART_CR1_TE | USART_CR1_RE)
+#define UART_HWCONTROL_NONE    0x00000000U
+#define UART_HWCONTROL_RTS     USART_CR3_RTSE
+#define UART_HWCONTROL_CTS     USART_CR3_CTSE
+#define UART_HWCONTROL_RTS_CTS (USART_CR3_RTSE | USART_CR3_CTSE)
+#define UART_OVERSAMPLING_16   0x00000000U
+#define UART_OVERSAMPLING_8    USART_CR1_OVER8
+#define UART_ONE_BIT_SAMPLE_DISABLE 0x00000000U
+
+#define HAL_UART_ERROR_NONE    0x00000000U
+#define HAL_UART_ERROR_PE      0x00000001U
+#define HAL_UART_ERROR_NE      0x00000002U
+#define HAL_UART_ERROR_FE      0x00000004U
+#define HAL_UART_ERROR_ORE     0x00000008U
+#define HAL_UART_ERROR_DMA     0x00000010U
+
+#define UART_FLAG_PE           USART_ISR_PE
+#define UART_FLAG_FE           USART_ISR_FE
+#define UART_FLAG_NE           USART_ISR_NE
+#define UART_FLAG_ORE          USART_ISR_ORE
+#define UART_FLAG_IDLE         USART_ISR_IDLE
+#define UART_FLAG_RXNE         USART_ISR_RXNE
+#define UART_FLAG_TC           USART_ISR_TC
+#define UART_FLAG_TXE          USART_ISR_TXE
+#define UART_CLEAR_PEF         USART_ICR_PECF
+#define UART_CLEAR_FEF         USART_ICR_FECF
+#define UART_CLEAR_NEF         USART_ICR_NCF
+#define UART_CLEAR_OREF        USART_ICR_ORECF
+#define UART_CLEAR_IDLEF       USART_ICR_IDLECF
+#define UART_CLEAR_TCF         USART_ICR_TCCF
+
+/* Interrupt ids: (register index << 8) | bit, like the real HAL */
+#define UART_IT_PE             0x0108U
+#define UART_IT_TXE            0x0107U
+#define UART_IT_TC             0x0106U
+#define UART_IT_RXNE           0x0105U
+#define UART_IT_IDLE           0x0104U
+#define UART_IT_ERR            0x0300U
+#define UART_IT_MASK           0x001FU
+
+#define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)   (((__HANDLE__)->Instance->ISR & (__FLAG__)) == (__FLAG__))
+#define __HAL_UART_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->Instance->ICR = (__FLAG__))
+#define __HAL_UART_CLEAR_IDLEFLAG(__HANDLE__)       __HAL_UART_CLEAR_FLAG((__HANDLE__), UART_CLEAR_IDLEF)
+#define __HAL_UART_CLEAR_OREFLAG(__HANDLE__)        __HAL_UART_CLEAR_FLAG((__HANDLE__), UART_CLEAR_OREF)
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __IT__)                                   \
+    ((((__IT__) >> 8) == 1U) ? ((__HANDLE__)->Instance->CR1 |= (1UL << ((__IT__) & UART_IT_MASK))) : \
+                               ((__HANDLE__)->Instance->CR3 |= (1UL << ((__IT__) & UART_IT_MASK))))
+#define __HAL_UART_DISABLE_IT(__HANDLE__, __IT__)                                  \
+    ((((__IT__) >> 8) == 1U) ? ((__HANDLE__)->Instance->CR1 &= ~(1UL << ((__IT__) & UART_IT_MASK))) : \
+                               ((__HANDLE__)->Instance->CR3 &= ~(1UL << ((__IT__) & UART_IT_MASK))))
+#define __HAL_UART_ENABLE(__HANDLE__)   ((__HANDLE__)->Instance->CR1 |= USART_CR1_UE)
+#define __HAL_UART_DISABLE(__HANDLE__)  ((__HANDLE__)->Instance->CR1 &= ~USART_CR1_UE)
+#define UART_DIV_SAMPLING16(__PCLK__, __BAUD__) (((__PCLK__) + ((__BAUD__) / 2U)) / (__BAUD__))
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Receive(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Abort(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+void              HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+HAL_UART_StateTypeDef HAL_UART_GetState(const UART_HandleTypeDef *huart);
+uint32_t          HAL_UART_GetError(const UART_HandleTypeDef *huart);
+
+void HAL_UART_MspInit(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+/* ==========================================================================
+   TIM
+   ========================================================================== */
+typedef struct
+{
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    uint32_t OCMode;
+    uint32_t Pulse;
+    uint32_t OCPolarity;
+    uint32_t OCNPolarity;
+    uint32_t OCFastMode;
+    uint32_t OCIdleState;
+    uint32_t OCNIdleState;
+} TIM_OC_InitTypeDef;
+
+typedef enum
+{
+    HAL_TIM_STATE_RESET = 0x00U,
+    HAL_TIM_STATE_READY = 0x01U,
+    HAL_TIM_STATE_BUSY  = 0x02U
+} HAL_TIM_StateTypeDef;
+
+typedef struct __TIM_HandleTypeDef
+{
+    TIM_TypeDef          *Instance;
+    TIM_Base_InitTypeDef  Init;
+    uint32_t              Channel;
+    DMA_HandleTypeDef    *hdma[7];
+    HAL_LockTypeDef       Lock;
+    __IO HAL_TIM_StateTypeDef State;
+} TIM_HandleTypeDef;
+
+#define TIM_COUNTERMODE_UP              0x00000000U
+#define TIM_CLOCKDIVISION_DIV1          0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE  0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_ENABLE   TIM_CR1_ARPE
+#define TIM_OCMODE_TIMING               0x00000000U
+#define TIM_OCMODE_PWM1                 0x00000060U
+#define TIM_OCMODE_PWM2                 0x00000070U
+#define TIM_OCPOLARITY_HIGH             0x00000000U
+#define TIM_OCPOLARITY_LOW              0x00000002U
+#define TIM_OCNPOLARITY_HIGH            0x00000000U
+#define TIM_OCFAST_DISABLE              0x00000000U
+#define TIM_OCFAST_ENABLE               0x00000004U
+#define TIM_OCIDLESTATE_RESET           0x00000000U
+#define TIM_OCNIDLESTATE_RESET          0x00000000U
+#define TIM_CHANNEL_1                   0x00000000U
+#define TIM_CHANNEL_2                   0x00000004U
+#define TIM_CHANNEL_3                   0x00000008U
+#define TIM_CHANNEL_4                   0x0000000CU
+#define TIM_IT_UPDATE                   TIM_DIER_UIE
+#define TIM_FLAG_UPDATE                 TIM_SR_UIF
+#define TIM_DMA_UPDATE                  TIM_DIER_UDE
+#define TIM_DMA_ID_UPDATE               ((uint16_t)0x0000)
+
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__)        \
+    (*(&((__HANDLE__)->Instance->CCR1) + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+#define __HAL_TIM_GET_COMPARE(__HANDLE__, __CHANNEL__)                     \
+    (*(&((__HANDLE__)->Instance->CCR1) + ((__CHANNEL__) >> 2U)))
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__)               \
+    do { (__HANDLE__)->Instance->ARR = (__AUTORELOAD__); (__HANDLE__)->Init.Period = (__AUTORELOAD__); } while (0)
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)     ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__) ((__HANDLE__)->Instance->PSC = (__PRESC__))
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) ((__HANDLE__)->Instance->CNT = (__COUNTER__))
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)        ((__HANDLE__)->Instance->CNT)
+#define __HAL_TIM_ENABLE(__HANDLE__)             ((__HANDLE__)->Instance->CR1 |= TIM_CR1_CEN)
+#define __HAL_TIM_DISABLE(__HANDLE__)            ((__HANDLE__)->Instance->CR1 &= ~TIM_CR1_CEN)
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __IT__)  ((__HANDLE__)->Instance->DIER |= (__IT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __IT__) ((__HANDLE__)->Instance->DIER &= ~(__IT__))
+#define __HAL_TIM_ENABLE_DMA(__HANDLE__, __DMA__)  ((__HANDLE__)->Instance->DIER |= (__DMA__))
+#define __HAL_TIM_DISABLE_DMA(__HANDLE__, __DMA__) ((__HANDLE__)->Instance->DIER &= ~(__DMA__))
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__)   (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__) ((__HANDLE__)->Instance->SR = (uint32_t)~(__FLAG__))
+#define __HAL_TIM_CLEAR_IT(__HANDLE__, __IT__)     ((__HANDLE__)->Instance->SR = (uint32_t)~(__IT__))
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, const TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+void              HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void              HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+/* ==========================================================================
+   Simulator control (host only)
+   ========================================================================== */
+#include "halsim.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F0XX_HAL_H */
@@ -0,0 +1,50 @@
+/*
+ * File: stm32f0xx_ll_gpio.h
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Host stand-in for the STM32CubeF0 LL GPIO header: the output and input
+ * pin functions, with the same names and register accesses as the real
+ * static inline ones. Stores go through halsim_reg_write() so the GPIO
+ * model sees every edge.
+ */
+
+#ifndef STM32F0XX_LL_GPIO_H
+#define STM32F0XX_LL_GPIO_H
+
+#include "stm32f0xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    halsim_reg_write(&GPIOx->BSRR, PinMask);
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    halsim_reg_write(&GPIOx->BRR, PinMask);
+}
+
+static inline void LL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    uint32_t odr = READ_REG(GPIOx->ODR);
+    halsim_reg_write(&GPIOx->BSRR, ((odr & PinMask) << 16U) | (~odr & PinMask));
+}
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (READ_BIT(GPIOx->IDR, PinMask) == PinMask) ? 1UL : 0UL;
+}
+
+static inline uint32_t LL_GPIO_IsOutputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (READ_BIT(GPIOx->ODR, PinMask) == PinMask) ? 1UL : 0UL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F0XX_LL_GPIO_H */
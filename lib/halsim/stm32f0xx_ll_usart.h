@@ -0,0 +1,49 @@
+/*
+ * File: stm32f0xx_ll_usart.h
+ * Project: STM32 PlatformIO Playground - HAL Simulation
+ * Description:
+ * Host stand-in for the STM32CubeF0 LL USART header: the status flags
+ * and data register functions. RDR and TDR go through the simulator so
+ * that reading clears RXNE and writing starts the transmitter, as on
+ * the MCU.
+ */
+
+#ifndef STM32F0XX_LL_USART_H
+#define STM32F0XX_LL_USART_H
+
+#include "stm32f0xx_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint32_t LL_USART_IsActiveFlag_TXE(USART_TypeDef *USARTx)
+{
+    return (READ_BIT(USARTx->ISR, USART_ISR_TXE) == USART_ISR_TXE) ? 1UL : 0UL;
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_TC(USART_TypeDef *USARTx)
+{
+    return (READ_BIT(USARTx->ISR, USART_ISR_TC) == USART_ISR_TC) ? 1UL : 0UL;
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_RXNE(USART_TypeDef *USARTx)
+{
+    return (READ_BIT(USARTx->ISR, USART_ISR_RXNE) == USART_ISR_RXNE) ? 1UL : 0UL;
+}
+
+static inline void LL_USART_TransmitData8(USART_TypeDef *USARTx, uint8_t Value)
+{
+    halsim_reg_write(&USARTx->TDR, Value);
+}
+
+static inline uint8_t LL_USART_ReceiveData8(USART_TypeDef *USARTx)
+{
+    return (uint8_t)halsim_uart_read(USARTx);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32F0XX_LL_USART_H */
@@ -0,0 +1,238 @@
+/*
+ * File: hwio.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Zero-cost GPIO pin and blocking UART access with a backend picked at
+ * build time. Application code is written once against hw_pin_* and
+ * hw_uart_*; HW_BACKEND decides what it compiles to:
+ *
+ *   HW_BACKEND_REG (default) : direct register access. A pin write is
+ *                              one BSRR/BRR store, a byte one TDR store
+ *                              after the TXE poll.
+ *   HW_BACKEND_LL            : the STM32Cube LL static inline functions,
+ *                              which compile to the same stores.
+ *   HW_BACKEND_HAL           : HAL_GPIO_* and HAL_UART_Transmit/Receive,
+ *                              the fallback (function calls, handle
+ *                              locking and state checks per call).
+ *
+ *     build_flags = -DHW_BACKEND=HW_BACKEND_HAL
+ *
+ * Pins and UARTs are const descriptors. Everything is static inline, so
+ * with a descriptor known at compile time the port address and pin mask
+ * fold into the instructions and nothing of the descriptor remains:
+ *
+ *     static const hw_pin_t  led     = HW_PIN(GPIOA, 5);
+ *     static const hw_uart_t console = HW_UART(USART1, &huart1);
+ *
+ *     hw_pin_toggle(led);
+ *     hw_uart_write(console, msg, len);
+ *
+ * The UART must be initialised with HAL_UART_Init() (the HAL backend
+ * also needs its handle). Register and LL backends only touch TDR/RDR
+ * and the status flags: do not mix them with a HAL or DMA transfer that
+ * is still running on the same USART. Pins are configured with
+ * HAL_GPIO_Init() as before.
+ */
+
+#ifndef HWIO_H
+#define HWIO_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+
+#define HW_BACKEND_HAL 0
+#define HW_BACKEND_LL  1
+#define HW_BACKEND_REG 2
+
+#ifndef HW_BACKEND
+#define HW_BACKEND HW_BACKEND_REG
+#endif
+
+#if HW_BACKEND == HW_BACKEND_LL
+#include "stm32f0xx_ll_gpio.h"
+#include "stm32f0xx_ll_usart.h"
+#elif HW_BACKEND != HW_BACKEND_HAL && HW_BACKEND != HW_BACKEND_REG
+#error "HW_BACKEND: HW_BACKEND_HAL, HW_BACKEND_LL or HW_BACKEND_REG"
+#endif
+
+/* Register backend on the host: stores and RDR reads with their side effects */
+#ifdef HALSIM
+#define HW_REG_WRITE(reg, value)  halsim_reg_write(&(reg), (value))
+#define HW_RDR_READ(usart)        ((uint8_t)halsim_uart_read(usart))
+#else
+#define HW_REG_WRITE(reg, value)  ((reg) = (value))
+#define HW_RDR_READ(usart)        ((uint8_t)(usart)->RDR)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint16_t mask;
+} hw_pin_t;
+
+typedef struct
+{
+    USART_TypeDef *usart;
+    UART_HandleTypeDef *huart;     // HAL backend only
+} hw_uart_t;
+
+/* Initialisers: pin number 0..15 on a port, USART instance and its HAL handle */
+#define HW_PIN(port, n)           { (port), (uint16_t)(1U << (n)) }
+#define HW_UART(usart, huart)     { (usart), (huart) }
+
+static inline const char *hw_backend_name(void)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    return "hal";
+#elif HW_BACKEND == HW_BACKEND_LL
+    return "ll";
+#else
+    return "reg";
+#endif
+}
+
+/* --- GPIO --- */
+
+static inline void hw_pin_high(hw_pin_t pin)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    HAL_GPIO_WritePin(pin.port, pin.mask, GPIO_PIN_SET);
+#elif HW_BACKEND == HW_BACKEND_LL
+    LL_GPIO_SetOutputPin(pin.port, pin.mask);
+#else
+    HW_REG_WRITE(pin.port->BSRR, pin.mask);
+#endif
+}
+
+static inline void hw_pin_low(hw_pin_t pin)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    HAL_GPIO_WritePin(pin.port, pin.mask, GPIO_PIN_RESET);
+#elif HW_BACKEND == HW_BACKEND_LL
+    LL_GPIO_ResetOutputPin(pin.port, pin.mask);
+#else
+    HW_REG_WRITE(pin.port->BRR, pin.mask);
+#endif
+}
+
+static inline void hw_pin_write(hw_pin_t pin, bool high)
+{
+    if (high)
+    {
+        hw_pin_high(pin);
+    }
+    else
+    {
+        hw_pin_low(pin);
+    }
+}
+
+/* One BSRR store sets or clears the pin, so an interrupt writing other
+   pins of the port between the ODR read and the store is not undone */
+static inline void hw_pin_toggle(hw_pin_t pin)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    HAL_GPIO_TogglePin(pin.port, pin.mask);
+#elif HW_BACKEND == HW_BACKEND_LL
+    LL_GPIO_TogglePin(pin.port, pin.mask);
+#else
+    uint32_t odr = pin.port->ODR;
+    HW_REG_WRITE(pin.port->BSRR, ((odr & pin.mask) << 16) | (~odr & pin.mask));
+#endif
+}
+
+static inline bool hw_pin_read(hw_pin_t pin)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    return HAL_GPIO_ReadPin(pin.port, pin.mask) == GPIO_PIN_SET;
+#elif HW_BACKEND == HW_BACKEND_LL
+    return LL_GPIO_IsInputPinSet(pin.port, pin.mask) != 0U;
+#else
+    return (pin.port->IDR & pin.mask) != 0U;
+#endif
+}
+
+/* --- UART (blocking) --- */
+
+/* Send one byte: wait for room in TDR, not for the end of the frame */
+static inline void hw_uart_putc(hw_uart_t uart, uint8_t byte)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    HAL_UART_Transmit(uart.huart, &byte, 1, HAL_MAX_DELAY);
+#elif HW_BACKEND == HW_BACKEND_LL
+    while (!LL_USART_IsActiveFlag_TXE(uart.usart))
+    {
+    }
+    LL_USART_TransmitData8(uart.usart, byte);
+#else
+    while ((uart.usart->ISR & USART_ISR_TXE) == 0U)
+    {
+    }
+    HW_REG_WRITE(uart.usart->TDR, byte);
+#endif
+}
+
+static inline void hw_uart_write(hw_uart_t uart, const void *data, uint16_t len)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    if (len != 0U)
+    {
+        HAL_UART_Transmit(uart.huart, (uint8_t *)data, len, HAL_MAX_DELAY);
+    }
+#else
+    const uint8_t *p = (const uint8_t *)data;
+    while (len-- != 0U)
+    {
+        hw_uart_putc(uart, *p++);
+    }
+#endif
+}
+
+/* Wait until the last frame has left the pin (before sleep or a clock change) */
+static inline void hw_uart_flush(hw_uart_t uart)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    (void)uart;                    // HAL_UART_Transmit() returns after TC
+#elif HW_BACKEND == HW_BACKEND_LL
+    while (!LL_USART_IsActiveFlag_TC(uart.usart))
+    {
+    }
+#else
+    while ((uart.usart->ISR & USART_ISR_TC) == 0U)
+    {
+    }
+#endif
+}
+
+/* Take a received byte if there is one; never waits. Polling only: with
+   an interrupt or DMA reception running the HAL backend returns busy */
+static inline bool hw_uart_getc(hw_uart_t uart, uint8_t *byte)
+{
+#if HW_BACKEND == HW_BACKEND_HAL
+    return HAL_UART_Receive(uart.huart, byte, 1, 0) == HAL_OK;
+#elif HW_BACKEND == HW_BACKEND_LL
+    if (!LL_USART_IsActiveFlag_RXNE(uart.usart))
+    {
+        return false;
+    }
+    *byte = LL_USART_ReceiveData8(uart.usart);
+    return true;
+#else
+    if ((uart.usart->ISR & USART_ISR_RXNE) == 0U)
+    {
+        return false;
+    }
+    *byte = HW_RDR_READ(uart.usart);
+    return true;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HWIO_H */
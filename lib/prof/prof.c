@@ -0,0 +1,138 @@
+/*
+ * File: prof.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Region profiler on a free-running timer, see prof.h.
+ *
+ * Concurrency: regions end in the main loop and in interrupts alike, so
+ * prof_end() updates the statistics and the trace with interrupts
+ * masked. A nested region is part of the region it interrupted.
+ */
+
+#include "prof.h"
+
+#if PROF_ENABLE
+
+#include <string.h>
+
+_Static_assert((PROF_TRACE_LEN & (PROF_TRACE_LEN - 1)) == 0 && PROF_TRACE_LEN <= 128,
+               "PROF_TRACE_LEN must be a power of two <= 128");
+_Static_assert(PROF_REGIONS <= 255, "PROF_REGIONS must fit in a uint8_t");
+
+#define TRACE_MASK      ((uint8_t)(PROF_TRACE_LEN - 1U))
+#define TICK_CYCLES     ((uint32_t)PROF_TIM_PSC + 1U)
+#define CALIBRATE_RUNS  16U
+
+static prof_stat_t stats[PROF_REGIONS];
+static prof_event_t trace[PROF_TRACE_LEN];
+static uint32_t traceHead;         // Next slot (free-running)
+static uint16_t overheadTicks;
+
+void prof_init(void)
+{
+#ifndef HALSIM
+    PROF_TIM_CLK_ENABLE();
+    PROF_TIM->CR1 = 0U;
+    PROF_TIM->PSC = PROF_TIM_PSC;
+    PROF_TIM->ARR = 0xFFFFU;
+    PROF_TIM->EGR = TIM_EGR_UG;    // Load PSC
+    PROF_TIM->CR1 = TIM_CR1_CEN;
+#endif
+
+    /* The shortest of a few back-to-back reads is the fixed cost */
+    overheadTicks = 0xFFFFU;
+    for (uint32_t i = 0; i < CALIBRATE_RUNS; i++)
+    {
+        uint16_t t0 = prof_now();
+        uint16_t ticks = (uint16_t)(prof_now() - t0);
+        if (ticks < overheadTicks)
+        {
+            overheadTicks = ticks;
+        }
+    }
+    prof_reset();
+}
+
+void prof_reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(stats, 0, sizeof(stats));
+    memset(trace, 0, sizeof(trace));
+    traceHead = 0;
+    __set_PRIMASK(primask);
+}
+
+void prof_end(uint8_t region, uint16_t start)
+{
+    uint16_t ticks = (uint16_t)(prof_now() - start);
+    uint32_t primask;
+
+    if (region >= PROF_REGIONS)
+    {
+        return;
+    }
+    ticks = (ticks > overheadTicks) ? (uint16_t)(ticks - overheadTicks) : 0U;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    prof_stat_t *s = &stats[region];
+    uint32_t cycles = ticks * TICK_CYCLES;
+    if (s->count == 0U || cycles < s->min)
+    {
+        s->min = cycles;
+    }
+    if (cycles > s->max)
+    {
+        s->max = cycles;
+    }
+    s->count++;
+    s->sum += cycles;
+
+    prof_event_t *e = &trace[traceHead & TRACE_MASK];
+    e->start  = start;
+    e->ticks  = ticks;
+    e->region = region;
+    traceHead++;
+    __set_PRIMASK(primask);
+}
+
+bool prof_get(uint8_t region, prof_stat_t *stat)
+{
+    uint32_t primask;
+
+    if (region >= PROF_REGIONS)
+    {
+        return false;
+    }
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *stat = stats[region];
+    __set_PRIMASK(primask);
+    return stat->count != 0U;
+}
+
+uint8_t prof_trace(prof_event_t *events, uint8_t max)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t n = (traceHead < PROF_TRACE_LEN) ? (uint8_t)traceHead : (uint8_t)PROF_TRACE_LEN;
+    if (n > max)
+    {
+        n = max;
+    }
+    for (uint8_t i = 0; i < n; i++)
+    {
+        events[i] = trace[(traceHead - n + i) & TRACE_MASK];
+    }
+    __set_PRIMASK(primask);
+    return n;
+}
+
+uint32_t prof_overhead(void)
+{
+    return overheadTicks * TICK_CYCLES;
+}
+
+#endif /* PROF_ENABLE */
@@ -0,0 +1,131 @@
+/*
+ * File: prof.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Region profiler for the Cortex-M0, which has no DWT cycle counter.
+ * A free-running timer (TIM14, prescaler 0 = one tick per timer clock
+ * cycle) timestamps the start and end of instrumented regions. Each
+ * region keeps count/min/avg/max, and the last PROF_TRACE_LEN regions
+ * are kept in a trace buffer with their start time.
+ *
+ *     enum { PROF_UART_IRQ, PROF_COMMAND, PROF_COUNT };
+ *
+ *     void USART1_IRQHandler(void)
+ *     {
+ *         PROF_BEGIN(PROF_UART_IRQ);
+ *         HAL_UART_IRQHandler(&huart1);
+ *         PROF_END(PROF_UART_IRQ);
+ *     }
+ *
+ * Build with -DPROF_ENABLE=1 to compile it in. Otherwise PROF_BEGIN,
+ * PROF_END and PROF_INIT expand to nothing and prof.c is empty.
+ *
+ * The counter is 16 bits wide: a region must end within 65536 ticks
+ * (8.2 ms at 8 MHz, 1.4 ms at 48 MHz), or set PROF_TIM_PSC to count
+ * in steps of PSC + 1 cycles. The cost of reading the timer twice is
+ * measured by prof_init() and subtracted. Cycles are timer clock cycles,
+ * which equal core cycles while the APB prescaler is 1.
+ *
+ * On the host simulation (lib/halsim) the timestamps are the CPU time
+ * of the simulated CPU thread in HCLK cycles (halsim_cycles()): stable
+ * enough to compare builds on the same machine, not target cycles.
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+#ifdef HALSIM
+#include "halsim.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+/* Regions the statistics table holds (ids 0..PROF_REGIONS-1) */
+#ifndef PROF_REGIONS
+#define PROF_REGIONS 8
+#endif
+
+/* Trace buffer depth (power of two) */
+#ifndef PROF_TRACE_LEN
+#define PROF_TRACE_LEN 32
+#endif
+
+/* Another timer (e.g. TIM16): define both PROF_TIM and PROF_TIM_CLK_ENABLE() */
+#ifndef PROF_TIM
+#define PROF_TIM TIM14
+#define PROF_TIM_CLK_ENABLE() __HAL_RCC_TIM14_CLK_ENABLE()
+#endif
+
+#ifndef PROF_TIM_PSC
+#define PROF_TIM_PSC 0
+#endif
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t sum;              // Cycles, overhead subtracted
+    uint32_t min;
+    uint32_t max;
+} prof_stat_t;
+
+typedef struct
+{
+    uint16_t start;            // Timer ticks when the region began
+    uint16_t ticks;            // Duration in ticks, overhead subtracted
+    uint8_t region;
+} prof_event_t;
+
+#if PROF_ENABLE
+
+static inline uint16_t prof_now(void)
+{
+#ifdef HALSIM
+    return (uint16_t)(halsim_cycles() / (PROF_TIM_PSC + 1U));
+#else
+    return (uint16_t)PROF_TIM->CNT;
+#endif
+}
+
+/* Start the timer and measure the cost of an empty region */
+void prof_init(void);
+
+/* Clear statistics and trace */
+void prof_reset(void);
+
+/* Record region `region` that began at `start` (interrupt safe) */
+void prof_end(uint8_t region, uint16_t start);
+
+/* Snapshot of one region; false if it never ran */
+bool prof_get(uint8_t region, prof_stat_t *stat);
+
+/* Copy up to max trace events, oldest first; returns the number copied */
+uint8_t prof_trace(prof_event_t *events, uint8_t max);
+
+/* Cycles subtracted from every region */
+uint32_t prof_overhead(void);
+
+#define PROF_INIT()           prof_init()
+#define PROF_BEGIN(region)    uint16_t prof_t0_##region = prof_now()
+#define PROF_END(region)      prof_end((uint8_t)(region), prof_t0_##region)
+
+#else
+
+#define PROF_INIT()           ((void)0)
+#define PROF_BEGIN(region)    ((void)0)
+#define PROF_END(region)      ((void)0)
+
+#endif /* PROF_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROF_H */
@@ -0,0 +1,184 @@
+/*
+ * File: pwm.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Multi-channel PWM engine, see pwm.h.
+ */
+
+#include "pwm.h"
+
+static const uint32_t pwmChannel[PWM_CHANNELS] = {
+    TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4
+};
+
+/* Enable the timer's clock; returns its channel count, 0 if not supported */
+static uint8_t pwm_clock_enable(const TIM_TypeDef *instance)
+{
+    if (instance == TIM3)
+    {
+        __HAL_RCC_TIM3_CLK_ENABLE();
+        return 4U;
+    }
+    if (instance == TIM1)
+    {
+        __HAL_RCC_TIM1_CLK_ENABLE();
+        return 4U;
+    }
+#if defined(TIM15)
+    if (instance == TIM15)
+    {
+        __HAL_RCC_TIM15_CLK_ENABLE();
+        return 2U;
+    }
+#endif
+#if defined(TIM16)
+    if (instance == TIM16)
+    {
+        __HAL_RCC_TIM16_CLK_ENABLE();
+        return 1U;
+    }
+#endif
+#if defined(TIM17)
+    if (instance == TIM17)
+    {
+        __HAL_RCC_TIM17_CLK_ENABLE();
+        return 1U;
+    }
+#endif
+    return 0U;
+}
+
+uint32_t pwm_timer_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (pclk != HAL_RCC_GetHCLKFreq()) ? 2U * pclk : pclk;
+}
+
+bool pwm_calc(uint32_t clock, uint32_t freq, uint32_t steps, pwm_timing_t *timing)
+{
+    if (!PWM_PLAN_VALID(clock, freq, steps))
+    {
+        return false;
+    }
+
+    uint32_t div = PWM_PLAN_DIV(clock, freq, steps);
+    uint32_t period = PWM_PERIOD_(clock, freq, div);
+
+    timing->prescaler = div - 1U;
+    timing->period    = period;
+    timing->freq      = (clock + (div * period) / 2U) / (div * period);
+    return true;
+}
+
+HAL_StatusTypeDef pwm_init(pwm_t *p, TIM_TypeDef *instance, uint8_t channels,
+                           uint32_t freq, uint32_t steps)
+{
+    TIM_OC_InitTypeDef sConfigOC = {0};
+    uint8_t count = pwm_clock_enable(instance);
+
+    if (count == 0U || channels == 0U || (channels >> count) != 0U ||
+        !pwm_calc(pwm_timer_clock(), freq, steps, &p->timing))
+    {
+        return HAL_ERROR;
+    }
+
+    p->channels = channels;
+    p->htim.Instance = instance;
+    p->htim.Init.Prescaler = p->timing.prescaler;
+    p->htim.Init.CounterMode = TIM_COUNTERMODE_UP;
+    p->htim.Init.Period = p->timing.period - 1U;
+    p->htim.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    p->htim.Init.RepetitionCounter = 0U;
+    p->htim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;  // ARR commits with the CCRs
+    if (HAL_TIM_PWM_Init(&p->htim) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+
+    // PWM mode 1, compare preload on (the HAL sets OCxPE)
+    sConfigOC.OCMode = TIM_OCMODE_PWM1;
+    sConfigOC.Pulse = 0U;
+    sConfigOC.OCPolarity = TIM_OCPOLARITY_HIGH;
+    sConfigOC.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    sConfigOC.OCFastMode = TIM_OCFAST_DISABLE;
+    sConfigOC.OCIdleState = TIM_OCIDLESTATE_RESET;
+    sConfigOC.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    for (uint8_t i = 0; i < PWM_CHANNELS; i++)
+    {
+        if ((channels & (1U << i)) != 0U &&
+            HAL_TIM_PWM_ConfigChannel(&p->htim, &sConfigOC, pwmChannel[i]) != HAL_OK)
+        {
+            return HAL_ERROR;
+        }
+    }
+    for (uint8_t i = 0; i < PWM_CHANNELS; i++)
+    {
+        if ((channels & (1U << i)) != 0U && HAL_TIM_PWM_Start(&p->htim, pwmChannel[i]) != HAL_OK)
+        {
+            return HAL_ERROR;
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef pwm_retime(TIM_HandleTypeDef *htim, uint32_t freq, uint32_t steps,
+                             pwm_timing_t *timing)
+{
+    TIM_TypeDef *tim = htim->Instance;
+    uint32_t oldPeriod = tim->ARR + 1U;
+    pwm_timing_t t;
+
+    if (!pwm_calc(pwm_timer_clock(), freq, steps, &t))
+    {
+        return HAL_ERROR;
+    }
+
+    tim->CR1 |= TIM_CR1_UDIS;
+    for (uint8_t i = 0; i < PWM_CHANNELS; i++)
+    {
+        // duty * period fits: both are <= 65535 (a 100 % compare may be ARR + 1)
+        uint32_t duty = (&tim->CCR1)[i];
+        (&tim->CCR1)[i] = (duty * t.period + oldPeriod / 2U) / oldPeriod;
+    }
+    tim->PSC = t.prescaler;                    // Always preloaded
+    tim->ARR = t.period - 1U;                  // Preloaded if ARPE
+    htim->Init.Prescaler = t.prescaler;
+    htim->Init.Period = t.period - 1U;
+    tim->CR1 &= ~TIM_CR1_UDIS;
+
+    if (timing != NULL)
+    {
+        *timing = t;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef pwm_set_freq(pwm_t *p, uint32_t freq, uint32_t steps)
+{
+    return pwm_retime(&p->htim, freq, steps, &p->timing);
+}
+
+void pwm_set_duties(pwm_t *p, uint8_t mask, const uint16_t *duty)
+{
+    mask &= p->channels;
+    pwm_hold(p);
+    for (uint8_t i = 0; i < PWM_CHANNELS; i++)
+    {
+        if ((mask & (1U << i)) != 0U)
+        {
+            pwm_stage(p, (uint8_t)(i + 1U), duty[i]);
+        }
+    }
+    pwm_release(p);
+}
+
+void pwm_sync(pwm_t *const *engines, uint8_t count)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        engines[i]->htim.Instance->EGR = TIM_EGR_UG;
+    }
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,194 @@
+/*
+ * File: pwm.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Multi-channel PWM engine: one pwm_t per timer (TIM3 with four
+ * channels, TIM1 with four, TIM15 with two, TIM16/TIM17 with one, where
+ * the part has them), set up from a frequency and a minimum resolution.
+ *
+ * Batched updates: every compare register and ARR are preloaded, so a
+ * write only reaches the output at the next update event. Writing
+ * several channels one by one can still straddle an update and tear
+ * (half of the channels change a period before the others). A batch
+ * sets CR1.UDIS first, which holds the preload -> active transfer, writes
+ * all values, then clears UDIS: the whole batch takes effect on the same
+ * update, in phase.
+ *
+ *     static pwm_t leds;
+ *     pwm_init(&leds, TIM3, PWM_CH(1) | PWM_CH(2) | PWM_CH(3) | PWM_CH(4), 1000, 1000);
+ *     uint16_t duty[4] = { 0, 250, 500, 1000 };      // counts of pwm_period()
+ *     pwm_set_duties(&leds, PWM_CH_ALL, duty);
+ *
+ * Several timers: pwm_hold() each, pwm_stage() the values, pwm_release()
+ * each; every timer commits at its own next update. pwm_sync() restarts
+ * the counters back to back so timers at the same frequency update
+ * within a few cycles of each other.
+ *
+ * The application configures the output pins (alternate function) and
+ * owns the pwm_t; the engine enables the timer clock.
+ *
+ * Timer planner: PWM_PLAN_PSC()/PWM_PLAN_ARR() compute the same PSC/ARR
+ * as pwm_calc() as integer constant expressions, for a hand-written
+ * MX_TIMx_Init(), and PWM_PLAN_ASSERT() fails the build when the clock
+ * cannot give the frequency (within PWM_MAX_ERROR_PPM) with at least the
+ * requested steps:
+ *
+ *     #define TIM_CLOCK_HZ  PWM_TIMER_CLOCK(SYSCLK_HZ, 1, 1)   // AHB /1, APB /1
+ *     PWM_PLAN_ASSERT(TIM_CLOCK_HZ, 1000, 1000);
+ *     htim3.Init.Prescaler = PWM_PLAN_PSC(TIM_CLOCK_HZ, 1000, 1000);
+ *     htim3.Init.Period    = PWM_PLAN_ARR(TIM_CLOCK_HZ, 1000, 1000);
+ *
+ * After a clock change, pwm_retime() redoes the plan at run time for any
+ * PWM timer handle from the clock the RCC reports.
+ */
+
+#ifndef PWM_H
+#define PWM_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWM_CHANNELS    4U
+#define PWM_CH(n)       (1U << ((n) - 1U))     // Channel mask bit, n = 1..4
+#define PWM_CH_ALL      0xFU
+
+/* Largest period: ARR 65534, so that a compare of `period` (100 %) still fits */
+#define PWM_PERIOD_MAX  65535U
+
+/* Largest accepted deviation of the produced frequency, parts per million */
+#ifndef PWM_MAX_ERROR_PPM
+#define PWM_MAX_ERROR_PPM  10000U
+#endif
+
+/* ---- Timer planner (integer constant expressions) ---- */
+
+/* Counter clock of the F0 timers: PCLK, x2 when the APB prescaler divides */
+#define PWM_TIMER_CLOCK(sysclk, ahbDiv, apbDiv) \
+    ((apbDiv) == 1U ? (uint32_t)(sysclk) / (ahbDiv) : 2U * ((uint32_t)(sysclk) / (ahbDiv) / (apbDiv)))
+
+#define PWM_NZ_(x)              ((x) != 0U ? (x) : 1U)
+#define PWM_COUNTS_(clk, f)     ((uint32_t)(clk) / PWM_NZ_((uint32_t)(f)))
+#define PWM_DIV_HI_(clk, f, s)  (PWM_COUNTS_(clk, f) / PWM_NZ_((uint32_t)(s)) < 65536U ? \
+                                 PWM_COUNTS_(clk, f) / PWM_NZ_((uint32_t)(s)) : 65536U)
+#define PWM_DIV_LO_(clk, f)     ((PWM_COUNTS_(clk, f) + PWM_PERIOD_MAX - 1U) / PWM_PERIOD_MAX)
+
+/* Prescaler divider: the largest that keeps `s` steps, at least what fits ARR */
+#define PWM_PLAN_DIV(clk, f, s) (PWM_DIV_HI_(clk, f, s) > PWM_DIV_LO_(clk, f) ? \
+                                 PWM_DIV_HI_(clk, f, s) : PWM_DIV_LO_(clk, f))
+
+/* Counts per period for a divider: clk / (f * div), rounded, at most PWM_PERIOD_MAX */
+#define PWM_PERIOD_(clk, f, div) \
+    (((uint32_t)(clk) + PWM_NZ_((uint32_t)(f) * (div)) / 2U) / PWM_NZ_((uint32_t)(f) * (div)) < PWM_PERIOD_MAX ? \
+     ((uint32_t)(clk) + PWM_NZ_((uint32_t)(f) * (div)) / 2U) / PWM_NZ_((uint32_t)(f) * (div)) : PWM_PERIOD_MAX)
+
+/* |clk - f * div * period| within PWM_MAX_ERROR_PPM of clk */
+#define PWM_ERROR_OK_(clk, f, div, period)                                          \
+    (((unsigned long long)(f) * (div) * (period) > (clk)                            \
+      ? (unsigned long long)(f) * (div) * (period) - (clk)                          \
+      : (clk) - (unsigned long long)(f) * (div) * (period)) * 1000000ULL            \
+     <= (unsigned long long)(clk) * PWM_MAX_ERROR_PPM)
+
+#define PWM_PLAN_PERIOD(clk, f, s)  PWM_PERIOD_(clk, f, PWM_PLAN_DIV(clk, f, s))
+#define PWM_PLAN_PSC(clk, f, s)     (PWM_PLAN_DIV(clk, f, s) - 1U)
+#define PWM_PLAN_ARR(clk, f, s)     (PWM_PLAN_PERIOD(clk, f, s) - 1U)
+
+/* Frequency actually produced by the plan, Hz */
+#define PWM_PLAN_FREQ(clk, f, s) \
+    (((uint32_t)(clk) + PWM_PLAN_DIV(clk, f, s) * PWM_PLAN_PERIOD(clk, f, s) / 2U) / \
+     PWM_NZ_(PWM_PLAN_DIV(clk, f, s) * PWM_PLAN_PERIOD(clk, f, s)))
+
+#define PWM_PLAN_VALID(clk, f, s)                                                   \
+    ((uint32_t)(f) != 0U && (uint32_t)(s) >= 2U && (uint32_t)(s) <= PWM_PERIOD_MAX && \
+     PWM_PLAN_DIV(clk, f, s) >= 1U && PWM_PLAN_DIV(clk, f, s) <= 65536U &&          \
+     PWM_PLAN_PERIOD(clk, f, s) >= (uint32_t)(s) &&                                 \
+     PWM_ERROR_OK_(clk, f, PWM_PLAN_DIV(clk, f, s), PWM_PLAN_PERIOD(clk, f, s)))
+
+/* Fail the build if `f` Hz with at least `s` steps is out of reach of `clk` */
+#define PWM_PLAN_ASSERT(clk, f, s) \
+    _Static_assert(PWM_PLAN_VALID(clk, f, s), \
+                   "PWM plan: " #f " Hz with " #s " steps is not reachable from a " #clk " timer clock")
+
+typedef struct
+{
+    uint32_t prescaler;            // PSC register value
+    uint32_t period;               // Counts per PWM period (ARR + 1) = duty resolution
+    uint32_t freq;                 // Frequency actually produced, Hz
+} pwm_timing_t;
+
+typedef struct
+{
+    TIM_HandleTypeDef htim;
+    pwm_timing_t timing;
+    uint8_t channels;              // PWM_CH() mask of the started channels
+} pwm_t;
+
+/* Counter clock of the timers: PCLK, x2 when the APB prescaler divides */
+uint32_t pwm_timer_clock(void);
+
+/*
+ * PSC/ARR for `freq` Hz with at least `steps` duty steps from a `clock`
+ * Hz counter clock: the run-time form of the PWM_PLAN_* macros. Picks
+ * the largest prescaler that keeps `steps`, so the period is as close to
+ * `steps` as the clock allows (exactly `steps` when clock / (freq * steps)
+ * is whole). False if no setting reaches both within PWM_MAX_ERROR_PPM.
+ */
+bool pwm_calc(uint32_t clock, uint32_t freq, uint32_t steps, pwm_timing_t *timing);
+
+/* Re-plan a running PWM timer for the current clock, at its next update;
+   the compare values are rescaled so duty ratios stay */
+HAL_StatusTypeDef pwm_retime(TIM_HandleTypeDef *htim, uint32_t freq, uint32_t steps,
+                             pwm_timing_t *timing);
+
+/* Set up `instance` for `freq`/`steps` and start the `channels`, all at duty 0 */
+HAL_StatusTypeDef pwm_init(pwm_t *p, TIM_TypeDef *instance, uint8_t channels,
+                           uint32_t freq, uint32_t steps);
+
+/* Retime at the next update; duty ratios are kept (compare values rescaled) */
+HAL_StatusTypeDef pwm_set_freq(pwm_t *p, uint32_t freq, uint32_t steps);
+
+/* Write the compare value of every channel in `mask` (duty[0] = CH1),
+   committed together on one update event */
+void pwm_set_duties(pwm_t *p, uint8_t mask, const uint16_t *duty);
+
+/* Restart the counters of several timers together, loading their preloads */
+void pwm_sync(pwm_t *const *engines, uint8_t count);
+
+static inline uint32_t pwm_period(const pwm_t *p)
+{
+    return p->timing.period;
+}
+
+static inline uint32_t pwm_get_duty(const pwm_t *p, uint8_t ch)
+{
+    return (&p->htim.Instance->CCR1)[ch - 1U];
+}
+
+/* ---- Building blocks of a batch (several timers) ---- */
+
+/* Hold the preload -> active transfer at update events */
+static inline void pwm_hold(pwm_t *p)
+{
+    p->htim.Instance->CR1 |= TIM_CR1_UDIS;
+}
+
+/* Preload one compare value, ch = 1..4 */
+static inline void pwm_stage(pwm_t *p, uint8_t ch, uint16_t duty)
+{
+    (&p->htim.Instance->CCR1)[ch - 1U] = duty;
+}
+
+/* Let the next update event commit everything staged */
+static inline void pwm_release(pwm_t *p)
+{
+    p->htim.Instance->CR1 &= ~TIM_CR1_UDIS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWM_H */
@@ -0,0 +1,188 @@
+/*
+ * File: pwm_player.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * DMA PWM waveform player, see pwm_player.h.
+ *
+ * Concurrency: the half/full DMA interrupts generate samples and apply
+ * pending waveforms; the application only writes `next` and `pending`,
+ * with interrupts masked so a refill never sees half a request.
+ */
+
+#include "pwm_player.h"
+
+/* CCR1..CCR4 are consecutive; TIM_CHANNEL_x is 4 * (x - 1) */
+static volatile uint32_t *pwm_player_ccr(const pwm_player_t *p)
+{
+    return &p->htim->Instance->CCR1 + (p->channel >> 2);
+}
+
+static void pwm_player_apply(pwm_player_t *p, const pwm_player_wave_t *wave)
+{
+    p->wave.table = wave->table;
+    p->wave.phase = 0U;
+    p->wave.step  = wave->step;
+    p->loopsLeft  = wave->loops;
+}
+
+/* Level the output rests at once the waveform has ended */
+static uint16_t pwm_player_rest(const pwm_player_t *p)
+{
+    return (uint16_t)wave_scale(p->wave.table[0], p->full);
+}
+
+/* Fill one half buffer with the rest level */
+static void pwm_player_fill_rest(const pwm_player_t *p, uint16_t *dst)
+{
+    for (uint16_t i = 0; i < PWM_PLAYER_HALF; i++)
+    {
+        dst[i] = pwm_player_rest(p);
+    }
+}
+
+/* Generate one half buffer; a queued waveform starts right after the last loop */
+static void pwm_player_fill(pwm_player_t *p, uint16_t *dst)
+{
+    uint16_t i = 0;
+
+    while (i < PWM_PLAYER_HALF)
+    {
+        uint32_t before = p->wave.phase;
+        dst[i++] = (uint16_t)wave_scale(wave_next(&p->wave), p->full);
+
+        if (p->wave.phase >= before || p->loopsLeft == 0U || --p->loopsLeft != 0U)
+        {
+            continue;                      // Not the end of the last loop
+        }
+        if (p->pending == PWM_PLAYER_QUEUE)
+        {
+            pwm_player_apply(p, &p->next);
+            p->pending = 0U;
+            continue;
+        }
+        while (i < PWM_PLAYER_HALF)
+        {
+            dst[i++] = pwm_player_rest(p);
+        }
+        p->ending = 2U;                    // This half, then the one after it
+    }
+    p->refills++;
+}
+
+/* The half at `dst` has been played: refill it or wind down */
+static void pwm_player_refill(pwm_player_t *p, uint16_t *dst)
+{
+    if (p->pending == PWM_PLAYER_SET || (p->pending != 0U && p->ending != 0U))
+    {
+        pwm_player_apply(p, &p->next);
+        p->pending = 0U;
+        p->ending  = 0U;
+    }
+    if (p->ending != 0U)
+    {
+        if (--p->ending == 0U)
+        {
+            pwm_player_stop(p);
+            return;
+        }
+        pwm_player_fill_rest(p, dst);
+        return;
+    }
+    pwm_player_fill(p, dst);
+}
+
+static void pwm_player_half_cplt(DMA_HandleTypeDef *hdma)
+{
+    pwm_player_t *p = (pwm_player_t *)hdma->Parent;
+    pwm_player_refill(p, &p->buf[0]);
+}
+
+static void pwm_player_cplt(DMA_HandleTypeDef *hdma)
+{
+    pwm_player_t *p = (pwm_player_t *)hdma->Parent;
+    pwm_player_refill(p, &p->buf[PWM_PLAYER_HALF]);
+}
+
+HAL_StatusTypeDef pwm_player_start(pwm_player_t *p, TIM_HandleTypeDef *htim, uint32_t channel,
+                                   DMA_HandleTypeDef *hdma, const pwm_player_wave_t *wave)
+{
+    p->htim    = htim;
+    p->hdma    = hdma;
+    p->channel = channel;
+    p->full    = (uint16_t)(__HAL_TIM_GET_AUTORELOAD(htim) + 1U);
+    p->pending = 0U;
+    p->ending  = 0U;
+    pwm_player_apply(p, wave);
+    pwm_player_fill(p, &p->buf[0]);
+
+    /* A waveform that already ended in the first half must not play on
+       (loopsLeft is 0 then, which fill would take as endless) */
+    if (p->ending != 0U)
+    {
+        pwm_player_fill_rest(p, &p->buf[PWM_PLAYER_HALF]);
+    }
+    else
+    {
+        pwm_player_fill(p, &p->buf[PWM_PLAYER_HALF]);
+    }
+
+    hdma->Parent               = p;
+    hdma->XferHalfCpltCallback = pwm_player_half_cplt;
+    hdma->XferCpltCallback     = pwm_player_cplt;
+    hdma->XferErrorCallback    = NULL;
+
+    /* The first update event loads buf[0]; until then output it directly */
+    *pwm_player_ccr(p) = p->buf[0];
+    if (HAL_DMA_Start_IT(hdma, (uint32_t)(uintptr_t)p->buf, (uint32_t)(uintptr_t)pwm_player_ccr(p),
+                         2U * PWM_PLAYER_HALF) != HAL_OK)
+    {
+        return HAL_ERROR;
+    }
+    __HAL_TIM_ENABLE_DMA(htim, TIM_DMA_UPDATE);
+    p->running = true;
+
+    /* A restart after the player stopped finds the output already on */
+    if ((htim->Instance->CCER & (TIM_CCER_CC1E << channel)) != 0U)
+    {
+        return HAL_OK;
+    }
+    return HAL_TIM_PWM_Start(htim, channel);
+}
+
+static void pwm_player_request(pwm_player_t *p, const pwm_player_wave_t *wave, uint8_t when)
+{
+    if (p->htim == NULL)
+    {
+        return;                            // Never started: no timer or DMA to restart
+    }
+    if (!p->running)
+    {
+        pwm_player_start(p, p->htim, p->channel, p->hdma, wave);
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    p->next    = *wave;
+    p->pending = when;
+    __set_PRIMASK(primask);
+}
+
+void pwm_player_set(pwm_player_t *p, const pwm_player_wave_t *wave)
+{
+    pwm_player_request(p, wave, PWM_PLAYER_SET);
+}
+
+void pwm_player_queue(pwm_player_t *p, const pwm_player_wave_t *wave)
+{
+    pwm_player_request(p, wave, PWM_PLAYER_QUEUE);
+}
+
+void pwm_player_stop(pwm_player_t *p)
+{
+    __HAL_TIM_DISABLE_DMA(p->htim, TIM_DMA_UPDATE);
+    HAL_DMA_Abort(p->hdma);
+    p->running = false;
+    p->ending  = 0U;
+    p->pending = 0U;
+}
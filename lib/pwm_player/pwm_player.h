@@ -0,0 +1,109 @@
+/*
+ * File: pwm_player.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * PWM waveform player: a DMA channel on the timer's update request
+ * copies one duty sample per PWM period from a RAM buffer into the
+ * channel's CCR, so the CPU only wakes to refill half of the buffer.
+ *
+ * The buffer holds 2 x PWM_PLAYER_HALF samples and the DMA runs over it
+ * in circular mode. At the half-transfer interrupt the first half has
+ * been played and is refilled while the DMA reads the second; at the
+ * transfer-complete interrupt the second half is refilled. Samples come
+ * from a Q15 table (lib/wave) stepped by a phase accumulator, scaled to
+ * the timer period.
+ *
+ * A new waveform, rate or loop count takes effect at a half-buffer
+ * boundary, never inside a half the DMA is reading:
+ *   pwm_player_set()   at the next refill
+ *   pwm_player_queue() when the current waveform has played its loops
+ * When the last loop ends with nothing queued, the player outputs the
+ * waveform's level at phase 0 and stops the DMA.
+ *
+ * Application wiring (TIM3_UP is DMA1 Channel3 on the F0):
+ *
+ *   - hdma: DMA_MEMORY_TO_PERIPH, DMA_CIRCULAR, MemInc on, PeriphInc off,
+ *     half-word on both sides; its IRQ enabled in the NVIC and the
+ *     handler calling HAL_DMA_IRQHandler(&hdma)
+ *   - htim: PWM channel configured with preload (the HAL default), not
+ *     started; pwm_player_start() starts it
+ *
+ * The player owns hdma's callbacks and Parent field.
+ */
+
+#ifndef PWM_PLAYER_H
+#define PWM_PLAYER_H
+
+#include "stm32f0xx_hal.h"
+#include <stdbool.h>
+#include "wave.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Samples per half buffer: one CPU wake-up per this many PWM periods */
+#ifndef PWM_PLAYER_HALF
+#define PWM_PLAYER_HALF 32
+#endif
+
+typedef struct
+{
+    const uint16_t *table;         // Q15 samples, WAVE_TABLE_LEN entries
+    uint32_t step;                 // Phase step per PWM period, WAVE_STEP(periods per cycle)
+    uint32_t loops;                // Cycles to play, 0 = until replaced
+} pwm_player_wave_t;
+
+typedef struct
+{
+    TIM_HandleTypeDef *htim;
+    DMA_HandleTypeDef *hdma;
+    uint32_t channel;
+    uint16_t full;                 // Compare value for Q15 full scale (ARR + 1)
+    uint16_t buf[2 * PWM_PLAYER_HALF];
+    wave_t wave;                   // Waveform being generated
+    uint32_t loopsLeft;            // 0 = endless
+    pwm_player_wave_t next;
+    volatile uint8_t pending;      // PWM_PLAYER_SET / PWM_PLAYER_QUEUE, 0 = none
+    volatile uint8_t ending;       // Halves left to play after the last loop
+    volatile bool running;
+    volatile uint32_t refills;     // Half buffers generated
+} pwm_player_t;
+
+#define PWM_PLAYER_SET    1U
+#define PWM_PLAYER_QUEUE  2U
+
+/* Fill the buffer with `wave`, start the DMA, the update request and the PWM output */
+HAL_StatusTypeDef pwm_player_start(pwm_player_t *p, TIM_HandleTypeDef *htim, uint32_t channel,
+                                   DMA_HandleTypeDef *hdma, const pwm_player_wave_t *wave);
+
+/*
+ * Replace the waveform at the next half-buffer boundary (restarts at
+ * phase 0). A player that has stopped is restarted on the timer and DMA
+ * of its last pwm_player_start(); one that was never started (zeroed)
+ * ignores the call.
+ */
+void pwm_player_set(pwm_player_t *p, const pwm_player_wave_t *wave);
+
+/* Play `wave` once the current one has finished its loops (restarts a
+   stopped player like pwm_player_set()) */
+void pwm_player_queue(pwm_player_t *p, const pwm_player_wave_t *wave);
+
+/* Stop the DMA and the update request; the output keeps the last sample */
+void pwm_player_stop(pwm_player_t *p);
+
+static inline bool pwm_player_pending(const pwm_player_t *p)
+{
+    return p->pending != 0U;
+}
+
+static inline bool pwm_player_running(const pwm_player_t *p)
+{
+    return p->running;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PWM_PLAYER_H */
@@ -0,0 +1,119 @@
+/*
+ * File: ringbuf.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Bulk operations of the SPSC ring buffer. The single-byte fast paths
+ * are inline in ringbuf.h so the UART ISR does not pay for a call.
+ */
+
+#include "ringbuf.h"
+#include <string.h>
+
+bool ringbuf_init(ringbuf_t *rb, uint8_t *storage, uint16_t size)
+{
+    if (size < 2u || size > 32768u || (size & (size - 1u)) != 0u)
+    {
+        return false;
+    }
+    rb->buf       = storage;
+    rb->mask      = (uint16_t)(size - 1u);
+    rb->head      = 0;
+    rb->tail      = 0;
+    rb->overflows = 0;
+    return true;
+}
+
+void ringbuf_reset(ringbuf_t *rb)
+{
+    rb->head      = 0;
+    rb->tail      = 0;
+    rb->overflows = 0;
+}
+
+uint16_t ringbuf_write_span(ringbuf_t *rb, uint8_t **span)
+{
+    uint16_t head   = rb->head;
+    uint16_t avail  = (uint16_t)(ringbuf_size(rb) - (uint16_t)(head - rb->tail));
+    uint16_t offset = (uint16_t)(head & rb->mask);
+    uint16_t toEnd  = (uint16_t)(ringbuf_size(rb) - offset);
+
+    *span = &rb->buf[offset];
+    return (avail < toEnd) ? avail : toEnd;
+}
+
+void ringbuf_commit(ringbuf_t *rb, uint16_t len)
+{
+    RINGBUF_BARRIER();
+    rb->head = (uint16_t)(rb->head + len);
+}
+
+uint16_t ringbuf_write(ringbuf_t *rb, const uint8_t *data, uint16_t len)
+{
+    uint16_t written = 0;
+
+    /* At most two contiguous spans: up to the end, then from the start */
+    while (written < len)
+    {
+        uint8_t *span;
+        uint16_t n = ringbuf_write_span(rb, &span);
+        if (n == 0u)
+        {
+            break;
+        }
+        if (n > (uint16_t)(len - written))
+        {
+            n = (uint16_t)(len - written);
+        }
+        memcpy(span, &data[written], n);
+        ringbuf_commit(rb, n);
+        written = (uint16_t)(written + n);
+    }
+
+    if (written < len)
+    {
+        rb->overflows += (uint32_t)(len - written);
+    }
+    return written;
+}
+
+uint16_t ringbuf_peek_span(ringbuf_t *rb, const uint8_t **span)
+{
+    uint16_t head   = rb->head;
+    uint16_t tail   = ringbuf_tail(rb, head);
+    uint16_t used   = (uint16_t)(head - tail);
+    uint16_t offset = (uint16_t)(tail & rb->mask);
+    uint16_t toEnd  = (uint16_t)(ringbuf_size(rb) - offset);
+
+    RINGBUF_BARRIER();
+    *span = &rb->buf[offset];
+    return (used < toEnd) ? used : toEnd;
+}
+
+void ringbuf_skip(ringbuf_t *rb, uint16_t len)
+{
+    RINGBUF_BARRIER();
+    rb->tail = (uint16_t)(rb->tail + len);
+}
+
+uint16_t ringbuf_read(ringbuf_t *rb, uint8_t *dst, uint16_t len)
+{
+    uint16_t copied = 0;
+
+    while (copied < len)
+    {
+        const uint8_t *span;
+        uint16_t n = ringbuf_peek_span(rb, &span);
+        if (n == 0u)
+        {
+            break;
+        }
+        if (n > (uint16_t)(len - copied))
+        {
+            n = (uint16_t)(len - copied);
+        }
+        memcpy(&dst[copied], span, n);
+        ringbuf_skip(rb, n);
+        copied = (uint16_t)(copied + n);
+    }
+    return copied;
+}
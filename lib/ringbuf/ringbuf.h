@@ -0,0 +1,172 @@
+/*
+ * File: ringbuf.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Lock-free single-producer / single-consumer byte ring buffer.
+ *
+ * - Size must be a power of two, so wrapping is a mask instead of the
+ *   software divide that `% SIZE` costs on the Cortex-M0.
+ * - `head` is written only by the producer (usually an ISR or DMA),
+ *   `tail` only by the consumer (usually the main loop). Both indices
+ *   run freely and are masked on access, so a full buffer holds all
+ *   `size` bytes and "full" never looks like "empty".
+ * - A full buffer drops the new bytes and counts them in `overflows`
+ *   instead of silently overwriting unread data.
+ * - A producer that writes the storage itself (a circular DMA) cannot
+ *   stop at a full buffer: it publishes what it wrote, and the consumer
+ *   side resyncs to the oldest byte still in the storage. The reader then
+ *   never sees more than `size` bytes and never reads one twice; the
+ *   producer counts the overwritten bytes.
+ * - Data is published with a memory barrier between the payload and the
+ *   index store, so the other side never sees an index ahead of the data.
+ *
+ * The code has no HAL dependency and builds for the `native` platform too.
+ */
+
+#ifndef RINGBUF_H
+#define RINGBUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Barrier between payload and index updates (DMB on Cortex-M). */
+#if defined(__arm__)
+#define RINGBUF_BARRIER()  __asm volatile ("dmb" ::: "memory")
+#else
+#define RINGBUF_BARRIER()  __atomic_thread_fence(__ATOMIC_ACQ_REL)
+#endif
+
+typedef struct
+{
+    uint8_t *buf;
+    uint16_t mask;                 // size - 1
+    volatile uint16_t head;        // Producer index (free-running)
+    volatile uint16_t tail;        // Consumer index (free-running)
+    volatile uint32_t overflows;   // Bytes dropped because the buffer was full
+} ringbuf_t;
+
+/*
+ * Define a statically allocated ring buffer. The size is checked at
+ * compile time:
+ *
+ *     RINGBUF_DEFINE(rxRing, 128);
+ */
+#define RINGBUF_DEFINE(name, size)                                          \
+    _Static_assert((size) >= 2 && (size) <= 32768 &&                        \
+                   ((size) & ((size) - 1)) == 0,                            \
+                   #name ": ring buffer size must be a power of two");      \
+    static uint8_t name##_storage[(size)];                                  \
+    static ringbuf_t name = { name##_storage, (uint16_t)((size) - 1), 0, 0, 0 }
+
+/* Initialise a ring buffer at runtime. Returns false if size is not a power of two. */
+bool ringbuf_init(ringbuf_t *rb, uint8_t *storage, uint16_t size);
+
+/* Discard all content and clear the overflow counter (not ISR-safe). */
+void ringbuf_reset(ringbuf_t *rb);
+
+static inline uint16_t ringbuf_size(const ringbuf_t *rb)
+{
+    return (uint16_t)(rb->mask + 1u);
+}
+
+static inline uint16_t ringbuf_used(const ringbuf_t *rb)
+{
+    uint16_t used = (uint16_t)(rb->head - rb->tail);
+    return (used > ringbuf_size(rb)) ? ringbuf_size(rb) : used;
+}
+
+static inline uint16_t ringbuf_free(const ringbuf_t *rb)
+{
+    return (uint16_t)(ringbuf_size(rb) - ringbuf_used(rb));
+}
+
+static inline bool ringbuf_is_empty(const ringbuf_t *rb)
+{
+    return rb->head == rb->tail;
+}
+
+static inline uint32_t ringbuf_overflows(const ringbuf_t *rb)
+{
+    return rb->overflows;
+}
+
+/* ---- Producer side ------------------------------------------------------ */
+
+/* Push one byte. On a full buffer the byte is dropped and counted. */
+static inline bool ringbuf_put(ringbuf_t *rb, uint8_t byte)
+{
+    uint16_t head = rb->head;
+    if ((uint16_t)(head - rb->tail) > rb->mask)
+    {
+        rb->overflows++;
+        return false;
+    }
+    rb->buf[head & rb->mask] = byte;
+    RINGBUF_BARRIER();
+    rb->head = (uint16_t)(head + 1u);
+    return true;
+}
+
+/* Push up to len bytes, returns how many fit. The rest is counted as overflow. */
+uint16_t ringbuf_write(ringbuf_t *rb, const uint8_t *data, uint16_t len);
+
+/*
+ * Zero-copy producer access: returns the largest contiguous free span
+ * and its address. Fill it, then publish with ringbuf_commit().
+ */
+uint16_t ringbuf_write_span(ringbuf_t *rb, uint8_t **span);
+void ringbuf_commit(ringbuf_t *rb, uint16_t len);
+
+/* ---- Consumer side ------------------------------------------------------ */
+
+/*
+ * The consumer's index. If the producer lapped it (head more than size
+ * ahead), the oldest bytes were overwritten: skip them. Only the consumer
+ * writes tail, so this keeps the single-producer/single-consumer rule.
+ */
+static inline uint16_t ringbuf_tail(ringbuf_t *rb, uint16_t head)
+{
+    uint16_t tail = rb->tail;
+    if ((uint16_t)(head - tail) > ringbuf_size(rb))
+    {
+        tail = (uint16_t)(head - ringbuf_size(rb));
+        rb->tail = tail;
+    }
+    return tail;
+}
+
+/* Pop one byte. Returns false if the buffer is empty. */
+static inline bool ringbuf_get(ringbuf_t *rb, uint8_t *byte)
+{
+    uint16_t head = rb->head;
+    uint16_t tail = ringbuf_tail(rb, head);
+    if (head == tail)
+    {
+        return false;
+    }
+    RINGBUF_BARRIER();
+    *byte = rb->buf[tail & rb->mask];
+    RINGBUF_BARRIER();
+    rb->tail = (uint16_t)(tail + 1u);
+    return true;
+}
+
+/* Pop up to len bytes into dst, returns how many were copied. */
+uint16_t ringbuf_read(ringbuf_t *rb, uint8_t *dst, uint16_t len);
+
+/*
+ * Zero-copy consumer access: returns the largest contiguous readable span
+ * and its address. Release it with ringbuf_skip() once it is consumed.
+ */
+uint16_t ringbuf_peek_span(ringbuf_t *rb, const uint8_t **span);
+void ringbuf_skip(ringbuf_t *rb, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RINGBUF_H */
@@ -0,0 +1,302 @@
+/*
+ * File: task.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Tickless cooperative scheduler, see task.h.
+ *
+ * Time base: the counter runs at 1 kHz from 0 to ARR; `base` is the time
+ * of its last overflow, so now = base + CNT. ARR has no preload: a new
+ * value applies at once and must stay above CNT, which holds because it
+ * is only written with interrupts masked, within a tick of reading CNT.
+ * An overflow that is still pending when the main loop reads the time
+ * is folded into `base` there (task_catch_up()), not in the handler.
+ *
+ * Deadlines: one wheel tick per millisecond. The wheel lags behind the
+ * timer while the core sleeps; task_run() advances it to task_now(),
+ * which runs the expired tasks from the wheel callback, and sleeps until
+ * wheel_next().
+ */
+
+#include "task.h"
+#ifdef HALSIM
+#include "halsim.h"
+#endif
+
+#define TASK_TICK_HZ   1000U
+#define TASK_ARR_MAX   0xFFFFU
+
+static task_t *head;
+static uint32_t base;              // ms at the last overflow
+static wheel_t wheel;              // Deadlines, one tick per ms
+static uint32_t target;            // Time task_run() advances the wheel to
+static volatile bool anyPosted;
+static task_stats_t stats;
+
+/* Counter clock of the timers: PCLK, x2 when the APB prescaler divides */
+static uint32_t task_timer_clock(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return (pclk != HAL_RCC_GetHCLKFreq()) ? 2U * pclk : pclk;
+}
+
+/* Fold a pending overflow into `base`; interrupts masked or in the handler */
+static void task_catch_up(void)
+{
+    if ((TASK_TIM->SR & TIM_SR_UIF) != 0U)
+    {
+        TASK_TIM->SR = ~(uint32_t)TIM_SR_UIF;
+        base += TASK_TIM->ARR + 1U;
+        stats.timerIrqs++;
+    }
+}
+
+/* Counter value that belongs to `base`; interrupts masked */
+static uint32_t task_count(void)
+{
+    uint32_t cnt;
+
+#ifdef HALSIM
+    halsim_sync();                 // CNT is only published between events
+#endif
+    do
+    {
+        task_catch_up();
+        cnt = TASK_TIM->CNT;
+    } while ((TASK_TIM->SR & TIM_SR_UIF) != 0U);
+    return cnt;
+}
+
+/*
+ * Move the overflow to `deadline`, at most TASK_ARR_MAX + 1 ms away (a
+ * longer wait takes several overflows). False if the deadline has passed
+ * or the counter overtook the new ARR: don't sleep then. Interrupts masked.
+ */
+static bool task_arm(bool timed, uint32_t deadline)
+{
+    uint32_t cnt = task_count();
+    uint32_t arr = TASK_ARR_MAX;
+
+    if (timed)
+    {
+        if ((int32_t)(deadline - (base + cnt)) <= 0)
+        {
+            return false;
+        }
+        if (deadline - base - 1U < TASK_ARR_MAX)
+        {
+            arr = deadline - base - 1U;
+        }
+    }
+    TASK_TIM->ARR = arr;
+#ifdef HALSIM
+    halsim_sync();
+#endif
+    if (TASK_TIM->CNT > arr)
+    {
+        TASK_TIM->ARR = TASK_ARR_MAX;    // Missed: keep the time base whole
+        return false;
+    }
+    return true;
+}
+
+static void task_link(task_t *t)
+{
+    task_t **pp = &head;
+
+    if (t->queued)
+    {
+        return;
+    }
+    while (*pp != NULL)
+    {
+        pp = &(*pp)->next;
+    }
+    t->next = NULL;
+    *pp = t;
+    t->queued = true;
+}
+
+void task_init(void)
+{
+    TASK_TIM_CLK_ENABLE();
+    TASK_TIM->CR1 = TIM_CR1_URS;              // Only overflows raise UIF
+    TASK_TIM->PSC = task_timer_clock() / TASK_TICK_HZ - 1U;
+    TASK_TIM->ARR = TASK_ARR_MAX;
+    TASK_TIM->EGR = TIM_EGR_UG;               // Load PSC, CNT = 0
+    TASK_TIM->SR = 0U;
+    TASK_TIM->DIER = TIM_DIER_UIE;
+    base = 0U;
+    head = NULL;
+    wheel_init(&wheel);
+    anyPosted = false;
+    stats = (task_stats_t){ 0 };
+
+    HAL_NVIC_SetPriority(TASK_TIM_IRQn, TASK_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(TASK_TIM_IRQn);
+    TASK_TIM->CR1 |= TIM_CR1_CEN;
+}
+
+uint32_t task_now(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = base + task_count();
+    __set_PRIMASK(primask);
+    return now;
+}
+
+/* Wheel callback: `t` is due; a one-shot leaves the list first, so it may requeue itself */
+static void task_expired(void *ctx)
+{
+    task_t *t = ctx;
+
+    if (t->period == 0U)
+    {
+        task_cancel(t);
+    }
+    else if ((int32_t)(target - (wheel_now(&wheel) + t->period)) >= 0)
+    {
+        /* Missed a whole period: resync instead of running it back to back */
+        wheel_start(&wheel, &t->timer, target - wheel_now(&wheel) + t->period, t->period,
+                    task_expired, t);
+        stats.late++;
+    }
+    t->posted = false;
+    stats.runs++;
+    t->fn(t->ctx);
+}
+
+/* (Re)arm the deadline `delayMs` from now; the wheel may lag behind the timer */
+static void task_schedule(task_t *t, uint32_t delayMs, uint32_t periodMs)
+{
+    uint32_t lag = task_now() - wheel_now(&wheel);
+
+    wheel_start(&wheel, &t->timer, lag + delayMs, periodMs, task_expired, t);
+}
+
+void task_every(task_t *t, uint32_t periodMs, task_fn_t fn, void *ctx)
+{
+    t->fn = fn;
+    t->ctx = ctx;
+    t->period = periodMs;
+    t->timed = true;
+    task_schedule(t, periodMs, periodMs);
+    task_link(t);
+}
+
+void task_after(task_t *t, uint32_t delayMs, task_fn_t fn, void *ctx)
+{
+    t->fn = fn;
+    t->ctx = ctx;
+    t->period = 0U;
+    t->timed = true;
+    if (delayMs != 0U)
+    {
+        task_schedule(t, delayMs, 0U);
+    }
+    else
+    {
+        wheel_stop(&wheel, &t->timer);
+        task_post(t);                      // At the next pass
+    }
+    task_link(t);
+}
+
+void task_add(task_t *t, task_fn_t fn, void *ctx)
+{
+    t->fn = fn;
+    t->ctx = ctx;
+    t->period = 0U;
+    t->timed = false;
+    wheel_stop(&wheel, &t->timer);
+    task_link(t);
+}
+
+void task_cancel(task_t *t)
+{
+    wheel_stop(&wheel, &t->timer);
+    for (task_t **pp = &head; *pp != NULL; pp = &(*pp)->next)
+    {
+        if (*pp == t)
+        {
+            *pp = t->next;         // t->next stays valid for a pass walking over t
+            t->queued = false;
+            t->posted = false;
+            return;
+        }
+    }
+}
+
+void task_post(task_t *t)
+{
+    t->posted = true;
+    anyPosted = true;
+}
+
+/* Run a posted task; a one-shot is done (a periodic one keeps its cadence) */
+static void task_dispatch(task_t *t)
+{
+    t->posted = false;
+    if (t->timed && t->period == 0U)
+    {
+        task_cancel(t);
+    }
+    stats.runs++;
+    t->fn(t->ctx);
+}
+
+void task_run(void)
+{
+    uint32_t next;
+
+    /* Due tasks run from the wheel, in deadline order */
+    target = task_now();
+    wheel_advance(&wheel, target - wheel_now(&wheel));
+
+    if (anyPosted)
+    {
+        anyPosted = false;
+        for (task_t *t = head; t != NULL; t = t->next)
+        {
+            if (t->queued && t->posted)
+            {
+                task_dispatch(t);
+            }
+        }
+    }
+
+    /* Earliest deadline; a task made due meanwhile makes task_arm() refuse */
+    next = wheel_next(&wheel);
+
+    __disable_irq();
+    if (!anyPosted && task_arm(next != WHEEL_NEVER, wheel_now(&wheel) + next))
+    {
+        __WFI();                   // Wakes on a pending IRQ even with PRIMASK set
+        stats.wakeups++;
+    }
+    __enable_irq();
+}
+
+void task_timer_irq(void)
+{
+    task_catch_up();
+}
+
+void task_retime(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    base += task_count();
+    TASK_TIM->PSC = task_timer_clock() / TASK_TICK_HZ - 1U;
+    TASK_TIM->ARR = TASK_ARR_MAX;             // task_run() re-arms the deadline
+    TASK_TIM->EGR = TIM_EGR_UG;               // Load PSC, CNT = 0; URS: no UIF
+    __set_PRIMASK(primask);
+}
+
+void task_stats(task_stats_t *out)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = stats;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,124 @@
+/*
+ * File: task.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Tickless cooperative scheduler: periodic and one-shot tasks that run to
+ * completion in the main loop, and a core that sleeps in between.
+ *
+ * Instead of a 1 ms SysTick and HAL_Delay() busy-waits, a basic timer
+ * (TIM6, 1 kHz counter) is reprogrammed for the next deadline: its
+ * auto-reload is set so that the overflow lands on the earliest due task,
+ * and the core sleeps in WFI until that overflow or any other interrupt.
+ * The counter is never stopped or reset, so the time base does not drift
+ * however often it is reprogrammed. Deadlines are kept on a timing wheel
+ * (lib/wheel) in milliseconds, so arming, re-arming and firing a task
+ * costs the same with two tasks or two hundred: a timeout pushed back on
+ * every message is cheap.
+ *
+ *     static task_t blink, status;
+ *
+ *     task_init();
+ *     HAL_SuspendTick();
+ *     task_every(&blink, 500, blinkTask, NULL);
+ *     task_after(&status, 3000, statusTask, NULL);
+ *     while (1) {
+ *         task_run();           // Runs what is due, then sleeps until the next deadline
+ *     }
+ *
+ *     void TIM6_IRQHandler(void) { task_timer_irq(); }
+ *
+ * Interrupt handlers hand work to the main loop with task_post() on a
+ * task queued with task_add(); any interrupt also ends the sleep. Tasks
+ * are application-owned and must not block; everything but task_post()
+ * is called from the main loop only.
+ *
+ * The F0 has no low-power timer that runs in Stop mode (only the RTC),
+ * so the core uses Sleep mode: the peripherals keep their clocks and any
+ * interrupt still wakes it.
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "stm32f0xx_hal.h"
+#include "wheel.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Another basic or general purpose timer: define all three */
+#ifndef TASK_TIM
+#define TASK_TIM TIM6
+#define TASK_TIM_IRQn TIM6_IRQn
+#define TASK_TIM_CLK_ENABLE() __HAL_RCC_TIM6_CLK_ENABLE()
+#endif
+
+#ifndef TASK_IRQ_PRIORITY
+#define TASK_IRQ_PRIORITY 3U
+#endif
+
+typedef void (*task_fn_t)(void *ctx);
+
+typedef struct task
+{
+    struct task *next;             // Queued tasks, in insertion order
+    wheel_timer_t timer;           // Deadline, in ms
+    task_fn_t fn;
+    void *ctx;
+    uint32_t period;               // ms, 0 = one-shot
+    bool timed;                    // Has a deadline (not task_add())
+    bool queued;                   // In the list
+    volatile bool posted;          // task_post(): run at the next pass
+} task_t;
+
+typedef struct
+{
+    uint32_t wakeups;              // Sleeps ended (timer or any other interrupt)
+    uint32_t timerIrqs;            // Deadline overflows
+    uint32_t runs;                 // Task runs
+    uint32_t late;                 // Periodic runs that missed a whole period
+} task_stats_t;
+
+/* Start the timer (after the clock is set up) */
+void task_init(void);
+
+/* Milliseconds since task_init() */
+uint32_t task_now(void);
+
+/* Run `fn` every `periodMs`, first after one period; reschedules if queued (O(1)) */
+void task_every(task_t *t, uint32_t periodMs, task_fn_t fn, void *ctx);
+
+/* Run `fn` once after `delayMs` (0 = at the next pass) */
+void task_after(task_t *t, uint32_t delayMs, task_fn_t fn, void *ctx);
+
+/* Queue `fn` without a deadline: it only runs when posted */
+void task_add(task_t *t, task_fn_t fn, void *ctx);
+
+/* Remove a task; a no-op if it is not queued */
+void task_cancel(task_t *t);
+
+/* Interrupt safe: run a queued task at the next pass, ahead of its time
+   (a periodic task keeps its cadence, a one-shot is done) */
+void task_post(task_t *t);
+
+/* Run every due or posted task once, then sleep until the next deadline
+   or interrupt; returns after one sleep, or at once if work is left */
+void task_run(void);
+
+/* Call from the timer's IRQ handler */
+void task_timer_irq(void);
+
+/* Reload the prescaler for the timer clock the RCC now reports; call
+   right after a clock change (a clk_on_change() hook). task_now() keeps
+   counting from where it was, less the part of a millisecond in flight */
+void task_retime(void);
+
+void task_stats(task_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TASK_H */
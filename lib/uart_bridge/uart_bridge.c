@@ -0,0 +1,193 @@
+/*
+ * File: uart_bridge.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Zero-copy UART bridge, see uart_bridge.h.
+ *
+ * The ring's head is the RX DMA write position and its tail the start
+ * of the span the TX DMA sends, so the ring is the only buffer. Both
+ * indices only move in the bridge's interrupts, which mask the others
+ * for the few register accesses they make: the USART and DMA vectors
+ * may then run at any priority.
+ */
+
+#include "uart_bridge.h"
+#include "hwio.h"
+
+#define UART_BRIDGE_LINE_ERRORS (USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)
+
+/* DMA1->ISR/IFCR hold 4 flag bits per channel; TCIF/HTIF sit at the bit
+   positions of TCIE/HTIE in CCR */
+static uint8_t uart_bridge_flags(const DMA_Channel_TypeDef *ch)
+{
+    uintptr_t stride = (uintptr_t)DMA1_Channel2 - (uintptr_t)DMA1_Channel1;
+
+    return (uint8_t)(4U * (((uintptr_t)ch - (uintptr_t)DMA1_Channel1) / stride));
+}
+
+/* Publish what the RX DMA wrote since the last call as the ring's head */
+static void uart_bridge_sync(uart_bridge_t *b)
+{
+    ringbuf_t *ring = b->ring;
+    uint16_t size   = ringbuf_size(ring);
+    uint16_t pos    = (uint16_t)((size - (uint16_t)b->rxDma->CNDTR) & ring->mask);
+    uint16_t delta  = (uint16_t)((pos - b->rxPos) & ring->mask);
+    uint16_t used   = ringbuf_used(ring);
+    uint16_t room   = (used < size) ? (uint16_t)(size - used) : 0U;
+
+    if (delta == 0U)
+    {
+        return;
+    }
+
+    /* The DMA has already written the bytes; anything beyond the free room overwrote unsent data */
+    if (delta > room)
+    {
+        b->drops += (uint32_t)(delta - room);
+    }
+    ringbuf_commit(ring, delta);
+    b->rxPos = pos;
+
+    used = ringbuf_used(ring);
+    if (used > b->peak)
+    {
+        b->peak = (used < size) ? used : size;
+    }
+}
+
+/* Hand the oldest contiguous span to the TX DMA if it is idle */
+static void uart_bridge_pump(uart_bridge_t *b)
+{
+    ringbuf_t *ring = b->ring;
+    DMA_Channel_TypeDef *tx = b->txDma;
+    const uint8_t *span;
+    uint16_t len;
+
+    if (b->txLen != 0U)
+    {
+        return;
+    }
+
+    /* Overwritten bytes are gone: the span starts at the newest full ring */
+    len = ringbuf_peek_span(ring, &span);
+    if (len == 0U)
+    {
+        return;
+    }
+    b->txLen = len;
+    b->spans++;
+
+    /* CNDTR and CMAR are only writable with the channel disabled */
+    tx->CCR &= ~DMA_CCR_EN;
+    tx->CMAR  = (uint32_t)(uintptr_t)span;
+    tx->CNDTR = len;
+    HW_REG_WRITE(tx->CCR, tx->CCR | DMA_CCR_EN);
+}
+
+HAL_StatusTypeDef uart_bridge_start(uart_bridge_t *b, UART_HandleTypeDef *from,
+                                    UART_HandleTypeDef *to, ringbuf_t *ring)
+{
+    DMA_Channel_TypeDef *rx;
+    DMA_Channel_TypeDef *tx;
+
+    if (from->hdmarx == NULL || to->hdmatx == NULL ||
+        from->hdmarx->Init.Mode != DMA_CIRCULAR)
+    {
+        return HAL_ERROR;
+    }
+    rx = from->hdmarx->Instance;
+    tx = to->hdmatx->Instance;
+
+    b->from    = from->Instance;
+    b->to      = to->Instance;
+    b->rxDma   = rx;
+    b->txDma   = tx;
+    b->ring    = ring;
+    b->rxFlags = uart_bridge_flags(rx);
+    b->txFlags = uart_bridge_flags(tx);
+    b->rxPos   = 0;
+    b->txLen   = 0;
+    b->peak    = 0;
+    b->bytes   = 0;
+    b->spans   = 0;
+    b->drops   = 0;
+    b->errors  = 0;
+    ringbuf_reset(ring);
+
+    /* RX: the whole ring storage, round and round; HT and TC publish */
+    rx->CCR &= ~DMA_CCR_EN;
+    rx->CPAR  = (uint32_t)(uintptr_t)&b->from->RDR;
+    rx->CMAR  = (uint32_t)(uintptr_t)ring->buf;
+    rx->CNDTR = ringbuf_size(ring);
+    rx->CCR   = (rx->CCR & ~DMA_CCR_TEIE) | DMA_CCR_HTIE | DMA_CCR_TCIE;
+
+    /* TX: one span per transfer, started by uart_bridge_pump() */
+    tx->CCR  = (tx->CCR & ~(DMA_CCR_EN | DMA_CCR_HTIE | DMA_CCR_TEIE)) | DMA_CCR_TCIE;
+    tx->CPAR = (uint32_t)(uintptr_t)&b->to->TDR;
+
+    DMA1->IFCR = (0xFUL << b->rxFlags) | (0xFUL << b->txFlags);
+    b->from->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF |
+                   USART_ICR_NCF | USART_ICR_PECF;
+
+    /* With DMAR set, EIE raises the USART interrupt for ORE, FE and NE */
+    SET_BIT(b->to->CR3, USART_CR3_DMAT);
+    SET_BIT(b->from->CR3, USART_CR3_DMAR | USART_CR3_EIE);
+    SET_BIT(b->from->CR1, USART_CR1_IDLEIE);
+    HW_REG_WRITE(rx->CCR, rx->CCR | DMA_CCR_EN);
+    return HAL_OK;
+}
+
+void uart_bridge_usart_irq(uart_bridge_t *b)
+{
+    USART_TypeDef *usart = b->from;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t isr;
+
+    __disable_irq();
+    isr = usart->ISR;
+
+    /* An overrun loses at least the byte in the shift register */
+    if ((isr & USART_ISR_ORE) != 0U)
+    {
+        b->drops++;
+    }
+    if ((isr & UART_BRIDGE_LINE_ERRORS) != 0U)
+    {
+        b->errors++;
+    }
+    HW_REG_WRITE(usart->ICR, USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF |
+                             USART_ICR_NCF | USART_ICR_PECF);
+
+    /* The line went idle: forward the tail of the burst */
+    uart_bridge_sync(b);
+    uart_bridge_pump(b);
+    __set_PRIMASK(primask);
+}
+
+void uart_bridge_dma_irq(uart_bridge_t *b)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t isr;
+
+    __disable_irq();
+    isr = DMA1->ISR;
+
+    if (((isr >> b->rxFlags) & (DMA_CCR_HTIE | DMA_CCR_TCIE)) != 0U)
+    {
+        HW_REG_WRITE(DMA1->IFCR, (DMA_CCR_HTIE | DMA_CCR_TCIE) << b->rxFlags);
+        uart_bridge_sync(b);
+    }
+
+    /* The last byte is in the USART now: release the span and start the next */
+    if (((isr >> b->txFlags) & DMA_CCR_TCIE) != 0U)
+    {
+        HW_REG_WRITE(DMA1->IFCR, DMA_CCR_TCIE << b->txFlags);
+        b->bytes += b->txLen;
+        ringbuf_skip(b->ring, b->txLen);
+        b->txLen = 0U;
+        uart_bridge_sync(b);
+    }
+
+    uart_bridge_pump(b);
+    __set_PRIMASK(primask);
+}
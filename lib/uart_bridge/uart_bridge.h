@@ -0,0 +1,88 @@
+/*
+ * File: uart_bridge.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * One direction of a UART-to-UART bridge, forwarded by DMA without a
+ * copy. The RX DMA of the `from` USART runs in circular mode straight
+ * into a ring's storage; the contiguous span of received bytes is then
+ * handed as it lies to the TX DMA of the `to` USART, and released from
+ * the ring when that transfer completes. Two bridges, one per
+ * direction, make a full-duplex link:
+ *
+ *     RINGBUF_DEFINE(toPeerRing, 1024);
+ *     RINGBUF_DEFINE(toHostRing, 1024);
+ *     static uart_bridge_t toPeer, toHost;
+ *
+ *     uart_bridge_start(&toPeer, &huart2, &huart1, &toPeerRing);  // VCP -> peer
+ *     uart_bridge_start(&toHost, &huart1, &huart2, &toHostRing);  // peer -> VCP
+ *
+ *     void USART2_IRQHandler(void)      { uart_bridge_usart_irq(&toPeer); }
+ *     void USART1_IRQHandler(void)      { uart_bridge_usart_irq(&toHost); }
+ *     void DMA1_Channel2_3_IRQHandler(void)                    // Same in 4_5
+ *     {   uart_bridge_dma_irq(&toPeer); uart_bridge_dma_irq(&toHost); }
+ *
+ * Both DMA handles must be initialised (HAL_DMA_Init()) and linked to
+ * their UART handles, the RX one with DMA_CIRCULAR; the USARTs must be
+ * initialised (HAL_UART_Init()). From the start on, the bridge owns the
+ * channels and the receive side of `from` / the transmit side of `to`
+ * at register level: the HAL IRQ handlers and callbacks are not used.
+ *
+ * The RX write position comes from the channel's CNDTR, read at the
+ * half/full-transfer interrupts, at the idle-line interrupt and whenever
+ * a TX transfer completes. The next span is started from the TX DMA's
+ * transfer-complete interrupt, while the USART is still sending the last
+ * byte, so back-to-back spans leave no idle time on the line. The cost
+ * is a few interrupts per span, not per byte.
+ *
+ * Nothing can stop the sender here (that is what flow control is for):
+ * when `to` is slower than `from` the ring fills up and the RX DMA
+ * overwrites bytes that were not sent yet. They are counted in `drops`,
+ * and the oldest bytes are skipped so the stream resumes with the newest
+ * ones. The interrupts must see the ring at least every half of it,
+ * i.e. run within size / 2 character times.
+ */
+
+#ifndef UART_BRIDGE_H
+#define UART_BRIDGE_H
+
+#include "stm32f0xx_hal.h"
+#include "ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    USART_TypeDef *from;            // Receiving USART
+    USART_TypeDef *to;              // Transmitting USART
+    DMA_Channel_TypeDef *rxDma;     // Circular: from->RDR into the ring storage
+    DMA_Channel_TypeDef *txDma;     // Normal: ring spans to to->TDR
+    ringbuf_t *ring;
+    uint8_t rxFlags;                // Bit offset of each channel's flags in DMA1->ISR
+    uint8_t txFlags;
+    uint16_t rxPos;                 // DMA write offset published last
+    volatile uint16_t txLen;        // Span owned by the TX DMA (0 = idle)
+    volatile uint16_t peak;         // Highest ring fill seen, for sizing it
+    volatile uint32_t bytes;        // Bytes forwarded (TX transfers completed)
+    volatile uint32_t spans;        // TX transfers started
+    volatile uint32_t drops;        // Bytes lost: overwritten in the ring, or a USART overrun
+    volatile uint32_t errors;       // Framing, noise and parity errors on `from`
+} uart_bridge_t;
+
+/* Start forwarding from->to through ring (reset here); HAL_ERROR if a
+   DMA handle is missing or the RX one is not circular */
+HAL_StatusTypeDef uart_bridge_start(uart_bridge_t *b, UART_HandleTypeDef *from,
+                                    UART_HandleTypeDef *to, ringbuf_t *ring);
+
+/* Call from the IRQ handler of the `from` USART: idle line, line errors */
+void uart_bridge_usart_irq(uart_bridge_t *b);
+
+/* Call from every DMA IRQ handler that serves one of b's channels */
+void uart_bridge_dma_irq(uart_bridge_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_BRIDGE_H */
@@ -0,0 +1,332 @@
+/*
+ * File: uart_rx.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * UART receive engine: per-byte interrupt (through the HAL or straight
+ * from RDR) or circular DMA with idle-line detection, all feeding a
+ * ringbuf_t. See uart_rx.h for the wiring.
+ *
+ * Flow control state changes happen in the receive interrupt (stop) and
+ * in uart_rx_flow_poll() with interrupts masked (go on), so `stopped`
+ * and the pending XON/XOFF byte have one writer at a time. The byte is
+ * written to TDR from the TXE interrupt, with the transmit engine held
+ * meanwhile so it cannot be overwritten by a DMA transfer.
+ */
+
+#include "uart_rx.h"
+#include "hwio.h"
+#ifdef HALSIM
+#include "halsim.h"
+#define UART_RX_RDR(usart)  ((uint8_t)halsim_uart_read(usart))   // Host: clear RXNE like the MCU
+#else
+#define UART_RX_RDR(usart)  ((uint8_t)(usart)->RDR)
+#endif
+
+#define UART_RX_LINE_ERRORS (USART_ISR_ORE | USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)
+
+/* Queue XON/XOFF for the TXE interrupt; a newer one replaces an unsent one */
+static void uart_rx_send_ctl(uart_rx_t *rx, uint8_t ctl)
+{
+    USART_TypeDef *usart = rx->huart->Instance;
+
+    rx->ctl = ctl;
+    if (rx->flow.tx != NULL)
+    {
+        uart_tx_hold(rx->flow.tx, UART_TX_HOLD_CTL, true);
+    }
+    HW_REG_WRITE(usart->CR1, usart->CR1 | USART_CR1_TXEIE);
+}
+
+/* Tell the sender to stop (RTS high, XOFF) or to go on (RTS low, XON) */
+static void uart_rx_flow_set(uart_rx_t *rx, bool stop)
+{
+    rx->stopped = stop;
+    if (rx->flow.mode == UART_RX_FLOW_RTS)
+    {
+        HAL_GPIO_WritePin(rx->flow.rtsPort, rx->flow.rtsPin, stop ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+    else
+    {
+        uart_rx_send_ctl(rx, stop ? UART_RX_XOFF : UART_RX_XON);
+    }
+}
+
+/* After publishing bytes: stop the sender at the high watermark */
+static void uart_rx_flow_check(uart_rx_t *rx)
+{
+    if (rx->flow.mode != UART_RX_FLOW_NONE && !rx->stopped &&
+        ringbuf_used(rx->ring) >= rx->flow.high)
+    {
+        rx->stops++;
+        uart_rx_flow_set(rx, true);
+    }
+}
+
+/* XON/XOFF mode: a received XOFF holds the transmit engine, XON resumes it */
+static bool uart_rx_flow_byte(uart_rx_t *rx, uint8_t byte)
+{
+    if (rx->flow.mode != UART_RX_FLOW_XONXOFF || (byte != UART_RX_XON && byte != UART_RX_XOFF))
+    {
+        return false;
+    }
+    if (rx->flow.tx != NULL)
+    {
+        uart_tx_hold(rx->flow.tx, UART_TX_HOLD_PEER, byte == UART_RX_XOFF);
+    }
+    return true;
+}
+
+/* Publish the DMA's writes up to `pos`, from the idle line or from HT/TC */
+static void uart_rx_publish(uart_rx_t *rx, uint16_t pos, bool idle)
+{
+    ringbuf_t *ring = rx->ring;
+    uint16_t size   = ringbuf_size(ring);
+    uint16_t delta  = (uint16_t)((pos - rx->dmaPos) & ring->mask);
+    uint16_t used   = ringbuf_used(ring);
+    uint32_t isr    = rx->huart->Instance->ISR;
+
+    rx->events++;
+
+    if ((isr & (USART_ISR_FE | USART_ISR_NE | USART_ISR_PE)) != 0U)
+    {
+        rx->errors++;
+        rx->huart->Instance->ICR = USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF;
+    }
+
+    /*
+     * Nothing new at the idle line, or HT/TC reporting bytes an idle event
+     * already published. Two HT/TC at one position have a TC/HT between
+     * them unless the DMA went a whole ring round.
+     */
+    if (delta == 0U)
+    {
+        if (idle)
+        {
+            return;
+        }
+        if (rx->idleLast)
+        {
+            rx->idleLast = false;
+            return;
+        }
+        delta = size;
+    }
+
+    /*
+     * The DMA has already written the bytes, so they are published whatever
+     * the room: the head has to stay on the DMA's write position. Anything
+     * beyond the room overwrote unread data; the reader skips it (see
+     * ringbuf_tail()). `used` never exceeds size, so each byte counts once.
+     */
+    uint16_t room = (uint16_t)(size - used);
+    if (delta > room)
+    {
+        ring->overflows += (uint32_t)(delta - room);
+    }
+
+    /* XON/XOFF stay in the ring (the DMA put them there); the last one counts */
+    if (rx->flow.mode == UART_RX_FLOW_XONXOFF)
+    {
+        for (uint16_t i = 0; i < delta; i++)
+        {
+            (void)uart_rx_flow_byte(rx, ring->buf[(rx->dmaPos + i) & ring->mask]);
+        }
+    }
+
+    ringbuf_commit(ring, delta);
+    rx->dmaPos = (uint16_t)(pos & ring->mask);
+    rx->idleLast = idle;
+    rx->bytes += delta;
+    uart_rx_flow_check(rx);
+}
+
+HAL_StatusTypeDef uart_rx_start(uart_rx_t *rx, UART_HandleTypeDef *huart,
+                                ringbuf_t *ring, uart_rx_mode_t mode)
+{
+    HAL_StatusTypeDef status;
+
+    rx->huart  = huart;
+    rx->ring   = ring;
+    rx->mode   = mode;
+    rx->dmaPos = 0;
+    rx->idleLast = false;
+    rx->events = 0;
+    rx->bytes  = 0;
+    rx->errors = 0;
+    rx->overruns = 0;
+    rx->framing  = 0;
+    rx->noise    = 0;
+    rx->flow.mode = UART_RX_FLOW_NONE;
+    rx->stopped  = false;
+    rx->ctl      = 0;
+    rx->stops    = 0;
+
+    if (mode == UART_RX_MODE_IT)
+    {
+        return HAL_UART_Receive_IT(huart, &rx->byte, 1);
+    }
+
+    if (mode == UART_RX_MODE_FAST)
+    {
+        /* The HAL's RxState stays READY: it never sees a reception. ORE
+           and FE/NE come with RXNE, so RXNEIE alone raises them all */
+        huart->Instance->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF;
+        SET_BIT(huart->Instance->CR1, USART_CR1_RXNEIE);
+        return HAL_OK;
+    }
+
+    /*
+     * The HAL aborts a DMA reception on any line error. The DMA keeps
+     * running through noise/framing errors anyway, so disable overrun
+     * detection (OVRDIS needs UE=0) and the error interrupt, and count
+     * the error flags at each event instead.
+     */
+    ringbuf_reset(ring);
+    __HAL_UART_DISABLE(huart);
+    SET_BIT(huart->Instance->CR3, USART_CR3_OVRDIS);
+    __HAL_UART_ENABLE(huart);
+
+    status = HAL_UARTEx_ReceiveToIdle_DMA(huart, ring->buf, ringbuf_size(ring));
+    if (status == HAL_OK)
+    {
+        CLEAR_BIT(huart->Instance->CR3, USART_CR3_EIE);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef uart_rx_flow(uart_rx_t *rx, const uart_rx_flow_t *cfg)
+{
+    uint32_t primask;
+
+    if (cfg->mode != UART_RX_FLOW_NONE &&
+        (cfg->high == 0U || cfg->high > ringbuf_size(rx->ring) || cfg->low >= cfg->high ||
+         (cfg->mode == UART_RX_FLOW_RTS && cfg->rtsPort == NULL)))
+    {
+        return HAL_ERROR;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    rx->flow    = *cfg;
+    rx->stopped = false;
+    rx->stops   = 0;
+    if (cfg->mode == UART_RX_FLOW_RTS)
+    {
+        HAL_GPIO_WritePin(cfg->rtsPort, cfg->rtsPin, GPIO_PIN_RESET);
+    }
+    uart_rx_flow_check(rx);
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+void uart_rx_flow_poll(uart_rx_t *rx)
+{
+    uint32_t primask;
+
+    if (!rx->stopped)
+    {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (rx->stopped && ringbuf_used(rx->ring) <= rx->flow.low)
+    {
+        uart_rx_flow_set(rx, false);
+    }
+    __set_PRIMASK(primask);
+}
+
+void uart_rx_irq(uart_rx_t *rx)
+{
+    USART_TypeDef *usart = rx->huart->Instance;
+    uint32_t isr;
+
+    /* A pending XON/XOFF goes out as soon as TDR is free */
+    if (rx->ctl != 0U && (usart->CR1 & USART_CR1_TXEIE) != 0U &&
+        (usart->ISR & USART_ISR_TXE) != 0U)
+    {
+        HW_REG_WRITE(usart->TDR, rx->ctl);
+        HW_REG_WRITE(usart->CR1, usart->CR1 & ~USART_CR1_TXEIE);
+        rx->ctl = 0;
+        if (rx->flow.tx != NULL)
+        {
+            uart_tx_hold(rx->flow.tx, UART_TX_HOLD_CTL, false);
+        }
+    }
+
+    /* DMA mode: the idle line is taken here, so the HAL's events are HT/TC only */
+    if (rx->mode == UART_RX_MODE_DMA && (usart->ISR & USART_ISR_IDLE) != 0U &&
+        (usart->CR1 & USART_CR1_IDLEIE) != 0U)
+    {
+        HW_REG_WRITE(usart->ICR, USART_ICR_IDLECF);
+        uart_rx_publish(rx, (uint16_t)(ringbuf_size(rx->ring) -
+                                       __HAL_DMA_GET_COUNTER(rx->huart->hdmarx)), true);
+    }
+
+    if (rx->mode != UART_RX_MODE_FAST)
+    {
+        HAL_UART_IRQHandler(rx->huart);
+        return;
+    }
+
+    isr = usart->ISR;
+    if ((isr & (USART_ISR_RXNE | UART_RX_LINE_ERRORS)) != 0U)
+    {
+        rx->events++;
+    }
+    if ((isr & UART_RX_LINE_ERRORS) != 0U)
+    {
+        rx->overruns += ((isr & USART_ISR_ORE) != 0U) ? 1U : 0U;
+        rx->framing  += ((isr & USART_ISR_FE) != 0U) ? 1U : 0U;
+        rx->noise    += ((isr & USART_ISR_NE) != 0U) ? 1U : 0U;
+        rx->errors++;
+        usart->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NCF | USART_ICR_PECF;
+    }
+
+    /* A byte that arrives meanwhile is taken in the same entry */
+    while ((isr & USART_ISR_RXNE) != 0U)
+    {
+        uint8_t byte = UART_RX_RDR(usart);
+
+        if (!uart_rx_flow_byte(rx, byte) && ringbuf_put(rx->ring, byte))
+        {
+            rx->bytes++;
+        }
+        isr = usart->ISR;
+    }
+    uart_rx_flow_check(rx);
+
+    /* TXE/TC sit at the bit positions of TXEIE/TCIE: a HAL (or uart_tx) transmit is running */
+    if ((isr & usart->CR1 & (USART_ISR_TXE | USART_ISR_TC)) != 0U)
+    {
+        HAL_UART_IRQHandler(rx->huart);
+    }
+}
+
+void uart_rx_on_cplt(uart_rx_t *rx)
+{
+    rx->events++;
+    if (!uart_rx_flow_byte(rx, rx->byte) && ringbuf_put(rx->ring, rx->byte))
+    {
+        rx->bytes++;
+    }
+    uart_rx_flow_check(rx);
+    HAL_UART_Receive_IT(rx->huart, &rx->byte, 1);
+}
+
+void uart_rx_on_event(uart_rx_t *rx, uint16_t pos)
+{
+    uart_rx_publish(rx, pos, false);
+}
+
+void uart_rx_on_error(uart_rx_t *rx)
+{
+    rx->errors++;
+
+    /* Only the IT mode reaches here; the HAL has aborted the reception */
+    if (rx->mode == UART_RX_MODE_IT)
+    {
+        HAL_UART_Receive_IT(rx->huart, &rx->byte, 1);
+    }
+}
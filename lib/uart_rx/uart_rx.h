@@ -0,0 +1,168 @@
+/*
+ * File: uart_rx.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * UART receive engine that feeds a ringbuf_t. Three modes:
+ *
+ * - UART_RX_MODE_IT  : one HAL receive interrupt per byte, the byte is
+ *                      pushed into the ring from HAL_UART_RxCpltCallback.
+ * - UART_RX_MODE_FAST: one interrupt per byte too, but uart_rx_irq()
+ *                      reads RDR into the ring itself: no HAL IRQ
+ *                      dispatch, callback and re-arm per byte. Overrun,
+ *                      framing and noise errors are counted and cleared
+ *                      there; the byte is kept (a framed protocol's CRC
+ *                      rejects it). The transmit interrupts (TXE, TC)
+ *                      still go to HAL_UART_IRQHandler(), so HAL or
+ *                      uart_tx transmits keep working.
+ * - UART_RX_MODE_DMA : the RX DMA channel runs in circular mode straight
+ *                      into the ring's storage. The DMA half/full-transfer
+ *                      interrupts and the USART idle-line interrupt report
+ *                      the DMA write position, which is published as the
+ *                      ring's new head. A burst costs a few interrupts
+ *                      instead of one per byte.
+ *
+ * In DMA mode the hardware cannot be told to stop when the ring is full.
+ * The bytes it wrote over unread ones are counted once (ring->overflows)
+ * and the reader skips them: it resumes at the oldest byte still in the
+ * ring, so it never sees more than the ring's size. Size the ring for the
+ * longest burst the main loop can fall behind on, or stop the sender with
+ * flow control. uart_rx_irq() takes the idle line itself, so the HAL's
+ * events are the HT/TC ones and each event knows its source. A whole ring
+ * between two events (HT or TC at the position of the last HT/TC) is
+ * taken as a full lap, so the DMA interrupt must not be held off for more
+ * than half a ring. The DMA and USART interrupts must have the same
+ * priority: neither may preempt the other while it publishes.
+ *
+ * Flow control (uart_rx_flow(), after uart_rx_start()) stops the sender
+ * when the ring fills up to a high watermark and lets it go on once the
+ * application has drained it down to a low one:
+ *
+ * - UART_RX_FLOW_RTS    : RTS is a GPIO driven by the engine, low while
+ *                         the sender may send. The USART's own RTS (RTSE)
+ *                         only reacts to a full RDR, not to the ring. CTS
+ *                         is the USART's: with UART_HWCONTROL_CTS and the
+ *                         pin in its AF the USART waits while CTS is high.
+ * - UART_RX_FLOW_XONXOFF: XOFF (0x13) and XON (0x11) are sent through TDR
+ *                         ahead of anything queued in `tx` (a uart_tx on
+ *                         the same USART, or NULL). Received XOFF/XON hold
+ *                         and resume `tx`. The IT and FAST modes keep them
+ *                         out of the ring; the DMA mode cannot, so the
+ *                         parser must skip them. Text only: a binary
+ *                         stream may contain the two bytes.
+ *
+ * The high watermark is checked whenever bytes are published, the low
+ * one by uart_rx_flow_poll(), which the main loop calls after draining.
+ * size - high must hold what the sender still sends after the stop: its
+ * FIFO and reaction time (a few bytes for a USB-serial adapter, up to a
+ * USB packet of 64 bytes for a PC tty). In DMA mode the fill is only seen
+ * at the half/full-transfer and idle events, so high must also stay below
+ * size / 2: keep high around size / 4.
+ *
+ * Application wiring:
+ *
+ *     void USART1_IRQHandler(void)                                   // Any mode
+ *     {   uart_rx_irq(&rx); }
+ *
+ *     void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)        // IT mode
+ *     {   if (huart == rx.huart) uart_rx_on_cplt(&rx); }
+ *
+ *     void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+ *     {   if (huart == rx.huart) uart_rx_on_event(&rx, Size); } // DMA mode
+ *
+ * For DMA mode the UART handle must have hdmarx linked to a channel set
+ * up with DMA_CIRCULAR, and both the USART and DMA IRQs must be enabled.
+ */
+
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include "stm32f0xx_hal.h"
+#include "ringbuf.h"
+#include "uart_tx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    UART_RX_MODE_IT = 0,
+    UART_RX_MODE_DMA,
+    UART_RX_MODE_FAST
+} uart_rx_mode_t;
+
+typedef enum
+{
+    UART_RX_FLOW_NONE = 0,
+    UART_RX_FLOW_RTS,
+    UART_RX_FLOW_XONXOFF
+} uart_rx_flow_mode_t;
+
+#define UART_RX_XON   0x11U
+#define UART_RX_XOFF  0x13U
+
+typedef struct
+{
+    uart_rx_flow_mode_t mode;
+    uint16_t high;               // Stop the sender at this ring fill
+    uint16_t low;                // Let it go on at this fill (< high)
+    GPIO_TypeDef *rtsPort;       // RTS mode: output pin, low = send
+    uint16_t rtsPin;
+    uart_tx_t *tx;               // XON/XOFF mode: transmit engine to hold, or NULL
+} uart_rx_flow_t;
+
+typedef struct
+{
+    UART_HandleTypeDef *huart;
+    ringbuf_t *ring;
+    uart_rx_mode_t mode;
+    uint8_t byte;                // IT mode: landing byte for the HAL
+    uint16_t dmaPos;             // DMA mode: last published write offset
+    bool idleLast;               // DMA mode: the last bytes were published by the idle line
+    volatile uint32_t events;    // Receive interrupts/callbacks handled
+    volatile uint32_t bytes;     // Bytes published to the ring
+    volatile uint32_t errors;    // Line errors: HAL error callbacks, or the flags below
+    volatile uint32_t overruns;  // FAST mode: ORE, a byte lost in the USART
+    volatile uint32_t framing;   // FAST mode: FE
+    volatile uint32_t noise;     // FAST mode: NE
+    uart_rx_flow_t flow;         // Flow control (mode NONE after uart_rx_start())
+    volatile bool stopped;       // The sender was told to stop
+    volatile uint8_t ctl;        // XON/XOFF waiting for TDR (0 = none)
+    volatile uint32_t stops;     // High watermark reached
+} uart_rx_t;
+
+/*
+ * Start reception into ring. In DMA mode the whole ring storage is the
+ * DMA target, so the ring must be empty and is reset here.
+ */
+HAL_StatusTypeDef uart_rx_start(uart_rx_t *rx, UART_HandleTypeDef *huart,
+                                ringbuf_t *ring, uart_rx_mode_t mode);
+
+/* Enable flow control with `cfg` (copied); RTS mode asserts RTS here.
+   HAL_ERROR if the watermarks do not fit the ring or a pin is missing */
+HAL_StatusTypeDef uart_rx_flow(uart_rx_t *rx, const uart_rx_flow_t *cfg);
+
+/* Call from the main loop after draining: lets the sender go on once
+   the ring is down to the low watermark */
+void uart_rx_flow_poll(uart_rx_t *rx);
+
+/* Call from the USART's IRQ handler: FAST mode handles reception and DMA
+   mode the idle line here, the rest (and FAST mode's transmit flags) goes
+   to the HAL; a pending XON/XOFF goes out first */
+void uart_rx_irq(uart_rx_t *rx);
+
+/* IT mode: call from HAL_UART_RxCpltCallback */
+void uart_rx_on_cplt(uart_rx_t *rx);
+
+/* DMA mode: call from HAL_UARTEx_RxEventCallback with its Size argument
+   (HT/TC events; the idle line never gets there, see uart_rx_irq()) */
+void uart_rx_on_event(uart_rx_t *rx, uint16_t pos);
+
+/* Call from HAL_UART_ErrorCallback: counts the error and restarts reception */
+void uart_rx_on_error(uart_rx_t *rx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_RX_H */
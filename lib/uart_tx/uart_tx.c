@@ -0,0 +1,236 @@
+/*
+ * File: uart_tx.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * DMA transmit queue of (pointer, length) descriptors, see uart_tx.h.
+ *
+ * Concurrency: the application (one context) queues descriptors, the TX
+ * complete interrupt releases them. Descriptor updates and kicking the
+ * DMA happen with interrupts masked; copying into the ring does not,
+ * since only the application writes to it.
+ *
+ * A hold clears CR3.DMAT: the USART stops requesting bytes, the DMA
+ * channel keeps its position, and setting DMAT again resumes it. The
+ * HAL clears DMAT itself once the channel is done, so setting it again
+ * after that is harmless.
+ */
+
+#include "uart_tx.h"
+#include "hwio.h"
+#include <string.h>
+
+_Static_assert((UART_TX_DESC_COUNT & (UART_TX_DESC_COUNT - 1)) == 0 &&
+               UART_TX_DESC_COUNT <= 128,
+               "UART_TX_DESC_COUNT must be a power of two <= 128");
+
+#define DESC_MASK  ((uint8_t)(UART_TX_DESC_COUNT - 1U))
+
+/* Start the oldest descriptor if the DMA is idle. IRQs must be masked. */
+static void uart_tx_kick(uart_tx_t *tx)
+{
+    const uart_tx_desc_t *d;
+
+    if (tx->inFlight != 0U || tx->held != 0U || tx->descHead == tx->descTail)
+    {
+        return;
+    }
+
+    d = &tx->desc[tx->descTail & DESC_MASK];
+    if (HAL_UART_Transmit_DMA(tx->huart, (uint8_t *)d->data, d->len) != HAL_OK)
+    {
+        tx->errors++; // Still queued: the next push, hold release or poll retries
+        return;
+    }
+    tx->inFlight     = d->len;
+    tx->descInFlight = 1;
+    tx->transfers++;
+    tx->bytes += d->len;
+}
+
+/*
+ * Append a descriptor. Copied bytes that directly follow the last queued
+ * (not yet started) copy descriptor in the ring extend it instead.
+ * IRQs must be masked. Returns false if the descriptor queue is full.
+ */
+static bool uart_tx_push(uart_tx_t *tx, const uint8_t *data, uint16_t len,
+                         uint8_t flags, uart_tx_done_fn done, void *arg)
+{
+    uint8_t head = tx->descHead;
+
+    if ((flags & UART_TX_DESC_COPY) != 0U && head != tx->descTail)
+    {
+        uint8_t lastIdx = (uint8_t)(head - 1U);
+        uart_tx_desc_t *last = &tx->desc[lastIdx & DESC_MASK];
+        bool started = (uint8_t)(lastIdx - tx->descTail) < tx->descInFlight;
+
+        if (!started && (last->flags & UART_TX_DESC_COPY) != 0U &&
+            last->data + last->len == data && (uint32_t)last->len + len <= 0xFFFFU)
+        {
+            last->len = (uint16_t)(last->len + len);
+            return true;
+        }
+    }
+
+    if (uart_tx_slots(tx) == 0U)
+    {
+        return false;
+    }
+
+    uart_tx_desc_t *d = &tx->desc[head & DESC_MASK];
+    d->data  = data;
+    d->len   = len;
+    d->flags = flags;
+    d->done  = done;
+    d->arg   = arg;
+    tx->descHead = (uint8_t)(head + 1U);
+    return true;
+}
+
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart, ringbuf_t *ring)
+{
+    memset(tx, 0, sizeof(*tx));
+    tx->huart = huart;
+    tx->ring  = ring;
+}
+
+bool uart_tx_send_ref(uart_tx_t *tx, const uint8_t *data, uint16_t len,
+                      uart_tx_done_fn done, void *arg)
+{
+    uint32_t primask;
+    bool queued;
+
+    if (len == 0U)
+    {
+        return true;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    queued = uart_tx_push(tx, data, len, 0U, done, arg);
+    uart_tx_kick(tx);
+    __set_PRIMASK(primask);
+
+    if (!queued)
+    {
+        tx->rejected++;
+    }
+    return queued;
+}
+
+bool uart_tx_write(uart_tx_t *tx, const uint8_t *data, uint16_t len)
+{
+    uint8_t *span[2];
+    uint16_t part[2] = { 0U, 0U };
+    uint32_t primask;
+
+    if (len == 0U)
+    {
+        return true;
+    }
+
+    /*
+     * Free ring space and free descriptors can only grow while we look
+     * (the interrupt only releases), so checking first is safe. A write
+     * that wraps the ring needs two descriptors.
+     */
+    if (tx->ring == NULL || len > ringbuf_free(tx->ring))
+    {
+        tx->rejected++;
+        uart_tx_poll(tx);
+        return false;
+    }
+    part[0] = ringbuf_write_span(tx->ring, &span[0]);
+    if (part[0] >= len)
+    {
+        part[0] = len;
+    }
+    if (uart_tx_slots(tx) < ((part[0] < len) ? 2U : 1U))
+    {
+        tx->rejected++;
+        uart_tx_poll(tx);
+        return false;
+    }
+
+    memcpy(span[0], data, part[0]);
+    ringbuf_commit(tx->ring, part[0]);
+    if (part[0] < len)
+    {
+        part[1] = (uint16_t)(len - part[0]);
+        ringbuf_write_span(tx->ring, &span[1]);
+        memcpy(span[1], &data[part[0]], part[1]);
+        ringbuf_commit(tx->ring, part[1]);
+    }
+    tx->copied += len;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    uart_tx_push(tx, span[0], part[0], UART_TX_DESC_COPY, NULL, NULL);
+    if (part[1] != 0U)
+    {
+        uart_tx_push(tx, span[1], part[1], UART_TX_DESC_COPY, NULL, NULL);
+    }
+    uart_tx_kick(tx);
+    __set_PRIMASK(primask);
+    return true;
+}
+
+void uart_tx_poll(uart_tx_t *tx)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    uart_tx_kick(tx);
+    __set_PRIMASK(primask);
+}
+
+void uart_tx_hold(uart_tx_t *tx, uint8_t reason, bool hold)
+{
+    USART_TypeDef *usart = tx->huart->Instance;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (hold)
+    {
+        tx->held |= reason;
+        HW_REG_WRITE(usart->CR3, usart->CR3 & ~USART_CR3_DMAT);
+    }
+    else if ((tx->held & reason) != 0U)
+    {
+        tx->held &= (uint8_t)~reason;
+        if (tx->held == 0U)
+        {
+            if (tx->inFlight != 0U)
+            {
+                HW_REG_WRITE(usart->CR3, usart->CR3 | USART_CR3_DMAT);
+            }
+            uart_tx_kick(tx);
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void uart_tx_on_cplt(uart_tx_t *tx)
+{
+    uint8_t count = tx->descInFlight;
+
+    tx->inFlight     = 0;
+    tx->descInFlight = 0;
+
+    /* Release each sent descriptor before its callback, which may queue more */
+    while (count-- > 0U)
+    {
+        uart_tx_desc_t d = tx->desc[tx->descTail & DESC_MASK];
+        tx->descTail = (uint8_t)(tx->descTail + 1U);
+
+        if ((d.flags & UART_TX_DESC_COPY) != 0U)
+        {
+            ringbuf_skip(tx->ring, d.len);
+        }
+        else if (d.done != NULL)
+        {
+            d.done(d.arg, d.data);
+        }
+    }
+
+    uart_tx_kick(tx);
+}
@@ -0,0 +1,135 @@
+/*
+ * File: uart_tx.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * DMA transmit queue of (pointer, length) descriptors.
+ *
+ * Two ways to queue data, sent in the order they were queued:
+ *
+ * - uart_tx_send_ref() queues a descriptor for a buffer the caller
+ *   owns: a string literal in flash or a RAM buffer. Nothing is copied;
+ *   the DMA reads the buffer directly. The optional `done` callback runs
+ *   (in interrupt context) once the buffer has been sent and may be
+ *   reused. Flash literals need no callback.
+ * - uart_tx_write() copies bytes into the engine's ring, for data that
+ *   lives on the stack. A copied write that directly follows the last
+ *   queued copy in the ring extends its descriptor while that one has
+ *   not started, so a burst of small writes goes out as one transfer.
+ *
+ * The engine hands the DMA one descriptor at a time. The completion
+ * callback releases it and starts the next one. If the HAL refuses to
+ * start a transfer (the UART is busy with another one), `errors` is
+ * incremented and the descriptor stays queued: the next call, hold
+ * release or uart_tx_poll() tries again.
+ *
+ * Both calls are all-or-nothing: if the ring or the descriptor queue is
+ * full, nothing is queued, the call returns false and `rejected` is
+ * incremented, so the caller can retry instead of sending a truncated
+ * message.
+ *
+ * uart_tx_hold() pauses transmission for flow control (uart_rx's
+ * XON/XOFF mode): a transfer already running stops after the byte in
+ * TDR and goes on where it stopped, and no new one starts until every
+ * hold reason is gone.
+ *
+ * Application wiring:
+ *
+ *     void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+ *     {   if (huart == tx.huart) uart_tx_on_cplt(&tx); }
+ *
+ * The UART handle must have hdmatx linked to a DMA_NORMAL channel, and
+ * both the USART and the DMA channel IRQs must be enabled.
+ */
+
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include "stm32f0xx_hal.h"
+#include "ringbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Descriptor queue depth (power of two, <= 128) */
+#ifndef UART_TX_DESC_COUNT
+#define UART_TX_DESC_COUNT 8
+#endif
+
+/* Buffer released: called from the TX complete interrupt */
+typedef void (*uart_tx_done_fn)(void *arg, const uint8_t *data);
+
+#define UART_TX_DESC_COPY  0x01U   // Bytes live in the engine's ring
+
+/* Reasons for uart_tx_hold(), one bit each */
+#define UART_TX_HOLD_PEER  0x01U   // The receiver sent XOFF
+#define UART_TX_HOLD_CTL   0x02U   // A flow control byte goes out first
+
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t flags;
+    uart_tx_done_fn done;
+    void *arg;
+} uart_tx_desc_t;
+
+typedef struct
+{
+    UART_HandleTypeDef *huart;
+    ringbuf_t *ring;               // Copy buffer for uart_tx_write(), may be NULL
+    uart_tx_desc_t desc[UART_TX_DESC_COUNT];
+    volatile uint8_t descHead;     // Next free descriptor (free-running)
+    volatile uint8_t descTail;     // Oldest queued descriptor (free-running)
+    volatile uint8_t descInFlight; // Descriptors covered by the running transfer
+    volatile uint16_t inFlight;    // Bytes owned by the running DMA transfer (0 = idle)
+    volatile uint8_t held;         // UART_TX_HOLD_* reasons in force (0 = sending)
+    volatile uint32_t transfers;   // DMA transfers started
+    volatile uint32_t bytes;       // Bytes handed to the DMA
+    volatile uint32_t copied;      // Bytes that went through the copy ring
+    volatile uint32_t rejected;    // Calls refused because the queue was full
+    volatile uint32_t errors;      // Transfers the HAL refused to start (retried)
+} uart_tx_t;
+
+/* ring may be NULL if only uart_tx_send_ref() is used */
+void uart_tx_init(uart_tx_t *tx, UART_HandleTypeDef *huart, ringbuf_t *ring);
+
+/* Queue a caller-owned buffer without copying. data must stay valid until done runs. */
+bool uart_tx_send_ref(uart_tx_t *tx, const uint8_t *data, uint16_t len,
+                      uart_tx_done_fn done, void *arg);
+
+/* Copy len bytes into the ring and queue them */
+bool uart_tx_write(uart_tx_t *tx, const uint8_t *data, uint16_t len);
+
+/* Start the oldest descriptor if nothing is sending: for loops that wait
+   for the queue, in case the HAL refused the last start */
+void uart_tx_poll(uart_tx_t *tx);
+
+/* Free space in the copy ring, for callers that want to check before writing */
+static inline uint16_t uart_tx_free(const uart_tx_t *tx)
+{
+    return (tx->ring != NULL) ? ringbuf_free(tx->ring) : 0U;
+}
+
+/* Free descriptor slots; a write that wraps the copy ring needs two */
+static inline uint8_t uart_tx_slots(const uart_tx_t *tx)
+{
+    return (uint8_t)(UART_TX_DESC_COUNT - (uint8_t)(tx->descHead - tx->descTail));
+}
+
+static inline bool uart_tx_idle(const uart_tx_t *tx)
+{
+    return tx->descHead == tx->descTail;
+}
+
+/* Pause (hold) or resume transmission for `reason` (UART_TX_HOLD_*) */
+void uart_tx_hold(uart_tx_t *tx, uint8_t reason, bool hold);
+
+/* Call from HAL_UART_TxCpltCallback */
+void uart_tx_on_cplt(uart_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_TX_H */
@@ -0,0 +1,21 @@
+/*
+ * File: wave.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Built-in waveform tables, see wave.h. Every entry is computed by the
+ * compiler; the object holds only the 512-byte tables, and tables the
+ * application does not reference are dropped by --gc-sections.
+ */
+
+#include "wave.h"
+
+#define WAVE_SINE_F(x)        (0.5 - 0.5 * __builtin_cos(2.0 * WAVE_PI * (x)))
+#define WAVE_SINE_GAMMA_F(x)  __builtin_pow(WAVE_SINE_F(x), 2.2)
+#define WAVE_TRIANGLE_F(x)    (((x) < 0.5) ? 2.0 * (x) : 2.0 - 2.0 * (x))
+#define WAVE_BREATH_F(x)      ((__builtin_exp(-__builtin_cos(2.0 * WAVE_PI * (x))) - 0.36787944117144233) / \
+                               (2.71828182845904524 - 0.36787944117144233))
+
+WAVE_TABLE_DEFINE(wave_sine, WAVE_SINE_F);
+WAVE_TABLE_DEFINE(wave_sine_gamma, WAVE_SINE_GAMMA_F);
+WAVE_TABLE_DEFINE(wave_triangle, WAVE_TRIANGLE_F);
+WAVE_TABLE_DEFINE(wave_breath, WAVE_BREATH_F);
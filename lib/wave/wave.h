@@ -0,0 +1,104 @@
+/*
+ * File: wave.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Integer waveform generator for LED fading and similar slow PWM effects.
+ *
+ * A waveform is a 256-entry table of unipolar Q15 samples (0 = off,
+ * 32767 = full) in flash. A 32-bit phase accumulator steps through it;
+ * the top 8 bits pick the entry and the next 16 bits interpolate
+ * linearly to the following one. One update is an add, two loads and a
+ * multiply, with no floating point and no divide.
+ *
+ * Built-in tables (wave.c), all starting at their minimum:
+ *   wave_sine       (1 - cos) / 2
+ *   wave_sine_gamma wave_sine raised to 2.2, so brightness looks sinusoidal
+ *   wave_triangle   linear up, linear down
+ *   wave_breath     (exp(-cos) - 1/e) / (e - 1/e), a short peak, long rest
+ *
+ * Own shapes: WAVE_TABLE_DEFINE(name, F) fills a table at compile time
+ * from F(x), an expression of x in [0, 1) with values in [0, 1]. GCC folds
+ * __builtin_sin(), __builtin_exp() and __builtin_pow() with constant
+ * arguments, so such tables cost no code and no libm:
+ *
+ *     #define SAW(x)  (x)
+ *     WAVE_TABLE_DEFINE(sawTable, SAW);
+ *
+ *     static wave_t breath = WAVE_INIT(wave_breath, 200);  // 200 updates per cycle
+ *     ...
+ *     duty = wave_scale(wave_next(&breath), 1000);
+ */
+
+#ifndef WAVE_H
+#define WAVE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WAVE_TABLE_BITS  8
+#define WAVE_TABLE_LEN   (1U << WAVE_TABLE_BITS)
+#define WAVE_Q15_MAX     32767U
+
+#define WAVE_PI          3.14159265358979323846
+
+typedef struct
+{
+    const uint16_t *table;
+    uint32_t phase;            // Position in the cycle, 2^32 = one cycle
+    uint32_t step;             // Phase added per update
+} wave_t;
+
+/* Phase step for a cycle of `updates` calls to wave_next() */
+#define WAVE_STEP(updates)     ((uint32_t)(4294967296ULL / (uint32_t)(updates)))
+
+#define WAVE_INIT(table, updates)  { (table), 0U, WAVE_STEP(updates) }
+
+/* ---- Compile-time table generation ---- */
+#define WAVE_Q15(v)            ((uint16_t)((double)WAVE_Q15_MAX * (v) + 0.5))
+#define WAVE_ENTRY_(F, i)      WAVE_Q15(F((double)(i) / (double)WAVE_TABLE_LEN))
+#define WAVE_ENTRY4_(F, i)     WAVE_ENTRY_(F, (i)), WAVE_ENTRY_(F, (i) + 1), \
+                               WAVE_ENTRY_(F, (i) + 2), WAVE_ENTRY_(F, (i) + 3)
+#define WAVE_ENTRY16_(F, i)    WAVE_ENTRY4_(F, (i)), WAVE_ENTRY4_(F, (i) + 4), \
+                               WAVE_ENTRY4_(F, (i) + 8), WAVE_ENTRY4_(F, (i) + 12)
+#define WAVE_ENTRY64_(F, i)    WAVE_ENTRY16_(F, (i)), WAVE_ENTRY16_(F, (i) + 16), \
+                               WAVE_ENTRY16_(F, (i) + 32), WAVE_ENTRY16_(F, (i) + 48)
+
+#define WAVE_TABLE_DEFINE(name, F)                                          \
+    const uint16_t name[WAVE_TABLE_LEN] = {                                 \
+        WAVE_ENTRY64_(F, 0),   WAVE_ENTRY64_(F, 64),                        \
+        WAVE_ENTRY64_(F, 128), WAVE_ENTRY64_(F, 192)                        \
+    }
+
+extern const uint16_t wave_sine[WAVE_TABLE_LEN];
+extern const uint16_t wave_sine_gamma[WAVE_TABLE_LEN];
+extern const uint16_t wave_triangle[WAVE_TABLE_LEN];
+extern const uint16_t wave_breath[WAVE_TABLE_LEN];
+
+/* Sample at the current phase (interpolated), then advance */
+static inline uint16_t wave_next(wave_t *w)
+{
+    uint32_t phase = w->phase;
+    uint32_t i = phase >> (32U - WAVE_TABLE_BITS);
+    int32_t a = (int32_t)w->table[i];
+    int32_t b = (int32_t)w->table[(i + 1U) & (WAVE_TABLE_LEN - 1U)];
+    int32_t frac = (int32_t)((phase >> (16U - WAVE_TABLE_BITS)) & 0xFFFFU);
+
+    w->phase = phase + w->step;
+    return (uint16_t)(a + (((b - a) * frac) >> 16));
+}
+
+/* Q15 sample -> 0..full (e.g. a timer compare value), full <= 65535.
+   A shift rather than a divide: the M0 has no divide instruction. */
+static inline uint32_t wave_scale(uint16_t q15, uint32_t full)
+{
+    return ((uint32_t)q15 * full + 0x4000U) >> 15;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WAVE_H */
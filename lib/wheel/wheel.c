@@ -0,0 +1,273 @@
+/*
+ * File: wheel.c
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Hierarchical timing wheel, see wheel.h.
+ *
+ * A timer expiring on tick e with d = e - now ticks to go sits on the
+ * lowest level L with d < SLOTS^(L+1), in slot (e >> L * BITS) % SLOTS.
+ * Level L is hit on the ticks whose low L * BITS bits are zero, so that
+ * slot comes round at e rounded down to a multiple of SLOTS^L, at most
+ * one ring ahead. Hitting it re-files its timers with the smaller d,
+ * which lands them on a lower level; level 0 slots are one tick wide and
+ * fire. The `pending` bitmaps let wheel_advance() and wheel_next() find
+ * the next slot with work without walking the empty ones.
+ */
+
+#include "wheel.h"
+
+_Static_assert(WHEEL_BITS >= 1 && WHEEL_BITS <= 5, "WHEEL_BITS: 2 to 32 slots per level");
+_Static_assert(WHEEL_LEVELS >= 1 && WHEEL_BITS * WHEEL_LEVELS <= 32, "WHEEL_LEVELS: span above 32 bits");
+
+#define WHEEL_MASK       (WHEEL_SLOTS - 1U)
+#define WHEEL_SPAN_BITS  (WHEEL_BITS * WHEEL_LEVELS)
+#define WHEEL_ALL        ((uint32_t)((1ULL << WHEEL_SLOTS) - 1U))
+
+static void wheel_link(wheel_t *w, wheel_timer_t *t, unsigned level, unsigned index)
+{
+    wheel_timer_t **head = &w->slot[level][index];
+
+    t->next = *head;
+    if (t->next != NULL)
+    {
+        t->next->pprev = &t->next;
+    }
+    t->pprev = head;
+    *head = t;
+    t->slot = (uint8_t)((level << WHEEL_BITS) | index);
+    w->pending[level] |= 1UL << index;
+}
+
+static void wheel_unlink(wheel_t *w, wheel_timer_t *t)
+{
+    unsigned level = t->slot >> WHEEL_BITS;
+    unsigned index = t->slot & WHEEL_MASK;
+
+    *t->pprev = t->next;
+    if (t->next != NULL)
+    {
+        t->next->pprev = t->pprev;
+    }
+    t->pprev = NULL;
+    if (w->slot[level][index] == NULL)
+    {
+        w->pending[level] &= ~(1UL << index);
+    }
+}
+
+/* File `t` by the ticks it has left */
+static void wheel_place(wheel_t *w, wheel_timer_t *t)
+{
+    uint32_t left = t->expires - w->now;
+    uint32_t at = t->expires;
+    unsigned level = 0U;
+
+    while (level < WHEEL_LEVELS - 1U && (left >> (WHEEL_BITS * (level + 1U))) != 0U)
+    {
+        level++;
+    }
+#if WHEEL_SPAN_BITS < 32
+    if ((left >> WHEEL_SPAN_BITS) != 0U)
+    {
+        at = w->now + ((1UL << WHEEL_SPAN_BITS) - 1U);  // Beyond the wheel: wait in the last slot
+    }
+#endif
+    wheel_link(w, t, level, (at >> (WHEEL_BITS * level)) & WHEEL_MASK);
+}
+
+/* Re-file every timer of a slot that has come round */
+static void wheel_cascade(wheel_t *w, unsigned level, unsigned index)
+{
+    wheel_timer_t *t = w->slot[level][index];
+
+    w->slot[level][index] = NULL;
+    w->pending[level] &= ~(1UL << index);
+    while (t != NULL)
+    {
+        wheel_timer_t *next = t->next;
+        wheel_place(w, t);
+        t = next;
+    }
+}
+
+/* First tick after `now` that hits a non-empty slot of `level` */
+static uint32_t wheel_first_hit(const wheel_t *w, unsigned level, unsigned *index)
+{
+    unsigned shift = WHEEL_BITS * level;
+    uint32_t first = ((w->now >> shift) + 1U) << shift;
+    unsigned pos = (first >> shift) & WHEEL_MASK;
+    uint32_t bits = w->pending[level];
+    unsigned k;
+
+    if (pos != 0U)
+    {
+        bits = ((bits >> pos) | (bits << (WHEEL_SLOTS - pos))) & WHEEL_ALL;
+    }
+    k = (unsigned)__builtin_ctz(bits);
+    *index = (pos + k) & WHEEL_MASK;
+    return first + ((uint32_t)k << shift);
+}
+
+/* Ticks until the next slot with work is hit (expiry or cascade) */
+static uint32_t wheel_gap(const wheel_t *w)
+{
+    uint32_t gap = WHEEL_NEVER;
+
+    for (unsigned level = 0U; level < WHEEL_LEVELS; level++)
+    {
+        if (w->pending[level] != 0U)
+        {
+            unsigned index;
+            uint32_t d = wheel_first_hit(w, level, &index) - w->now;
+            if (d < gap)
+            {
+                gap = d;
+            }
+        }
+    }
+    return gap;
+}
+
+void wheel_init(wheel_t *w)
+{
+    *w = (wheel_t){ 0 };
+}
+
+void wheel_start(wheel_t *w, wheel_timer_t *t, uint32_t delay, uint32_t period,
+                 wheel_fn_t fn, void *ctx)
+{
+    wheel_stop(w, t);
+    t->expires = w->now + ((delay != 0U) ? delay : 1U);
+    t->period = period;
+    t->fn = fn;
+    t->ctx = ctx;
+    wheel_place(w, t);
+    w->running++;
+}
+
+void wheel_stop(wheel_t *w, wheel_timer_t *t)
+{
+    if (t->pprev != NULL)
+    {
+        wheel_unlink(w, t);
+        w->running--;
+    }
+}
+
+void wheel_tick(wheel_t *w)
+{
+    uint32_t now = ++w->now;
+    unsigned index = now & WHEEL_MASK;
+    wheel_timer_t *due;
+
+    /* Level 0 wrapped: bring down the next slot of each level that wrapped with it */
+    if (index == 0U)
+    {
+        for (unsigned level = 1U; level < WHEEL_LEVELS; level++)
+        {
+            unsigned i = (now >> (WHEEL_BITS * level)) & WHEEL_MASK;
+            if ((w->pending[level] & (1UL << i)) != 0U)
+            {
+                wheel_cascade(w, level, i);
+            }
+            if (i != 0U)
+            {
+                break;
+            }
+        }
+    }
+
+    if ((w->pending[0] & (1UL << index)) == 0U)
+    {
+        return;
+    }
+
+    /* Take the slot over, so that callbacks can start timers and stop the ones still in it */
+    due = w->slot[0][index];
+    w->slot[0][index] = NULL;
+    w->pending[0] &= ~(1UL << index);
+    due->pprev = &due;
+    while (due != NULL)
+    {
+        wheel_timer_t *t = due;
+
+        due = t->next;
+        if (due != NULL)
+        {
+            due->pprev = &due;
+        }
+        t->pprev = NULL;
+        w->running--;
+        if (t->period != 0U)
+        {
+            t->expires += t->period;           // Drift-free: from the tick it was due
+            wheel_place(w, t);
+            w->running++;
+        }
+        t->fn(t->ctx);
+    }
+}
+
+void wheel_advance(wheel_t *w, uint32_t ticks)
+{
+    while (ticks > 0U)
+    {
+        uint32_t gap = wheel_gap(w);
+
+        if (gap > ticks)
+        {
+            w->now += ticks;               // Nothing in between: skip the empty ticks
+            return;
+        }
+        w->now += gap - 1U;
+        ticks -= gap;
+        wheel_tick(w);
+    }
+}
+
+uint32_t wheel_next(const wheel_t *w)
+{
+    uint32_t best = WHEEL_NEVER;
+
+    /*
+     * The first non-empty slot of a level holds its earliest timer: the
+     * next one is hit a whole slot width later. Only timers waiting
+     * beyond the wheel break that, hence the walk on while a slot could
+     * still hold something sooner.
+     */
+    for (unsigned level = 0U; level < WHEEL_LEVELS; level++)
+    {
+        uint32_t bits = w->pending[level];
+        unsigned shift = WHEEL_BITS * level;
+        uint32_t first = ((w->now >> shift) + 1U) << shift;
+        unsigned pos = (first >> shift) & WHEEL_MASK;
+
+        if (bits == 0U)
+        {
+            continue;
+        }
+        for (unsigned k = 0U; k < WHEEL_SLOTS; k++)
+        {
+            unsigned index = (pos + k) & WHEEL_MASK;
+            uint32_t hit = first + ((uint32_t)k << shift) - w->now;
+
+            if (hit >= best)
+            {
+                break;
+            }
+            if ((bits & (1UL << index)) == 0U)
+            {
+                continue;
+            }
+            for (const wheel_timer_t *t = w->slot[level][index]; t != NULL; t = t->next)
+            {
+                uint32_t left = t->expires - w->now;
+                if (left < best)
+                {
+                    best = left;
+                }
+            }
+        }
+    }
+    return best;
+}
@@ -0,0 +1,124 @@
+/*
+ * File: wheel.h
+ * Project: STM32 PlatformIO Playground - Shared Libraries
+ * Description:
+ * Software timers on a hierarchical timing wheel: O(1) start, stop and
+ * expiry however many timers run, and no dynamic allocation.
+ *
+ * Time is counted in ticks of whatever drives the wheel. Level 0 has
+ * WHEEL_SLOTS slots of one tick, level 1 as many slots of WHEEL_SLOTS
+ * ticks, and so on. A timer is linked into the slot of the level that
+ * its remaining time fits in; when the level below wraps, the next slot
+ * of a level is emptied into the finer levels ("cascade"). Each timer is
+ * moved at most WHEEL_LEVELS - 1 times before it expires, and a tick
+ * only touches the slots it hits. Delays beyond the top level wait in
+ * its last slot and are re-filed when that slot comes round.
+ *
+ * Timers are application-owned and linked in place (doubly linked slot
+ * lists), so stopping one is an unlink, not a search:
+ *
+ *     static wheel_t wheel;
+ *     static wheel_timer_t led, timeout;
+ *
+ *     wheel_init(&wheel);
+ *     wheel_start(&wheel, &led, 500, 500, ledToggle, NULL);    // Periodic
+ *     wheel_start(&wheel, &timeout, 5000, 0, linkLost, NULL);  // One-shot
+ *
+ *     void SysTick_Handler(void) {
+ *         HAL_IncTick();
+ *         wheel_tick(&wheel);   // Callbacks run here, in the tick interrupt
+ *     }
+ *
+ * A tickless caller advances the wheel by the elapsed time instead and
+ * sleeps for wheel_next() ticks (lib/task does this on TIM6). Empty
+ * stretches are skipped, not stepped through.
+ *
+ * The wheel is not reentrant: call everything from one context, or mask
+ * the tick interrupt around wheel_start()/wheel_stop() in the main loop.
+ * Callbacks may start and stop any timer, including their own.
+ *
+ * The code has no HAL dependency and builds for the `native` platform too.
+ */
+
+#ifndef WHEEL_H
+#define WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Slots per level = 1 << WHEEL_BITS (at most 32: one bitmap word per level) */
+#ifndef WHEEL_BITS
+#define WHEEL_BITS 4
+#endif
+
+/* Levels: the wheel spans 1 << (WHEEL_BITS * WHEEL_LEVELS) ticks, 65 s of 1 ms by default */
+#ifndef WHEEL_LEVELS
+#define WHEEL_LEVELS 4
+#endif
+
+#define WHEEL_SLOTS (1U << WHEEL_BITS)
+
+/* wheel_next() with no timer running */
+#define WHEEL_NEVER UINT32_MAX
+
+typedef void (*wheel_fn_t)(void *ctx);
+
+typedef struct wheel_timer
+{
+    struct wheel_timer *next;      // Slot list
+    struct wheel_timer **pprev;    // Link that points here, NULL when stopped
+    uint32_t expires;              // Tick it fires on
+    uint32_t period;               // Ticks, 0 = one-shot
+    wheel_fn_t fn;
+    void *ctx;
+    uint8_t slot;                  // level * WHEEL_SLOTS + index, while linked
+} wheel_timer_t;
+
+typedef struct
+{
+    wheel_timer_t *slot[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint32_t pending[WHEEL_LEVELS]; // Bit per non-empty slot
+    uint32_t now;                  // Ticks processed
+    uint32_t running;              // Timers linked
+} wheel_t;
+
+void wheel_init(wheel_t *w);
+
+/* (Re)start `t`: fire `fn(ctx)` after `delay` ticks (0 counts as 1, below
+   2^31), then every `period` ticks unless that is 0 */
+void wheel_start(wheel_t *w, wheel_timer_t *t, uint32_t delay, uint32_t period,
+                 wheel_fn_t fn, void *ctx);
+
+/* Stop `t`; a no-op if it is not running */
+void wheel_stop(wheel_t *w, wheel_timer_t *t);
+
+static inline bool wheel_running(const wheel_timer_t *t)
+{
+    return t->pprev != NULL;
+}
+
+/* One tick has passed: fire what expires on it */
+void wheel_tick(wheel_t *w);
+
+/* `ticks` have passed: fire everything that expired, in order */
+void wheel_advance(wheel_t *w, uint32_t ticks);
+
+/* Ticks until the earliest timer fires (>= 1), WHEEL_NEVER if none runs */
+uint32_t wheel_next(const wheel_t *w);
+
+/* Ticks processed since wheel_init() */
+static inline uint32_t wheel_now(const wheel_t *w)
+{
+    return w->now;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WHEEL_H */
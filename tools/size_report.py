@@ -0,0 +1,625 @@
+#!/usr/bin/env python3
+"""
+File: size_report.py
+Project: STM32 PlatformIO Playground - Tools
+Description:
+Flash/RAM footprint and worst-case stack report for every example project
+and every STM32 board env, checked against budgets.
+
+For each project (a platformio.ini under examples/) and each env on the
+ststm32 platform, the firmware is linked with `pio run` and two extra
+flags, `-fstack-usage` and `-Wl,-Map`. Then:
+
+  ELF   : section headers give the flash/RAM totals, the symbol table the
+          size of every function and object
+  map   : input sections give the bytes each object file contributes
+          (module), grouped by where it comes from (src, lib/<name>, hal,
+          cmsis, libc.a, libm.a, libgcc.a, ...)
+  .su   : frame size of every compiled function
+  objdump -d : direct calls (bl, tail-call branches) and indirect calls
+          (blx rN) for the call graph
+
+The worst-case stack is the deepest path from Reset_Handler plus the
+deepest handlers that can preempt it: the Cortex-M0 has four priority
+levels, so at most four handlers nest, each with its 32-byte exception
+frame. An indirect call counts as a call to the deepest function whose
+address is stored somewhere in the image (cmd tables, task and wheel
+callbacks, clk hooks). Functions without a .su entry (startup code, libc,
+libgcc) count as zero and are listed; recursion is reported and cut.
+
+Budgets per board are BOARD_FLASH_SIZE and BOARD_RAM_SIZE of the env's
+BOARD_NAME in lib/board/board.h; size_budgets.json overrides them and adds
+limits (flash, ram, stack per board, per project, or per project and
+board; the linker script's FLASH/RAM lengths apply where nothing is set).
+A build fails its budget when
+
+  flash                        > flash budget
+  static RAM + worst stack     > ram budget    (static RAM: .data + .bss,
+                                                without the linker's
+                                                heap/stack reservation)
+  worst stack                  > stack budget
+
+Usage (from the repository root, with PlatformIO installed):
+
+  python3 tools/size_report.py                       # build all, print, check
+  python3 tools/size_report.py --json size.json --csv size.csv
+  python3 tools/size_report.py --baseline old.json --max-growth 256
+  python3 tools/size_report.py --project uartringbuffer --env nucleo_f030r8 --top 10
+
+Exit status: 0 all within budget, 1 a budget or the growth limit is
+exceeded, 2 a build or the analysis failed.
+"""
+
+import argparse
+import configparser
+import csv
+import glob
+import json
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BUDGETS = os.path.join(ROOT, "tools", "size_budgets.json")
+BOARD_H = os.path.join(ROOT, "lib", "board", "board.h")
+
+EXTRA_FLAGS = "-fstack-usage -Wl,-Map,$BUILD_DIR/firmware.map"
+
+NVIC_LEVELS = 4            # Cortex-M0: 2 priority bits
+EXC_FRAME = 32             # r0-r3, r12, lr, pc, xPSR (+4 alignment, not counted)
+RESERVED_SECTIONS = ("._user_heap_stack", ".heap", ".stack")
+
+# --- ELF ---
+
+SHF_WRITE, SHF_ALLOC = 0x1, 0x2
+SHT_SYMTAB, SHT_NOBITS = 2, 8
+STT_OBJECT, STT_FUNC = 1, 2
+
+
+class Elf:
+    """Sections and symbols of an ELF32/ELF64 file, enough for sizes."""
+
+    def __init__(self, path):
+        self.path = path
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF":
+            raise ValueError("%s: not an ELF file" % path)
+        self.is64 = d[4] == 2
+        e = "<" if d[5] == 1 else ">"
+        self.endian = e
+        if self.is64:
+            hdr = struct.unpack_from(e + "HHIQQQIHHHHHH", d, 16)
+            shoff, shentsize, shnum, shstrndx = hdr[5], hdr[10], hdr[11], hdr[12]
+            shfmt = e + "IIQQQQIIQQ"
+        else:
+            hdr = struct.unpack_from(e + "HHIIIIIHHHHHH", d, 16)
+            shoff, shentsize, shnum, shstrndx = hdr[5], hdr[10], hdr[11], hdr[12]
+            shfmt = e + "IIIIIIIIII"
+
+        raw = [struct.unpack_from(shfmt, d, shoff + i * shentsize) for i in range(shnum)]
+        names = raw[shstrndx]
+        self.sections = []
+        for s in raw:
+            self.sections.append({
+                "name": self._str(names[4], s[0]),
+                "type": s[1], "flags": s[2], "addr": s[3],
+                "offset": s[4], "size": s[5], "link": s[6], "entsize": s[9],
+            })
+        self.symbols = self._read_symbols()
+
+    def _str(self, table_offset, index):
+        start = table_offset + index
+        return self.data[start:self.data.index(b"\0", start)].decode("ascii", "replace")
+
+    def _read_symbols(self):
+        e, symbols = self.endian, []
+        for s in self.sections:
+            if s["type"] != SHT_SYMTAB:
+                continue
+            strtab = self.sections[s["link"]]["offset"]
+            for off in range(s["offset"], s["offset"] + s["size"], s["entsize"]):
+                if self.is64:
+                    name, info, _, shndx, value, size = struct.unpack_from(e + "IBBHQQ", self.data, off)
+                else:
+                    name, value, size, info, _, shndx = struct.unpack_from(e + "IIIBBH", self.data, off)
+                kind = info & 0xF
+                if kind in (STT_OBJECT, STT_FUNC) and 0 < shndx < len(self.sections):
+                    symbols.append({
+                        "name": self._str(strtab, name), "value": value, "size": size,
+                        "func": kind == STT_FUNC, "section": self.sections[shndx],
+                    })
+        return symbols
+
+    @staticmethod
+    def regions(section):
+        """(in flash, in RAM) of an allocated section: initialised data is both."""
+        if not section["flags"] & SHF_ALLOC:
+            return False, False
+        return section["type"] != SHT_NOBITS, bool(section["flags"] & SHF_WRITE)
+
+    def words(self, section):
+        """Aligned 32-bit words of a section with contents."""
+        if section["type"] == SHT_NOBITS:
+            return []
+        start, end = section["offset"], section["offset"] + section["size"] - 3
+        return [struct.unpack_from(self.endian + "I", self.data, o)[0]
+                for o in range(start + (-start % 4), end, 4)]
+
+
+# --- Linker map ---
+
+MAP_INPUT = re.compile(r"^ (\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+MAP_INPUT_NAME = re.compile(r"^ (\S+)$")
+MAP_INPUT_REST = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+MAP_OUTPUT = re.compile(r"^(\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+))?")
+MAP_MEMORY = re.compile(r"^(\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)")
+
+
+def parse_map(path):
+    """Memory regions and (output section, object file, size) contributions."""
+    memory, contrib = {}, []
+    part = None
+    output = pending = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Memory Configuration"):
+                part = "memory"
+                continue
+            if line.startswith("Linker script and memory map"):
+                part = "map"
+                continue
+            if part == "memory":
+                m = MAP_MEMORY.match(line)
+                if m and m.group(1) != "*default*":
+                    memory[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+                continue
+            if part != "map" or not line.strip():
+                continue
+            if line.startswith("OUTPUT("):
+                break
+
+            if pending is not None:
+                m = MAP_INPUT_REST.match(line)
+                name, pending = pending, None
+                if m:
+                    contrib.append((output, name, int(m.group(2), 16), m.group(3).strip()))
+                    continue
+            if not line[0].isspace():
+                m = MAP_OUTPUT.match(line)
+                output = m.group(1) if m else None
+                continue
+            if line.startswith(" *") or output is None:
+                continue              # Linker script patterns and *fill*
+            m = MAP_INPUT.match(line)
+            if m:
+                contrib.append((output, m.group(1), int(m.group(3), 16), m.group(4).strip()))
+                continue
+            m = MAP_INPUT_NAME.match(line)
+            if m:
+                pending = m.group(1)   # Long name: address and size on the next line
+    return memory, contrib
+
+
+def module_of(obj):
+    """(group, module) of an object file path in the map."""
+    obj = obj.replace("\\", "/")
+    member = None
+    m = re.match(r"^(.*)\((.*)\)$", obj)
+    if m:
+        obj, member = m.group(1), m.group(2)
+    base = os.path.basename(obj)
+    in_build = "/.pio/" in "/" + obj or obj.startswith(".pio/")
+
+    if member is not None:
+        stem = base[3:-2] if base.startswith("lib") and base.endswith(".a") else base
+        if "FrameworkHALDriver" in stem:
+            group = "hal"
+        elif "CMSIS" in stem:
+            group = "cmsis"
+        elif in_build:
+            group = "lib/" + stem
+        else:
+            group = base              # libc.a, libm.a, libgcc.a, libnosys.a
+        return group, "%s:%s" % (group, member)
+
+    if "FrameworkHALDriver" in obj:
+        group = "hal"
+    elif "CMSIS" in obj:
+        group = "cmsis"
+    elif in_build and "/src/" in obj:
+        group = "src"
+    elif in_build:
+        parts = obj.split("/")
+        group = "lib/" + parts[-2] if len(parts) >= 2 else "other"
+    else:
+        group = "toolchain"           # crt*.o
+    return group, "%s:%s" % (group, base)
+
+
+# --- Stack ---
+
+def read_stack_usage(build_dir):
+    """Frame size per function name from the .su files; names with a dynamic frame."""
+    frames, dynamic = {}, set()
+    for path in glob.glob(os.path.join(build_dir, "**", "*.su"), recursive=True):
+        with open(path, errors="replace") as f:
+            for line in f:
+                fields = line.rstrip("\n").split("\t")
+                if len(fields) < 3:
+                    continue
+                name = fields[0].rsplit(":", 1)[-1]
+                frames[name] = max(frames.get(name, 0), int(fields[1]))
+                if fields[2].startswith("dynamic") and "bounded" not in fields[2]:
+                    dynamic.add(name)
+    return frames, dynamic
+
+
+DIS_FUNC = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+DIS_BRANCH = re.compile(r"\t(b[a-z]*(?:\.[nw])?)\s+[0-9a-f]+ <([^>+]+)(\+0x[0-9a-f]+)?>")
+DIS_INDIRECT = re.compile(r"\t(blx|bx)\s+(r\d+|ip|sl|fp|sb)\s*$")
+
+
+def parse_calls(disassembly):
+    """Direct callees and whether there is an indirect call, per function."""
+    calls, indirect = {}, set()
+    current = None
+    for line in disassembly.splitlines():
+        m = DIS_FUNC.match(line)
+        if m:
+            current = m.group(2)
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        m = DIS_BRANCH.search(line)
+        if m:
+            op, target, offset = m.groups()
+            is_call = op in ("bl", "blx")
+            if target != current and (is_call or offset is None):
+                calls[current].add(target)       # Call, or tail call to a function entry
+            elif target == current and is_call and offset is None:
+                calls[current].add(target)       # Recursion
+            continue
+        if DIS_INDIRECT.search(line):
+            indirect.add(current)
+    return calls, indirect
+
+
+class StackAnalysis:
+    INDIRECT = "<indirect>"
+
+    def __init__(self, calls, indirect, frames, targets):
+        self.calls = dict(calls)
+        self.calls[self.INDIRECT] = set(targets)
+        for f in indirect:
+            self.calls.setdefault(f, set()).add(self.INDIRECT)
+        self.frames = frames
+        self.memo = {}
+        self.path = set()
+        self.recursive = set()
+        self.unknown = set()
+
+    def depth(self, func):
+        if func in self.memo:
+            return self.memo[func]
+        if func in self.path:
+            self.recursive.add(func)
+            return 0
+        self.path.add(func)
+        if func == self.INDIRECT:
+            frame = 0
+        elif func in self.frames:
+            frame = self.frames[func]
+        else:
+            frame = 0
+            self.unknown.add(func)
+        deepest = max((self.depth(g) for g in self.calls.get(func, ())), default=0)
+        self.path.discard(func)
+        self.memo[func] = frame + deepest
+        return self.memo[func]
+
+
+def analyse_stack(elf, objdump, build_dir):
+    frames, dynamic = read_stack_usage(build_dir)
+    if not frames:
+        raise RuntimeError("no .su files in %s (built without -fstack-usage?)" % build_dir)
+    disassembly = subprocess.run([objdump, "-d", "--no-show-raw-insn", elf.path],
+                                 check=True, capture_output=True, text=True).stdout
+    calls, indirect = parse_calls(disassembly)
+
+    funcs = {}
+    for s in elf.symbols:
+        if s["func"]:
+            funcs.setdefault(s["value"], s["name"])
+    vectors, stored = set(), set()
+    for sec in elf.sections:
+        if not sec["flags"] & SHF_ALLOC:
+            continue
+        hits = {funcs[w] for w in elf.words(sec) if w in funcs}
+        (vectors if sec["name"] == ".isr_vector" else stored).update(hits)
+
+    analysis = StackAnalysis(calls, indirect, frames, stored)
+    entry = "Reset_Handler" if "Reset_Handler" in calls else "main"
+    main_depth = analysis.depth(entry)
+    handlers = sorted(((analysis.depth(h), h) for h in vectors if h != entry), reverse=True)
+    nested = handlers[:NVIC_LEVELS]
+    worst = main_depth + sum(d + EXC_FRAME for d, _ in nested)
+    return {
+        "main": main_depth,
+        "isr_max": handlers[0][0] if handlers else 0,
+        "worst": worst,
+        "nested": [{"handler": h, "depth": d} for d, h in nested],
+        "recursive": sorted(analysis.recursive - {StackAnalysis.INDIRECT}),
+        "dynamic": sorted(dynamic & set(analysis.memo)),
+        "unknown": sorted(analysis.unknown),
+        "indirect_targets": len(stored),
+    }
+
+
+# --- Projects and builds ---
+
+def find_projects(root, name_filter):
+    projects = []
+    for ini in sorted(glob.glob(os.path.join(root, "examples", "**", "platformio.ini"), recursive=True)):
+        rel = os.path.relpath(os.path.dirname(ini), os.path.join(root, "examples")).replace(os.sep, "/")
+        if name_filter and not any(f in rel for f in name_filter):
+            continue
+        envs = stm32_envs(ini)
+        if envs:
+            projects.append((rel, os.path.dirname(ini), envs))
+    return projects
+
+
+def stm32_envs(ini):
+    cfg = configparser.ConfigParser(interpolation=None, strict=False, inline_comment_prefixes=(";",))
+    cfg.read(ini)
+
+    def option(section, key, seen=()):
+        if cfg.has_option(section, key):
+            return cfg.get(section, key)
+        parent = cfg.get(section, "extends", fallback=None)
+        if parent and parent not in seen:
+            return option(parent.strip(), key, seen + (section,))
+        return cfg.get("env", key, fallback="") if cfg.has_section("env") else ""
+
+    return [s[4:] for s in cfg.sections()
+            if s.startswith("env:") and option(s, "platform").strip().startswith("ststm32")]
+
+
+def find_objdump():
+    tool = shutil.which("arm-none-eabi-objdump")
+    if tool:
+        return tool
+    core = os.environ.get("PLATFORMIO_CORE_DIR", os.path.join(os.path.expanduser("~"), ".platformio"))
+    found = glob.glob(os.path.join(core, "packages", "toolchain-gccarmnoneeabi*", "bin", "arm-none-eabi-objdump*"))
+    return found[0] if found else None
+
+
+def build(project_dir, env):
+    environ = dict(os.environ)
+    environ["PLATFORMIO_BUILD_FLAGS"] = (environ.get("PLATFORMIO_BUILD_FLAGS", "") + " " + EXTRA_FLAGS).strip()
+    result = subprocess.run(["pio", "run", "-d", project_dir, "-e", env],
+                            env=environ, capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout[-4000:] + result.stderr[-4000:])
+    return result.returncode == 0
+
+
+# --- Report ---
+
+BOARD_DEFINE = re.compile(r"^#define\s+BOARD_(NAME|FLASH_SIZE|RAM_SIZE)\s+(.+?)\s*$")
+BOARD_SIZE = re.compile(r"^\((\d+)U?\s*\*\s*(\d+)U?\)$")
+
+
+def board_memory(path):
+    """{env: {"flash": bytes, "ram": bytes}} from the per-part block of board.h."""
+    boards, current = {}, None
+    with open(path) as f:
+        for line in f:
+            m = BOARD_DEFINE.match(line)
+            if m is None:
+                continue
+            if m.group(1) == "NAME":
+                current = boards.setdefault(m.group(2).strip('"'), {})
+                continue
+            size = BOARD_SIZE.match(m.group(2))
+            if current is None or size is None:
+                raise ValueError("%s: cannot read %s" % (path, line.strip()))
+            current["flash" if m.group(1) == "FLASH_SIZE" else "ram"] = int(size.group(1)) * int(size.group(2))
+    return boards
+
+
+def budget_for(budgets, boards, project, env, memory):
+    limits = {}
+    for region, key in (("FLASH", "flash"), ("RAM", "ram")):
+        if region in memory:
+            limits[key] = memory[region][1]
+    limits.update(boards.get(env, {}))
+    limits.update(budgets.get("boards", {}).get(env, {}))
+    per_project = budgets.get("projects", {}).get(project, {})
+    limits.update({k: v for k, v in per_project.items() if not isinstance(v, dict)})
+    limits.update(per_project.get(env, {}))
+    return limits
+
+
+def analyse(project, project_dir, env, objdump, budgets, boards):
+    build_dir = os.path.join(project_dir, ".pio", "build", env)
+    elf = Elf(os.path.join(build_dir, "firmware.elf"))
+    memory, contrib = parse_map(os.path.join(build_dir, "firmware.map"))
+
+    sections = {s["name"]: s for s in elf.sections}
+    flash = ram = reserved = 0
+    for s in elf.sections:
+        in_flash, in_ram = Elf.regions(s)
+        flash += s["size"] if in_flash else 0
+        ram += s["size"] if in_ram else 0
+        reserved += s["size"] if in_ram and s["name"] in RESERVED_SECTIONS else 0
+
+    modules = {}
+    for output, _, size, obj in contrib:
+        s = sections.get(output)
+        if s is None or size == 0 or output in RESERVED_SECTIONS:
+            continue
+        in_flash, in_ram = Elf.regions(s)
+        group, name = module_of(obj)
+        m = modules.setdefault(name, {"module": name, "group": group, "flash": 0, "ram": 0})
+        m["flash"] += size if in_flash else 0
+        m["ram"] += size if in_ram else 0
+
+    groups = {}
+    for m in modules.values():
+        g = groups.setdefault(m["group"], {"group": m["group"], "flash": 0, "ram": 0})
+        g["flash"] += m["flash"]
+        g["ram"] += m["ram"]
+
+    symbols, seen = [], set()
+    for s in elf.symbols:
+        in_flash, in_ram = Elf.regions(s["section"])
+        key = (s["name"], s["value"])
+        if s["size"] == 0 or key in seen or not (in_flash or in_ram):
+            continue
+        seen.add(key)
+        symbols.append({"name": s["name"], "kind": "func" if s["func"] else "object",
+                        "section": s["section"]["name"], "size": s["size"],
+                        "flash": s["size"] if in_flash else 0, "ram": s["size"] if in_ram else 0})
+
+    stack = analyse_stack(elf, objdump, build_dir)
+    ram_static = ram - reserved
+    limits = budget_for(budgets, boards, project, env, memory)
+    violations = []
+    if "flash" in limits and flash > limits["flash"]:
+        violations.append("flash %d > %d" % (flash, limits["flash"]))
+    if "ram" in limits and ram_static + stack["worst"] > limits["ram"]:
+        violations.append("static RAM %d + stack %d > %d" % (ram_static, stack["worst"], limits["ram"]))
+    if "stack" in limits and stack["worst"] > limits["stack"]:
+        violations.append("stack %d > %d" % (stack["worst"], limits["stack"]))
+
+    by_size = lambda item: (-(item["flash"] + item["ram"]), item.get("module", item.get("group", item.get("name"))))
+    return {
+        "project": project, "env": env,
+        "flash": flash, "ram": ram, "ram_static": ram_static, "ram_reserved": reserved,
+        "stack": stack, "budget": limits, "violations": violations, "ok": not violations,
+        "groups": sorted(groups.values(), key=by_size),
+        "modules": sorted(modules.values(), key=by_size),
+        "symbols": sorted(symbols, key=by_size),
+    }
+
+
+def print_result(r, top):
+    def pct(used, key):
+        limit = r["budget"].get(key)
+        return " (%3d%%)" % (100 * used // limit) if limit else ""
+
+    print("%-52s %-14s flash %6d%s  ram %5d+%-5d%s  stack %4d/%-4d  %s" % (
+        r["project"], r["env"], r["flash"], pct(r["flash"], "flash"),
+        r["ram_static"], r["stack"]["worst"], pct(r["ram_static"] + r["stack"]["worst"], "ram"),
+        r["stack"]["main"], r["stack"]["isr_max"], "ok" if r["ok"] else "OVER: " + "; ".join(r["violations"])))
+    if top:
+        for label, items, key in (("group", r["groups"], "group"), ("module", r["modules"], "module"),
+                                  ("symbol", r["symbols"], "name")):
+            for item in items[:top]:
+                print("    %-6s %-48s flash %6d  ram %5d" % (label, item[key], item["flash"], item["ram"]))
+        if r["stack"]["recursive"]:
+            print("    stack: recursion cut at %s" % ", ".join(r["stack"]["recursive"]))
+
+
+def compare(results, baseline_path, max_growth):
+    with open(baseline_path) as f:
+        old = {(r["project"], r["env"]): r for r in json.load(f)["results"]}
+    failures = 0
+    print("\nchange against %s:" % baseline_path)
+    for r in results:
+        o = old.get((r["project"], r["env"]))
+        if o is None:
+            print("%-52s %-14s new" % (r["project"], r["env"]))
+            continue
+        delta = {k: r[k] - o[k] for k in ("flash", "ram_static")}
+        delta["stack"] = r["stack"]["worst"] - o["stack"]["worst"]
+        grew = max_growth is not None and max(delta.values()) > max_growth
+        failures += grew
+        if any(delta.values()) or grew:
+            print("%-52s %-14s flash %+6d  ram %+5d  stack %+4d%s" % (
+                r["project"], r["env"], delta["flash"], delta["ram_static"], delta["stack"],
+                "  > %d" % max_growth if grew else ""))
+    return failures
+
+
+def git_revision():
+    try:
+        rev = subprocess.run(["git", "-C", ROOT, "rev-parse", "HEAD"],
+                             capture_output=True, text=True, check=True).stdout.strip()
+        dirty = subprocess.run(["git", "-C", ROOT, "status", "--porcelain", "--untracked-files=no"],
+                               capture_output=True, text=True).stdout.strip()
+        return rev + ("-dirty" if dirty else "")
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Flash/RAM/stack report and budget check for all STM32 envs.")
+    ap.add_argument("--project", action="append", help="only projects whose path contains this (repeatable)")
+    ap.add_argument("--env", action="append", help="only this env (repeatable)")
+    ap.add_argument("--no-build", action="store_true", help="analyse the existing .pio builds")
+    ap.add_argument("--budgets", default=BUDGETS, help="budget file (default tools/size_budgets.json)")
+    ap.add_argument("--json", help="write the full report here")
+    ap.add_argument("--csv", help="write one summary row per project and env here")
+    ap.add_argument("--top", type=int, default=0, help="print the N largest groups, modules and symbols")
+    ap.add_argument("--baseline", help="earlier --json report to compare with")
+    ap.add_argument("--max-growth", type=int, help="fail if flash, static RAM or stack grew by more bytes")
+    args = ap.parse_args()
+
+    objdump = find_objdump()
+    if objdump is None:
+        sys.exit("size_report: arm-none-eabi-objdump not found (PATH or the PlatformIO toolchain)")
+    with open(args.budgets) as f:
+        budgets = json.load(f)
+    boards = board_memory(BOARD_H)
+
+    results, errors = [], 0
+    for project, project_dir, envs in find_projects(ROOT, args.project):
+        for env in envs:
+            if args.env and env not in args.env:
+                continue
+            if not args.no_build and not build(project_dir, env):
+                print("%-52s %-14s BUILD FAILED" % (project, env))
+                errors += 1
+                continue
+            try:
+                r = analyse(project, project_dir, env, objdump, budgets, boards)
+            except (OSError, ValueError, RuntimeError, subprocess.CalledProcessError) as e:
+                print("%-52s %-14s ANALYSIS FAILED: %s" % (project, env, e))
+                errors += 1
+                continue
+            results.append(r)
+            print_result(r, args.top)
+
+    report = {"schema": 1, "revision": git_revision(), "nvic_levels": NVIC_LEVELS,
+              "exception_frame": EXC_FRAME, "results": results}
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=1)
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.writer(f)
+            w.writerow(["revision", "project", "env", "flash", "ram_static", "ram_reserved",
+                        "stack_main", "stack_isr", "stack_worst", "ok"])
+            for r in results:
+                w.writerow([report["revision"], r["project"], r["env"], r["flash"], r["ram_static"],
+                            r["ram_reserved"], r["stack"]["main"], r["stack"]["isr_max"],
+                            r["stack"]["worst"], int(r["ok"])])
+
+    over = sum(not r["ok"] for r in results)
+    if args.baseline:
+        over += compare(results, args.baseline, args.max_growth)
+    print("\n%d builds, %d over budget, %d failed" % (len(results), sum(not r["ok"] for r in results), errors))
+    return 2 if errors else (1 if over else 0)
+
+
+if __name__ == "__main__":
+    sys.exit(main())